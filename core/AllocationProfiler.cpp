@@ -0,0 +1,430 @@
+/*
+ * AllocationProfiler.cpp
+ *
+ * The sampling allocation profiler behind
+ * ProtoSpace::startAllocationProfiler.
+ *
+ * Sampling.  Every thread counts down the bytes left until its next
+ * sample; allocCell takes 64 per cell and samples the cell that crosses
+ * zero.  The gaps are drawn from an exponential distribution with the
+ * configured mean, which makes the sample points a Poisson process over
+ * the allocated bytes: each cell is sampled with probability
+ * 1 - exp(-64 / mean), independently of its neighbours, so one sample
+ * stands for the inverse of that many allocations.  Between samples the
+ * cost is a thread-local subtraction.
+ *
+ * Types.  allocCell runs before the cell's constructor, and constructor
+ * arguments may allocate before it runs, so a fresh sample has no type.
+ * It is looked up later, when the constructor has finished: by the
+ * allocating thread at its next allocation, by the collector during its
+ * stop, or at the latest when the collector frees the cell.
+ *
+ * Survival.  The collector reports every sampled cell it sweeps (a bit
+ * filter over addresses keeps the lookup off the common path) and, at the
+ * end of each cycle, credits one survived cycle to every live sample that
+ * was allocated before the cycle's stop.  Dead samples are merged by
+ * type, site, stack and survived cycles, so memory stays bounded by the
+ * live samples plus the distinct allocation paths.
+ *
+ * Output.  writePprof encodes profile.proto by hand (no compression; pprof
+ * accepts raw protobuf).  Native frames are named through dladdr, so
+ * functions without dynamic symbols show up as module+offset.
+ */
+
+#include "../headers/proto_internal.h"
+
+#include <cinttypes>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <tuple>
+
+namespace proto {
+
+    namespace {
+
+        constexpr long kCellBytes = 64;
+        constexpr int kMaxFrames = 64;
+        // AllocationProfiler::onAllocation and ProtoContext::allocCell.
+        constexpr int kSkippedFrames = 2;
+
+        thread_local const char* currentSite = nullptr;
+
+        // Per-thread sampling state.  `session` ties it to one
+        // AllocationProfiler::start: a thread that finds a new session
+        // draws a fresh gap and forgets its pending cell.
+        struct Sampler {
+            uint64_t session;
+            uint64_t rng;
+            long bytesUntilSample;
+            // The thread's last sample, while its type is still unknown.
+            const Cell* pending;
+            uint64_t pendingId;
+        };
+        thread_local Sampler sampler{};
+
+        std::atomic<uint64_t> nextSession{1};
+
+        // xorshift64*, uniform in [0, 1).
+        double nextUniform(Sampler& s) {
+            s.rng ^= s.rng >> 12;
+            s.rng ^= s.rng << 25;
+            s.rng ^= s.rng >> 27;
+            return static_cast<double>((s.rng * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+        }
+
+        long nextGap(Sampler& s, unsigned long meanBytes) {
+            const double gap = -std::log(1.0 - nextUniform(s)) * static_cast<double>(meanBytes);
+            return gap >= static_cast<double>(LONG_MAX / 2) ? LONG_MAX / 2 : static_cast<long>(gap) + 1;
+        }
+
+        // Minimal protobuf writer for profile.proto: varint scalars and
+        // length-delimited fields, which is all the format needs.
+        class Message {
+        public:
+            void number(int field, uint64_t value) {
+                if (!value) return;
+                key(field, 0);
+                varint(value);
+            }
+            void bytes(int field, const std::string& value) {
+                key(field, 2);
+                varint(value.size());
+                data += value;
+            }
+            void packed(int field, const std::vector<uint64_t>& values) {
+                Message body;
+                for (uint64_t value : values) body.varint(value);
+                bytes(field, body.data);
+            }
+
+            std::string data;
+
+        private:
+            void key(int field, int wireType) { varint(static_cast<uint64_t>(field) << 3 | wireType); }
+            void varint(uint64_t value) {
+                while (value >= 0x80) {
+                    data.push_back(static_cast<char>(value | 0x80));
+                    value >>= 7;
+                }
+                data.push_back(static_cast<char>(value));
+            }
+        };
+
+        std::string frameName(void* address) {
+            Dl_info info{};
+            if (dladdr(address, &info) && info.dli_sname) {
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+                std::free(demangled);
+                return name;
+            }
+            char text[64];
+            if (info.dli_fname && info.dli_fbase) {
+                const char* module = std::strrchr(info.dli_fname, '/');
+                std::snprintf(text, sizeof(text), "%s+0x%" PRIxPTR, module ? module + 1 : info.dli_fname,
+                              reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+            } else {
+                std::snprintf(text, sizeof(text), "0x%" PRIxPTR, reinterpret_cast<uintptr_t>(address));
+            }
+            return text;
+        }
+
+    } // namespace
+
+    ProtoAllocationSite::ProtoAllocationSite(const char* tag) : previous_(currentSite) {
+        currentSite = tag;
+    }
+
+    ProtoAllocationSite::~ProtoAllocationSite() {
+        currentSite = previous_;
+    }
+
+    bool AllocationProfiler::FreedKey::operator<(const FreedKey& other) const {
+        return std::tie(type, site, stack, survivedCycles) <
+               std::tie(other.type, other.site, other.stack, other.survivedCycles);
+    }
+
+    AllocationProfiler::AllocationProfiler(ProtoSpace* space)
+        : space(space), session(0), meanBytes(ProtoSpace::ALLOCATION_SAMPLE_BYTES_DEFAULT),
+          captureStacks(false), nextSampleId(0) {
+        for (auto& word : filter) word.store(0, std::memory_order_relaxed);
+    }
+
+    void AllocationProfiler::start(unsigned long meanBytes, bool captureStacks) {
+        std::lock_guard<std::mutex> guard(mutex);
+        live.clear();
+        freed.clear();
+        for (auto& word : filter) word.store(0, std::memory_order_relaxed);
+        if (captureStacks) {
+            // backtrace() loads its unwinder on first use, which allocates;
+            // do that here rather than on the first sample.
+            void* warmup[1];
+            backtrace(warmup, 1);
+        }
+        this->meanBytes.store(meanBytes, std::memory_order_relaxed);
+        this->captureStacks.store(captureStacks, std::memory_order_relaxed);
+        session.store(nextSession.fetch_add(1, std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    void AllocationProfiler::onAllocation(Cell* cell) {
+        Sampler& s = sampler;
+        const uint64_t current = session.load(std::memory_order_acquire);
+        const unsigned long mean = meanBytes.load(std::memory_order_relaxed);
+        if (s.session != current) {
+            s.session = current;
+            s.rng = (reinterpret_cast<uintptr_t>(&s) ^
+                     static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                     current * 0x9E3779B97F4A7C15ULL) | 1;
+            s.bytesUntilSample = nextGap(s, mean);
+            s.pending = nullptr;
+        }
+        if (s.pending) resolvePending();
+
+        s.bytesUntilSample -= kCellBytes;
+        if (s.bytesUntilSample > 0) return;
+        s.bytesUntilSample = nextGap(s, mean);
+
+        LiveSample sample{};
+        sample.type = CellType::None;
+        sample.site = currentSite;
+        if (captureStacks.load(std::memory_order_relaxed)) {
+            void* frames[kMaxFrames];
+            const int depth = backtrace(frames, kMaxFrames);
+            if (depth > kSkippedFrames) sample.stack.assign(frames + kSkippedFrames, frames + depth);
+        }
+        sample.weight = 1.0 / (1.0 - std::exp(-static_cast<double>(kCellBytes) / static_cast<double>(mean)));
+        sample.cycle = space->gcCycleCount.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> guard(mutex);
+        if (session.load(std::memory_order_relaxed) != current) return;
+        sample.id = ++nextSampleId;
+        s.pending = cell;
+        s.pendingId = sample.id;
+        live[cell] = std::move(sample);
+        const size_t bit = filterBit(cell);
+        filter[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+    }
+
+    bool AllocationProfiler::resolveType(const Cell* cell, LiveSample& sample) {
+        // allocCell only clears the link word: the rest of the cell is
+        // zero because the sweep zeroes every cell it frees and fresh heap
+        // blocks come zeroed from mmap (allocCell asserts it).  So a null
+        // vtable pointer means the Cell constructor has not run yet; after
+        // it, the type reads None until the derived constructor takes over.
+        void* vtable;
+        std::memcpy(&vtable, cell, sizeof(vtable));
+        if (!vtable) return false;
+        const CellType type = cell->getType();
+        if (type == CellType::None) return false;
+        sample.type = type;
+        sample.resolved = true;
+        return true;
+    }
+
+    void AllocationProfiler::resolvePending() {
+        Sampler& s = sampler;
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = live.find(s.pending);
+        // Gone, replaced by another thread's sample of a reused cell, or
+        // already resolved by the collector: nothing left to do.
+        if (it == live.end() || it->second.id != s.pendingId || it->second.resolved ||
+            resolveType(s.pending, it->second)) {
+            s.pending = nullptr;
+        }
+    }
+
+    void AllocationProfiler::resolveTypes() {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (auto& entry : live) {
+            if (!entry.second.resolved) resolveType(entry.first, entry.second);
+        }
+    }
+
+    void AllocationProfiler::onFreed(const Cell* cell) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = live.find(cell);
+        if (it == live.end()) return;
+        LiveSample& sample = it->second;
+        FreedKey key{sample.resolved ? sample.type : cell->getType(), sample.site,
+                     std::move(sample.stack), sample.survivedCycles};
+        FreedTotals& totals = freed[std::move(key)];
+        totals.count++;
+        totals.weight += sample.weight;
+        live.erase(it);
+    }
+
+    void AllocationProfiler::onCycleEnd(uint64_t cycle) {
+        std::lock_guard<std::mutex> guard(mutex);
+        // Rebuilt from the live samples, dropping the bits of dead ones.
+        for (auto& word : filter) word.store(0, std::memory_order_relaxed);
+        for (auto& entry : live) {
+            if (entry.second.cycle < cycle) entry.second.survivedCycles++;
+            const size_t bit = filterBit(entry.first);
+            filter[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<ProtoAllocationSample> AllocationProfiler::samples() {
+        if (sampler.pending && sampler.session == session.load(std::memory_order_acquire))
+            resolvePending();
+        std::lock_guard<std::mutex> guard(mutex);
+        std::vector<ProtoAllocationSample> out;
+        out.reserve(live.size() + freed.size());
+        for (const auto& entry : live) {
+            const LiveSample& sample = entry.second;
+            out.push_back({sample.resolved ? cellTypeName(sample.type) : "unresolved", sample.site,
+                           sample.stack, 1, sample.weight, sample.survivedCycles, true});
+        }
+        for (const auto& entry : freed) {
+            out.push_back({cellTypeName(entry.first.type), entry.first.site, entry.first.stack,
+                           entry.second.count, entry.second.weight, entry.first.survivedCycles, false});
+        }
+        return out;
+    }
+
+    bool AllocationProfiler::writePprof(const char* path) {
+        const std::vector<ProtoAllocationSample> all = samples();
+
+        // Live and dead samples on the same path and with the same
+        // survival are one pprof sample.
+        struct Values { double allocated = 0; double inUse = 0; };
+        std::map<std::tuple<std::string, std::string, std::vector<void*>, unsigned long>, Values> merged;
+        for (const ProtoAllocationSample& sample : all) {
+            Values& values = merged[std::make_tuple(sample.type, std::string(sample.site ? sample.site : ""),
+                                                    sample.stack, sample.survivedCycles)];
+            values.allocated += sample.weight;
+            if (sample.live) values.inUse += sample.weight;
+        }
+
+        std::vector<std::string> strings{""};
+        std::unordered_map<std::string, uint64_t> stringIds{{"", 0}};
+        auto str = [&](const std::string& text) {
+            auto inserted = stringIds.emplace(text, strings.size());
+            if (inserted.second) strings.push_back(text);
+            return inserted.first->second;
+        };
+        std::unordered_map<std::string, uint64_t> functionIds;
+        Message functions;
+        auto function = [&](const std::string& name) {
+            auto inserted = functionIds.emplace(name, functionIds.size() + 1);
+            if (inserted.second) {
+                Message f;
+                f.number(1, inserted.first->second);
+                f.number(2, str(name));
+                f.number(3, str(name));
+                functions.bytes(5, f.data);
+            }
+            return inserted.first->second;
+        };
+        // Native frames are keyed by address, the type and site frames by
+        // name (with a null address).
+        std::map<std::pair<void*, std::string>, uint64_t> locationIds;
+        Message locations;
+        auto location = [&](void* address, const std::string& name) {
+            auto inserted = locationIds.emplace(std::make_pair(address, address ? std::string() : name),
+                                                locationIds.size() + 1);
+            if (inserted.second) {
+                Message line;
+                line.number(1, function(name));
+                Message l;
+                l.number(1, inserted.first->second);
+                l.number(3, reinterpret_cast<uintptr_t>(address));
+                l.bytes(4, line.data);
+                locations.bytes(4, l.data);
+            }
+            return inserted.first->second;
+        };
+        auto valueType = [&](const char* type, const char* unit) {
+            Message m;
+            m.number(1, str(type));
+            m.number(2, str(unit));
+            return m.data;
+        };
+        auto label = [&](const char* key, const std::string* text, uint64_t number, const char* unit) {
+            Message m;
+            m.number(1, str(key));
+            if (text) m.number(2, str(*text));
+            m.number(3, number);
+            if (unit) m.number(4, str(unit));
+            return m.data;
+        };
+
+        Message profile;
+        profile.bytes(1, valueType("alloc_objects", "count"));
+        profile.bytes(1, valueType("alloc_space", "bytes"));
+        profile.bytes(1, valueType("inuse_objects", "count"));
+        profile.bytes(1, valueType("inuse_space", "bytes"));
+        for (const auto& entry : merged) {
+            const std::string& type = std::get<0>(entry.first);
+            const std::string& site = std::get<1>(entry.first);
+            std::vector<uint64_t> frames{location(nullptr, "[cell " + type + "]")};
+            if (!site.empty()) frames.push_back(location(nullptr, "[site " + site + "]"));
+            for (void* address : std::get<2>(entry.first)) frames.push_back(location(address, frameName(address)));
+            const Values& values = entry.second;
+            Message sample;
+            sample.packed(1, frames);
+            sample.packed(2, {static_cast<uint64_t>(std::llround(values.allocated)),
+                              static_cast<uint64_t>(std::llround(values.allocated * kCellBytes)),
+                              static_cast<uint64_t>(std::llround(values.inUse)),
+                              static_cast<uint64_t>(std::llround(values.inUse * kCellBytes))});
+            sample.bytes(3, label("cell_type", &type, 0, nullptr));
+            if (!site.empty()) sample.bytes(3, label("site", &site, 0, nullptr));
+            sample.bytes(3, label("survived_cycles", nullptr, std::get<3>(entry.first), "cycles"));
+            profile.bytes(2, sample.data);
+        }
+        profile.data += locations.data;
+        profile.data += functions.data;
+        const std::string periodType = valueType("space", "bytes");
+        const uint64_t defaultType = str("alloc_space");
+        for (const std::string& text : strings) profile.bytes(6, text);
+        profile.number(9, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::system_clock::now().time_since_epoch()).count()));
+        profile.bytes(11, periodType);
+        profile.number(12, meanBytes.load(std::memory_order_relaxed));
+        profile.number(14, defaultType);
+
+        std::FILE* file = std::fopen(path, "wb");
+        if (!file) return false;
+        const bool written = std::fwrite(profile.data.data(), 1, profile.data.size(), file) == profile.data.size();
+        const bool closed = std::fclose(file) == 0;
+        return written && closed;
+    }
+
+    void ProtoSpace::startAllocationProfiler(unsigned long meanBytes, bool captureStacks) {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        if (!this->allocationProfiler) this->allocationProfiler = new AllocationProfiler(this);
+        this->allocationProfiler->start(meanBytes ? meanBytes : ALLOCATION_SAMPLE_BYTES_DEFAULT, captureStacks);
+        this->allocationSampling.store(true, std::memory_order_release);
+    }
+
+    void ProtoSpace::stopAllocationProfiler() {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        this->allocationSampling.store(false, std::memory_order_relaxed);
+    }
+
+    std::vector<ProtoAllocationSample> ProtoSpace::allocationSamples() {
+        AllocationProfiler* profiler;
+        {
+            std::lock_guard<std::recursive_mutex> lock(globalMutex);
+            profiler = this->allocationProfiler;
+        }
+        return profiler ? profiler->samples() : std::vector<ProtoAllocationSample>();
+    }
+
+    bool ProtoSpace::writeAllocationProfile(const char* path) {
+        AllocationProfiler* profiler;
+        {
+            std::lock_guard<std::recursive_mutex> lock(globalMutex);
+            profiler = this->allocationProfiler;
+        }
+        return profiler && profiler->writePprof(path);
+    }
+
+} // namespace proto
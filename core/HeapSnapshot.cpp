@@ -0,0 +1,179 @@
+/*
+ * HeapSnapshot.cpp
+ *
+ * The heap snapshot writer behind ProtoSpace::writeHeapSnapshot.  The
+ * collector calls writeHeapSnapshotFile from its stop-the-world with the
+ * roots it has just collected, each tagged with where it was found; the
+ * writer walks everything reachable from them through processReferences
+ * (strong edges only) and streams it to disk.
+ *
+ * File format, version 1.  All integers little-endian; strings are a u16
+ * length followed by that many bytes, not terminated.
+ *
+ *   "PCHS"            magic
+ *   u32               version (1)
+ *   u32 n, n strings  cell type names, indexed by the node type byte
+ *   u32 n, n strings  root category names, indexed by the root kind byte
+ *   u64               node count
+ *   per node, in id order starting at 0:
+ *     u64             cell address
+ *     u8              type
+ *     u64             size in bytes: the 64-byte cell plus memory it owns
+ *                     out of line (byte and external buffers)
+ *     u32 n, n × u32  ids of the cells it references
+ *   u64               root count
+ *   per root:
+ *     u32             node id
+ *     u8              root category
+ *
+ * Ids are assigned breadth first from the roots, so a node's record only
+ * names ids that the file defines.  A cell reachable from several roots
+ * appears once as a node and once per root.
+ */
+
+#include "../headers/proto_internal.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace proto {
+
+    namespace {
+
+        const char* const kCellTypeNames[] = {
+            "None", "Object", "List", "Tuple", "String", "SparseList", "Method",
+            "ExternalPointer", "ExternalBuffer", "Thread", "LargeInteger", "Double",
+            "Set", "Multiset", "MethodCell", "SparseListIterator", "ListIterator",
+            "TupleIterator", "StringIterator", "RangeIterator", "SetIterator",
+            "MultisetIterator", "ReturnReference", "ParentLink", "ThreadExtension",
+            "ByteBuffer", "TupleDictionary", "StringLeafNode", "StringInternalNode",
+            "ListSmall", "SparseListSmall", "WeakRef", "WeakMap", "Future", "Channel"
+        };
+        constexpr size_t kCellTypeCount = sizeof(kCellTypeNames) / sizeof(kCellTypeNames[0]);
+        static_assert(kCellTypeCount == static_cast<size_t>(CellType::Channel) + 1,
+                      "kCellTypeNames must name every CellType");
+
+        const char* const kRootKindNames[] = {
+            "thread", "global", "module", "tuple-interner", "mutable-shard",
+            "root-set", "fiber", "channel", "young", "survivor-pen"
+        };
+        static_assert(sizeof(kRootKindNames) / sizeof(kRootKindNames[0]) ==
+                          static_cast<size_t>(HeapRootKind::SurvivorPen) + 1,
+                      "kRootKindNames must name every HeapRootKind");
+
+        class SnapshotWriter {
+        public:
+            explicit SnapshotWriter(std::FILE* file) : file(file) {}
+
+            void u8(uint8_t v) { bytes(&v, 1); }
+            void u16(uint16_t v) { le(v, 2); }
+            void u32(uint32_t v) { le(v, 4); }
+            void u64(uint64_t v) { le(v, 8); }
+
+            void string(const char* s) {
+                const size_t length = std::strlen(s);
+                u16(static_cast<uint16_t>(length));
+                bytes(s, length);
+            }
+
+            bool ok() const { return good; }
+
+        private:
+            void le(uint64_t v, int width) {
+                unsigned char out[8];
+                for (int i = 0; i < width; ++i) out[i] = static_cast<unsigned char>(v >> (8 * i));
+                bytes(out, width);
+            }
+
+            void bytes(const void* data, size_t length) {
+                if (good && std::fwrite(data, 1, length, file) != length) good = false;
+            }
+
+            std::FILE* file;
+            bool good = true;
+        };
+
+        uint64_t cellSize(const Cell* cell) {
+            uint64_t size = 64;
+            switch (cell->getType()) {
+                case CellType::ByteBuffer: {
+                    const auto* buffer = static_cast<const ProtoByteBufferImplementation*>(cell);
+                    if (buffer->freeOnExit) size += buffer->size;
+                    break;
+                }
+                case CellType::ExternalBuffer:
+                    size += static_cast<const ProtoExternalBufferImplementation*>(cell)->size;
+                    break;
+                default:
+                    break;
+            }
+            return size;
+        }
+
+    } // namespace
+
+    const char* cellTypeName(CellType type) {
+        const size_t index = static_cast<size_t>(type);
+        return index < kCellTypeCount ? kCellTypeNames[index] : "None";
+    }
+
+    bool writeHeapSnapshotFile(ProtoSpace* space, const char* path,
+                               const std::vector<HeapSnapshotRoot>& roots) {
+        std::FILE* file = std::fopen(path, "wb");
+        if (!file) return false;
+        SnapshotWriter out(file);
+
+        std::unordered_map<const Cell*, uint32_t> ids;
+        std::vector<const Cell*> nodes;
+        auto idOf = [&](const Cell* cell) {
+            auto inserted = ids.emplace(cell, static_cast<uint32_t>(nodes.size()));
+            if (inserted.second) nodes.push_back(cell);
+            return inserted.first->second;
+        };
+        for (const HeapSnapshotRoot& root : roots) idOf(root.cell);
+
+        // The node count precedes the nodes, so the walk runs twice: once
+        // to number every reachable cell, once to write them.
+        struct Collect { std::vector<const Cell*>* refs; };
+        std::vector<const Cell*> refs;
+        Collect collect{&refs};
+        auto referencesOf = [&](const Cell* cell) {
+            refs.clear();
+            cell->processReferences(space->rootContext, &collect, [](ProtoContext*, void* self, const Cell* ref) {
+                if (ref) static_cast<Collect*>(self)->refs->push_back(ref);
+            });
+        };
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            referencesOf(nodes[i]);
+            for (const Cell* ref : refs) idOf(ref);
+        }
+
+        out.u8('P'); out.u8('C'); out.u8('H'); out.u8('S');
+        out.u32(1);
+        out.u32(kCellTypeCount);
+        for (const char* name : kCellTypeNames) out.string(name);
+        out.u32(sizeof(kRootKindNames) / sizeof(kRootKindNames[0]));
+        for (const char* name : kRootKindNames) out.string(name);
+
+        out.u64(nodes.size());
+        for (const Cell* cell : nodes) {
+            referencesOf(cell);
+            out.u64(reinterpret_cast<uintptr_t>(cell));
+            out.u8(static_cast<uint8_t>(cell->getType()));
+            out.u64(cellSize(cell));
+            out.u32(static_cast<uint32_t>(refs.size()));
+            for (const Cell* ref : refs) out.u32(ids.at(ref));
+        }
+
+        out.u64(roots.size());
+        for (const HeapSnapshotRoot& root : roots) {
+            out.u32(ids.at(root.cell));
+            out.u8(static_cast<uint8_t>(root.kind));
+        }
+
+        const bool closed = std::fclose(file) == 0;
+        return out.ok() && closed;
+    }
+
+} // namespace proto
@@ -768,6 +768,8 @@ namespace proto
         LargeIntegerImplementation* current = nullptr;
         int digits_processed = 0;
         int num_digits = temp.magnitude.size();
+        ProtoContext::CellBatch batch(context,
+            (num_digits + LargeIntegerImplementation::DIGIT_COUNT - 1) / LargeIntegerImplementation::DIGIT_COUNT);
         while (digits_processed < num_digits) {
             auto* new_chunk = new(context) LargeIntegerImplementation(context);
             new_chunk->is_negative = temp.is_negative;
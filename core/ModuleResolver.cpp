@@ -16,9 +16,11 @@ const ProtoObject* getImportModuleImpl(ProtoSpace* space, ProtoContext* context,
 
     const std::string key(logicalPath);
     ProtoContext* ctx = context;
+    PROTO_PROBE1(module_resolve_start, logicalPath);
 
     const ProtoObject* cached = sharedModuleCacheGet(key);
     if (cached) {
+        PROTO_PROBE3(module_resolve_done, logicalPath, cached, 1);
         {
             std::lock_guard<std::mutex> lock(space->moduleRootsMutex);
             // Ensure the cached module is rooted in this space
@@ -68,6 +70,7 @@ const ProtoObject* getImportModuleImpl(ProtoSpace* space, ProtoContext* context,
         fprintf(stderr, "DEBUG: [UMD] resolutionChain size=%lu\n", chainSize);
     }
     const ProtoObject* module = nullptr;
+    const uint64_t traceLoad = traceBegin(space);
 
     for (unsigned long i = 0; i < chainSize; ++i) {
         const ProtoObject* entryObj = chain->getAt(ctx, static_cast<int>(i));
@@ -104,7 +107,12 @@ const ProtoObject* getImportModuleImpl(ProtoSpace* space, ProtoContext* context,
         }
     }
 
-    if (!module || module == PROTO_NONE) {
+    const bool found = module && module != PROTO_NONE;
+    if (traceLoad)
+        traceEnd(space, traceLoad, "module.load", "found", found, space->traceRecorder->intern(key));
+    PROTO_PROBE3(module_resolve_done, logicalPath, found ? module : nullptr, 0);
+
+    if (!found) {
         if (diag) {
             fprintf(stderr, "DEBUG: [UMD] FAILURE: Module %s not found in any entry\n", logicalPath);
         }
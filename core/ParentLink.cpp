@@ -9,6 +9,8 @@
  */
 
 #include "../headers/proto_internal.h"
+#include <cstdlib>
+#include <new>
 
 namespace proto
 {
@@ -40,8 +42,19 @@ std::mutex dbg_mutex;
         ProtoContext* context,
         const ParentLinkImplementation* parent,
         const ProtoObject* object
-    ) : Cell(context), parent(parent), object(object)
+    ) : Cell(context), parent(parent), object(object), ancestors(nullptr), summary(nullptr)
     {
+        // A mutable prototype's later name additions must expire the chain
+        // summaries of everything that inherits from it (see the "Chain
+        // summaries" section of ProtoObject.cpp).  Flag its shape epoch
+        // here, before any chain that includes this link can be summarised.
+        if (isObjectFast(object)) {
+            const auto* oc = toImpl<const ProtoObjectCell>(object);
+            if (oc->mutable_ref > 0) {
+                std::atomic<uint64_t>* epoch = context->space->shapeEpoch(oc->mutable_ref, true);
+                if (!(epoch->load(std::memory_order_relaxed) & 1)) epoch->fetch_or(1);
+            }
+        }
     };
 
     /**
@@ -99,4 +112,151 @@ std::mutex dbg_mutex;
     {
         return this->parent;
     };
+
+    //=========================================================================
+    // Cached ancestor sets (isInstanceOf)
+    //=========================================================================
+    //
+    // isInstanceOf used to walk the chain with a fixed 64-entry sibling
+    // stack and a 50-step cap on every call.  Instead, the first query
+    // against a chain head builds an AncestorTable — the transitive
+    // closure of objects reachable through the chain, resolving mutable
+    // members to their current snapshot — and later queries are a single
+    // hashed probe.
+    //
+    // Tables are cached on the link, not on objects: newChild links every
+    // instance's head to the class chain (`link->parent`), so all instances
+    // of a class share the table built for that shared tail.
+    //
+    // Validity follows the chain-summary protocol in ProtoObject.cpp: a
+    // closure with no mutable member never changes; otherwise the table is
+    // valid while ProtoSpace::ancestryEpoch is unchanged.  The epoch moves
+    // only when a mutable object that is already someone's parent gets
+    // new parents, which is class-definition-time activity in practice.
+    //
+    // A stale table is replaced by CAS.  The loser of a racing rebuild
+    // frees its own table; the replaced table is retired to the space and
+    // freed under the next STW, when no reader can still hold it.
+
+    namespace {
+        constexpr uint64_t ANCESTOR_TABLE_STABLE = ~0ULL - 1;
+
+        inline bool ancestorTableValid(ProtoContext* context, const AncestorTable* table) {
+            return table && (table->tag == ANCESTOR_TABLE_STABLE ||
+                             table->tag == context->space->ancestryEpoch.load(std::memory_order_acquire) + 1);
+        }
+
+        const ProtoObjectCell* resolveSnapshotSlow(ProtoContext* context, const ProtoObjectCell* oc) {
+            if (oc->mutable_ref == 0) return oc;
+            const int shard = oc->mutable_ref % ProtoSpace::MUTABLE_ROOT_SHARDS;
+            ProtoSparseList* root = context->space->mutableRoot[shard].root.load(std::memory_order_acquire);
+            const ProtoObject* snap = sparseListGetRaw(context, root, oc->mutable_ref);
+            return (snap && isObjectFast(snap)) ? toImpl<const ProtoObjectCell>(snap) : oc;
+        }
+    }
+
+    AncestorTable* AncestorTable::build(ProtoContext* context, const ParentLinkImplementation* head) {
+        // Read the epoch BEFORE resolving any mutable member, so a parent
+        // change racing with the walk leaves the table tagged stale.
+        const uint64_t epoch = context->space->ancestryEpoch.load(std::memory_order_acquire);
+        bool dependsOnMutable = false;
+
+        std::unordered_set<const ProtoObject*> members;
+        std::vector<const ParentLinkImplementation*> pending{head};
+        while (!pending.empty()) {
+            const ParentLinkImplementation* link = pending.back();
+            pending.pop_back();
+            for (; link && ((uintptr_t)link & 0x3F) == 0; link = link->parent) {
+                const ProtoObject* member = link->object;
+                if (!member || !members.insert(member).second) continue;
+                if (!isObjectFast(member)) continue;
+                const auto* oc = toImpl<const ProtoObjectCell>(member);
+                if (oc->mutable_ref > 0) {
+                    dependsOnMutable = true;
+                    oc = resolveSnapshotSlow(context, oc);
+                }
+                if (oc->parent) pending.push_back(oc->parent);
+            }
+        }
+
+        unsigned long capacity = 8;
+        while (capacity < members.size() * 2) capacity <<= 1;
+        void* block = std::calloc(1, sizeof(AncestorTable) + (capacity - 1) * sizeof(const ProtoObject*));
+        if (!block) throw std::bad_alloc();
+        auto* table = static_cast<AncestorTable*>(block);
+        table->tag = dependsOnMutable ? epoch + 1 : ANCESTOR_TABLE_STABLE;
+        table->mask = capacity - 1;
+        for (const ProtoObject* member : members) {
+            unsigned long i = slotFor(member, table->mask);
+            while (table->slots[i]) i = (i + 1) & table->mask;
+            table->slots[i] = member;
+        }
+        return table;
+    }
+
+    bool ParentLinkImplementation::implHasAncestor(ProtoContext* context, const ProtoObject* candidate) const
+    {
+        AncestorTable* table = this->ancestors.load(std::memory_order_acquire);
+        if (!ancestorTableValid(context, table)) {
+            AncestorTable* fresh = AncestorTable::build(context, this);
+            if (this->ancestors.compare_exchange_strong(table, fresh, std::memory_order_acq_rel)) {
+                if (table) context->space->retireAncestorTable(table);
+            } else {
+                // Another thread installed a table first; use ours for
+                // this query and drop it.
+                const bool found = fresh->contains(candidate);
+                std::free(fresh);
+                return found;
+            }
+            table = fresh;
+        }
+        return table->contains(candidate);
+    }
+
+    void ParentLinkImplementation::finalize(ProtoContext* context) const
+    {
+        // The link is unreachable, so no reader can still see its caches.
+        AncestorTable* table = this->ancestors.exchange(nullptr, std::memory_order_relaxed);
+        if (table) std::free(table);
+        ChainSummary* names = this->summary.exchange(nullptr, std::memory_order_relaxed);
+        if (names) std::free(names);
+    }
+
+    void ProtoSpace::retireAncestorTable(AncestorTable* table)
+    {
+        std::lock_guard<std::mutex> lock(retiredLinkCachesMutex_);
+        retiredAncestorTables_.push_back(table);
+    }
+
+    void ProtoSpace::retireChainSummary(ChainSummary* summary)
+    {
+        std::lock_guard<std::mutex> lock(retiredLinkCachesMutex_);
+        retiredChainSummaries_.push_back(summary);
+    }
+
+    void ProtoSpace::reclaimRetiredLinkCaches()
+    {
+        std::lock_guard<std::mutex> lock(retiredLinkCachesMutex_);
+        for (AncestorTable* table : retiredAncestorTables_) std::free(table);
+        retiredAncestorTables_.clear();
+        for (ChainSummary* summary : retiredChainSummaries_) std::free(summary);
+        retiredChainSummaries_.clear();
+    }
+
+    std::atomic<uint64_t>* ProtoSpace::shapeEpoch(unsigned long mutableRef, bool create)
+    {
+        const unsigned long index = mutableRef % (SHAPE_EPOCH_PAGES * SHAPE_EPOCH_PAGE_SIZE);
+        std::atomic<std::atomic<uint64_t>*>& slot = shapeEpochPages[index / SHAPE_EPOCH_PAGE_SIZE];
+        std::atomic<uint64_t>* page = slot.load(std::memory_order_acquire);
+        if (!page) {
+            if (!create) return nullptr;
+            auto* fresh = new std::atomic<uint64_t>[SHAPE_EPOCH_PAGE_SIZE]();
+            if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+                page = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return &page[index % SHAPE_EPOCH_PAGE_SIZE];
+    }
 };
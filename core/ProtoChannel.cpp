@@ -0,0 +1,366 @@
+/*
+ * ProtoChannel.cpp
+ *
+ * Bounded MPMC channels.  See ProtoChannel in protoCore.h for the public
+ * contract and ProtoChannelImplementation in proto_internal.h for the
+ * layout.
+ *
+ * The ring is Dmitry Vyukov's bounded MPMC queue: slot i of lap n has
+ * sequence i + n*capacity while free and one more while full, so a
+ * producer or consumer claims a slot with a single CAS on tail or head.
+ *
+ * Sleeping uses the usual two-sided check.  A thread about to sleep bumps
+ * the sleeper count, fences, and re-checks the ring under the mutex; a
+ * thread that changes the ring fences and then reads the sleeper count,
+ * taking the mutex to notify only if it is non-zero.  Either the sleeper
+ * sees the change or the changer sees the sleeper.  The re-check only
+ * reads sequence numbers, so it is done unmanaged; the actual transfer is
+ * retried after returning to managed state.
+ *
+ * Values are anchored in the receiving context (a ReturnReference, as
+ * join and ~ProtoContext do).  The receiver allocates the anchor before
+ * claiming a slot, so the value is never held by a C++ local alone across
+ * an allocation.  A blocked sender anchors its value before going
+ * unmanaged, since it may sit out several collections.
+ */
+
+#include "../headers/proto_internal.h"
+#include <algorithm>
+
+namespace proto {
+
+    namespace {
+
+        using Ring = ProtoChannelImplementation::Ring;
+        using SelectWaiter = ProtoChannelImplementation::SelectWaiter;
+
+        void anchor(ProtoContext* context, const ProtoObject* value) {
+            if (value && ProtoObject::isCellPointer(value))
+                (void) new(context) ReturnReference(context, const_cast<Cell*>(ProtoObject::asCellPointer(value)));
+        }
+
+        // A receiver allocates its anchor before claiming a slot: the
+        // allocation may park for a collection, and a claimed value is no
+        // longer in the ring, where collectChannelContents would find it.
+        ReturnReference* newAnchor(ProtoContext* context) {
+            return new(context) ReturnReference(context, nullptr);
+        }
+
+        const ProtoObject* fillAnchor(ReturnReference* held, const ProtoObject* value) {
+            if (value && ProtoObject::isCellPointer(value))
+                held->returnValue = const_cast<Cell*>(ProtoObject::asCellPointer(value));
+            return value;
+        }
+
+        bool hasRoom(const Ring* r) {
+            const unsigned long pos = r->tail.load(std::memory_order_relaxed);
+            const unsigned long seq = r->slots[pos & r->mask].sequence.load(std::memory_order_acquire);
+            return static_cast<long>(seq - pos) >= 0;
+        }
+
+        bool hasValue(const Ring* r) {
+            const unsigned long pos = r->head.load(std::memory_order_relaxed);
+            const unsigned long seq = r->slots[pos & r->mask].sequence.load(std::memory_order_acquire);
+            return static_cast<long>(seq - (pos + 1)) >= 0;
+        }
+
+        void wakeReceivers(Ring* r) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (r->sleepingReceivers.load(std::memory_order_relaxed) == 0) return;
+            {
+                std::lock_guard<std::mutex> lock(r->mutex);
+                for (SelectWaiter* w : r->selectors) {
+                    std::lock_guard<std::mutex> waiterLock(w->mutex);
+                    w->signaled = true;
+                    w->cv.notify_one();
+                }
+            }
+            r->notEmpty.notify_one();
+        }
+
+        void wakeSenders(Ring* r) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (r->sleepingSenders.load(std::memory_order_relaxed) == 0) return;
+            {
+                std::lock_guard<std::mutex> lock(r->mutex);
+            }
+            r->notFull.notify_one();
+        }
+
+        const ProtoChannelImplementation* implOf(const ProtoChannel* channel) {
+            return toImpl<const ProtoChannelImplementation>(channel);
+        }
+
+    }
+
+    ProtoChannelImplementation::ProtoChannelImplementation(ProtoContext* context, unsigned long capacity)
+        : Cell(context), ring(new Ring())
+    {
+        // A single-slot ring cannot tell "full" from "free next lap".
+        unsigned long size = 2;
+        while (size < capacity) size <<= 1;
+        ring->mask = size - 1;
+        ring->slots.reset(new Slot[size]);
+        for (unsigned long i = 0; i < size; ++i) {
+            ring->slots[i].sequence.store(i, std::memory_order_relaxed);
+            ring->slots[i].value = nullptr;
+        }
+        std::lock_guard<std::mutex> lock(context->space->channelCellsMutex_);
+        context->space->channelCells_.insert(this);
+    }
+
+    const ProtoObject* ProtoChannelImplementation::implAsObject(ProtoContext* context) const {
+        ProtoObjectPointer p{};
+        p.channelImplementation = this;
+        p.op.pointer_tag = POINTER_TAG_CHANNEL;
+        return p.oid;
+    }
+
+    bool ProtoChannelImplementation::implTrySend(const ProtoObject* value) const {
+        Ring* r = ring;
+        if (r->closed.load(std::memory_order_acquire)) return false;
+        unsigned long pos = r->tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &r->slots[pos & r->mask];
+            const unsigned long seq = slot->sequence.load(std::memory_order_acquire);
+            const long dif = static_cast<long>(seq - pos);
+            if (dif == 0) {
+                if (r->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = r->tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        wakeReceivers(r);
+        return true;
+    }
+
+    const ProtoObject* ProtoChannelImplementation::implTryReceive() const {
+        Ring* r = ring;
+        unsigned long pos = r->head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &r->slots[pos & r->mask];
+            const unsigned long seq = slot->sequence.load(std::memory_order_acquire);
+            const long dif = static_cast<long>(seq - (pos + 1));
+            if (dif == 0) {
+                if (r->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return nullptr;
+            } else {
+                pos = r->head.load(std::memory_order_relaxed);
+            }
+        }
+        const ProtoObject* value = slot->value;
+        slot->value = nullptr;
+        slot->sequence.store(pos + r->mask + 1, std::memory_order_release);
+        wakeSenders(r);
+        return value;
+    }
+
+    bool ProtoChannelImplementation::implSend(ProtoContext* context, const ProtoObject* value) const {
+        if (implTrySend(value)) return true;
+        anchor(context, value);
+        Ring* r = ring;
+        while (!r->closed.load(std::memory_order_acquire)) {
+            {
+                ProtoContext::UnmanagedScope unmanaged(context);
+                std::unique_lock<std::mutex> lock(r->mutex);
+                r->sleepingSenders.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!hasRoom(r) && !r->closed.load()) r->notFull.wait(lock);
+                r->sleepingSenders.fetch_sub(1);
+            }
+            if (implTrySend(value)) return true;
+        }
+        return false;
+    }
+
+    const ProtoObject* ProtoChannelImplementation::implReceive(ProtoContext* context) const {
+        Ring* r = ring;
+        ReturnReference* held = newAnchor(context);
+        while (true) {
+            if (const ProtoObject* value = implTryReceive()) return fillAnchor(held, value);
+            if (r->closed.load(std::memory_order_acquire) && !hasValue(r)) return nullptr;
+            ProtoContext::UnmanagedScope unmanaged(context);
+            std::unique_lock<std::mutex> lock(r->mutex);
+            r->sleepingReceivers.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasValue(r) && !r->closed.load()) r->notEmpty.wait(lock);
+            r->sleepingReceivers.fetch_sub(1);
+        }
+    }
+
+    void ProtoChannelImplementation::implClose() const {
+        Ring* r = ring;
+        r->closed.store(true);
+        {
+            std::lock_guard<std::mutex> lock(r->mutex);
+            for (SelectWaiter* w : r->selectors) {
+                std::lock_guard<std::mutex> waiterLock(w->mutex);
+                w->signaled = true;
+                w->cv.notify_one();
+            }
+        }
+        r->notEmpty.notify_all();
+        r->notFull.notify_all();
+    }
+
+    void ProtoChannelImplementation::processReferences(
+        ProtoContext* /*context*/,
+        void* /*self*/,
+        void (*/*method*/)(ProtoContext*, void*, const Cell*)
+    ) const {
+        /* Queued values are roots; see collectChannelContents. */
+    }
+
+    void ProtoChannelImplementation::finalize(ProtoContext* context) const {
+        {
+            std::lock_guard<std::mutex> lock(context->space->channelCellsMutex_);
+            context->space->channelCells_.erase(this);
+        }
+        delete ring;
+        ring = nullptr;
+    }
+
+    unsigned long ProtoChannelImplementation::getHash(ProtoContext* /*context*/) const {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    void collectChannelContents(ProtoSpace* space, std::vector<const Cell*>& out) {
+        std::lock_guard<std::mutex> lock(space->channelCellsMutex_);
+        for (const Cell* cell : space->channelCells_) {
+            const Ring* r = static_cast<const ProtoChannelImplementation*>(cell)->ring;
+            const unsigned long tail = r->tail.load(std::memory_order_acquire);
+            for (unsigned long pos = r->head.load(std::memory_order_acquire); pos != tail; ++pos) {
+                const auto& slot = r->slots[pos & r->mask];
+                if (slot.sequence.load(std::memory_order_acquire) != pos + 1) continue;
+                if (slot.value && ProtoObject::isCellPointer(slot.value))
+                    out.push_back(ProtoObject::asCellPointer(slot.value));
+            }
+        }
+    }
+
+    void releaseChannelRings(ProtoSpace* space) {
+        std::lock_guard<std::mutex> lock(space->channelCellsMutex_);
+        for (const Cell* cell : space->channelCells_) {
+            const auto* channel = static_cast<const ProtoChannelImplementation*>(cell);
+            delete channel->ring;
+            channel->ring = nullptr;
+        }
+        space->channelCells_.clear();
+    }
+
+}
+
+namespace proto {
+
+    bool ProtoChannel::send(ProtoContext* context, const ProtoObject* value) const {
+        return implOf(this)->implSend(context, value ? value : PROTO_NONE);
+    }
+
+    bool ProtoChannel::trySend(ProtoContext* /*context*/, const ProtoObject* value) const {
+        return implOf(this)->implTrySend(value ? value : PROTO_NONE);
+    }
+
+    const ProtoObject* ProtoChannel::receive(ProtoContext* context) const {
+        return implOf(this)->implReceive(context);
+    }
+
+    const ProtoObject* ProtoChannel::tryReceive(ProtoContext* context) const {
+        const ProtoChannelImplementation* impl = implOf(this);
+        if (!hasValue(impl->ring)) return nullptr;
+        ReturnReference* held = newAnchor(context);
+        return fillAnchor(held, impl->implTryReceive());
+    }
+
+    void ProtoChannel::close(ProtoContext* /*context*/) const {
+        implOf(this)->implClose();
+    }
+
+    bool ProtoChannel::isClosed(ProtoContext* /*context*/) const {
+        return implOf(this)->ring->closed.load(std::memory_order_acquire);
+    }
+
+    unsigned long ProtoChannel::getCapacity(ProtoContext* /*context*/) const {
+        return implOf(this)->ring->mask + 1;
+    }
+
+    unsigned long ProtoChannel::getSize(ProtoContext* /*context*/) const {
+        const Ring* r = implOf(this)->ring;
+        const unsigned long head = r->head.load(std::memory_order_acquire);
+        const unsigned long tail = r->tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    const ProtoObject* ProtoChannel::select(ProtoContext* context,
+                                            const ProtoChannel* const* channels,
+                                            unsigned long count,
+                                            unsigned long* index,
+                                            long milliseconds) {
+        if (!channels || count == 0) return nullptr;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(milliseconds, 0L));
+        // Rotate the starting channel so a busy one cannot starve the rest.
+        static thread_local unsigned long rotation = 0;
+        const unsigned long start = rotation++;
+        ReturnReference* held = newAnchor(context);
+
+        while (true) {
+            bool open = false;
+            for (unsigned long k = 0; k < count; ++k) {
+                const unsigned long i = (start + k) % count;
+                const ProtoChannelImplementation* impl = implOf(channels[i]);
+                if (const ProtoObject* value = impl->implTryReceive()) {
+                    if (index) *index = i;
+                    return fillAnchor(held, value);
+                }
+                if (!impl->ring->closed.load(std::memory_order_acquire) || hasValue(impl->ring)) open = true;
+            }
+            if (!open) return nullptr;
+
+            bool timedOut = false;
+            {
+                ProtoContext::UnmanagedScope unmanaged(context);
+                SelectWaiter waiter;
+                for (unsigned long i = 0; i < count; ++i) {
+                    Ring* r = implOf(channels[i])->ring;
+                    std::lock_guard<std::mutex> lock(r->mutex);
+                    r->selectors.push_back(&waiter);
+                    r->sleepingReceivers.fetch_add(1);
+                }
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool ready = false;
+                for (unsigned long i = 0; i < count && !ready; ++i) {
+                    const Ring* r = implOf(channels[i])->ring;
+                    ready = hasValue(r) || r->closed.load();
+                }
+                if (!ready) {
+                    std::unique_lock<std::mutex> lock(waiter.mutex);
+                    auto signaled = [&waiter] { return waiter.signaled; };
+                    if (milliseconds < 0) waiter.cv.wait(lock, signaled);
+                    else timedOut = !waiter.cv.wait_until(lock, deadline, signaled);
+                }
+                for (unsigned long i = 0; i < count; ++i) {
+                    Ring* r = implOf(channels[i])->ring;
+                    std::lock_guard<std::mutex> lock(r->mutex);
+                    r->selectors.erase(std::find(r->selectors.begin(), r->selectors.end(), &waiter));
+                    r->sleepingReceivers.fetch_sub(1);
+                }
+            }
+            if (timedOut) return nullptr;
+        }
+    }
+
+    const ProtoObject* ProtoChannel::asObject(ProtoContext* context) const {
+        return implOf(this)->implAsObject(context);
+    }
+
+    unsigned long ProtoChannel::getHash(ProtoContext* context) const {
+        return implOf(this)->getHash(context);
+    }
+
+}
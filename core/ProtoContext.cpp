@@ -7,6 +7,7 @@
 
 #include "../headers/proto_internal.h"
 #include <stdexcept>
+#include <cassert>
 #include <vector>
 #include <cstdlib>
 #include <iostream>
@@ -14,6 +15,16 @@
 
 namespace proto
 {
+    namespace {
+        // A free cell's vtable word is still zero: no constructor has run
+        // on it since the sweep or the OS zeroed it.
+        [[maybe_unused]] bool isUnconstructed(const Cell* cell) {
+            void* vtable;
+            std::memcpy(&vtable, static_cast<const void*>(cell), sizeof(vtable));
+            return vtable == nullptr;
+        }
+    }
+
     unsigned long generate_mutable_ref(ProtoContext* context) {
         return context->space->nextMutableRef++;
     }
@@ -270,9 +281,10 @@ namespace proto
      * Fast path: relaxed atomic load of `stwFlag`.  When the flag is clear
      * (the common case) the call costs essentially nothing.
      *
-     * Slow path: when the GC has signalled stop-the-world, increment
-     * `parkedThreads`, notify the GC, and wait on `stopTheWorldCV` until
-     * the flag clears.  This is the same handshake `allocCell` performs
+     * Slow path: when the GC has signalled stop-the-world, mark the
+     * thread parked in its state word and futex-wait until the flag
+     * clears (ProtoThreadImplementation::implSynchToGC).  This is the
+     * same handshake `allocCell` performs
      * every 64 allocations, exposed as a public hook so that an embedder
      * (e.g. protoPython's bytecode dispatcher) can cooperate with the GC
      * from a tight, allocation-free hot loop.
@@ -280,6 +292,7 @@ namespace proto
     void ProtoContext::safepoint()
     {
         if (!this || !this->space) return;
+        if (this->cellBatchDepth) this->spliceCellBatch();
 
 #ifdef PROTOCORE_GC_REINCLUDE_SURVIVORS
         // Per-context allocation-threshold submission.  This is the only
@@ -320,15 +333,12 @@ namespace proto
         // tree's cells in dirtySegments and unreachable from any root.
         if (this->criticalSectionDepth > 0) return;
 #endif
-        this->space->parkedThreads++;
-        {
-            GC_LOCK_TRACE("safepoint STW ACQ");
-            std::unique_lock<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-            this->space->gcCV.notify_all();
-            this->space->stopTheWorldCV.wait(lock, [this] { return !this->space->stwFlag.load(); });
-            GC_LOCK_TRACE("safepoint STW REL");
-        }
-        this->space->parkedThreads--;
+        GC_LOCK_TRACE("safepoint STW park");
+        if (this->thread)
+            toImpl<ProtoThreadImplementation>(this->thread)->implSynchToGC();
+        else
+            waitForWorldRestart(this->space);
+        GC_LOCK_TRACE("safepoint STW resume");
     }
 
     // 2026-05-25: thin wrappers around the thread-level unmanaged-region
@@ -351,6 +361,121 @@ namespace proto
         toImpl<ProtoThreadImplementation>(this->thread)->implReturnFromUnmanaged();
     }
 
+    void ProtoContext::enterNoGC(unsigned long reserveCells) {
+        if (!this || !this->thread) return;
+        toImpl<ProtoThreadImplementation>(this->thread)->implEnterNoGC(this, reserveCells);
+    }
+
+    void ProtoContext::exitNoGC() {
+        if (!this || !this->thread) return;
+        toImpl<ProtoThreadImplementation>(this->thread)->implExitNoGC();
+    }
+
+    void ProtoContext::allocCells(unsigned long count)
+    {
+        if (!this || !this->space) return;
+        if (this->cellBatchDepth++ > 0) {
+            if (this->reservedCount >= count) return;
+            // Topping up may park: the open batch's cells must be rooted.
+            this->spliceCellBatch();
+        }
+
+        // One stop-the-world poll for the whole batch, under the same rules
+        // as the every-64-allocations poll in allocCell.
+        if (this->space->stwFlag.load(std::memory_order_relaxed) &&
+            this->space->gcThread &&
+            std::this_thread::get_id() != this->space->gcThread->get_id()
+#ifdef PROTOCORE_GC_REINCLUDE_SURVIVORS
+            && this->criticalSectionDepth == 0
+#endif
+            ) {
+            if (this->thread)
+                toImpl<ProtoThreadImplementation>(this->thread)->implSynchToGC();
+            else
+                waitForWorldRestart(this->space);
+        }
+
+        const unsigned long wanted = count - this->reservedCount;
+        unsigned long taken = 0;
+        Cell* run = nullptr;
+        if (this->thread) {
+            run = toImpl<ProtoThreadImplementation>(this->thread)->implAllocCells(this, wanted, taken);
+        } else {
+            // Same freelist discipline as allocCell: never hold the
+            // per-context spinlock across getFreeCells.
+            Cell* tail = nullptr;
+            while (taken < wanted) {
+                while (lock.test_and_set(std::memory_order_acquire)) {}
+                Cell* first = this->freeCells;
+                Cell* last = first;
+                if (first) {
+                    ++taken;
+                    for (Cell* next; taken < wanted && (next = last->getNext()); last = next) ++taken;
+                    this->freeCells = last->getNext();
+                }
+                lock.clear(std::memory_order_release);
+                if (!first) {
+                    Cell* refill = this->space->getFreeCells(this);
+                    if (!refill) break;
+                    while (lock.test_and_set(std::memory_order_acquire)) {}
+                    this->freeCells = refill;
+                    lock.clear(std::memory_order_release);
+                    continue;
+                }
+                if (tail) tail->internalSetNextRaw(first);
+                else run = first;
+                tail = last;
+            }
+            if (tail) tail->internalSetNextRaw(nullptr);
+        }
+        if (!run) return;
+
+        if (this->reservedCells) {
+            Cell* last = run;
+            while (last->getNext()) last = last->getNext();
+            last->internalSetNextRaw(this->reservedCells);
+        }
+        this->reservedCells = run;
+        this->reservedCount += taken;
+        this->allocatedCellsCount += taken;
+    }
+
+    void ProtoContext::spliceCellBatch()
+    {
+        if (!this->batchYoungHead) return;
+        while (lock.test_and_set(std::memory_order_acquire)) {}
+        this->batchYoungTail->setNext(this->lastAllocatedCell);
+        this->lastAllocatedCell = this->batchYoungHead;
+        lock.clear(std::memory_order_release);
+        this->batchYoungHead = nullptr;
+        this->batchYoungTail = nullptr;
+    }
+
+    void ProtoContext::releaseCells()
+    {
+        if (!this || !this->cellBatchDepth || --this->cellBatchDepth > 0) return;
+        this->spliceCellBatch();
+        Cell* unused = this->reservedCells;
+        if (!unused) return;
+
+        // Unused cells are still zero but for their link: return them as is.
+        Cell* last = unused;
+        while (last->getNext()) last = last->getNext();
+        this->allocatedCellsCount -= this->reservedCount;
+        this->reservedCells = nullptr;
+        this->reservedCount = 0;
+        if (this->thread) {
+            ProtoThreadExtension* extension = toImpl<ProtoThreadImplementation>(this->thread)->extension;
+            last->internalSetNextRaw(extension->freeCells);
+            extension->freeCells = unused;
+        } else {
+            while (lock.test_and_set(std::memory_order_acquire)) {}
+            last->internalSetNextRaw(this->freeCells);
+            this->freeCells = unused;
+            lock.clear(std::memory_order_release);
+        }
+    }
+
     void ProtoContext::heapLimitCheckpoint()
     {
         ProtoSpace* sp = this->space;
@@ -361,6 +486,8 @@ namespace proto
         // re-validates the heap state under globalMutex before blocking.
         if (!sp || sp->maxHeapSize <= 0) return;
         if (sp->heapSize < sp->maxHeapSize) return;
+        // A no-GC region allocates from its reservation and must not block.
+        if (ProtoThreadImplementation::inNoGCRegion(sp)) return;
         // At the ceiling — block here, at criticalSectionDepth == 0, where the
         // thread holds no half-built tree and can safely yield to the GC.
         sp->waitForHeapHeadroom(this);
@@ -371,6 +498,21 @@ namespace proto
      */
     Cell* ProtoContext::allocCell()
     {
+        // Inside a cell batch (allocCells): hand out the reservation with no
+        // poll.  Past it, splice the batch's cells into the young chain
+        // first — the normal path below may park for the collector.
+        if (this && this->cellBatchDepth) {
+            if (Cell* reserved = this->reservedCells) {
+                this->reservedCells = reserved->getNext();
+                this->reservedCount--;
+                reserved->internalSetNextRaw(nullptr);
+                if (this->space->allocationSampling.load(std::memory_order_acquire))
+                    this->space->allocationProfiler->onAllocation(reserved);
+                return reserved;
+            }
+            this->spliceCellBatch();
+        }
+
         // Poll the stop-the-world flag every 64 allocations instead of every call.
         // A cooperative GC can tolerate a few-microsecond delay; this eliminates 63 out of 64
         // seq_cst atomic loads on the hot allocation path.
@@ -388,16 +530,12 @@ namespace proto
             && this->criticalSectionDepth == 0
 #endif
             ) {
-            this->space->parkedThreads++;
-            {
-                GC_LOCK_TRACE("allocCell STW ACQ");
-                std::unique_lock<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-                this->space->gcCV.notify_all();
-                this->space->stopTheWorldCV.wait(lock, [this] { return !this->space->stwFlag.load(); });
-                GC_LOCK_TRACE("allocCell STW ACQ(wake)");
-                GC_LOCK_TRACE("allocCell STW REL");
-            }
-            this->space->parkedThreads--;
+            GC_LOCK_TRACE("allocCell STW park");
+            if (this->thread)
+                toImpl<ProtoThreadImplementation>(this->thread)->implSynchToGC();
+            else
+                waitForWorldRestart(this->space);
+            GC_LOCK_TRACE("allocCell STW resume");
         }
 
         Cell* newCell = nullptr;
@@ -434,12 +572,21 @@ namespace proto
              // Absolute fall back (rare or error)
              int result = posix_memalign(reinterpret_cast<void**>(&newCell), 64, sizeof(BigCell));
              if (result != 0) return nullptr;
+             std::memset(newCell, 0, sizeof(BigCell));
         }
 
         if (newCell) {
-            std::memset(newCell, 0, 64);
+            // Free cells are already zero except for their link word: the
+            // sweep zeroes what it reclaims and fresh heap blocks come zeroed
+            // from the OS.  Clearing the link is the only store left here.
+            // The allocation profiler also reads a null vtable word as "not
+            // constructed yet" (AllocationProfiler::resolveType).
+            assert(isUnconstructed(newCell) && "free cell handed out with a stale vtable");
+            newCell->internalSetNextRaw(nullptr);
             if (this) {
                 this->allocatedCellsCount++;
+                if (this->space && this->space->allocationSampling.load(std::memory_order_acquire))
+                    this->space->allocationProfiler->onAllocation(newCell);
 #ifdef PROTOCORE_GC_REINCLUDE_SURVIVORS
                 // Per-context allocation-threshold submission.
                 //
@@ -483,7 +630,12 @@ namespace proto
      */
     void ProtoContext::addCell2Context(Cell* cell)
     {
-        if (this) {
+        if (this && this->cellBatchDepth) {
+            // Held back for one splice when the batch closes.
+            cell->setNext(this->batchYoungHead);
+            this->batchYoungHead = cell;
+            if (!this->batchYoungTail) this->batchYoungTail = cell;
+        } else if (this) {
             while (lock.test_and_set(std::memory_order_acquire)) {}
             cell->setNext(this->lastAllocatedCell);
             this->lastAllocatedCell = cell;
@@ -599,18 +751,11 @@ namespace proto
         if (n <= ProtoListSmallImplementation::MAX_INLINE) {
             return (new(this) ProtoListSmallImplementation(this, n, items))->asProtoList(this);
         }
-        // n > 5: produce the AVL form.  Build it in a single critical
-        // section via repeated appendLast over an empty AVL list — every
-        // intermediate is held in a C++ local, no half-built tree leaks
-        // to the GC's view between allocations.
+        // n > 5: produce the AVL form, built balanced bottom-up from one
+        // batch of n cells.  The subtrees are held in C++ locals until the
+        // root is built, hence the critical section.
         ProtoContext::CriticalSection cs(this);
-        const ProtoList* result =
-            (new(this) ProtoListImplementation(this, PROTO_NONE, true, nullptr, nullptr))
-                ->asProtoList(this);
-        for (unsigned i = 0; i < n; ++i) {
-            result = result->appendLast(this, items[i]);
-        }
-        return result;
+        return ProtoListImplementation::fromArray(this, items, n)->asProtoList(this);
     }
 
     const ProtoTuple* ProtoContext::newTuple()
@@ -695,17 +840,11 @@ namespace proto
     const ProtoObject* ProtoContext::newObject(const bool mutableObject)
     {
         unsigned long ref = mutableObject ? generate_mutable_ref(this) : 0;
-        // GC critical section: `attributes` is held in a C++ local across
-        // the wrapping ProtoObjectCell allocation.  Same discipline as
-        // ProtoObject::newChild (which already wraps); this is the
-        // simpler factory path used everywhere else.
-        ProtoContext::CriticalSection cs(this);
-        // ProtoObjectCell::attributes is a raw ProtoSparseListImplementation*
-        // (internal IMPL pointer) — pass an empty AVL impl directly. No
-        // tag, no public-API handle, no Small-form dispatch.
-        const ProtoSparseListImplementation* attributes = newSparseListImpl();
-        const ProtoObject* result = (new(this) ProtoObjectCell(this, nullptr, attributes, ref))->asObject(this);
-        return result;
+        // A fresh object has an empty AttributeStore: its first attributes
+        // are held in the object cell itself, and no attribute cell is
+        // allocated before the third.  One allocation, so no critical
+        // section is needed.
+        return (new(this) ProtoObjectCell(this, nullptr, AttributeStore(), ref))->asObject(this);
     }
 
     const ProtoObject* ProtoContext::newExternalBuffer(unsigned long size)
@@ -713,6 +852,30 @@ namespace proto
         return (new(this) ProtoExternalBufferImplementation(this, size))->implAsObject(this);
     }
 
+    const ProtoWeakRef* ProtoContext::newWeakRef(const ProtoObject* target, ProtoWeakClearCallback onClear, void* userData)
+    {
+        return reinterpret_cast<const ProtoWeakRef*>(
+            (new(this) ProtoWeakRefImplementation(this, target, onClear, userData))->implAsObject(this));
+    }
+
+    const ProtoWeakMap* ProtoContext::newWeakMap(ProtoWeakClearCallback onClear, void* userData)
+    {
+        return reinterpret_cast<const ProtoWeakMap*>(
+            (new(this) ProtoWeakMapImplementation(this, onClear, userData))->implAsObject(this));
+    }
+
+    const ProtoPromise* ProtoContext::newPromise()
+    {
+        return reinterpret_cast<const ProtoPromise*>(
+            (new(this) ProtoFutureImplementation(this))->implAsObject(this));
+    }
+
+    const ProtoChannel* ProtoContext::newChannel(unsigned long capacity)
+    {
+        return reinterpret_cast<const ProtoChannel*>(
+            (new(this) ProtoChannelImplementation(this, capacity))->implAsObject(this));
+    }
+
     const ProtoObject* ProtoContext::fromBoolean(bool value) {
         return value ? PROTO_TRUE : PROTO_FALSE;
     }
@@ -751,6 +914,10 @@ namespace proto
         return (new(this) ProtoMethodCell(this, self, method))->implAsObject(this);
     }
 
+    const ProtoObject* ProtoContext::fromFastMethod(ProtoObject* self, ProtoFastMethod method, ProtoMethod legacy) {
+        return (new(this) ProtoMethodCell(this, self, method, legacy))->implAsObject(this);
+    }
+
     const ProtoObject* ProtoContext::fromExternalPointer(void* pointer, void (*finalizer)(void*)) {
         return (new(this) ProtoExternalPointerImplementation(this, pointer, finalizer))->implAsObject(this);
     }
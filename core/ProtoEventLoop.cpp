@@ -0,0 +1,478 @@
+/*
+ * ProtoEventLoop.cpp
+ *
+ * Readiness-based I/O loop.  See ProtoEventLoop in protoCore.h for the
+ * public contract.
+ *
+ * Implementation outline:
+ *
+ *   - Each descriptor has at most one persistent watch, one pending read
+ *     and one pending write.  The kernel interest set is the union of
+ *     the three and is updated whenever it changes; a descriptor with no
+ *     interest left is dropped.  Level-triggered, so a transfer that hits
+ *     EAGAIN simply stays pending.
+ *
+ *   - The wait (epoll_wait or poll) runs in an unmanaged region: it only
+ *     touches the kernel and this Impl, never a ProtoObject.  Transfers
+ *     and callbacks run after returning to managed state, so a buffer
+ *     being filled is never moved or freed under us.
+ *
+ *   - Callback receivers and buffers are pinned in the loop's root set
+ *     while registered.  A callback's receiver is also anchored in its
+ *     callback context, so a watch may unwatch itself safely.
+ *
+ *   - `stop` writes to a wake descriptor (an eventfd, or a pipe where
+ *     there is none) that is always part of the wait.
+ */
+
+#include "../headers/proto_internal.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <initializer_list>
+#include <iostream>
+#include <poll.h>
+#include <queue>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace proto {
+
+struct ProtoEventLoop::Impl {
+    struct Callback {
+        ProtoMethod method = nullptr;
+        ProtoRootSet::Handle self = ProtoRootSet::kNullHandle;
+    };
+
+    struct Transfer {
+        Callback callback;
+        ProtoRootSet::Handle buffer = ProtoRootSet::kNullHandle;
+        char* data = nullptr;
+        unsigned long length = 0;
+        unsigned long done = 0;
+        bool active = false;
+    };
+
+    struct Descriptor {
+        unsigned int watched = 0;
+        Callback watcher;
+        Transfer reading;
+        Transfer writing;
+        unsigned int registered = 0;
+    };
+
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        unsigned long sequence;
+        Callback callback;
+        bool operator>(const Timer& other) const {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    ProtoSpace* space = nullptr;
+    ProtoRootSet* roots = nullptr;
+    std::unordered_map<int, Descriptor> descriptors;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    unsigned long timerSequence = 0;
+    std::atomic<bool> stopping{false};
+
+    int pollFd = -1;                // epoll instance (Linux only)
+    int wakeRead = -1;
+    int wakeWrite = -1;
+
+    Callback pin(ProtoMethod method, const ProtoObject* self);
+    void release(Callback& callback);
+    void release(Transfer& transfer);
+    bool update(int fd);
+    void wait(int timeout, std::vector<std::pair<int, unsigned int>>& ready);
+    void drainWake();
+    bool hasWork() const { return !descriptors.empty() || !timers.empty(); }
+    void invoke(ProtoContext* parent, const Callback& callback,
+                const ProtoList* (*args)(ProtoContext*, long, long), long a, long b,
+                std::initializer_list<ProtoRootSet::Handle> unpin = {});
+};
+
+namespace {
+
+    unsigned int interestOf(const ProtoEventLoop::Impl::Descriptor& d) {
+        unsigned int events = d.watched;
+        if (d.reading.active) events |= ProtoEventLoop::Readable;
+        if (d.writing.active) events |= ProtoEventLoop::Writable;
+        return events;
+    }
+
+    const ProtoList* noArgs(ProtoContext* context, long, long) {
+        return context->newList();
+    }
+
+    const ProtoList* pairArgs(ProtoContext* context, long a, long b) {
+        return context->newList()
+            ->appendLast(context, context->fromInteger(a))
+            ->appendLast(context, context->fromInteger(b));
+    }
+
+    // Sockets are written with MSG_NOSIGNAL so a peer that went away
+    // reports EPIPE instead of raising SIGPIPE.
+    long writeSome(int fd, const char* data, unsigned long length) {
+#if defined(MSG_NOSIGNAL)
+        long n = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == ENOTSOCK) n = ::write(fd, data, length);
+        return n;
+#else
+        return ::write(fd, data, length);
+#endif
+    }
+
+#if defined(__linux__)
+    unsigned int fromEpoll(uint32_t events) {
+        unsigned int out = 0;
+        if (events & EPOLLIN) out |= ProtoEventLoop::Readable;
+        if (events & EPOLLOUT) out |= ProtoEventLoop::Writable;
+        if (events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) out |= ProtoEventLoop::Closed;
+        return out;
+    }
+
+    uint32_t toEpoll(unsigned int events) {
+        uint32_t out = EPOLLRDHUP;
+        if (events & ProtoEventLoop::Readable) out |= EPOLLIN;
+        if (events & ProtoEventLoop::Writable) out |= EPOLLOUT;
+        return out;
+    }
+#endif
+
+}
+
+ProtoEventLoop::Impl::Callback ProtoEventLoop::Impl::pin(ProtoMethod method, const ProtoObject* self) {
+    return Callback{method, roots->add(self)};
+}
+
+void ProtoEventLoop::Impl::release(Callback& callback) {
+    roots->remove(callback.self);
+    callback = Callback{};
+}
+
+void ProtoEventLoop::Impl::release(Transfer& transfer) {
+    release(transfer.callback);
+    roots->remove(transfer.buffer);
+    transfer = Transfer{};
+}
+
+bool ProtoEventLoop::Impl::update(int fd) {
+    auto it = descriptors.find(fd);
+    if (it == descriptors.end()) return true;
+    Descriptor& d = it->second;
+    const unsigned int events = interestOf(d);
+    if (events == d.registered) {
+        if (events == 0) descriptors.erase(it);
+        return true;
+    }
+#if defined(__linux__)
+    epoll_event ev{};
+    ev.events = toEpoll(events);
+    ev.data.fd = fd;
+    int rc;
+    if (events == 0) {
+        // The descriptor may already be closed; nothing to undo then.
+        (void) epoll_ctl(pollFd, EPOLL_CTL_DEL, fd, nullptr);
+        rc = 0;
+    } else if (d.registered == 0) {
+        rc = epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev);
+        if (rc < 0 && errno == EEXIST) rc = epoll_ctl(pollFd, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        rc = epoll_ctl(pollFd, EPOLL_CTL_MOD, fd, &ev);
+        if (rc < 0 && errno == ENOENT) rc = epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    if (rc < 0) return false;
+#else
+    if (events != 0 && fcntl(fd, F_GETFD) < 0) return false;
+#endif
+    d.registered = events;
+    if (events == 0) descriptors.erase(it);
+    return true;
+}
+
+void ProtoEventLoop::Impl::wait(int timeout, std::vector<std::pair<int, unsigned int>>& ready) {
+#if defined(__linux__)
+    epoll_event events[64];
+    const int n = epoll_wait(pollFd, events, 64, timeout);
+    for (int i = 0; i < n; ++i)
+        ready.emplace_back(static_cast<int>(events[i].data.fd), fromEpoll(events[i].events));
+#else
+    std::vector<pollfd> fds;
+    fds.push_back(pollfd{wakeRead, POLLIN, 0});
+    for (const auto& entry : descriptors) {
+        short events = 0;
+        if (entry.second.registered & Readable) events |= POLLIN;
+        if (entry.second.registered & Writable) events |= POLLOUT;
+        fds.push_back(pollfd{entry.first, events, 0});
+    }
+    if (::poll(fds.data(), fds.size(), timeout) <= 0) return;
+    for (const pollfd& p : fds) {
+        if (!p.revents) continue;
+        unsigned int events = 0;
+        if (p.revents & POLLIN) events |= Readable;
+        if (p.revents & POLLOUT) events |= Writable;
+        if (p.revents & (POLLHUP | POLLERR | POLLNVAL)) events |= Closed;
+        ready.emplace_back(p.fd, events);
+    }
+#endif
+}
+
+void ProtoEventLoop::Impl::drainWake() {
+    char scratch[64];
+    while (::read(wakeRead, scratch, sizeof scratch) > 0) {}
+}
+
+// Runs `callback` in a fresh context.  The receiver is anchored there
+// before the pins in `unpin` are released.
+void ProtoEventLoop::Impl::invoke(ProtoContext* parent, const Callback& callback,
+                                  const ProtoList* (*args)(ProtoContext*, long, long), long a, long b,
+                                  std::initializer_list<ProtoRootSet::Handle> unpin) {
+    ProtoContext callbackContext(space, parent, nullptr, nullptr, nullptr, nullptr);
+    const ProtoObject* self = roots->resolve(callback.self);
+    if (self && ProtoObject::isCellPointer(self))
+        (void) new(&callbackContext) ReturnReference(&callbackContext, const_cast<Cell*>(ProtoObject::asCellPointer(self)));
+    for (ProtoRootSet::Handle h : unpin) roots->remove(h);
+    callback.method(&callbackContext, self, nullptr, args(&callbackContext, a, b), nullptr);
+}
+
+ProtoEventLoop::ProtoEventLoop(ProtoContext* context)
+    : impl_(new Impl{}) {
+    impl_->space = context->space;
+    impl_->roots = context->space->createRootSet("event-loop");
+#if defined(__linux__)
+    impl_->pollFd = epoll_create1(EPOLL_CLOEXEC);
+    impl_->wakeRead = impl_->wakeWrite = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = impl_->wakeRead;
+    epoll_ctl(impl_->pollFd, EPOLL_CTL_ADD, impl_->wakeRead, &ev);
+#else
+    int fds[2];
+    if (pipe(fds) == 0) {
+        for (int fd : fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        impl_->wakeRead = fds[0];
+        impl_->wakeWrite = fds[1];
+    }
+#endif
+    if (impl_->wakeRead < 0) {
+        std::cerr << "ProtoEventLoop: cannot create wake descriptor (errno " << errno << ")" << std::endl;
+        std::abort();
+    }
+}
+
+ProtoEventLoop::~ProtoEventLoop() {
+    impl_->space->destroyRootSet(impl_->roots);
+    if (impl_->wakeWrite != impl_->wakeRead) ::close(impl_->wakeWrite);
+    ::close(impl_->wakeRead);
+    if (impl_->pollFd >= 0) ::close(impl_->pollFd);
+    delete impl_;
+}
+
+bool ProtoEventLoop::watch(ProtoContext* /*context*/, int fd, unsigned int events,
+                           ProtoMethod callback, const ProtoObject* self) {
+    // Without a readiness bit the descriptor would be dropped by update()
+    // while its watcher stayed pinned.
+    if (fd < 0 || !callback || (events & (Readable | Writable)) == 0) return false;
+    Impl::Descriptor& d = impl_->descriptors[fd];
+    if (d.watched) impl_->release(d.watcher);
+    d.watched = events & (Readable | Writable);
+    d.watcher = impl_->pin(callback, self);
+    if (impl_->update(fd)) return true;
+    unwatch(nullptr, fd);
+    return false;
+}
+
+bool ProtoEventLoop::unwatch(ProtoContext* /*context*/, int fd) {
+    auto it = impl_->descriptors.find(fd);
+    if (it == impl_->descriptors.end() || !it->second.watched) return false;
+    impl_->release(it->second.watcher);
+    it->second.watched = 0;
+    impl_->update(fd);
+    return true;
+}
+
+bool ProtoEventLoop::read(ProtoContext* context, int fd, const ProtoByteBuffer* buffer,
+                          ProtoMethod callback, const ProtoObject* self,
+                          unsigned long offset, unsigned long length) {
+    if (fd < 0 || !buffer || !callback) return false;
+    const unsigned long size = buffer->getSize(context);
+    if (offset > size) return false;
+    if (length == 0 || length > size - offset) length = size - offset;
+    Impl::Descriptor& d = impl_->descriptors[fd];
+    if (d.reading.active) return false;
+    d.reading.callback = impl_->pin(callback, self);
+    d.reading.buffer = impl_->roots->add(buffer->asObject(context));
+    d.reading.data = buffer->getBuffer(context) + offset;
+    d.reading.length = length;
+    d.reading.active = true;
+    if (impl_->update(fd)) return true;
+    impl_->release(impl_->descriptors[fd].reading);
+    impl_->update(fd);
+    return false;
+}
+
+bool ProtoEventLoop::write(ProtoContext* context, int fd, const ProtoByteBuffer* buffer,
+                           ProtoMethod callback, const ProtoObject* self,
+                           unsigned long offset, unsigned long length) {
+    if (fd < 0 || !buffer || !callback) return false;
+    const unsigned long size = buffer->getSize(context);
+    if (offset > size) return false;
+    if (length == 0 || length > size - offset) length = size - offset;
+    Impl::Descriptor& d = impl_->descriptors[fd];
+    if (d.writing.active) return false;
+    d.writing.callback = impl_->pin(callback, self);
+    d.writing.buffer = impl_->roots->add(buffer->asObject(context));
+    d.writing.data = buffer->getBuffer(context) + offset;
+    d.writing.length = length;
+    d.writing.active = true;
+    if (impl_->update(fd)) return true;
+    impl_->release(impl_->descriptors[fd].writing);
+    impl_->update(fd);
+    return false;
+}
+
+void ProtoEventLoop::setTimeout(ProtoContext* /*context*/, unsigned long milliseconds,
+                                ProtoMethod callback, const ProtoObject* self) {
+    if (!callback) return;
+    impl_->timers.push(Impl::Timer{
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds),
+        impl_->timerSequence++,
+        impl_->pin(callback, self)});
+}
+
+unsigned long ProtoEventLoop::runOnce(ProtoContext* context, long milliseconds) {
+    using Clock = std::chrono::steady_clock;
+    Impl* loop = impl_;
+
+    long timeout = milliseconds;
+    if (!loop->timers.empty()) {
+        const auto untilDue = std::chrono::ceil<std::chrono::milliseconds>(loop->timers.top().due - Clock::now()).count();
+        const long next = untilDue > 0 ? static_cast<long>(untilDue) : 0;
+        if (timeout < 0 || next < timeout) timeout = next;
+    }
+
+    std::vector<std::pair<int, unsigned int>> ready;
+    {
+        ProtoContext::UnmanagedScope unmanaged(context);
+        loop->wait(static_cast<int>(std::min(timeout, 0x7fffffffL)), ready);
+    }
+
+    unsigned long ran = 0;
+    for (const auto& [fd, events] : ready) {
+        if (fd == loop->wakeRead) {
+            loop->drainWake();
+            continue;
+        }
+
+        auto it = loop->descriptors.find(fd);
+        if (it != loop->descriptors.end() && it->second.reading.active && (events & (Readable | Closed))) {
+            Impl::Transfer& t = it->second.reading;
+            long n = ::read(fd, t.data, t.length);
+            if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                if (n < 0) n = -errno;
+                const Impl::Callback callback = t.callback;
+                const ProtoRootSet::Handle buffer = t.buffer;
+                t = Impl::Transfer{};
+                loop->update(fd);
+                loop->invoke(context, callback, pairArgs, fd, n, {callback.self, buffer});
+                ++ran;
+            }
+        }
+
+        it = loop->descriptors.find(fd);
+        if (it != loop->descriptors.end() && it->second.writing.active && (events & (Writable | Closed))) {
+            Impl::Transfer& t = it->second.writing;
+            long result = 0;
+            while (t.done < t.length) {
+                const long n = writeSome(fd, t.data + t.done, t.length - t.done);
+                if (n < 0) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) result = -errno;
+                    break;
+                }
+                t.done += static_cast<unsigned long>(n);
+            }
+            if (result < 0 || t.done == t.length) {
+                if (result == 0) result = static_cast<long>(t.done);
+                const Impl::Callback callback = t.callback;
+                const ProtoRootSet::Handle buffer = t.buffer;
+                t = Impl::Transfer{};
+                loop->update(fd);
+                loop->invoke(context, callback, pairArgs, fd, result, {callback.self, buffer});
+                ++ran;
+            }
+        }
+
+        it = loop->descriptors.find(fd);
+        if (it != loop->descriptors.end() && it->second.watched) {
+            const unsigned int fired = events & (it->second.watched | Closed);
+            if (fired) {
+                const Impl::Callback callback = it->second.watcher;
+                loop->invoke(context, callback, pairArgs, fd, fired);
+                ++ran;
+            }
+        }
+    }
+
+    // Timers due now; ones added by these callbacks wait for the next turn.
+    const auto now = Clock::now();
+    std::vector<Impl::Timer> due;
+    while (!loop->timers.empty() && loop->timers.top().due <= now) {
+        due.push_back(loop->timers.top());
+        loop->timers.pop();
+    }
+    for (const Impl::Timer& timer : due) {
+        loop->invoke(context, timer.callback, noArgs, 0, 0, {timer.callback.self});
+        ++ran;
+    }
+    return ran;
+}
+
+void ProtoEventLoop::run(ProtoContext* context) {
+    while (!impl_->stopping.load(std::memory_order_acquire) && impl_->hasWork()) {
+        runOnce(context, -1);
+        context->safepoint();
+    }
+    impl_->stopping.store(false, std::memory_order_release);
+}
+
+void ProtoEventLoop::stop() {
+    impl_->stopping.store(true, std::memory_order_release);
+    // Eight bytes suit both an eventfd counter and a pipe.
+    const uint64_t one = 1;
+    const ssize_t written = ::write(impl_->wakeWrite, &one, sizeof one);
+    (void) written;
+}
+
+// ---- ProtoSpace integration -------------------------------------------
+
+ProtoEventLoop* ProtoSpace::createEventLoop(ProtoContext* context) {
+    auto* loop = new ProtoEventLoop(context);
+    std::lock_guard<std::mutex> lock(eventLoopsMutex_);
+    eventLoops_.push_back(loop);
+    return loop;
+}
+
+void ProtoSpace::destroyEventLoop(ProtoContext* /*context*/, ProtoEventLoop* loop) {
+    if (!loop) return;
+    {
+        std::lock_guard<std::mutex> lock(eventLoopsMutex_);
+        auto it = std::find(eventLoops_.begin(), eventLoops_.end(), loop);
+        if (it != eventLoops_.end()) eventLoops_.erase(it);
+    }
+    delete loop;
+}
+
+} // namespace proto
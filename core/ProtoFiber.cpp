@@ -0,0 +1,445 @@
+/*
+ * ProtoFiber.cpp
+ *
+ * Stackful fibers.  See ProtoFiber in protoCore.h for the public contract.
+ *
+ * Every fiber owns one anonymous mapping: a guard page at the bottom, the
+ * machine stack, and the fiber's control block (ProtoFiber::Impl) at the
+ * top.  Its base ProtoContext lives on the heap so that it outlives the
+ * stack frames above it.
+ *
+ * Context chains.  While a fiber runs, `base->previous` points at the
+ * resumer's context and the thread's current context is the fiber's
+ * innermost one, so thread root scanning covers fiber and resumer alike
+ * and ~ProtoContext inside the fiber behaves as on any other stack.  On
+ * yield the chain is cut again (`base->previous = nullptr`), the thread
+ * gets the resumer's context back, and the fiber's innermost context is
+ * left in `top` for collectSuspendedFiberContexts.  None of this can be
+ * observed half-done: the owning thread reaches no safepoint in between.
+ *
+ * Values crossing a switch are anchored with a ReturnReference in the
+ * receiving context before the switch, the same way ~ProtoContext hands a
+ * return value to its caller.  When the fiber's method returns, deleting
+ * the base context (with `previous` pointing at the resumer) does exactly
+ * that for the result.
+ */
+
+#include "../headers/proto_internal.h"
+#include <cstring>
+#include <exception>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(__x86_64__) || defined(PROTOCORE_FIBER_UCONTEXT)
+#define PROTO_FIBER_USE_UCONTEXT 1
+#include <ucontext.h>
+#endif
+
+#ifndef PROTO_FIBER_USE_UCONTEXT
+// proto_fiber_switch(save, load): push the callee-saved registers and the
+// SSE/x87 control words, store rsp in *save, switch to `load` and pop the
+// same frame from there.  A fresh stack starts in proto_fiber_trampoline
+// with the entry point in r13 and its argument in r12.
+asm(R"(
+    .text
+    .globl proto_fiber_switch
+    .hidden proto_fiber_switch
+    .type proto_fiber_switch,@function
+proto_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size proto_fiber_switch,.-proto_fiber_switch
+
+    .globl proto_fiber_trampoline
+    .hidden proto_fiber_trampoline
+    .type proto_fiber_trampoline,@function
+proto_fiber_trampoline:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size proto_fiber_trampoline,.-proto_fiber_trampoline
+)");
+
+extern "C" void proto_fiber_switch(void** save, void* load);
+extern "C" void proto_fiber_trampoline();
+#endif
+
+namespace proto {
+
+struct ProtoFiber::Impl : ProtoFiber {
+    enum class State { Suspended, Running, Finished };
+
+    ProtoSpace* space = nullptr;
+    ProtoThread* thread = nullptr;
+    ProtoMethod method = nullptr;
+    const ProtoObject* self = nullptr;
+    const ProtoList* args = nullptr;
+    const ProtoSparseList* kwargs = nullptr;
+
+    ProtoContext* base = nullptr;
+    ProtoContext* top = nullptr;
+    ProtoContext* resumer = nullptr;
+    // Where the thread's handle scopes stood when resume entered the
+    // fiber; yield checks that the fiber left them there.
+    const HandleBlock* handleBlock = nullptr;
+    unsigned int handleUsed = 0;
+    const ProtoObject* transfer = PROTO_NONE;
+    std::exception_ptr error;
+    State state = State::Suspended;
+
+#ifdef PROTO_FIBER_USE_UCONTEXT
+    ucontext_t fiberMachine{};
+    ucontext_t resumerMachine{};
+#else
+    void* fiberSp = nullptr;
+    void* resumerSp = nullptr;
+#endif
+
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+
+    // Space registry.
+    Impl* prev = nullptr;
+    Impl* next = nullptr;
+
+    // The fiber running on this OS thread, if any.
+    static thread_local Impl* running;
+
+    void switchIn();
+    void switchOut();
+    [[noreturn]] void run();
+};
+
+thread_local ProtoFiber::Impl* ProtoFiber::Impl::running = nullptr;
+
+namespace {
+
+    constexpr size_t kDefaultStackSize = 128 * 1024;
+
+    // Mappings of the default size freed on this thread, reused by the next
+    // fibers it creates.  Creating a fiber then costs no system call.
+    struct StackCache {
+        static constexpr size_t kMax = 64;
+        void* mappings[kMax];
+        size_t count = 0;
+
+        ~StackCache() {
+            while (count) munmap(mappings[--count], kDefaultStackSize + pageSize());
+        }
+
+        static size_t pageSize() {
+            static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return size;
+        }
+    };
+    thread_local StackCache stackCache;
+
+    void* mapStack(size_t mappingSize, bool cacheable) {
+        if (cacheable && stackCache.count) return stackCache.mappings[--stackCache.count];
+        void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (mapping == MAP_FAILED) throw std::bad_alloc();
+        // Guard page: overflowing the fiber stack faults instead of
+        // silently overwriting whatever is mapped below it.
+        mprotect(mapping, StackCache::pageSize(), PROT_NONE);
+        return mapping;
+    }
+
+    void unmapStack(void* mapping, size_t mappingSize) {
+        if (mappingSize == kDefaultStackSize + StackCache::pageSize() &&
+            stackCache.count < StackCache::kMax) {
+            stackCache.mappings[stackCache.count++] = mapping;
+            return;
+        }
+        munmap(mapping, mappingSize);
+    }
+
+    void anchor(ProtoContext* context, const ProtoObject* value) {
+        if (value && ProtoObject::isCellPointer(value))
+            (void) new(context) ReturnReference(context, const_cast<Cell*>(ProtoObject::asCellPointer(value)));
+    }
+
+    ProtoThreadImplementation* threadOf(const ProtoFiber::Impl* fiber) {
+        return toImpl<ProtoThreadImplementation>(fiber->thread);
+    }
+
+    [[noreturn]] void fiberMisuse(const char* what) {
+        std::cerr << "ProtoFiber: " << what << std::endl;
+        std::abort();
+    }
+
+#ifdef PROTO_FIBER_USE_UCONTEXT
+    void fiberEntry(unsigned int hi, unsigned int lo) {
+        const uintptr_t bits = (static_cast<uintptr_t>(hi) << 32) | lo;
+        reinterpret_cast<ProtoFiber::Impl*>(bits)->run();
+    }
+#else
+    void fiberEntry(ProtoFiber::Impl* fiber) {
+        fiber->run();
+    }
+#endif
+
+    // Abandons the frames of an unfinished fiber: hands every young chain
+    // of its context chain to the collector and frees the base context.
+    // `context` is the caller's current context.
+    void abandon(ProtoFiber::Impl* fiber, ProtoContext* context) {
+        if (!fiber->base) return;
+        for (ProtoContext* ctx = fiber->top; ctx && ctx != fiber->base; ctx = ctx->previous) {
+            if (ctx->lastAllocatedCell) fiber->space->submitYoungGeneration(ctx->lastAllocatedCell);
+            ctx->lastAllocatedCell = nullptr;
+        }
+        // ~ProtoContext makes `previous` the thread's current context
+        // again; point it at the caller so nothing changes.
+        fiber->base->previous = context;
+        fiber->base->returnValue = nullptr;
+        delete fiber->base;
+        fiber->base = fiber->top = nullptr;
+    }
+
+    void unregisterFiber(ProtoSpace* space, ProtoFiber::Impl* fiber) {
+        std::lock_guard<std::mutex> lock(space->fibersMutex_);
+        if (fiber->prev) fiber->prev->next = fiber->next;
+        else space->fibers_ = fiber->next;
+        if (fiber->next) fiber->next->prev = fiber->prev;
+    }
+
+    void freeFiber(ProtoFiber::Impl* fiber) {
+        void* mapping = fiber->mapping;
+        const size_t mappingSize = fiber->mappingSize;
+        fiber->~Impl();
+        unmapStack(mapping, mappingSize);
+    }
+
+}
+
+void ProtoFiber::Impl::switchIn() {
+#ifdef PROTO_FIBER_USE_UCONTEXT
+    swapcontext(&resumerMachine, &fiberMachine);
+#else
+    proto_fiber_switch(&resumerSp, fiberSp);
+#endif
+}
+
+void ProtoFiber::Impl::switchOut() {
+#ifdef PROTO_FIBER_USE_UCONTEXT
+    swapcontext(&fiberMachine, &resumerMachine);
+#else
+    proto_fiber_switch(&fiberSp, resumerSp);
+#endif
+}
+
+void ProtoFiber::Impl::run() {
+    const ProtoObject* result = PROTO_NONE;
+    try {
+        result = method(base, self, nullptr, args, kwargs);
+        if (!result) result = PROTO_NONE;
+    } catch (...) {
+        error = std::current_exception();
+        result = PROTO_NONE;
+    }
+
+    // Every context the method opened is gone, so base is current again.
+    // Deleting it anchors the result in the resumer and makes the
+    // resumer's context current.
+    ProtoContext* finished = base;
+    base = top = nullptr;
+    state = State::Finished;
+    finished->previous = resumer;
+    finished->returnValue = result;
+    delete finished;
+
+    transfer = result;
+    switchOut();
+    __builtin_unreachable();
+}
+
+const ProtoObject* ProtoFiber::resume(ProtoContext* context, const ProtoObject* value) {
+    auto* fiber = static_cast<Impl*>(this);
+    if (fiber->state == Impl::State::Finished) return PROTO_NONE;
+    if (fiber->state == Impl::State::Running) fiberMisuse("resume of a running fiber");
+    if (context->thread != fiber->thread) fiberMisuse("resumed on a thread other than its creator");
+
+    anchor(fiber->top, value);
+    fiber->transfer = value ? value : PROTO_NONE;
+    fiber->resumer = context;
+    fiber->base->previous = context;
+    fiber->state = Impl::State::Running;
+    threadOf(fiber)->implSetCurrentContext(fiber->top);
+    // Scopes share the thread's HandleArea with the resumer's, in LIFO
+    // order.  Install it now so that a fiber's first scope does not move
+    // the position yield compares against.
+    ProtoThreadExtension* ext = threadOf(fiber)->extension;
+    if (!ext->handles) ext->handles = new HandleArea();
+    fiber->handleBlock = ext->handles->current;
+    fiber->handleUsed = ext->handles->used;
+
+    Impl* outer = Impl::running;
+    Impl::running = fiber;
+    fiber->switchIn();
+    Impl::running = outer;
+
+    const ProtoObject* out = fiber->transfer;
+    fiber->transfer = PROTO_NONE;
+    if (fiber->error) {
+        std::exception_ptr error = fiber->error;
+        fiber->error = nullptr;
+        std::rethrow_exception(error);
+    }
+    return out;
+}
+
+const ProtoObject* ProtoFiber::yield(ProtoContext* context, const ProtoObject* value) {
+    Impl* fiber = Impl::running;
+    if (!fiber) fiberMisuse("yield outside a fiber");
+    const HandleArea* handles = threadOf(fiber)->extension->handles;
+    if (handles->current != fiber->handleBlock || handles->used != fiber->handleUsed)
+        fiberMisuse("yield inside a handle scope");
+
+    anchor(fiber->resumer, value);
+    fiber->transfer = value ? value : PROTO_NONE;
+    fiber->top = threadOf(fiber)->context;
+    fiber->base->previous = nullptr;
+    fiber->state = Impl::State::Suspended;
+    threadOf(fiber)->implSetCurrentContext(fiber->resumer);
+
+    fiber->switchOut();
+
+    // Resumed: resume() already made our innermost context current.
+    const ProtoObject* in = fiber->transfer;
+    fiber->transfer = PROTO_NONE;
+    return in;
+}
+
+bool ProtoFiber::isFinished() const {
+    return static_cast<const Impl*>(this)->state == Impl::State::Finished;
+}
+
+// ---- Collector support ------------------------------------------------
+
+void collectSuspendedFiberContexts(ProtoSpace* space, std::vector<ProtoContext*>& out) {
+    std::lock_guard<std::mutex> lock(space->fibersMutex_);
+    for (ProtoFiber::Impl* fiber = space->fibers_; fiber; fiber = fiber->next) {
+        if (fiber->state == ProtoFiber::Impl::State::Suspended && fiber->top)
+            out.push_back(fiber->top);
+    }
+}
+
+void releaseFibers(ProtoSpace* space) {
+    ProtoFiber::Impl* fibers;
+    {
+        std::lock_guard<std::mutex> lock(space->fibersMutex_);
+        fibers = space->fibers_;
+        space->fibers_ = nullptr;
+    }
+    while (fibers) {
+        ProtoFiber::Impl* next = fibers->next;
+        abandon(fibers, space->rootContext);
+        freeFiber(fibers);
+        fibers = next;
+    }
+}
+
+// ---- ProtoSpace integration -------------------------------------------
+
+ProtoFiber* ProtoSpace::createFiber(ProtoContext* context, ProtoMethod method,
+                                   const ProtoObject* self,
+                                   const ProtoList* args,
+                                   const ProtoSparseList* kwargs,
+                                   size_t stackSize) {
+    if (!context || !context->thread) fiberMisuse("context has no owning thread");
+
+    const size_t page = StackCache::pageSize();
+    if (stackSize == 0) stackSize = kDefaultStackSize;
+    stackSize = (stackSize + page - 1) & ~(page - 1);
+    const size_t mappingSize = stackSize + page;
+    void* mapping = mapStack(mappingSize, stackSize == kDefaultStackSize);
+
+    // Control block at the top of the mapping, stack right below it.
+    char* limit = static_cast<char*>(mapping) + mappingSize;
+    auto* fiber = new (reinterpret_cast<void*>(
+        (reinterpret_cast<uintptr_t>(limit) - sizeof(ProtoFiber::Impl)) & ~uintptr_t(63))) ProtoFiber::Impl();
+    fiber->mapping = mapping;
+    fiber->mappingSize = mappingSize;
+    fiber->space = this;
+    fiber->thread = context->thread;
+    fiber->method = method;
+    fiber->self = self;
+    fiber->args = args;
+    fiber->kwargs = kwargs;
+
+    const uintptr_t stackTop = reinterpret_cast<uintptr_t>(fiber) & ~uintptr_t(15);
+#ifdef PROTO_FIBER_USE_UCONTEXT
+    getcontext(&fiber->fiberMachine);
+    fiber->fiberMachine.uc_stack.ss_sp = static_cast<char*>(mapping) + page;
+    fiber->fiberMachine.uc_stack.ss_size = stackTop - reinterpret_cast<uintptr_t>(fiber->fiberMachine.uc_stack.ss_sp);
+    fiber->fiberMachine.uc_link = nullptr;
+    const auto bits = reinterpret_cast<uintptr_t>(fiber);
+    makecontext(&fiber->fiberMachine, reinterpret_cast<void (*)()>(fiberEntry), 2,
+                static_cast<unsigned int>(bits >> 32), static_cast<unsigned int>(bits));
+#else
+    // The frame proto_fiber_switch pops: control words, r15..r12, rbx,
+    // rbp, return address.  After the `ret` rsp is 16-byte aligned, as
+    // the trampoline's call expects.
+    auto* frame = reinterpret_cast<uint64_t*>(stackTop - 16 - 8 * sizeof(uint64_t));
+    std::memset(frame, 0, 8 * sizeof(uint64_t));
+    const uint32_t mxcsr = 0x1F80;
+    const uint16_t fpucw = 0x037F;
+    std::memcpy(reinterpret_cast<char*>(frame), &mxcsr, sizeof(mxcsr));
+    std::memcpy(reinterpret_cast<char*>(frame) + 4, &fpucw, sizeof(fpucw));
+    frame[3] = reinterpret_cast<uint64_t>(&fiberEntry);          // r13
+    frame[4] = reinterpret_cast<uint64_t>(fiber);                // r12
+    frame[7] = reinterpret_cast<uint64_t>(&proto_fiber_trampoline);
+    fiber->fiberSp = frame;
+#endif
+
+    // The base context is built as a child of the creator (to inherit its
+    // thread) and then cut loose; building it made it the thread's
+    // current context, so hand that back.
+    fiber->base = new ProtoContext(this, context, nullptr, nullptr, nullptr, nullptr);
+    fiber->base->previous = nullptr;
+    toImpl<ProtoThreadImplementation>(context->thread)->implSetCurrentContext(context);
+    fiber->top = fiber->base;
+
+    {
+        std::lock_guard<std::mutex> lock(fibersMutex_);
+        fiber->next = fibers_;
+        if (fibers_) fibers_->prev = fiber;
+        fibers_ = fiber;
+    }
+
+    // Until the first resume, only the control block refers to these.
+    anchor(fiber->base, self);
+    if (args) anchor(fiber->base, args->asObject(context));
+    if (kwargs) anchor(fiber->base, kwargs->asObject(context));
+    return fiber;
+}
+
+void ProtoSpace::destroyFiber(ProtoContext* context, ProtoFiber* fiber) {
+    if (!fiber) return;
+    auto* impl = static_cast<ProtoFiber::Impl*>(fiber);
+    if (impl->state == ProtoFiber::Impl::State::Running) fiberMisuse("destroy of a running fiber");
+    unregisterFiber(this, impl);
+    abandon(impl, context);
+    freeFiber(impl);
+}
+
+} // namespace proto
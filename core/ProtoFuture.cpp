@@ -0,0 +1,257 @@
+/*
+ * ProtoFuture.cpp
+ *
+ * Futures and promises.  A ProtoFuture and its ProtoPromise are two views of
+ * one ProtoFutureImplementation cell; the public pointers differ only in
+ * their C++ type.
+ *
+ * Settling is a CAS from Pending to Settling (first settler wins), a store
+ * of the value, then a store of the final state.  Waiters and `then` publish
+ * the waiter table before checking the state, and settlers check for the
+ * table after storing the final state; with both sides sequentially
+ * consistent, one of them always sees the other, so no wakeup or
+ * continuation is lost without taking a lock on the fast path.
+ */
+
+#include "../headers/proto_internal.h"
+#include <exception>
+
+namespace proto {
+
+    namespace {
+
+        // Runs a fulfilled future's continuation.  args: the derived future,
+        // the value, and the continuation's method as an external pointer.
+        const ProtoObject* continuationMain(
+            ProtoContext* context,
+            const ProtoObject* self,
+            const ParentLink* /*parentLink*/,
+            const ProtoList* args,
+            const ProtoSparseList* /*kwargs*/
+        ) {
+            const auto* derived = toImpl<const ProtoFutureImplementation>(
+                args->getAt(context, 0)->asFuture(context));
+            const ProtoObject* value = args->getAt(context, 1);
+            const auto method = reinterpret_cast<ProtoMethod>(
+                args->getAt(context, 2)->asExternalPointer(context)->getPointer(context));
+            try {
+                const ProtoObject* result = method(context, self, nullptr,
+                    context->newList()->appendLast(context, value), nullptr);
+                derived->implSettle(context, result, false);
+            } catch (const std::exception& e) {
+                derived->implSettle(context, context->fromUTF8String(e.what()), true);
+            } catch (...) {
+                derived->implSettle(context, context->fromUTF8String("unknown exception"), true);
+            }
+            return PROTO_NONE;
+        }
+
+        void dispatch(ProtoContext* context, const ProtoFutureImplementation::Continuation& c,
+                      const ProtoObject* value, bool rejected) {
+            if (rejected) {
+                c.derived->implSettle(context, value, true);
+                return;
+            }
+            const ProtoList* args = context->newList()
+                ->appendLast(context, c.derived->implAsObject(context))
+                ->appendLast(context, value)
+                ->appendLast(context, context->fromExternalPointer(reinterpret_cast<void*>(c.method)));
+            if (c.pool) {
+                c.pool->post(context, continuationMain, c.self, args);
+            } else {
+                ProtoContext inline_(context->space, context, nullptr, nullptr, nullptr, nullptr);
+                continuationMain(&inline_, c.self, nullptr, args, nullptr);
+            }
+        }
+
+        void reportIfCell(ProtoContext* context, void* self,
+                          void (*method)(ProtoContext*, void*, const Cell*),
+                          const ProtoObject* obj) {
+            if (obj && ProtoObject::isCellPointer(obj))
+                method(context, self, ProtoObject::asCellPointer(obj));
+        }
+
+    }
+
+    ProtoFutureImplementation::ProtoFutureImplementation(ProtoContext* context)
+        : Cell(context), value(nullptr), state(Pending), waiters(nullptr)
+    {
+    }
+
+    const ProtoObject* ProtoFutureImplementation::implAsObject(ProtoContext* context) const {
+        ProtoObjectPointer p{};
+        p.futureImplementation = this;
+        p.op.pointer_tag = POINTER_TAG_FUTURE;
+        return p.oid;
+    }
+
+    ProtoFutureImplementation::Waiters* ProtoFutureImplementation::ensureWaiters(ProtoContext* context) const {
+        Waiters* w = waiters.load();
+        if (w) return w;
+        auto* fresh = new Waiters();
+        if (!waiters.compare_exchange_strong(w, fresh)) {
+            delete fresh;
+            return w;
+        }
+        std::lock_guard<std::mutex> lock(context->space->futureCellsMutex_);
+        context->space->futureCells_.insert(this);
+        return fresh;
+    }
+
+    bool ProtoFutureImplementation::implIsSettled() const {
+        return state.load() >= Fulfilled;
+    }
+
+    bool ProtoFutureImplementation::implSettle(ProtoContext* context, const ProtoObject* result, bool rejected) const {
+        int expected = Pending;
+        if (!state.compare_exchange_strong(expected, Settling)) return false;
+        if (!result) result = PROTO_NONE;
+        value.store(result);
+        state.store(rejected ? Rejected : Fulfilled);
+
+        Waiters* w = waiters.load();
+        if (!w) return true;
+        std::vector<Continuation> ready;
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            for (Continuation& c : w->continuations) {
+                if (c.dispatched) continue;
+                c.dispatched = true;
+                ready.push_back(c);
+            }
+        }
+        w->cv.notify_all();
+        for (const Continuation& c : ready) dispatch(context, c, result, rejected);
+        return true;
+    }
+
+    bool ProtoFutureImplementation::implWaitFor(ProtoContext* context, long milliseconds) const {
+        if (implIsSettled()) return true;
+        Waiters* w = ensureWaiters(context);
+        ProtoContext::UnmanagedScope unmanaged(context);
+        std::unique_lock<std::mutex> lock(w->mutex);
+        auto settled = [this] { return implIsSettled(); };
+        if (milliseconds < 0) {
+            w->cv.wait(lock, settled);
+            return true;
+        }
+        return w->cv.wait_for(lock, std::chrono::milliseconds(milliseconds), settled);
+    }
+
+    const ProtoFutureImplementation* ProtoFutureImplementation::implThen(
+        ProtoContext* context, ProtoMethod method, const ProtoObject* self, ProtoTaskPool* pool) const
+    {
+        const auto* derived = new(context) ProtoFutureImplementation(context);
+        Continuation c{method, self, derived, pool, false};
+        if (!implIsSettled()) {
+            Waiters* w = ensureWaiters(context);
+            std::lock_guard<std::mutex> lock(w->mutex);
+            if (!implIsSettled()) {
+                w->continuations.push_back(c);
+                return derived;
+            }
+        }
+        dispatch(context, c, value.load(), state.load() == Rejected);
+        return derived;
+    }
+
+    void ProtoFutureImplementation::processReferences(
+        ProtoContext* context,
+        void* self,
+        void (*method)(ProtoContext*, void*, const Cell*)
+    ) const {
+        reportIfCell(context, self, method, value.load());
+        Waiters* w = waiters.load();
+        if (!w) return;
+        std::lock_guard<std::mutex> lock(w->mutex);
+        for (const Continuation& c : w->continuations) {
+            reportIfCell(context, self, method, c.self);
+            method(context, self, c.derived);
+        }
+    }
+
+    void ProtoFutureImplementation::finalize(ProtoContext* context) const {
+        Waiters* w = waiters.exchange(nullptr);
+        if (!w) return;
+        {
+            std::lock_guard<std::mutex> lock(context->space->futureCellsMutex_);
+            context->space->futureCells_.erase(this);
+        }
+        delete w;
+    }
+
+    unsigned long ProtoFutureImplementation::getHash(ProtoContext* /*context*/) const {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    void releaseFutureTables(ProtoSpace* space) {
+        std::lock_guard<std::mutex> lock(space->futureCellsMutex_);
+        for (const Cell* cell : space->futureCells_) {
+            const auto* future = static_cast<const ProtoFutureImplementation*>(cell);
+            delete future->waiters.exchange(nullptr);
+        }
+        space->futureCells_.clear();
+    }
+
+}
+
+namespace proto {
+
+    const ProtoObject* ProtoFuture::get(ProtoContext* context) const {
+        const auto* impl = toImpl<const ProtoFutureImplementation>(this);
+        impl->implWaitFor(context, -1);
+        return impl->state.load() == ProtoFutureImplementation::Fulfilled ? impl->value.load() : nullptr;
+    }
+
+    bool ProtoFuture::waitFor(ProtoContext* context, unsigned long milliseconds) const {
+        return toImpl<const ProtoFutureImplementation>(this)->implWaitFor(context, static_cast<long>(milliseconds));
+    }
+
+    bool ProtoFuture::isReady(ProtoContext* /*context*/) const {
+        return toImpl<const ProtoFutureImplementation>(this)->implIsSettled();
+    }
+
+    bool ProtoFuture::isRejected(ProtoContext* /*context*/) const {
+        return toImpl<const ProtoFutureImplementation>(this)->state.load() == ProtoFutureImplementation::Rejected;
+    }
+
+    const ProtoObject* ProtoFuture::getError(ProtoContext* /*context*/) const {
+        const auto* impl = toImpl<const ProtoFutureImplementation>(this);
+        return impl->state.load() == ProtoFutureImplementation::Rejected ? impl->value.load() : nullptr;
+    }
+
+    const ProtoFuture* ProtoFuture::then(ProtoContext* context, ProtoMethod method,
+                                         const ProtoObject* self, ProtoTaskPool* pool) const {
+        const auto* derived = toImpl<const ProtoFutureImplementation>(this)->implThen(context, method, self, pool);
+        return reinterpret_cast<const ProtoFuture*>(derived->implAsObject(context));
+    }
+
+    const ProtoObject* ProtoFuture::asObject(ProtoContext* context) const {
+        return toImpl<const ProtoFutureImplementation>(this)->implAsObject(context);
+    }
+
+    unsigned long ProtoFuture::getHash(ProtoContext* context) const {
+        return toImpl<const ProtoFutureImplementation>(this)->getHash(context);
+    }
+
+    bool ProtoPromise::resolve(ProtoContext* context, const ProtoObject* value) const {
+        return toImpl<const ProtoFutureImplementation>(this)->implSettle(context, value, false);
+    }
+
+    bool ProtoPromise::reject(ProtoContext* context, const ProtoObject* error) const {
+        return toImpl<const ProtoFutureImplementation>(this)->implSettle(context, error, true);
+    }
+
+    const ProtoFuture* ProtoPromise::getFuture(ProtoContext* /*context*/) const {
+        return reinterpret_cast<const ProtoFuture*>(this);
+    }
+
+    const ProtoObject* ProtoPromise::asObject(ProtoContext* context) const {
+        return toImpl<const ProtoFutureImplementation>(this)->implAsObject(context);
+    }
+
+    unsigned long ProtoPromise::getHash(ProtoContext* context) const {
+        return toImpl<const ProtoFutureImplementation>(this)->getHash(context);
+    }
+
+}
@@ -337,10 +337,17 @@ namespace proto {
                 return (new (context) ProtoListSmallImplementation(context, n, items))
                     ->asProtoList(context);
             }
-            return buildBalancedFromArray(context, items, n)->asProtoList(context);
+            return ProtoListImplementation::fromArray(context, items, n)->asProtoList(context);
         }
     }
 
+    const ProtoListImplementation* ProtoListImplementation::fromArray(
+        ProtoContext* context, const ProtoObject* const* items, unsigned n)
+    {
+        ProtoContext::CellBatch batch(context, n ? n : 1);
+        return buildBalancedFromArray(context, items, n);
+    }
+
     //=========================================================================
     // ProtoListIteratorImplementation
     //=========================================================================
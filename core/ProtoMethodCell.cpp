@@ -1,11 +1,18 @@
 #include "../headers/proto_internal.h"
+#include <vector>
 
 namespace proto
 {
     // --- ProtoMethodCell ---
 
     ProtoMethodCell::ProtoMethodCell(ProtoContext* context, const ProtoObject* selfObject, ProtoMethod methodTarget) :
-        Cell(context), self(selfObject), method(methodTarget)
+        Cell(context), self(selfObject), method(methodTarget), fastMethod(nullptr)
+    {
+    };
+
+    ProtoMethodCell::ProtoMethodCell(ProtoContext* context, const ProtoObject* selfObject, ProtoFastMethod fastTarget,
+                                     ProtoMethod legacyTarget) :
+        Cell(context), self(selfObject), method(legacyTarget), fastMethod(fastTarget)
     {
     };
 
@@ -15,7 +22,92 @@ namespace proto
         const ProtoSparseList* kwargs
     ) const
     {
-        return this->method(context, const_cast<ProtoObject*>(this->self), static_cast<ParentLink*>(nullptr), const_cast<ProtoList*>(args), const_cast<ProtoSparseList*>(kwargs));
+        return this->implCall(context, this->self, nullptr, args, kwargs);
+    }
+
+    const ProtoObject* ProtoMethodCell::implCall(
+        ProtoContext* context,
+        const ProtoObject* callSelf,
+        const ParentLink* parentLink,
+        const ProtoList* args,
+        const ProtoSparseList* kwargs
+    ) const
+    {
+        if (this->method) {
+            return this->method(context, callSelf, parentLink, args, kwargs);
+        }
+
+        // Fast-only target reached through the list form: unpack the
+        // positional list into a native array.  Small packs (the common
+        // interpreter case) stay on the C stack; anything larger spills to
+        // a vector.  The values remain reachable through `args` for the
+        // whole call, so the array needs no GC registration.
+        const unsigned long nargs = args ? args->getSize(context) : 0;
+        const ProtoObject* inlineArgs[8];
+        std::vector<const ProtoObject*> spilledArgs;
+        const ProtoObject** argv = inlineArgs;
+        if (nargs > 8) {
+            spilledArgs.resize(nargs);
+            argv = spilledArgs.data();
+        }
+        for (unsigned long i = 0; i < nargs; ++i) {
+            argv[i] = args->getAt(context, static_cast<int>(i));
+        }
+
+        // The keyword dict is keyed by name hash, so the names a fast
+        // callee expects in `kwnames` cannot be recovered.  Report it the
+        // same way ProtoContext reports an unbindable keyword.
+        if (kwargs && kwargs->getSize(context) > 0 && context->space->parameterNotFoundCallback) {
+            context->space->parameterNotFoundCallback(context, callSelf, nullptr);
+        }
+
+        return this->fastMethod(context, callSelf, parentLink, argv, nargs, nullptr);
+    }
+
+    const ProtoObject* ProtoMethodCell::implCallVector(
+        ProtoContext* context,
+        const ProtoObject* callSelf,
+        const ParentLink* parentLink,
+        const ProtoObject* const* args,
+        unsigned long nargs,
+        const ProtoTuple* kwnames
+    ) const
+    {
+        if (this->fastMethod) {
+            return this->fastMethod(context, callSelf, parentLink, args, nargs, kwnames);
+        }
+        const ProtoList* argList = nullptr;
+        const ProtoSparseList* kwargs = nullptr;
+        packArguments(context, args, nargs, kwnames, &argList, &kwargs);
+        return this->method(context, callSelf, parentLink, argList, kwargs);
+    }
+
+    void ProtoMethodCell::packArguments(
+        ProtoContext* context,
+        const ProtoObject* const* args,
+        unsigned long nargs,
+        const ProtoTuple* kwnames,
+        const ProtoList** outArgs,
+        const ProtoSparseList** outKwargs
+    )
+    {
+        // The list and dict cells are registered on this context's young
+        // chain as they are built, which keeps them alive for the callee.
+        // The critical section only covers the chain of setAt results that
+        // are not yet published to *outKwargs.
+        *outArgs = context->newList(static_cast<unsigned>(nargs), args);
+        *outKwargs = nullptr;
+        const unsigned long nkw = kwnames ? kwnames->getSize(context) : 0;
+        if (nkw == 0) return;
+
+        ProtoContext::CriticalSection cs(context);
+        const ProtoSparseList* kwargs = context->newSparseList();
+        for (unsigned long i = 0; i < nkw; ++i) {
+            const ProtoString* name = kwnames->getAt(context, static_cast<int>(i))->asString(context);
+            if (!name) continue;
+            kwargs = kwargs->setAt(context, name->getHash(context), args[nargs + i]);
+        }
+        *outKwargs = kwargs;
     }
 
     const ProtoObject* ProtoMethodCell::implAsObject(ProtoContext* context) const
@@ -58,4 +150,9 @@ namespace proto
         return this->method;
     }
 
+    ProtoFastMethod ProtoMethodCell::implGetFastMethod(ProtoContext* context) const
+    {
+        return this->fastMethod;
+    }
+
 } // namespace proto
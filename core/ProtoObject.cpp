@@ -9,6 +9,8 @@
  */
 
 #include "../headers/proto_internal.h"
+#include <algorithm>
+#include <cstdlib>
 #include <thread>
 
 #ifdef PROTO_CACHE_STATS
@@ -132,6 +134,312 @@ namespace proto
             unsigned long idx = mutable_ref % MUTABLE_VALUE_CACHE_DEPTH;
             context->mutableValueCache_[idx] = {mutable_ref, new_root, new_value};
         }
+
+        // ---------------------------------------------------------------
+        // Chain summaries (negative-lookup acceleration)
+        // ---------------------------------------------------------------
+        //
+        // A failed getAttribute walks the whole linearised chain and
+        // probes every member's AVL; the per-thread attribute cache only
+        // helps when each (member, name) fact is still resident.  Duck-
+        // typing probes for optional protocol names are exactly that
+        // pattern, so every ParentLink can carry a ChainSummary: a 64-bit
+        // bloom of all names reachable through the chain it starts (two
+        // bits per name).  A name whose bits are not all set is definitely
+        // absent and the lookup returns PROTO_NONE after probing only the
+        // receiver's own attributes.
+        //
+        // Summaries live on links, like the isInstanceOf ancestor tables
+        // (ParentLink.cpp): newChild links every instance to the shared
+        // class chain, so all instances of a class reuse one summary, and
+        // object cells carry no lookup state.  The bloom is built lazily,
+        // on the first full-chain miss, and installed by CAS; a replaced
+        // summary is retired to the space and freed at the next STW.
+        //
+        // A summary reaching only immutable cells never goes stale.  For
+        // every mutable member it records that object's shape epoch
+        // (ProtoSpace::shapeEpoch), and it is valid while all of them are
+        // unchanged.  Writers bump the epoch of the object they wrote
+        // AFTER their CAS publishes, and only when that object is some
+        // link's target and the write can turn a miss into a hit (new
+        // name, new parents).  Builders read each epoch BEFORE resolving
+        // the member's snapshot, so a summary computed from a pre-write
+        // snapshot always records a pre-bump epoch.
+        constexpr unsigned long CHAIN_SUMMARY_MAX_DEPS = 32;
+
+        inline uint64_t chainSummaryBits(unsigned long key) {
+            // Keys are symbol pointers: drop the alignment/tag bits, then
+            // take two 6-bit indices from the top of a Fibonacci hash.
+            const uint64_t h = (static_cast<uint64_t>(key) >> 6) * 0x9E3779B97F4A7C15ULL;
+            return (1ULL << (h >> 58)) | (1ULL << ((h >> 52) & 63));
+        }
+
+        inline uint64_t shapeEpochOf(ProtoContext* context, unsigned long mutableRef) {
+            const std::atomic<uint64_t>* entry = context->space->shapeEpoch(mutableRef, false);
+            return entry ? entry->load(std::memory_order_acquire) >> 1 : 0;
+        }
+
+        inline bool chainSummaryValid(ProtoContext* context, const ChainSummary* summary) {
+            for (unsigned long i = 0; i < summary->count; ++i) {
+                if (shapeEpochOf(context, summary->deps[i].mutableRef) != summary->deps[i].epoch) return false;
+            }
+            return true;
+        }
+
+        /** True iff `link`'s summary is valid and proves `key` absent from its chain. */
+        inline bool chainSummaryExcludes(ProtoContext* context, const ParentLinkImplementation* link,
+                                         unsigned long key) {
+            const ChainSummary* summary = link->summary.load(std::memory_order_acquire);
+            if (!summary) return false;
+            const uint64_t bits = chainSummaryBits(key);
+            return (summary->bloom & bits) != bits && chainSummaryValid(context, summary);
+        }
+
+        /** OR the bloom bits of every own attribute name in `attributes` into `bloom`. */
+        void chainSummaryAddAttributes(const AttributeStore& attributes, uint64_t& bloom) {
+            for (unsigned i = 0; i < AttributeStore::IN_CELL_MAX; ++i) {
+                if (attributes.inCellKey(i) != 0) bloom |= chainSummaryBits(attributes.inCellKey(i));
+            }
+            if (const auto* block = attributes.inlineBlock()) {
+                for (unsigned i = 0; i < ProtoSparseListSmallImplementation::MAX_INLINE; ++i) {
+                    if (block->keys[i] != 0) bloom |= chainSummaryBits(block->keys[i]);
+                }
+                return;
+            }
+            const ProtoSparseListImplementation* root = attributes.tree();
+            // AVL height is bounded by ~1.44 log2(n); 64 slots cover any
+            // tree that fits in memory.
+            const ProtoSparseListImplementation* stack[64];
+            int sp = 0;
+            if (root && !root->isEmpty) stack[sp++] = root;
+            while (sp > 0) {
+                const ProtoSparseListImplementation* node = stack[--sp];
+                bloom |= chainSummaryBits(node->key);
+                if (node->previous && !node->previous->isEmpty && sp < 64) stack[sp++] = node->previous;
+                if (node->next && !node->next->isEmpty && sp < 64) stack[sp++] = node->next;
+            }
+        }
+
+        /**
+         * Build and publish the summary for the chain starting at `head`.
+         * The bloom covers the transitive closure of parent chains, not
+         * only the linearised chain getAttribute walks: hasAttribute also
+         * descends into each parent's own chain, and a superset is still
+         * exact for "definitely absent".  Gives up silently if the walk
+         * leaves the ProtoObjectCell invariant, the closure is larger than
+         * the lookup walkers themselves would ever visit, or it reaches
+         * more mutable prototypes than a summary records.
+         */
+        void chainSummaryCompute(ProtoContext* context, const ParentLinkImplementation* head) {
+            // A still-valid summary that let this miss through was a bloom
+            // false positive; rebuilding it would produce the same bits.
+            ChainSummary* current = head->summary.load(std::memory_order_acquire);
+            if (current && chainSummaryValid(context, current)) return;
+
+            uint64_t bloom = 0;
+            std::vector<ChainSummary::Dependency> deps;
+            std::vector<const ParentLinkImplementation*> pending{head};
+            std::unordered_set<const ProtoObject*> visited;
+            while (!pending.empty()) {
+                const ParentLinkImplementation* link = pending.back();
+                pending.pop_back();
+                for (; link && ((uintptr_t)link & 0x3F) == 0; link = link->parent) {
+                    if (!isObjectFast(link->object)) return;
+                    if (!visited.insert(link->object).second) continue;
+                    if (visited.size() > 500) return;
+                    const auto* member = toImpl<const ProtoObjectCell>(link->object);
+                    if (member->mutable_ref > 0) {
+                        if (deps.size() == CHAIN_SUMMARY_MAX_DEPS) return;
+                        // Epoch first, then the snapshot — see above.
+                        deps.push_back({member->mutable_ref, shapeEpochOf(context, member->mutable_ref)});
+                        const ProtoObject* snap = resolveMutableSnapshot(context, member->mutable_ref);
+                        if (snap != nullptr) member = toImpl<const ProtoObjectCell>(snap);
+                    }
+                    chainSummaryAddAttributes(member->attributes, bloom);
+                    if (member->parent) pending.push_back(member->parent);
+                }
+            }
+
+            const size_t extra = deps.empty() ? 0 : deps.size() - 1;
+            void* block = std::malloc(sizeof(ChainSummary) + extra * sizeof(ChainSummary::Dependency));
+            if (!block) return;
+            auto* fresh = static_cast<ChainSummary*>(block);
+            fresh->bloom = bloom;
+            fresh->count = deps.size();
+            std::copy(deps.begin(), deps.end(), fresh->deps);
+            if (head->summary.compare_exchange_strong(current, fresh, std::memory_order_acq_rel)) {
+                if (current) context->space->retireChainSummary(current);
+            } else {
+                std::free(fresh);
+            }
+        }
+
+        /**
+         * Expire summaries that may depend on mutable object `oc` after a
+         * write has been published.  With `previous` / `key` the write set
+         * one attribute on snapshot `previous`: only adding a new name can
+         * turn a miss into a hit, so overwrites leave the epoch alone.
+         * Without them (parent changes) the epoch is bumped as well as
+         * ancestryEpoch, so the isInstanceOf ancestor tables (ParentLink.cpp)
+         * expire too.  Objects no link points at have nothing to expire.
+         * Must run after the CAS — see above.
+         */
+        inline void chainSummaryInvalidate(ProtoContext* context, const ProtoObjectCell* oc,
+                                           const ProtoObjectCell* previous = nullptr,
+                                           unsigned long key = 0) {
+            std::atomic<uint64_t>* epoch = context->space->shapeEpoch(oc->mutable_ref, false);
+            if (!epoch || !(epoch->load(std::memory_order_acquire) & 1)) return;
+            if (previous) {
+                if (previous->attributes.has(context, key)) {
+                    return;
+                }
+            } else {
+                context->space->ancestryEpoch.fetch_add(1, std::memory_order_acq_rel);
+            }
+            epoch->fetch_add(2, std::memory_order_acq_rel);
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // AttributeStore
+    // ------------------------------------------------------------------
+    //
+    // The block form reuses ProtoSparseListSmallImplementation so it keeps
+    // its GC tracing and can be handed out through getOwnAttributes as a
+    // public ProtoSparseList without copying.  The helpers below keep the
+    // block's construction contract, which the in-cell pairs share: used
+    // slots first, key-ascending, no key 0.
+
+    namespace {
+        constexpr unsigned ATTRIBUTE_INLINE_MAX = ProtoSparseListSmallImplementation::MAX_INLINE;
+
+        // Collect the in-cell or block pairs of `store` minus `skip` into
+        // ks/vs; returns the count.
+        unsigned attributeSmallPairs(const AttributeStore& store, unsigned long skip,
+                                     unsigned long* ks, const ProtoObject** vs) {
+            unsigned n = 0;
+            if (const auto* block = store.inlineBlock()) {
+                for (unsigned i = 0; i < ATTRIBUTE_INLINE_MAX; ++i) {
+                    if (block->keys[i] != 0 && block->keys[i] != skip) {
+                        ks[n] = block->keys[i];
+                        vs[n] = block->values[i];
+                        ++n;
+                    }
+                }
+                return n;
+            }
+            for (unsigned i = 0; i < AttributeStore::IN_CELL_MAX; ++i) {
+                const unsigned long key = store.inCellKey(i);
+                if (key != 0 && key != skip) {
+                    ks[n] = key;
+                    vs[n] = store.inCellValue(i);
+                    ++n;
+                }
+            }
+            return n;
+        }
+
+        void attributeBlockSort(unsigned n, unsigned long* ks, const ProtoObject** vs) {
+            for (unsigned i = 1; i < n; ++i) {
+                const unsigned long k = ks[i];
+                const ProtoObject* v = vs[i];
+                unsigned j = i;
+                while (j > 0 && ks[j - 1] > k) {
+                    ks[j] = ks[j - 1];
+                    vs[j] = vs[j - 1];
+                    --j;
+                }
+                ks[j] = k;
+                vs[j] = v;
+            }
+        }
+    }
+
+    AttributeStore::AttributeStore(unsigned n, const unsigned long* ks, const ProtoObject* const* vs)
+        : keys{0, 0}, values{nullptr, nullptr} {
+        for (unsigned i = 0; i < n; ++i) {
+            keys[i] = ks[i];
+            values[i] = vs[i];
+        }
+    }
+
+    const Cell* AttributeStore::cell() const {
+        if (const auto* block = inlineBlock()) return block;
+        return tree();
+    }
+
+    const ProtoObject* AttributeStore::getOutOfLine(ProtoContext* context, unsigned long key) const {
+        if (const auto* block = inlineBlock()) {
+            // Key 0 is the block's empty-slot sentinel and never stored here.
+            if (key == 0) return nullptr;
+            for (unsigned i = 0; i < ATTRIBUTE_INLINE_MAX; ++i) {
+                if (block->keys[i] == key) return block->values[i];
+            }
+            return nullptr;
+        }
+        const auto* root = tree();
+        return root ? root->implGetAt(context, key) : nullptr;
+    }
+
+    unsigned long AttributeStore::count() const {
+        if (isInCell()) return keys[1] != 0 ? 2 : 1;
+        if (const auto* block = inlineBlock()) return block->implCount();
+        const auto* root = tree();
+        return root ? root->size : 0;
+    }
+
+    AttributeStore AttributeStore::setAt(ProtoContext* context, unsigned long key,
+                                         const ProtoObject* value) const {
+        if (const auto* root = tree()) return AttributeStore(root->implSetAt(context, key, value));
+
+        unsigned long ks[ATTRIBUTE_INLINE_MAX + 1];
+        const ProtoObject* vs[ATTRIBUTE_INLINE_MAX + 1];
+        unsigned n = attributeSmallPairs(*this, key, ks, vs);
+        ks[n] = key;
+        vs[n] = value;
+        ++n;
+        if (key != 0) {
+            attributeBlockSort(n, ks, vs);
+            if (n <= IN_CELL_MAX && !inlineBlock()) return AttributeStore(n, ks, vs);
+            if (n <= ATTRIBUTE_INLINE_MAX) {
+                return AttributeStore(new(context) ProtoSparseListSmallImplementation(context, n, ks, vs));
+            }
+        }
+        // Spill: the object has outgrown the block for good.
+        const ProtoSparseListImplementation* root = context->newSparseListImpl();
+        for (unsigned i = 0; i < n; ++i) root = root->implSetAt(context, ks[i], vs[i]);
+        return AttributeStore(root);
+    }
+
+    AttributeStore AttributeStore::removeAt(ProtoContext* context, unsigned long key) const {
+        if (const auto* root = tree()) return AttributeStore(root->implRemoveAt(context, key));
+        if (isEmpty()) return *this;
+        unsigned long ks[ATTRIBUTE_INLINE_MAX];
+        const ProtoObject* vs[ATTRIBUTE_INLINE_MAX];
+        const unsigned n = attributeSmallPairs(*this, key, ks, vs);
+        if (n == 0) return AttributeStore();
+        if (isInCell()) return AttributeStore(n, ks, vs);
+        return AttributeStore(new(context) ProtoSparseListSmallImplementation(context, n, ks, vs));
+    }
+
+    const ProtoSparseListImplementation* AttributeStore::asTree(ProtoContext* context) const {
+        if (const auto* root = tree()) return root;
+        if (const auto* block = inlineBlock()) return block->promoteToAVL(context);
+        const ProtoSparseListImplementation* root = context->newSparseListImpl();
+        for (unsigned i = 0; i < IN_CELL_MAX; ++i) {
+            if (inCellKey(i) != 0) root = root->implSetAt(context, keys[i], values[i]);
+        }
+        return root;
+    }
+
+    const ProtoSparseList* AttributeStore::asSparseList(ProtoContext* context) const {
+        if (const auto* root = tree()) return root->asSparseList(context);
+        if (const auto* block = inlineBlock()) return block->asSparseList(context);
+        if (isEmpty()) return context->newSparseList();
+        unsigned long ks[IN_CELL_MAX];
+        const ProtoObject* vs[IN_CELL_MAX];
+        const unsigned n = attributeSmallPairs(*this, 0, ks, vs);
+        return (new(context) ProtoSparseListSmallImplementation(context, n, ks, vs))->asSparseList(context);
     }
 
     /**
@@ -147,16 +455,16 @@ namespace proto
      * @brief Constructs a new object cell.
      * @param context The current execution context.
      * @param parent A pointer to the `ParentLink` that forms the head of the prototype chain.
-     * @param attributes A `ProtoSparseList` holding the object's own key-value attributes.
+     * @param attributes The object's own key-value attributes; empty for none.
      * @param mutable_ref A non-zero ID if this object is a mutable reference, otherwise 0.
      */
     ProtoObjectCell::ProtoObjectCell(
         ProtoContext* context,
         const ParentLinkImplementation* parent,
-        const ProtoSparseListImplementation* attributes,
+        AttributeStore attributes,
         const unsigned long mutable_ref
     ) : Cell(context), parent(parent),
-        attributes(attributes ? attributes : context->newSparseListImpl()),
+        attributes(attributes),
         mutable_ref(mutable_ref)
     {
     }
@@ -268,12 +576,20 @@ namespace proto
             method(context, self, this->parent);
         }
 
-        // Report the attribute list. `attributes` is now a raw
-        // ProtoSparseListImplementation* (internal IMPL) — the same
-        // type the GC tracer expects (Cell*-derived). No conversion.
-        if (this->attributes)
+        // Report the attribute store: the values held in-cell, or the
+        // block or AVL root, untagged.  Keys are interned symbols and are
+        // not traced, as in the block.
+        if (const Cell* attributeCell = this->attributes.cell())
+        {
+            method(context, self, attributeCell);
+        }
+        for (unsigned i = 0; i < AttributeStore::IN_CELL_MAX; ++i)
         {
-            method(context, self, this->attributes);
+            const ProtoObject* value = this->attributes.inCellValue(i);
+            if (this->attributes.inCellKey(i) != 0 && ProtoObject::isCellPointer(value))
+            {
+                method(context, self, ProtoObject::asCellPointer(value));
+            }
         }
     }
 
@@ -366,18 +682,18 @@ namespace proto
         }
         auto* oc = toImpl<const ProtoObjectCell>(this);
         unsigned long ref = isMutable ? generate_mutable_ref(context) : 0;
-        // GC critical section: this expression allocates three cells
-        // (the empty SparseList, the ParentLinkImplementation, and the
-        // outer ProtoObjectCell) in a single statement.  Argument
+        // GC critical section: this expression allocates two cells
+        // (the ParentLinkImplementation and the outer ProtoObjectCell)
+        // in a single statement.  Argument
         // evaluation order is unspecified and the temporaries live in
         // the C++ stack between sub-expression results — none of them
         // are reachable from a GC root until the surrounding
         // ProtoObjectCell finishes constructing and links the chain
         // back together.  Without the guard a concurrent STW root scan
         // would observe a partial chain as candidate-but-unreachable
-        // and sweep would free the SparseList or ParentLink under us.
+        // and sweep would free the ParentLink under us.
         ProtoContext::CriticalSection cs(context);
-        auto* newObject = new(context) ProtoObjectCell(context, new(context) ParentLinkImplementation(context, oc->parent, this), context->newSparseListImpl(), ref);
+        auto* newObject = new(context) ProtoObjectCell(context, new(context) ParentLinkImplementation(context, oc->parent, this), AttributeStore(), ref);
         const ProtoObject* result = newObject->asObject(context);
         return result;
     }
@@ -386,7 +702,8 @@ namespace proto
     {
         const auto* result = this->getAttribute(context, const_cast<ProtoString*>(method));
         if (result && result->isMethod(context)) {
-            return result->asMethod(context)(context, self, nextParent, positionalParameters, keywordParametersDict);
+            return toImpl<const ProtoMethodCell>(result)->implCall(
+                context, self, nextParent, positionalParameters, keywordParametersDict);
         }
         if (context->space->nonMethodCallback) {
             return (*context->space->nonMethodCallback)(context, nextParent, method, self, positionalParameters, keywordParametersDict);
@@ -394,74 +711,80 @@ namespace proto
         return PROTO_NONE;
     }
 
-    const ProtoObject* ProtoObject::isInstanceOf(ProtoContext* context, const ProtoObject* prototype) const
+    const ProtoObject* ProtoObject::callv(ProtoContext* context, const ParentLink* nextParent, const ProtoString* method, const ProtoObject* self, const ProtoObject* const* args, unsigned long nargs, const ProtoTuple* kwnames) const
     {
-        const ParentLinkImplementation* plStack[64];
-        int plPtr = 0;
-        const ProtoObject* current = this->getPrototype(context);
-        int iterationCount = 0;
+        // Same resolution as call(); the difference is only in how the
+        // arguments reach the callee.  A fastMethod target gets the
+        // caller's array as-is — the hot path allocates no cells at all.
+        const auto* result = this->getAttribute(context, const_cast<ProtoString*>(method));
+        if (result && result->isMethod(context)) {
+            return toImpl<const ProtoMethodCell>(result)->implCallVector(
+                context, self, nextParent, args, nargs, kwnames);
+        }
+        if (context->space->nonMethodCallback) {
+            const ProtoList* argList = nullptr;
+            const ProtoSparseList* kwargs = nullptr;
+            ProtoMethodCell::packArguments(context, args, nargs, kwnames, &argList, &kwargs);
+            return (*context->space->nonMethodCallback)(context, nextParent, method, self, argList, kwargs);
+        }
+        return PROTO_NONE;
+    }
 
-        while (current) {
-            if (++iterationCount > 50) {
-                 return PROTO_FALSE;
-            }
-            if (current == prototype) return PROTO_TRUE;
-            ProtoObjectPointer pa{};
-            pa.oid = current;
-            if (pa.op.pointer_tag != POINTER_TAG_OBJECT) {
-                current = current->getPrototype(context);
-                continue;
-            }
-            auto oc = toImpl<const ProtoObjectCell>(current);
-            
-            // Handle Mutable Objects (cache-fast)
-            if (oc->mutable_ref > 0) {
-                 const proto::ProtoObject* storedState =
-                     resolveMutableSnapshot(context, oc->mutable_ref);
-                 if (storedState != nullptr && storedState != current) {
-                      ProtoObjectPointer psa{};
-                      psa.oid = storedState;
-                      if (psa.op.pointer_tag == POINTER_TAG_OBJECT) {
-                          oc = toImpl<const ProtoObjectCell>(storedState);
-                      }
-                 }
+    const ProtoObject* ProtoObject::isInstanceOf(ProtoContext* context, const ProtoObject* prototype) const
+    {
+        if (!this || !prototype) return PROTO_FALSE;
+
+        // Find the snapshot whose parent chain defines the ancestry.  A
+        // non-object value starts from its type prototype, which is itself
+        // an ancestor.
+        const ProtoObject* start = this;
+        if (!proto::isObjectFast(this)) {
+            start = this->getPrototype(context);
+            if (!start) return PROTO_FALSE;
+            if (start == prototype) return PROTO_TRUE;
+            if (!proto::isObjectFast(start)) return PROTO_FALSE;
+        }
+        const auto* oc = toImpl<const ProtoObjectCell>(start);
+        if (oc->mutable_ref > 0) {
+            const ProtoObject* storedState = resolveMutableSnapshot(context, oc->mutable_ref);
+            if (storedState != nullptr && proto::isObjectFast(storedState)) {
+                oc = toImpl<const ProtoObjectCell>(storedState);
             }
-            
-            if (oc->parent && ((uintptr_t)oc->parent & 0x3F) == 0) {
-                auto pl = toImpl<const ParentLinkImplementation>(oc->parent);
-                if (pl->getType() == CellType::ParentLink) {
-                    const ParentLinkImplementation* sibling = pl->getParent(context);
-                    int sibCount = 0;
-                    while (sibling && plPtr < 64 && ((uintptr_t)sibling & 0x3F) == 0) {
-                        auto sl = toImpl<const ParentLinkImplementation>(sibling);
-                        if (sl->getType() != CellType::ParentLink) break;
-                        if (++sibCount > 100) break;
-                        plStack[plPtr++] = sibling;
-                        sibling = sl->getParent(context);
-                    }
-                    current = pl->getObject(context);
-                } else {
-                    current = nullptr;
-                }
-            } else {
-                if (plPtr > 0) {
-                    const ParentLinkImplementation* top = plStack[--plPtr];
-                    if (top && ((uintptr_t)top & 0x3F) == 0) {
-                        auto tl = toImpl<const ParentLinkImplementation>(top);
-                        if (tl->getType() == CellType::ParentLink) {
-                            current = tl->getObject(context);
-                        } else {
-                            current = nullptr;
-                        }
-                    } else {
-                        current = nullptr;
-                    }
-                } else {
-                    current = nullptr;
+        }
+
+        const ParentLinkImplementation* head = oc->parent;
+        if (!head || ((uintptr_t)head & 0x3F) != 0) {
+            // Parentless object: objectPrototype is its conventional root
+            // (mirrors getPrototype).
+            return (start == this && this != context->space->objectPrototype &&
+                    prototype == context->space->objectPrototype) ? PROTO_TRUE : PROTO_FALSE;
+        }
+
+        // The head link is usually unique to this instance (newChild makes
+        // one per child), while its tail is the class chain every sibling
+        // instance shares.  Check the head by hand and consult the shared
+        // tables so instances never build tables of their own.
+        if (head->object == prototype) return PROTO_TRUE;
+        if (head->parent && ((uintptr_t)head->parent & 0x3F) == 0 &&
+            head->parent->implHasAncestor(context, prototype)) {
+            return PROTO_TRUE;
+        }
+        const ProtoObject* first = head->object;
+        if (proto::isObjectFast(first)) {
+            const auto* firstOc = toImpl<const ProtoObjectCell>(first);
+            if (firstOc->mutable_ref > 0) {
+                const ProtoObject* storedState = resolveMutableSnapshot(context, firstOc->mutable_ref);
+                if (storedState != nullptr && proto::isObjectFast(storedState)) {
+                    firstOc = toImpl<const ProtoObjectCell>(storedState);
                 }
             }
+            if (firstOc->parent && firstOc->parent != head->parent &&
+                ((uintptr_t)firstOc->parent & 0x3F) == 0 &&
+                firstOc->parent->implHasAncestor(context, prototype)) {
+                return PROTO_TRUE;
+            }
         }
-        return PROTO_NONE;
+        return PROTO_FALSE;
     }
 
     const ProtoObject* ProtoObject::getAttribute(ProtoContext* context, const ProtoString* name, bool callbacks) const
@@ -503,6 +826,9 @@ namespace proto
         const ParentLinkImplementation* currentLink = nullptr;
         const unsigned long attr_hash = reinterpret_cast<uintptr_t>(name);
         int iterationCount = 0;
+        // Parent chain of the first object visited; owner of the
+        // negative-lookup summary consulted / built below.
+        const ParentLinkImplementation* summaryStart = nullptr;
 
         while (currentPointer) {
             if (++iterationCount > 500) {
@@ -579,6 +905,7 @@ namespace proto
                     ++protoCacheStats_hits;
 #endif
                 } else {
+                    PROTO_PROBE3(attrcache_miss, currentValue, name, cache[hash_idx].object);
 #ifdef PROTO_CACHE_STATS
                     // Occupied with different key → collision; empty → cold miss.
                     if (cache[hash_idx].object != nullptr) ++protoCacheStats_collisions;
@@ -594,16 +921,12 @@ namespace proto
             // "not found", so calling `implHas` first would just walk
             // the AVL twice.
             if (!cache_resolved) {
-                // Direct IMPL access: `attributes` is now a raw
-                // ProtoSparseListImplementation* (AVL form), so the
-                // lookup is a single C++ call into the AVL probe with
-                // no toImpl, no tag dispatch. `implGetAt` returns
-                // nullptr for absent keys and the actual value
+                // Direct store probe: a 3-slot scan of the inline block
+                // for small objects, the AVL walk otherwise.  `getAt`
+                // returns nullptr for absent keys and the actual value
                 // (possibly PROTO_NONE) for present keys — the
                 // distinction `x = None` vs `hasattr(x)` is preserved.
-                result = ocValue->attributes
-                    ? ocValue->attributes->implGetAt(context, attr_hash)
-                    : nullptr;
+                result = ocValue->attributes.getAt(context, attr_hash);
                 if (cache) {
                     // Persist the own-fact (positive OR negative).  A
                     // cached miss prevents the next chain walk from
@@ -623,6 +946,17 @@ namespace proto
                 return result;
             }
 
+            // Not an own attribute of the chain's first member: before
+            // walking the parents, ask its chain summary whether the name
+            // can exist anywhere up the chain.  Done after the own probe so
+            // the common own-hit path pays nothing for it.
+            if (currentLink == nullptr && ocValue->parent && ((uintptr_t)ocValue->parent & 0x3F) == 0) {
+                summaryStart = ocValue->parent;
+                if (chainSummaryExcludes(context, summaryStart, attr_hash)) {
+                    return PROTO_NONE;
+                }
+            }
+
             // Move to NEXT in linearised chain.  First iteration
             // (currentLink == nullptr) starts from this object's
             // parent link; subsequent iterations dereference the
@@ -648,9 +982,13 @@ namespace proto
                 currentLink = nullptr;
             }
         }
-        // Full prototype chain searched, attribute not found.  Return
-        // PROTO_NONE per the API convention (nullptr is reserved for
-        // invalid inputs at the top of this function).
+        // Full prototype chain searched, attribute not found.  Build the
+        // chain summary so the next miss on this chain is rejected up
+        // front.  Return PROTO_NONE per the API convention (nullptr is
+        // reserved for invalid inputs at the top of this function).
+        if (summaryStart) {
+            chainSummaryCompute(context, summaryStart);
+        }
         return PROTO_NONE;
     }
 
@@ -749,11 +1087,10 @@ namespace proto
                      return this; // Corruption detected or inconsistent state
                  }
                  auto* currentOc = toImpl<const ProtoObjectCell>(currentObjState);
-                 // Direct IMPL setAt: returns a new AVL impl pointer
-                 // (raw, untagged), suitable for storage in the next
-                 // ProtoObjectCell's `attributes` field.
-                 const ProtoSparseListImplementation* newAttributes =
-                     currentOc->attributes->implSetAt(context, reinterpret_cast<uintptr_t>(name), value);
+                 // New attribute store for the next snapshot; stays
+                 // inline until the object outgrows the block.
+                 const AttributeStore newAttributes =
+                     currentOc->attributes.setAt(context, reinterpret_cast<uintptr_t>(name), value);
 
                  // CRITICAL: newState MUST have mutable_ref = 0 to avoid infinite loop during lookup
                  auto* newState = (new(context) ProtoObjectCell(context, currentOc->parent, newAttributes, 0))->asObject(context);
@@ -771,6 +1108,7 @@ namespace proto
                  if (context->space->mutableRoot[shard].root.compare_exchange_weak(expected, newRoot)) {
                      // Refresh per-thread cache so subsequent reads on this thread hit immediately.
                      refreshMutableCache(context, oc->mutable_ref, newRoot, newState);
+                     chainSummaryInvalidate(context, oc, currentOc, reinterpret_cast<uintptr_t>(name));
                      break;
                  }
                  // CAS lost — another writer beat us; back off briefly
@@ -791,8 +1129,8 @@ namespace proto
         // reachable through this function's return value once both are
         // wired up; sweeping mid-build would orphan them.
         ProtoContext::CriticalSection cs(context);
-        const ProtoSparseListImplementation* newAttributes =
-            oc->attributes->implSetAt(context, (uintptr_t)name, value);
+        const AttributeStore newAttributes =
+            oc->attributes.setAt(context, (uintptr_t)name, value);
         const ProtoObject* result = (new(context) ProtoObjectCell(context, oc->parent, newAttributes, 0))->asObject(context);
         return result;
     }
@@ -863,9 +1201,7 @@ namespace proto
             auto* currentOc = toImpl<const ProtoObjectCell>(currentObjState);
 
             // The current OWN value of `name` (nullptr == attribute absent).
-            const ProtoObject* currentValue = currentOc->attributes
-                ? currentOc->attributes->implGetAt(context, key)
-                : nullptr;
+            const ProtoObject* currentValue = currentOc->attributes.getAt(context, key);
 
             // Precondition: the attribute must still hold `expected`.  A
             // mismatch is a genuine concurrent write — report failure so the
@@ -877,8 +1213,8 @@ namespace proto
             }
 
             // Build the new snapshot with name := newValue.
-            const ProtoSparseListImplementation* newAttributes =
-                currentOc->attributes->implSetAt(context, key, newValue);
+            const AttributeStore newAttributes =
+                currentOc->attributes.setAt(context, key, newValue);
             auto* newState = (new(context) ProtoObjectCell(
                 context, currentOc->parent, newAttributes, 0))->asObject(context);
 
@@ -889,6 +1225,7 @@ namespace proto
             ProtoSparseList* expectedRoot = oldRoot;
             if (context->space->mutableRoot[shard].root.compare_exchange_weak(expectedRoot, newRoot)) {
                 refreshMutableCache(context, oc->mutable_ref, newRoot, newState);
+                chainSummaryInvalidate(context, oc, currentOc, key);
                 return true;
             }
             // CAS lost to a concurrent shard write; back off occasionally and
@@ -961,12 +1298,12 @@ namespace proto
                  // the allocation+CAS entirely and return `this` unchanged.
                  // Matches the "no allocation if no change" contract callers
                  // can rely on for cheap idempotent del.
-                 if (!currentOc->attributes->implHas(context, reinterpret_cast<uintptr_t>(name))) {
+                 if (!currentOc->attributes.has(context, reinterpret_cast<uintptr_t>(name))) {
                      return this;
                  }
 
-                 const ProtoSparseListImplementation* newAttributes =
-                     currentOc->attributes->implRemoveAt(context, reinterpret_cast<uintptr_t>(name));
+                 const AttributeStore newAttributes =
+                     currentOc->attributes.removeAt(context, reinterpret_cast<uintptr_t>(name));
 
                  auto* newState = (new(context) ProtoObjectCell(context, currentOc->parent, newAttributes, 0))->asObject(context);
 
@@ -989,12 +1326,12 @@ namespace proto
         }
 
         // Immutable path: copy-on-write.  No-op when the name isn't OWN.
-        if (!oc->attributes->implHas(context, reinterpret_cast<uintptr_t>(name))) {
+        if (!oc->attributes.has(context, reinterpret_cast<uintptr_t>(name))) {
             return this;
         }
         ProtoContext::CriticalSection cs(context);
-        const ProtoSparseListImplementation* newAttributes =
-            oc->attributes->implRemoveAt(context, reinterpret_cast<uintptr_t>(name));
+        const AttributeStore newAttributes =
+            oc->attributes.removeAt(context, reinterpret_cast<uintptr_t>(name));
         const ProtoObject* result = (new(context) ProtoObjectCell(context, oc->parent, newAttributes, 0))->asObject(context);
         return result;
     }
@@ -1108,6 +1445,7 @@ namespace proto
                  if (context->space->mutableRoot[shard].root.compare_exchange_weak(expected, newRoot)) {
                      // Refresh per-thread cache so subsequent reads on this thread hit immediately.
                      refreshMutableCache(context, oc->mutable_ref, newRoot, newState);
+                     chainSummaryInvalidate(context, oc);
                      break;
                  }
                  if ((casIteration & 31) == 0) {
@@ -1217,6 +1555,7 @@ namespace proto
                 ProtoSparseList* expected = oldRoot;
                 if (context->space->mutableRoot[shard].root.compare_exchange_weak(expected, newRoot)) {
                     refreshMutableCache(context, oc->mutable_ref, newRoot, newState);
+                    chainSummaryInvalidate(context, oc);
                     break;
                 }
                 if ((casIteration & 31) == 0) {
@@ -1282,6 +1621,12 @@ namespace proto
         return pa.op.pointer_tag == POINTER_TAG_METHOD ? toImpl<const ProtoMethodCell>(this)->method : nullptr;
     }
 
+    ProtoFastMethod ProtoObject::asFastMethod(ProtoContext* context) const {
+        ProtoObjectPointer pa{};
+        pa.oid = this;
+        return pa.op.pointer_tag == POINTER_TAG_METHOD ? toImpl<const ProtoMethodCell>(this)->fastMethod : nullptr;
+    }
+
     const ProtoObject* ProtoObject::asMethodSelf(ProtoContext* context) const {
         ProtoObjectPointer pa{};
         pa.oid = this;
@@ -1372,18 +1717,18 @@ namespace proto
         ProtoObjectPointer pa{}; pa.oid = this;
         if (pa.op.pointer_tag != POINTER_TAG_OBJECT) return nullptr;
         auto oc = toImpl<const ProtoObjectCell>(this);
-        const ProtoSparseListImplementation* attrs = oc->attributes;
+        AttributeStore attrs = oc->attributes;
         if (oc->mutable_ref > 0) {
             const ProtoObject* ss = resolveMutableSnapshot(context, oc->mutable_ref);
             if (ss != nullptr) {
                 attrs = toImpl<const ProtoObjectCell>(ss)->attributes;
             }
         }
-        // Direct IMPL lookup. Preserves the nullptr-for-absent contract:
+        // Direct store lookup. Preserves the nullptr-for-absent contract:
         // an attribute legitimately set to PROTO_NONE (Python's
         // `x = None`) returns PROTO_NONE here, not nullptr — callers
         // that want existence semantics use hasOwnAttribute.
-        return attrs ? attrs->implGetAt(context, reinterpret_cast<uintptr_t>(name)) : nullptr;
+        return attrs.getAt(context, reinterpret_cast<uintptr_t>(name));
     }
 
     unsigned long ProtoObject::getHash(ProtoContext* context) const {
@@ -1462,6 +1807,10 @@ namespace proto
     }
     const ProtoExternalPointer* ProtoObject::asExternalPointer(ProtoContext* context) const { ProtoObjectPointer pa{}; pa.oid = this; return pa.op.pointer_tag == POINTER_TAG_EXTERNAL_POINTER ? reinterpret_cast<const ProtoExternalPointer*>(this) : nullptr; }
     const ProtoExternalBuffer* ProtoObject::asExternalBuffer(ProtoContext* context) const { ProtoObjectPointer pa{}; pa.oid = this; return pa.op.pointer_tag == POINTER_TAG_EXTERNAL_BUFFER ? reinterpret_cast<const ProtoExternalBuffer*>(this) : nullptr; }
+    const ProtoWeakRef* ProtoObject::asWeakRef(ProtoContext* context) const { ProtoObjectPointer pa{}; pa.oid = this; return pa.op.pointer_tag == POINTER_TAG_WEAK_REF ? reinterpret_cast<const ProtoWeakRef*>(this) : nullptr; }
+    const ProtoWeakMap* ProtoObject::asWeakMap(ProtoContext* context) const { ProtoObjectPointer pa{}; pa.oid = this; return pa.op.pointer_tag == POINTER_TAG_WEAK_MAP ? reinterpret_cast<const ProtoWeakMap*>(this) : nullptr; }
+    const ProtoFuture* ProtoObject::asFuture(ProtoContext* context) const { ProtoObjectPointer pa{}; pa.oid = this; return pa.op.pointer_tag == POINTER_TAG_FUTURE ? reinterpret_cast<const ProtoFuture*>(this) : nullptr; }
+    const ProtoChannel* ProtoObject::asChannel(ProtoContext* context) const { ProtoObjectPointer pa{}; pa.oid = this; return pa.op.pointer_tag == POINTER_TAG_CHANNEL ? reinterpret_cast<const ProtoChannel*>(this) : nullptr; }
     void* ProtoObject::getRawPointerIfExternalBuffer(ProtoContext* context) const {
         const ProtoExternalBuffer* buf = asExternalBuffer(context);
         return buf ? reinterpret_cast<const ProtoExternalBuffer*>(buf)->getRawPointer(context) : nullptr;
@@ -1617,6 +1966,8 @@ namespace proto
         const ParentLinkImplementation* plStack[64];
         int plPtr = 0;
         int iterationCount = 0;
+        bool summaryChecked = false;
+        const ParentLinkImplementation* summaryStart = nullptr;
 
         // A ParentLink pointer is valid when it is non-null,
         // 64-byte-aligned (cell-aligned, low 6 bits = 0), and its
@@ -1637,7 +1988,6 @@ namespace proto
                 continue;
             }
             auto oc = toImpl<const ProtoObjectCell>(currentObject);
-            const ProtoSparseListImplementation* attributes = oc->attributes;
 
             // Support for Mutable Objects (cache-fast).  resolveMutableSnapshot
             // never returns a non-Object pointer for a valid mutable_ref, so
@@ -1646,20 +1996,30 @@ namespace proto
                  const proto::ProtoObject* storedState =
                      resolveMutableSnapshot(context, oc->mutable_ref);
                  if (storedState != nullptr && storedState != currentObject) {
-                     auto* storedOc = toImpl<const ProtoObjectCell>(storedState);
-                     attributes = storedOc->attributes;
-                     oc = storedOc;
+                     oc = toImpl<const ProtoObjectCell>(storedState);
                  }
             }
 
-            // Direct IMPL probe. nullptr means absent; anything else
+            // Direct store probe. nullptr means absent; anything else
             // (including PROTO_NONE) means present. Preserves the
             // distinction so `attr = None` → `hasattr(x, 'attr')` is
             // True (vs missing).
-            if (attributes && attributes->implGetAt(context, attr_hash) != nullptr) {
+            if (oc->attributes.has(context, attr_hash)) {
                 return PROTO_TRUE;
             }
 
+            // First object visited: its chain's summary covers everything
+            // the rest of this walk can reach (see "Chain summaries" above).
+            if (!summaryChecked) {
+                summaryChecked = true;
+                if (validLink(oc->parent)) {
+                    summaryStart = oc->parent;
+                    if (chainSummaryExcludes(context, summaryStart, attr_hash)) {
+                        return PROTO_FALSE;
+                    }
+                }
+            }
+
             // Multiple inheritance support: walk the linearised chain
             // through `oc->parent`, while pushing any sibling links on
             // a small stack so they can be revisited after the main
@@ -1678,6 +2038,9 @@ namespace proto
                 currentObject = nullptr;
             }
         }
+        if (summaryStart) {
+            chainSummaryCompute(context, summaryStart);
+        }
         return PROTO_FALSE;
     }
     
@@ -1689,7 +2052,7 @@ namespace proto
             return prototype ? prototype->getAttributes(context) : context->newSparseList();
         }
         auto oc = toImpl<const ProtoObjectCell>(this);
-        const ProtoSparseListImplementation* attributes = oc->attributes;
+        AttributeStore attributes = oc->attributes;
 
         if (oc->mutable_ref > 0) {
             const ProtoObject* storedState = resolveMutableSnapshot(context, oc->mutable_ref);
@@ -1700,7 +2063,7 @@ namespace proto
             }
         }
 
-        const ProtoSparseListImplementation* attrs = attributes;
+        const ProtoSparseListImplementation* attrs = nullptr;
         if (oc->parent && ((uintptr_t)oc->parent & 0x3F) == 0) {
             auto pl = toImpl<const ParentLinkImplementation>(oc->parent);
             if (pl->getType() == CellType::ParentLink) {
@@ -1717,23 +2080,23 @@ namespace proto
                 // partial tree is reachable only via this C++ local until
                 // the final `return`.
                 ProtoContext::CriticalSection cs(context);
+                attrs = attributes.asTree(context);
                 const ProtoSparseListIterator* it = parentAttrs->getIterator(context);
                 while (it && it->hasNext(context)) {
                     unsigned long key = it->nextKey(context);
                     const ProtoObject* value = it->nextValue(context);
-                    if (!attrs || attrs->implGetAt(context, key) == nullptr) {
-                        attrs = attrs ? attrs->implSetAt(context, key, value)
-                                      : new(context) ProtoSparseListImplementation(context, key, value, nullptr, nullptr, false);
+                    if (attrs->implGetAt(context, key) == nullptr) {
+                        attrs = attrs->implSetAt(context, key, value);
                     }
                     it = const_cast<ProtoSparseListIterator*>(it)->advance(context);
                 }
                 }
             }
         }
-        // Convert the IMPL pointer to the public API tagged handle at
-        // the boundary — this is the trampoline that returns to the
-        // user/external callers.
-        return attrs ? attrs->asSparseList(context) : context->newSparseList();
+        // Convert to the public API tagged handle at the boundary — this
+        // is the trampoline that returns to the user/external callers.
+        // Without a merge the own store is handed out as-is.
+        return attrs ? attrs->asSparseList(context) : attributes.asSparseList(context);
     }
     
     const ProtoSparseList* ProtoObject::getOwnAttributes(ProtoContext* context) const {
@@ -1741,7 +2104,7 @@ namespace proto
         pa.oid = this;
         if (pa.op.pointer_tag != POINTER_TAG_OBJECT) return context->newSparseList();
         auto oc = toImpl<const ProtoObjectCell>(this);
-        const ProtoSparseListImplementation* attributes = oc->attributes;
+        AttributeStore attributes = oc->attributes;
 
         if (oc->mutable_ref > 0) {
             const ProtoObject* storedState = resolveMutableSnapshot(context, oc->mutable_ref);
@@ -1750,9 +2113,10 @@ namespace proto
                 attributes = storedOc->attributes;
             }
         }
-        // Trampoline boundary: convert the internal IMPL pointer to the
-        // public-API tagged handle.
-        return attributes ? attributes->asSparseList(context) : context->newSparseList();
+        // Trampoline boundary: convert the internal store to the
+        // public-API tagged handle (the inline block is already a valid
+        // Small-form ProtoSparseList, so no copy).
+        return attributes.asSparseList(context);
     }
     
     const ProtoObject* ProtoObject::hasOwnAttribute(ProtoContext* context, const ProtoString* name) const {
@@ -1776,7 +2140,7 @@ namespace proto
 
         if (!proto::isObjectFast(this)) return PROTO_FALSE;
         auto oc = toImpl<const ProtoObjectCell>(this);
-        const ProtoSparseListImplementation* attributes = oc->attributes;
+        AttributeStore attributes = oc->attributes;
 
         if (oc->mutable_ref > 0) {
             const ProtoObject* storedState = resolveMutableSnapshot(context, oc->mutable_ref);
@@ -1784,10 +2148,9 @@ namespace proto
                 attributes = toImpl<const ProtoObjectCell>(storedState)->attributes;
             }
         }
-        // Direct IMPL probe — an attribute set to PROTO_NONE is still
-        // "present" (implGetAt returns PROTO_NONE, not nullptr).
-        return context->fromBoolean(
-            attributes && attributes->implGetAt(context, reinterpret_cast<uintptr_t>(name)) != nullptr);
+        // Direct store probe — an attribute set to PROTO_NONE is still
+        // "present" (getAt returns PROTO_NONE, not nullptr).
+        return context->fromBoolean(attributes.has(context, reinterpret_cast<uintptr_t>(name)));
     }
     
     const ProtoObject* ProtoObject::divmod(ProtoContext* context, const ProtoObject* other) const {
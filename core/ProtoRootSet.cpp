@@ -1,37 +1,40 @@
 /*
  * ProtoRootSet.cpp
  *
- * Embedder-owned GC root sets.  See ProtoRootSet in protoCore.h for
- * motivation and the public API.
+ * Embedder-owned GC root sets, and the thread-local ProtoHandleScope.
+ * See ProtoRootSet / ProtoHandleScope in protoCore.h for motivation and
+ * the public API.
  *
- * Implementation outline:
+ * Root set outline:
  *
- *   - A flat vector of slots, each holding either a live `(handle,
- *     ProtoObject*)` pair or a "free" marker.  The vector grows
- *     monotonically; slot indices are stable for the life of the
- *     root set.
+ *   - Slots live in fixed-size chunks reached through a chain of
+ *     fixed-size directories, the first one inline; a further directory
+ *     is linked in by CAS when the chain runs out.  A slot never moves
+ *     once allocated and may be read without a lock.  Slot indices are
+ *     stable for the life of the root set.
  *
- *   - A `std::mutex` protects mutation (add/remove) and iteration.
- *     Adds and removes are short and contention is bounded by the
- *     embedder's call rate; on the steady state they are amortised
- *     O(1) thanks to the free-list of recyclable slots.  Iteration
- *     happens only from the GC thread during STW, when mutators are
- *     parked, so the lock is uncontended in that path too.
+ *   - Freed slots go on a Treiber stack threaded through the slots
+ *     themselves.  The head carries a 32-bit tag next to the index to
+ *     defeat ABA; slot memory is never released before the set, so a
+ *     popper racing with another pop only ever reads a valid slot.
+ *     When the stack is empty a fresh index is taken from `highWater`.
  *
  *   - Handles are 64-bit and encode `(slot_index, generation)` so a
  *     stale handle from a freed slot cannot accidentally resolve to
- *     a different object after the slot is reused.  Generation
- *     counters wrap at 2^32; reuse after wrap-around is benign at
- *     normal call rates.
+ *     a different object after the slot is reused.  `remove` retires a
+ *     slot by CAS-ing its generation to 0, so two removes of the same
+ *     handle cannot both push the slot.  Generation counters wrap at
+ *     2^32; reuse after wrap-around is benign at normal call rates.
  *
- * The implementation is intentionally simple: no atomics, no
- * lock-free pop.  In benchmarks the JS thread does at most a few
- * thousand pin/unpin per second, far below the threshold where mutex
- * contention would matter, and it is much easier to reason about
- * than a hand-rolled lock-free free list.
+ *   - Iteration happens from the GC thread during STW, when mutators
+ *     are parked, so it only has to skip slots that are free.
+ *
+ * Handle scopes are cheaper still: a per-thread stack of handle blocks
+ * (HandleArea, hung off the thread's ProtoThreadExtension) that only its
+ * owner writes, scanned by gcThreadLoop's Phase 2.
  */
 
-#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
 #include <algorithm>
 #include <cstring>
 #include <mutex>
@@ -43,28 +46,115 @@ struct ProtoRootSet::Impl {
     std::string name;
     ProtoSpace* owner;
 
-    // Slot layout: low 32 bits = slot index, high 32 bits = generation.
-    static constexpr unsigned long long kFreeMarker = 0;  // generation 0 == free
+    static constexpr unsigned int kChunkBits = 10;
+    static constexpr unsigned int kChunkSize = 1u << kChunkBits;
+    static constexpr unsigned int kDirectoryBits = 10;
+    static constexpr unsigned int kDirectorySize = 1u << kDirectoryBits;  // 1M slots per directory
+    static constexpr unsigned int kNoSlot = 0xFFFFFFFFu;
 
     struct Slot {
-        const ProtoObject* obj = nullptr;
-        unsigned int generation = 0;  // 0 means free; >=1 means live
+        std::atomic<const ProtoObject*> obj{nullptr};
+        std::atomic<unsigned int> generation{0};  // 0 means free; >=1 means live
+        std::atomic<unsigned int> nextFree{kNoSlot};
+    };
+
+    struct Directory {
+        std::atomic<Slot*> chunks[kDirectorySize] = {};
+        std::atomic<Directory*> next{nullptr};
     };
 
-    std::vector<Slot> slots;
-    std::vector<unsigned int> freeList;  // indices of free slots
-    unsigned int nextGeneration = 1;
-    unsigned long liveCount = 0;
-    mutable std::mutex mutex;
+    Directory directory;
+    std::atomic<unsigned int> highWater{0};
+    // Low 32 bits: index of the top free slot (kNoSlot if none).
+    // High 32 bits: ABA tag, bumped on every push and pop.
+    std::atomic<unsigned long long> freeHead{kNoSlot};
+    std::atomic<unsigned int> nextGeneration{1};
+    std::atomic<unsigned long> liveCount{0};
+
+    ~Impl() {
+        for (Directory* d = &directory; d; ) {
+            for (auto& c : d->chunks) delete[] c.load(std::memory_order_relaxed);
+            Directory* next = d->next.load(std::memory_order_relaxed);
+            if (d != &directory) delete d;
+            d = next;
+        }
+    }
+
+    // The chunk entry for \a idx, or nullptr when its directory has not
+    // been linked in yet.
+    const std::atomic<Slot*>* chunkEntry(unsigned int idx) const {
+        const Directory* d = &directory;
+        for (unsigned int hops = idx >> (kChunkBits + kDirectoryBits); hops && d; --hops)
+            d = d->next.load(std::memory_order_acquire);
+        return d ? &d->chunks[(idx >> kChunkBits) & (kDirectorySize - 1)] : nullptr;
+    }
+
+    std::atomic<Slot*>& ensureChunkEntry(unsigned int idx) {
+        Directory* d = &directory;
+        for (unsigned int hops = idx >> (kChunkBits + kDirectoryBits); hops; --hops) {
+            Directory* next = d->next.load(std::memory_order_acquire);
+            if (!next) {
+                auto* fresh = new Directory();
+                if (d->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel))
+                    next = fresh;
+                else
+                    delete fresh;  // another adder linked it first
+            }
+            d = next;
+        }
+        return d->chunks[(idx >> kChunkBits) & (kDirectorySize - 1)];
+    }
+
+    Slot* slotAt(unsigned int idx) const {
+        if (idx >= highWater.load(std::memory_order_acquire)) return nullptr;
+        const std::atomic<Slot*>* entry = chunkEntry(idx);
+        Slot* chunk = entry ? entry->load(std::memory_order_acquire) : nullptr;
+        return chunk ? &chunk[idx & (kChunkSize - 1)] : nullptr;
+    }
+
+    Slot* ensureSlot(unsigned int idx) {
+        std::atomic<Slot*>& entry = ensureChunkEntry(idx);
+        Slot* chunk = entry.load(std::memory_order_acquire);
+        if (!chunk) {
+            Slot* fresh = new Slot[kChunkSize];
+            if (entry.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel))
+                chunk = fresh;
+            else
+                delete[] fresh;  // another adder installed it first
+        }
+        return &chunk[idx & (kChunkSize - 1)];
+    }
+
+    unsigned int popFree() {
+        unsigned long long head = freeHead.load(std::memory_order_acquire);
+        while (static_cast<unsigned int>(head) != kNoSlot) {
+            const unsigned int idx = static_cast<unsigned int>(head);
+            const unsigned int next = slotAt(idx)->nextFree.load(std::memory_order_relaxed);
+            const unsigned long long tag = (head >> 32) + 1;
+            if (freeHead.compare_exchange_weak(head, (tag << 32) | next,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire))
+                return idx;
+        }
+        return kNoSlot;
+    }
+
+    void pushFree(unsigned int idx, Slot* slot) {
+        unsigned long long head = freeHead.load(std::memory_order_relaxed);
+        unsigned long long desired;
+        do {
+            slot->nextFree.store(static_cast<unsigned int>(head), std::memory_order_relaxed);
+            desired = (((head >> 32) + 1) << 32) | idx;
+        } while (!freeHead.compare_exchange_weak(head, desired,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
 };
 
 ProtoRootSet::ProtoRootSet(ProtoSpace* owner, const char* name)
     : impl_(new Impl{}) {
     impl_->owner = owner;
     impl_->name = name ? name : "";
-    // Reserve a small initial capacity to avoid reallocs in the common
-    // case (a few hundred outstanding async callbacks).
-    impl_->slots.reserve(64);
 }
 
 ProtoRootSet::~ProtoRootSet() {
@@ -73,22 +163,26 @@ ProtoRootSet::~ProtoRootSet() {
 
 ProtoRootSet::Handle ProtoRootSet::add(const ProtoObject* obj) {
     if (!obj) return kNullHandle;
-    std::lock_guard<std::mutex> lock(impl_->mutex);
 
-    unsigned int idx;
-    if (!impl_->freeList.empty()) {
-        idx = impl_->freeList.back();
-        impl_->freeList.pop_back();
+    Impl::Slot* slot;
+    unsigned int idx = impl_->popFree();
+    if (idx != Impl::kNoSlot) {
+        slot = impl_->slotAt(idx);
     } else {
-        idx = static_cast<unsigned int>(impl_->slots.size());
-        impl_->slots.emplace_back();
+        idx = impl_->highWater.load(std::memory_order_relaxed);
+        do {
+            // Every 32-bit index but kNoSlot is in use: report it rather
+            // than wrap onto live slots.
+            if (idx == Impl::kNoSlot) return kNullHandle;
+        } while (!impl_->highWater.compare_exchange_weak(idx, idx + 1, std::memory_order_acq_rel));
+        slot = impl_->ensureSlot(idx);
     }
-    auto& slot = impl_->slots[idx];
-    unsigned int gen = impl_->nextGeneration++;
-    if (gen == 0) gen = impl_->nextGeneration++;  // skip the "free" marker
-    slot.obj = obj;
-    slot.generation = gen;
-    impl_->liveCount++;
+
+    unsigned int gen = impl_->nextGeneration.fetch_add(1, std::memory_order_relaxed);
+    if (gen == 0) gen = impl_->nextGeneration.fetch_add(1, std::memory_order_relaxed);  // skip the "free" marker
+    slot->obj.store(obj, std::memory_order_relaxed);
+    slot->generation.store(gen, std::memory_order_release);
+    impl_->liveCount.fetch_add(1, std::memory_order_relaxed);
     return (static_cast<Handle>(gen) << 32) | static_cast<Handle>(idx);
 }
 
@@ -96,30 +190,29 @@ const ProtoObject* ProtoRootSet::resolve(Handle h) const {
     if (h == kNullHandle) return nullptr;
     unsigned int idx = static_cast<unsigned int>(h & 0xFFFFFFFFu);
     unsigned int gen = static_cast<unsigned int>(h >> 32);
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    if (idx >= impl_->slots.size()) return nullptr;
-    const auto& slot = impl_->slots[idx];
-    if (slot.generation != gen) return nullptr;
-    return slot.obj;
+    const Impl::Slot* slot = impl_->slotAt(idx);
+    if (!slot || slot->generation.load(std::memory_order_acquire) != gen) return nullptr;
+    const ProtoObject* obj = slot->obj.load(std::memory_order_acquire);
+    // Re-check: the slot may have been removed (and reused) meanwhile.
+    if (slot->generation.load(std::memory_order_acquire) != gen) return nullptr;
+    return obj;
 }
 
 void ProtoRootSet::remove(Handle h) {
     if (h == kNullHandle) return;
     unsigned int idx = static_cast<unsigned int>(h & 0xFFFFFFFFu);
     unsigned int gen = static_cast<unsigned int>(h >> 32);
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    if (idx >= impl_->slots.size()) return;
-    auto& slot = impl_->slots[idx];
-    if (slot.generation != gen) return;  // stale handle — silent no-op
-    slot.obj = nullptr;
-    slot.generation = 0;  // mark free
-    impl_->freeList.push_back(idx);
-    impl_->liveCount--;
+    Impl::Slot* slot = impl_->slotAt(idx);
+    if (!slot) return;
+    // Stale handle (or a concurrent remove won) — silent no-op.
+    if (!slot->generation.compare_exchange_strong(gen, 0, std::memory_order_acq_rel)) return;
+    slot->obj.store(nullptr, std::memory_order_relaxed);
+    impl_->liveCount.fetch_sub(1, std::memory_order_relaxed);
+    impl_->pushFree(idx, slot);
 }
 
 unsigned long ProtoRootSet::size() const {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->liveCount;
+    return impl_->liveCount.load(std::memory_order_relaxed);
 }
 
 const char* ProtoRootSet::getName() const {
@@ -130,17 +223,70 @@ void ProtoRootSet::forEachRoot(
     void (*visit)(void* user, const ProtoObject* obj),
     void* user) const {
     if (!visit) return;
-    // The GC normally calls this during STW where the lock is
-    // uncontended; locking unconditionally also makes the method
-    // safe to invoke from diagnostic code at any time.
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    for (const auto& slot : impl_->slots) {
-        if (slot.generation != 0 && slot.obj) {
-            visit(user, slot.obj);
+    const unsigned long long n = impl_->highWater.load(std::memory_order_acquire);
+    unsigned long long base = 0;
+    for (const Impl::Directory* d = &impl_->directory; d && base < n;
+         d = d->next.load(std::memory_order_acquire)) {
+        for (unsigned int c = 0; c < Impl::kDirectorySize && base < n; ++c, base += Impl::kChunkSize) {
+            const Impl::Slot* chunk = d->chunks[c].load(std::memory_order_acquire);
+            if (!chunk) continue;
+            const unsigned int end = static_cast<unsigned int>(
+                std::min<unsigned long long>(Impl::kChunkSize, n - base));
+            for (unsigned int i = 0; i < end; ++i) {
+                if (chunk[i].generation.load(std::memory_order_acquire) == 0) continue;
+                const ProtoObject* obj = chunk[i].obj.load(std::memory_order_relaxed);
+                if (obj) visit(user, obj);
+            }
         }
     }
 }
 
+// ---- ProtoHandleScope -------------------------------------------------
+
+HandleArea::HandleArea() : first(new HandleBlock{nullptr, nullptr, {}}), current(first), used(0) {}
+
+HandleArea::~HandleArea() {
+    HandleBlock* b = first;
+    while (b) {
+        HandleBlock* next = b->next;
+        delete b;
+        b = next;
+    }
+}
+
+void HandleArea::push(const ProtoObject* obj) {
+    if (used == HandleBlock::CAPACITY) {
+        if (!current->next) current->next = new HandleBlock{current, nullptr, {}};
+        current = current->next;
+        used = 0;
+    }
+    current->slots[used++] = obj;
+}
+
+ProtoHandleScope::ProtoHandleScope(ProtoContext* context) {
+    if (!context || !context->thread) {
+        std::cerr << "ProtoHandleScope: context has no owning thread" << std::endl;
+        std::abort();
+    }
+    ProtoThreadExtension* ext = toImpl<ProtoThreadImplementation>(context->thread)->extension;
+    // The collector only reads `handles` while this thread is parked, so
+    // installing it lazily here needs no synchronisation.
+    if (!ext->handles) ext->handles = new HandleArea();
+    area_ = ext->handles;
+    savedBlock_ = area_->current;
+    savedUsed_ = area_->used;
+}
+
+ProtoHandleScope::~ProtoHandleScope() {
+    area_->current = savedBlock_;
+    area_->used = savedUsed_;
+}
+
+const ProtoObject* ProtoHandleScope::pin(const ProtoObject* obj) {
+    if (obj && ProtoObject::isCellPointer(obj)) area_->push(obj);
+    return obj;
+}
+
 // ---- ProtoSpace integration -------------------------------------------
 
 ProtoRootSet* ProtoSpace::createRootSet(const char* name) {
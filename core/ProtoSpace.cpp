@@ -6,6 +6,7 @@
  */
 
 #include "../headers/proto_internal.h"
+#include <array>
 #include <iostream>
 #include <cstdlib>
 #include <set>
@@ -17,12 +18,19 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <cerrno>
 #include <chrono>
 #include <thread>
+#include <sys/mman.h>
 #if defined(__linux__)
 #include <sys/syscall.h>
 #include <unistd.h>
 #endif
+#if defined(__linux__) || defined(__APPLE__)
+#include <execinfo.h>
+#include <pthread.h>
+#endif
 
 namespace proto {
 
@@ -33,6 +41,8 @@ namespace proto {
         constexpr int kMaxBlocksPerOSAllocation = static_cast<int>(kMaxBytesPerOSAllocation / sizeof(BigCell));
 
         std::atomic<uint64_t> s_getFreeCellsCalls{0};
+        // Source of ProtoSpace::serial; starts at 1 so 0 never names a space.
+        std::atomic<uint64_t> nextSpaceSerial{1};
         static long long diagCurrentTid() {
 #if defined(__linux__)
             return static_cast<long long>(syscall(SYS_gettid));
@@ -108,6 +118,256 @@ namespace proto {
             space->freeCellsCount += count;
         }
 
+        // The safepoint watchdog's view of one stop: its settings, copied
+        // under globalMutex, and when each thread was last seen parked or
+        // unmanaged.  Lives in gcThreadLoop, so only the collector touches it.
+        struct SafepointWatch {
+            unsigned long thresholdMicros = 0;
+            ProtoSafepointLaggardCallback callback = nullptr;
+            void* userData = nullptr;
+            bool captureStacks = false;
+            std::unordered_map<const ProtoThreadImplementation*,
+                               std::chrono::steady_clock::time_point> lastSeen;
+        };
+
+        unsigned long microsBetween(std::chrono::steady_clock::time_point from,
+                                    std::chrono::steady_clock::time_point to) {
+            return static_cast<unsigned long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+        }
+
+        void reportLaggardToStderr(void*, const ProtoSafepointLaggard& laggard) {
+            std::cerr << "protoCore: thread '" << laggard.name << "' has kept a stop-the-world waiting for "
+                      << laggard.waitedMicros / 1000 << " ms";
+            if (laggard.seenAtSafepoint)
+                std::cerr << "; last at a safepoint " << laggard.sinceSafepointMicros / 1000
+                          << " ms before the stop";
+            else
+                std::cerr << "; not at a safepoint since it started";
+            std::cerr << std::endl;
+#if defined(__linux__) || defined(__APPLE__)
+            if (!laggard.stack.empty())
+                backtrace_symbols_fd(laggard.stack.data(), static_cast<int>(laggard.stack.size()), STDERR_FILENO);
+#endif
+        }
+
+        void reportLaggard(ProtoSpace* space, const SafepointWatch& watch,
+                           const ProtoThreadImplementation* thread,
+                           std::chrono::steady_clock::time_point stopBegan,
+                           unsigned long waitedMicros) {
+            ProtoSafepointLaggard laggard;
+            laggard.thread = thread->asThread(space->rootContext);
+            if (thread->name) laggard.name = thread->name->toStdString(space->rootContext);
+            laggard.waitedMicros = waitedMicros;
+            auto seen = watch.lastSeen.find(thread);
+            laggard.seenAtSafepoint = seen != watch.lastSeen.end();
+            laggard.sinceSafepointMicros = laggard.seenAtSafepoint ? microsBetween(seen->second, stopBegan) : 0;
+            if (watch.captureStacks) {
+                const std::thread* osThread = thread->extension->osThread;
+                void* frames[64];
+                const int depth = captureThreadStack(
+                    osThread ? const_cast<std::thread*>(osThread)->native_handle() : space->mainThreadHandle,
+                    frames, 64, 100000);
+                laggard.stack.assign(frames, frames + depth);
+            }
+            (watch.callback ? watch.callback : reportLaggardToStderr)(watch.userData, laggard);
+        }
+
+        // Records a stop-the-world's length against the pause budget in
+        // force when it began.
+        void publishPause(ProtoSpace* space, unsigned long budgetMicros, unsigned long pauseMicros) {
+            const bool met = budgetMicros == 0 || pauseMicros <= budgetMicros;
+            space->pauseLastCycle.store(pauseMicros, std::memory_order_relaxed);
+            space->pauseBudgetMetLastCycle.store(met, std::memory_order_relaxed);
+            if (!met) space->pauseBudgetMissedCycles.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Cuts the collector's concurrent work into slices no longer than
+        // the pause budget and yields the CPU between them, so mutators
+        // sharing a core with the collector still get their quantum.  The
+        // clock is read every 256 units of work; with no budget, step()
+        // does nothing.
+        class WorkSlicer {
+        public:
+            explicit WorkSlicer(unsigned long budgetMicros)
+                : budgetMicros(budgetMicros), sliceBegan(std::chrono::steady_clock::now()) {}
+
+            void step() {
+                if (budgetMicros == 0 || (++work & 255) != 0) return;
+                if (microsBetween(sliceBegan, std::chrono::steady_clock::now()) < budgetMicros) return;
+                std::this_thread::yield();
+                sliceBegan = std::chrono::steady_clock::now();
+            }
+
+        private:
+            const unsigned long budgetMicros;
+            std::chrono::steady_clock::time_point sliceBegan;
+            unsigned long work = 0;
+        };
+
+        // The collector's grey set: a stack of fixed capacity, allocated
+        // once by the collector thread.  A push onto a full stack marks the
+        // cell instead and appends it to the cycle's markedList without
+        // scanning it; the drain loop then rescans markedList from the first
+        // such cell.  Mark memory is the capacity plus markedList (one
+        // pointer per live cell) whatever the shape of the heap.
+        class MarkStack {
+        public:
+            void reset(unsigned long newCapacity, std::vector<const Cell*>* newMarked) {
+                if (newCapacity == 0) newCapacity = 1;
+                if (newCapacity != capacity) {
+                    slots.reset(new const Cell*[newCapacity]);
+                    capacity = newCapacity;
+                }
+                depth = 0;
+                marked = newMarked;
+                rescanFrom = SIZE_MAX;
+                overflows = 0;
+            }
+
+            void push(const Cell* cell) {
+                if (depth < capacity) {
+                    slots[depth++] = cell;
+                    return;
+                }
+                if (cell->isMarked()) return;
+                const_cast<Cell*>(cell)->mark();
+                rescanFrom = std::min(rescanFrom, marked->size());
+                marked->push_back(cell);
+                ++overflows;
+            }
+
+            bool empty() const { return depth == 0; }
+            const Cell* top() const { return slots[depth - 1]; }
+            const Cell* pop() { return slots[--depth]; }
+
+            // Index into markedList of the first cell marked on overflow
+            // since the last call, or SIZE_MAX if none was.
+            size_t takeRescanFrom() {
+                const size_t from = rescanFrom;
+                rescanFrom = SIZE_MAX;
+                return from;
+            }
+
+            unsigned long overflows = 0;
+
+        private:
+            std::unique_ptr<const Cell*[]> slots;
+            unsigned long capacity = 0;
+            unsigned long depth = 0;
+            std::vector<const Cell*>* marked = nullptr;
+            size_t rescanFrom = SIZE_MAX;
+        };
+
+        // Returns once every registered thread reports a non-zero
+        // unmanagedDepth (parked, unmanaged, not started or finished), or
+        // the space is ending.  Threads usually reach a safepoint within
+        // microseconds, so each one is polled briefly before futex-waiting
+        // on its state word; its transition out of managed code wakes us.
+        // Threads registered after the walk start unmanaged, and park on
+        // stwFlag before running managed code.
+        //
+        // With the watchdog on, a thread still running after the threshold
+        // is reported, and again each time the wait doubles.  The longest
+        // wait is published as timeToSafepointLastCycle.
+        void waitForSafepoints(ProtoSpace* space, SafepointWatch& watch) {
+            using Clock = std::chrono::steady_clock;
+            const Clock::time_point stopBegan = Clock::now();
+            std::unordered_map<const ProtoThreadImplementation*, Clock::time_point> seen;
+            unsigned long longest = 0;
+            space->threads->forEach([&](ProtoThreadImplementation* thread) {
+                std::atomic<int>& depth = thread->extension->unmanagedDepth;
+                unsigned long nextReport = watch.thresholdMicros;
+                for (int polls = 0; depth.load() == 0; ++polls) {
+                    if (space->state == SPACE_STATE_ENDING) return;
+                    if (polls < 64) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    long timeout = 10000;
+                    if (nextReport) {
+                        const unsigned long waited = microsBetween(stopBegan, Clock::now());
+                        if (waited >= nextReport) {
+                            reportLaggard(space, watch, thread, stopBegan, waited);
+                            while (nextReport <= waited) nextReport *= 2;
+                        }
+                        timeout = std::min<long>(timeout, static_cast<long>(nextReport - waited));
+                    }
+                    futexWait(depth, 0, timeout);
+                }
+                const Clock::time_point now = Clock::now();
+                seen[thread] = now;
+                longest = std::max(longest, microsBetween(stopBegan, now));
+            });
+            watch.lastSeen.swap(seen);
+            space->timeToSafepointLastCycle.store(longest, std::memory_order_relaxed);
+        }
+
+        // Waits, for at most maxMicros, until no thread has a no-GC region
+        // open.  The thread closing the last region wakes us through
+        // noGCStopPending.
+        // Returns false when regions were still open at the deadline.
+        bool waitForNoGCRegions(ProtoSpace* space, unsigned long maxMicros) {
+            using Clock = std::chrono::steady_clock;
+            const Clock::time_point deadline = Clock::now() + std::chrono::microseconds(maxMicros);
+            space->noGCStopPending.store(true);
+            bool closed = true;
+            for (int open = space->noGCRegions.load(); open > 0; open = space->noGCRegions.load()) {
+                if (space->state == SPACE_STATE_ENDING) break;
+                const long left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()).count();
+                if (left <= 0) {
+                    closed = false;
+                    break;
+                }
+                futexWait(space->noGCRegions, open, std::min(left, 10000L));
+            }
+            space->noGCStopPending.store(false);
+            return closed;
+        }
+
+        // Expires every no-GC region open for at least maxMicros: it stops
+        // counting in noGCRegions, and its thread parks at its next
+        // safepoint as if it had closed.  Each one counts in noGCOverruns
+        // and goes to the overrun callback now, from the collector, rather
+        // than whenever (if ever) it closes.
+        void expireNoGCRegions(ProtoSpace* space, unsigned long maxMicros,
+                               ProtoNoGCOverrunCallback callback, void* userData) {
+            using Clock = std::chrono::steady_clock;
+            const Clock::time_point now = Clock::now();
+            space->threads->forEach([&](ProtoThreadImplementation* thread) {
+                ThreadRegistry::NoGCSlot& slot = space->threads->noGCSlot(thread->extension->registrySlot);
+                int state = slot.state.load(std::memory_order_acquire);
+                if (state != ThreadRegistry::NoGCSlot::OPEN) return;
+                const Clock::time_point entered{Clock::duration(slot.entered.load(std::memory_order_relaxed))};
+                const unsigned long micros = microsBetween(entered, now);
+                if (micros < maxMicros) return;
+                // Lost to the owner closing it meanwhile.
+                if (!slot.state.compare_exchange_strong(state, ThreadRegistry::NoGCSlot::EXPIRED)) return;
+                space->noGCRegions.fetch_sub(1);
+                space->noGCOverruns.fetch_add(1, std::memory_order_relaxed);
+                if (callback) callback(userData, thread->asThread(space->rootContext), micros);
+            });
+        }
+
+        void restartTheWorld(ProtoSpace* space) {
+            space->stwFlag.store(0);
+            futexWake(space->stwFlag);
+        }
+
+        void publishHeapCensus(ProtoSpace* space,
+                               const std::array<unsigned long, CELL_TYPE_COUNT>& live,
+                               const std::array<unsigned long, CELL_TYPE_COUNT>& reclaimed) {
+            ProtoHeapCensus& census = space->heapCensusLastCycle;
+            census.cycle = space->gcCycleCount.load(std::memory_order_relaxed);
+            census.entries.clear();
+            for (size_t type = 0; type < CELL_TYPE_COUNT; ++type) {
+                if (live[type] || reclaimed[type])
+                    census.entries.push_back({cellTypeName(static_cast<CellType>(type)), live[type], reclaimed[type]});
+            }
+            std::stable_sort(census.entries.begin(), census.entries.end(),
+                             [](const ProtoHeapCensusEntry& a, const ProtoHeapCensusEntry& b) { return a.live > b.live; });
+        }
+
         void gcThreadLoop(ProtoSpace* space) {
             std::unique_lock<std::recursive_mutex> lock(ProtoSpace::globalMutex);
             GC_LOCK_TRACE("gcLoop ACQ(init)");
@@ -124,6 +384,10 @@ namespace proto {
             static std::atomic<uint64_t> dbg_total_segments_swept{0};
             const bool dbg_profile = std::getenv("PROTOCORE_GC_PROFILE") != nullptr;
 #endif
+            SafepointWatch watch;
+            MarkStack workList;
+            // The pending cycle was already postponed for a no-GC region.
+            bool postponedForNoGC = false;
             while (space->state != SPACE_STATE_ENDING) {
                 // Wait for a GC trigger or space ending
                 space->gcCV.wait(lock, [space] {
@@ -136,18 +400,67 @@ namespace proto {
 #endif
                 
                 // --- PHASE 1: STOP THE WORLD ---
-                space->stwFlag.store(true);
-                // We need to wait until ALL other threads are parked
-                // runningThreads includes all application threads.
-                // GC thread doesn't increment/decrement runningThreads.
-                // We need to wait until ALL other threads are parked
-                // runningThreads includes all application threads.
-                // GC thread doesn't increment/decrement runningThreads.
-                space->gcCV.wait(lock, [space] {
-                    return space->parkedThreads.load() >= space->runningThreads.load() || space->state == SPACE_STATE_ENDING;
-                });
+                // Wait, with globalMutex released, until every registered
+                // thread is parked or unmanaged.
+                watch.thresholdMicros = space->safepointWatchdogMicros;
+                watch.callback = space->safepointLaggardCallback;
+                watch.userData = space->safepointLaggardUserData;
+                watch.captureStacks = space->captureLaggardStacks;
+                const unsigned long pauseBudget = space->pauseBudgetMicros;
+                const bool census = space->heapCensusEnabled;
+                const uint64_t traceCycle = traceBegin(space);
+                if (traceCycle) space->traceRecorder->nameThread("protoCore GC");
+                PROTO_PROBE1(gc_start, space->gcCycleCount.load(std::memory_order_relaxed) + 1);
+                // Open no-GC regions get up to noGCMaxMicros to close.  Past
+                // that the overdue ones are reported and expired, and the
+                // stop goes ahead; their threads park at their next
+                // safepoint.  Regions younger than the limit postpone the
+                // cycle, with the world still running, and the wait starts
+                // over: none of them can hold it off past its own limit.
+                if (const int open = space->noGCRegions.load()) {
+                    if (!postponedForNoGC) space->noGCDeferredCycles.fetch_add(1, std::memory_order_relaxed);
+                    const unsigned long maxMicros = space->noGCMaxMicros.load(std::memory_order_relaxed);
+                    const ProtoNoGCOverrunCallback overrunCallback = space->noGCOverrunCallback;
+                    void* const overrunUserData = space->noGCOverrunUserData;
+                    lock.unlock();
+                    const uint64_t traceNoGC = traceBegin(space);
+                    const bool closed = waitForNoGCRegions(space, maxMicros);
+                    traceEnd(space, traceNoGC, "gc.noGCWait", "regions", open);
+                    if (!closed) expireNoGCRegions(space, maxMicros, overrunCallback, overrunUserData);
+                    lock.lock();
+                    if (space->state == SPACE_STATE_ENDING) break;
+                    if (!closed && space->noGCRegions.load()) {
+                        if (!postponedForNoGC) space->noGCPostponedCycles.fetch_add(1, std::memory_order_relaxed);
+                        postponedForNoGC = true;
+                        space->gcStarted = true;
+                        continue;
+                    }
+                }
+                const auto stopRequested = std::chrono::steady_clock::now();
+                const uint64_t tracePause = traceBegin(space);
+                PROTO_PROBE0(gc_stop_requested);
+                space->stwFlag.store(1);
+                // A region that opened after the check above either saw the
+                // stop on entry and is parking, or is counted here (both
+                // sides are seq_cst; see implEnterNoGC).  Back off instead
+                // of stopping the world under it, and wait for it next time.
+                if (space->noGCRegions.load()) {
+                    restartTheWorld(space);
+                    space->gcStarted = true;
+                    continue;
+                }
+                postponedForNoGC = false;
+                lock.unlock();
+                waitForSafepoints(space, watch);
+                traceEnd(space, tracePause, "gc.safepointWait");
+                PROTO_PROBE1(gc_world_stopped, space->timeToSafepointLastCycle.load(std::memory_order_relaxed));
+                uint64_t tracePhase = traceBegin(space);
+                lock.lock();
                 GC_LOCK_TRACE("gcLoop ACQ(parked)");
-                if (space->state == SPACE_STATE_ENDING) break;
+                if (space->state == SPACE_STATE_ENDING) {
+                    restartTheWorld(space);
+                    break;
+                }
 #ifdef PROTOCORE_GC_INSTRUMENT
                 auto t_phase2_start = std::chrono::steady_clock::now();
                 dbg_total_phase1_us.fetch_add(
@@ -157,14 +470,40 @@ namespace proto {
 #endif
 
                 // --- PHASE 2: COLLECT ROOTS ---
-                std::vector<const Cell*> workList;
+                // Every cell marked this cycle, in marking order (see
+                // Phase 4); roots that overflow the mark stack land here
+                // already.
+                std::vector<const Cell*> markedList;
+                workList.reset(space->markStackCapacity, &markedList);
+                // Cell chains whose outgoing references are roots but whose
+                // links no mutator rewrites: traced after the restart.
+                struct DeferredChain { const Cell* head; const char* phase; HeapRootKind kind; };
+                std::vector<DeferredChain> deferredChains;
+                // A pending writeHeapSnapshot also records every root with
+                // the category of the section that found it.
+                HeapSnapshotRequest* snapshot = space->heapSnapshotRequest;
+                std::vector<HeapSnapshotRoot> snapshotRoots;
+                HeapRootKind rootKind = HeapRootKind::Thread;
+                // Sampled allocations are followed through the cycle.
+                AllocationProfiler* profile = space->allocationProfiler;
+                auto addRootCell = [&](const Cell* cell) {
+                    workList.push(cell);
+                    if (snapshot) snapshotRoots.push_back({cell, rootKind});
+                };
                 auto addRootObj = [&](const ProtoObject* obj) {
                     if (ProtoObject::isCellPointer(obj)) {
-                        workList.push_back(ProtoObject::asCellPointer(obj));
+                        addRootCell(ProtoObject::asCellPointer(obj));
                     }
                 };
 
-                auto scanContexts = [&](ProtoContext* currentCtx) {
+                auto scanContexts = [&](ProtoContext* currentCtx, bool withHandles = true) {
+                    // Roots: the thread's open ProtoHandleScopes.  Only the
+                    // owning thread writes its handle area, and it is parked.
+                    if (withHandles && currentCtx && currentCtx->thread) {
+                        const ProtoThreadExtension* ext =
+                            toImpl<const ProtoThreadImplementation>(currentCtx->thread)->extension;
+                        if (ext && ext->handles) ext->handles->forEach(addRootObj);
+                    }
                     while (currentCtx) {
                         // Roots: Automatic locals
                         for (unsigned int i = 0; i < currentCtx->getAutomaticLocalsCount(); ++i) {
@@ -180,7 +519,7 @@ namespace proto {
                         }
                         // Push pending root
                         if (currentCtx->pendingRoot) {
-                            workList.push_back(currentCtx->pendingRoot);
+                            addRootCell(currentCtx->pendingRoot);
                         }
                         
                         // Roots: Young generation (pinned objects allocated in this context)
@@ -188,63 +527,30 @@ namespace proto {
                         // We scan their references to find pointers to older objects, but we don't
                         // mark the young objects themselves yet. They will be submitted to the GC
                         // only at the end of the method execution (ProtoContext destructor).
-                        Cell* youngCell = nullptr;
+                        //
+                        // Only the chain head is read here.  Allocation
+                        // prepends and submission hands the chain over
+                        // unchanged, so the links below the head stay put
+                        // until a later cycle sweeps them; the chain is
+                        // walked after the world restarts.
                         while (currentCtx->lock.test_and_set(std::memory_order_acquire)) {}
-                        youngCell = currentCtx->lastAllocatedCell;
+                        Cell* youngCell = currentCtx->lastAllocatedCell;
                         currentCtx->lock.clear(std::memory_order_release);
-
-                        if (youngCell) {
-                            Cell* scanCell = youngCell;
-                            struct GCLambdaState { std::vector<const Cell*>* wl; const Cell* parent; const char* phase; } state = {&workList, scanCell, "Phase2(Young)"};
-                            while (scanCell) {
-                                state.parent = scanCell;
-                                scanCell->processReferences(space->rootContext, &state, [](ProtoContext* ctx, void* self, const Cell* ref) {
-                                    auto* s = static_cast<GCLambdaState*>(self);
-                                    if (reinterpret_cast<uintptr_t>(ref) & 1) { std::cerr << "CRITICAL TAGGED POINTER 2 (Y): " << ref << " from parent " << s->parent << " type " << (int)s->parent->getType() << std::endl; std::abort(); }
-                                    s->wl->push_back(ref);
-                                });
-                                scanCell = scanCell->getNext();
-                            }
-                        }
+                        if (youngCell) deferredChains.push_back({youngCell, "young", HeapRootKind::Young});
                         currentCtx = currentCtx->previous;
                     }
                 };
 
-                // 1. Scan Thread Stacks.  The threads list may now be in
-                // either form (Small with ≤ 3 entries — typical for the
-                // common 1-3-thread process; AVL otherwise).  Branch on
-                // pointer tag and walk inline pairs for Small, AVL nodes
-                // otherwise.
-                if (space->threads) {
-                    const ProtoObject* rootObj = reinterpret_cast<const ProtoObject*>(space->threads);
-                    if (ProtoObject::isCellPointer(rootObj)) {
-                        ProtoObjectPointer pa{}; pa.oid = rootObj;
-                        if (pa.op.pointer_tag == POINTER_TAG_SPARSE_LIST_SMALL) {
-                            const auto* small = toImpl<const ProtoSparseListSmallImplementation>(rootObj);
-                            for (unsigned i = 0; i < ProtoSparseListSmallImplementation::MAX_INLINE; ++i) {
-                                if (small->keys[i] == 0) continue;
-                                const ProtoObject* v = small->values[i];
-                                if (v && v->asThread(space->rootContext)) {
-                                    scanContexts(toImpl<const ProtoThreadImplementation>(v->asThread(space->rootContext))->context);
-                                }
-                            }
-                        } else {
-                            std::vector<const ProtoSparseListImplementation*> stack;
-                            stack.push_back(toImpl<const ProtoSparseListImplementation>(rootObj));
-                            while (!stack.empty()) {
-                                const ProtoSparseListImplementation* node = stack.back();
-                                stack.pop_back();
-                                if (!node->isEmpty && node->value && node->value->asThread(space->rootContext)) {
-                                    scanContexts(toImpl<const ProtoThreadImplementation>(node->value->asThread(space->rootContext))->context);
-                                }
-                                if (node->previous) stack.push_back(node->previous);
-                                if (node->next) stack.push_back(node->next);
-                            }
-                        }
-                    }
-                }
+                // 1. Scan Thread Stacks, and keep every registered
+                // thread cell (and so its extension) alive.
+                rootKind = HeapRootKind::Thread;
+                space->threads->forEach([&](ProtoThreadImplementation* thread) {
+                    addRootObj(thread->implAsObject(space->rootContext));
+                    scanContexts(thread->context);
+                });
                 
                 // 2. Global Roots
+                rootKind = HeapRootKind::Global;
                 addRootObj(space->objectPrototype);
                 addRootObj(space->booleanPrototype);
                 addRootObj(space->unicodeCharPrototype);
@@ -278,6 +584,7 @@ namespace proto {
                 // literalData is a strong Symbol — covered by the SymbolTable sweep below
                 if (space->resolutionChain_) addRootObj(space->resolutionChain_->asObject(space->rootContext));
 
+                rootKind = HeapRootKind::Module;
                 {
                     std::lock_guard<std::mutex> modLock(space->moduleRootsMutex);
                     for (const ProtoObject* mod : space->moduleRoots) {
@@ -299,7 +606,8 @@ namespace proto {
                         std::cerr << "CRITICAL TAGGED tupleRoot: " << tRoot << "\n";
                         std::abort();
                     }
-                    workList.push_back(tRoot);
+                    rootKind = HeapRootKind::TupleInterner;
+                    addRootCell(tRoot);
                 }
 
                 // stringInternMap is intentionally NOT scanned.  The map
@@ -344,13 +652,13 @@ namespace proto {
                 // Independent of heap size or live-object count.  No write
                 // barriers anywhere in the runtime — the snapshot replaces
                 // them.  See docs/STW_ELIMINATION_RESEARCH.md § 13.
+                rootKind = HeapRootKind::MutableShard;
                 for (int s = 0; s < ProtoSpace::MUTABLE_ROOT_SHARDS; ++s) {
                     ProtoSparseList* r =
                         space->mutableRoot[s].root.load(std::memory_order_acquire);
                     space->gcMutableSnapshot[s] = r;
                     if (r) addRootObj(reinterpret_cast<const ProtoObject*>(r));
                 }
-                if (space->threads) addRootObj(reinterpret_cast<const ProtoObject*>(space->threads));
                 
                 // Scan embedder-registered root sets.  Each set owns a
                 // private collection of `ProtoObject*` pinned by a
@@ -364,17 +672,18 @@ namespace proto {
                 // that signature (kept C-friendly for FFIs).  We
                 // route the addRootObj closure through a stack
                 // context structure passed as `user`.
+                rootKind = HeapRootKind::RootSet;
                 struct RootSetVisitCtx {
-                    std::vector<const Cell*>* workList;
+                    decltype(addRootCell)* addRoot;
                 };
-                RootSetVisitCtx rsCtx{&workList};
+                RootSetVisitCtx rsCtx{&addRootCell};
                 space->forEachRootSet(
                     [](void* user, ProtoRootSet* rs) {
                         rs->forEachRoot(
                             [](void* u, const ProtoObject* obj) {
                                 auto* c = static_cast<RootSetVisitCtx*>(u);
                                 if (ProtoObject::isCellPointer(obj)) {
-                                    c->workList->push_back(
+                                    (*c->addRoot)(
                                         ProtoObject::asCellPointer(obj));
                                 }
                             },
@@ -383,8 +692,27 @@ namespace proto {
                     &rsCtx);
 
                 // 3. Scan the Main Thread stack
+                rootKind = HeapRootKind::Thread;
                 scanContexts(space->mainContext);
 
+                // 4. Scan suspended fibers.  Their handle scopes were closed
+                // before they yielded, so only the context chains matter.
+                rootKind = HeapRootKind::Fiber;
+                {
+                    std::vector<ProtoContext*> fiberContexts;
+                    collectSuspendedFiberContexts(space, fiberContexts);
+                    for (ProtoContext* fiberCtx : fiberContexts) scanContexts(fiberCtx, false);
+                }
+
+                // 5. Values sitting in channel rings belong to no context
+                // until received; treat them as roots.
+                rootKind = HeapRootKind::Channel;
+                {
+                    std::vector<const Cell*> queued;
+                    collectChannelContents(space, queued);
+                    for (const Cell* value : queued) addRootCell(value);
+                }
+
                 // 6. Capture the heap snapshot (segments to process)
                 // This MUST be done during STW to ensure we only sweep what existed at root collection.
                 //
@@ -435,32 +763,55 @@ namespace proto {
                     }
                 } else {
                     // Stagger > 1, non-fold cycle: scan pen cells'
-                    // outgoing references so mark traces them.  Pen
-                    // pointer load is relaxed because we are inside STW;
-                    // mutators are parked and no sweep is in flight.
+                    // outgoing references so mark traces them.  Only the
+                    // collector touches the pen, so its chains are walked
+                    // after the restart like the young chains.
                     DirtySegment* penSeg = space->survivorPen.load(std::memory_order_relaxed);
                     while (penSeg) {
-                        Cell* scanCell = penSeg->cellChain;
-                        struct PenScanState { std::vector<const Cell*>* wl; const Cell* parent; } pst = {&workList, scanCell};
-                        while (scanCell) {
-                            pst.parent = scanCell;
-                            scanCell->processReferences(space->rootContext, &pst, [](ProtoContext* ctx, void* self, const Cell* ref) {
-                                auto* s = static_cast<PenScanState*>(self);
-                                if (reinterpret_cast<uintptr_t>(ref) & 1) {
-                                    std::cerr << "CRITICAL TAGGED POINTER (pen): " << ref << " from parent " << s->parent << " type " << (int)s->parent->getType() << std::endl;
-                                    std::abort();
-                                }
-                                s->wl->push_back(ref);
-                            });
-                            scanCell = scanCell->getNext();
-                        }
+                        if (penSeg->cellChain) deferredChains.push_back({penSeg->cellChain, "pen", HeapRootKind::SurvivorPen});
                         penSeg = penSeg->next;
                     }
                 }
 #endif
 
+                // Ancestor tables and chain summaries replaced since the
+                // last cycle: every mutator is parked, so none can still
+                // hold one.
+                space->reclaimRetiredLinkCaches();
+
+                // Weak refs and weak maps do not report their referents;
+                // snapshot them here, alongside the mutable-shard snapshot,
+                // for the ephemeron and grace passes after the mark.
+                WeakSnapshot weak;
+                collectWeakReferents(space, weak);
+
+                // Sampled cells whose constructors have finished since the
+                // sample get their types now, while no mutator is writing.
+                if (profile) profile->resolveTypes();
+
                 DirtySegment* segmentsToProcess = space->dirtySegments.exchange(nullptr, std::memory_order_acquire);
 
+                // A requested heap snapshot is written now, with the world
+                // still stopped.  The young and pen chains are only traced
+                // after the restart, so their references are added as
+                // roots here.
+                if (snapshot) {
+                    struct ChainRoots { std::vector<HeapSnapshotRoot>* roots; HeapRootKind kind; };
+                    for (const DeferredChain& chain : deferredChains) {
+                        ChainRoots chainRoots{&snapshotRoots, chain.kind};
+                        for (const Cell* cell = chain.head; cell; cell = cell->getNext()) {
+                            cell->processReferences(space->rootContext, &chainRoots, [](ProtoContext*, void* self, const Cell* ref) {
+                                auto* r = static_cast<ChainRoots*>(self);
+                                r->roots->push_back({ref, r->kind});
+                            });
+                        }
+                    }
+                    snapshot->written = writeHeapSnapshotFile(space, snapshot->path, snapshotRoots);
+                    snapshot->done = true;
+                    space->heapSnapshotRequest = nullptr;
+                    space->gcCV.notify_all();
+                }
+
                 // --- PHASE 3: RESUME THE WORLD ---
                 //
                 // The STW window closes HERE — before the mark phase, not
@@ -494,10 +845,16 @@ namespace proto {
                 // The change is described in detail in
                 // docs/GarbageCollector.md § "Concurrent Mark Without
                 // Barriers" and docs/STW_ELIMINATION_RESEARCH.md § 13.
-                space->stwFlag.store(false);
-                space->stopTheWorldCV.notify_all();
+                restartTheWorld(space);
+                publishPause(space, pauseBudget,
+                             microsBetween(stopRequested, std::chrono::steady_clock::now()));
+                traceEnd(space, tracePhase, "gc.roots", "roots", static_cast<long>(markedList.size()));
+                traceEnd(space, tracePause, "gc.pause");
+                PROTO_PROBE1(gc_world_restarted, space->pauseLastCycle.load(std::memory_order_relaxed));
+                tracePhase = traceBegin(space);
                 GC_LOCK_TRACE("gcLoop REL(mark)");
                 lock.unlock(); // Mark, sweep, and bulk-unmark all run unlocked.
+                WorkSlicer slicer(pauseBudget);
 #ifdef PROTOCORE_GC_INSTRUMENT
                 auto t_phase4_start = std::chrono::steady_clock::now();
                 dbg_total_phase2_us.fetch_add(
@@ -542,37 +899,116 @@ namespace proto {
                 // the marks", so a single iteration of gcThreadLoop
                 // is self-contained — no cross-iteration state
                 // beyond the cell mark bits themselves.
-                std::vector<const Cell*> markedList;
-                while (!workList.empty()) {
-                    const Cell* cell = workList.back();
-                    workList.pop_back();
-                    // Prefetch the NEXT cell to be popped — the mark
-                    // phase, like sweep, is a pointer-chasing loop
-                    // where each iteration loads
-                    // `cell->next_and_flags` to read the mark bit.
-                    // Prefetching the lookahead pop overlaps the
-                    // cache-line miss with the current cell's
-                    // mark + processReferences work.
-                    if (!workList.empty()) {
-                        const Cell* nextCell = workList.back();
-                        if (nextCell && (reinterpret_cast<uintptr_t>(nextCell) & 0x3F) == 0) {
-                            __builtin_prefetch(nextCell, 1, 1);
+                //
+                // The mark stack is bounded (see MarkStack): a cell pushed
+                // onto a full stack is marked and appended here unscanned,
+                // so once the stack drains, markedList is rescanned from
+                // the first such cell.  Rescanning a cell whose references
+                // were already traced only pushes marked cells, which the
+                // pop discards.
+                auto scanReferences = [&](const Cell* cell) {
+                    struct GCLambdaState { MarkStack* wl; const Cell* parent; } state = {&workList, cell};
+                    cell->processReferences(space->rootContext, &state, [](ProtoContext* ctx, void* self, const Cell* ref) {
+                        auto* s = static_cast<GCLambdaState*>(self);
+                        if (reinterpret_cast<uintptr_t>(ref) & 1) {
+                            std::cerr << "CRITICAL TAGGED POINTER 2: " << ref << " from parent " << s->parent << " type " << (int)s->parent->getType() << std::endl;
+                            std::abort();
+                        }
+                        s->wl->push(ref);
+                    });
+                };
+                auto drainStack = [&]() {
+                    while (!workList.empty()) {
+                        slicer.step();
+                        const Cell* cell = workList.pop();
+                        // Prefetch the NEXT cell to be popped — the mark
+                        // phase, like sweep, is a pointer-chasing loop
+                        // where each iteration loads
+                        // `cell->next_and_flags` to read the mark bit.
+                        // Prefetching the lookahead pop overlaps the
+                        // cache-line miss with the current cell's
+                        // mark + processReferences work.
+                        if (!workList.empty()) {
+                            const Cell* nextCell = workList.top();
+                            if (nextCell && (reinterpret_cast<uintptr_t>(nextCell) & 0x3F) == 0) {
+                                __builtin_prefetch(nextCell, 1, 1);
+                            }
+                        }
+
+                        if (!cell->isMarked()) {
+                            const_cast<Cell*>(cell)->mark();
+                            markedList.push_back(cell);
+                            scanReferences(cell);
+                        }
+                    }
+                };
+                auto drainWorkList = [&]() {
+                    drainStack();
+                    for (size_t from; (from = workList.takeRescanFrom()) != SIZE_MAX;) {
+                        // Overflows met while rescanning land past `end`
+                        // and are picked up by the next round.
+                        const size_t end = markedList.size();
+                        for (size_t i = from; i < end; ++i) {
+                            slicer.step();
+                            scanReferences(markedList[i]);
+                            drainStack();
                         }
                     }
+                };
 
-                    if (!cell->isMarked()) {
-                        const_cast<Cell*>(cell)->mark();
-                        markedList.push_back(cell);
-                        struct GCLambdaState { std::vector<const Cell*>* wl; const Cell* parent; } state = {&workList, cell};
-                        cell->processReferences(space->rootContext, &state, [](ProtoContext* ctx, void* self, const Cell* ref) {
+                // The young and pen chains captured in Phase 2: their
+                // cells are not candidates, only what they reference.
+                for (const DeferredChain& chain : deferredChains) {
+                    struct GCLambdaState { MarkStack* wl; const Cell* parent; const char* phase; } state = {&workList, chain.head, chain.phase};
+                    for (const Cell* scanCell = chain.head; scanCell; scanCell = scanCell->getNext()) {
+                        slicer.step();
+                        state.parent = scanCell;
+                        scanCell->processReferences(space->rootContext, &state, [](ProtoContext* ctx, void* self, const Cell* ref) {
                             auto* s = static_cast<GCLambdaState*>(self);
-                            if (reinterpret_cast<uintptr_t>(ref) & 1) {
-                                std::cerr << "CRITICAL TAGGED POINTER 2: " << ref << " from parent " << s->parent << " type " << (int)s->parent->getType() << std::endl;
-                                std::abort();
-                            }
-                            s->wl->push_back(ref);
+                            if (reinterpret_cast<uintptr_t>(ref) & 1) { std::cerr << "CRITICAL TAGGED POINTER (" << s->phase << "): " << ref << " from parent " << s->parent << " type " << (int)s->parent->getType() << std::endl; std::abort(); }
+                            s->wl->push(ref);
                         });
+                        drainWorkList();
+                    }
+                }
+                drainWorkList();
+
+                // Weak referents.  A weak map value is live only if its key
+                // is: iterate the snapshotted entries to a fixpoint, marking
+                // the values of entries whose key got marked (non-cell keys
+                // never die).  Whatever referent is still unmarked after
+                // that is dead — but a mutator may have read it through a
+                // weak cell since the STW and we have no barrier to tell, so
+                // it is graced: marked, with the values it keys, and only
+                // cleared from the weak cells after sweep.  It is reclaimed
+                // by the next cycle, once nothing weak points at it.
+                std::unordered_set<const Cell*> graced;
+                if (!weak.referents.empty()) {
+                    auto& pending = weak.entries;
+                    bool progress = true;
+                    while (progress) {
+                        progress = false;
+                        for (size_t i = 0; i < pending.size();) {
+                            const ProtoObject* key = pending[i].first;
+                            if (ProtoObject::isCellPointer(key) && !ProtoObject::asCellPointer(key)->isMarked()) {
+                                ++i;
+                                continue;
+                            }
+                            addRootObj(pending[i].second);
+                            pending[i] = pending.back();
+                            pending.pop_back();
+                            progress = true;
+                        }
+                        drainWorkList();
+                    }
+                    for (const Cell* referent : weak.referents) {
+                        if (!referent->isMarked()) {
+                            graced.insert(referent);
+                            workList.push(referent);
+                        }
                     }
+                    for (const auto& entry : pending) addRootObj(entry.second);
+                    drainWorkList();
                 }
 
                 // Phase 3 (Resume The World) already happened above —
@@ -595,6 +1031,10 @@ namespace proto {
                 }
 #endif
 
+                traceEnd(space, tracePhase, "gc.mark", "cells", static_cast<long>(markedList.size()));
+                PROTO_PROBE1(gc_mark_done, markedList.size());
+                tracePhase = traceBegin(space);
+
                 // --- PHASE 5: SWEEP ---
                 //
                 // Cross-segment chunk accumulator (path #5 v2).  Dead cells
@@ -610,6 +1050,13 @@ namespace proto {
                 // Total cells reclaimed this cycle, across all published
                 // chunks — the out-of-memory signal (see reclaimedLastCycle).
                 unsigned long reclaimedThisCycle = 0;
+                // Heap census counts, per cell type: reclaimed here, live
+                // in the bulk unmark below.
+                std::array<unsigned long, CELL_TYPE_COUNT> censusReclaimed{};
+                std::array<unsigned long, CELL_TYPE_COUNT> censusLive{};
+                // Graced weak referents found among the candidates: these
+                // are the ones the weak cells let go of this cycle.
+                std::unordered_set<const Cell*> dyingReferents;
 
                 DirtySegment* currentSeg = segmentsToProcess;
                 while (currentSeg) {
@@ -629,9 +1076,16 @@ namespace proto {
 #endif
 
                     while (cell) {
+                        slicer.step();
                         Cell* nextCell = cell->getNext();
                         if (!cell->isMarked()) {
+                            if (profile && profile->mayBeSampled(cell)) profile->onFreed(cell);
+                            if (census) censusReclaimed[static_cast<size_t>(cell->getType())]++;
                             cell->finalize(space->rootContext);
+                            // Zero the dead cell here, on the collector's
+                            // thread and while its line is still cached,
+                            // so allocCell hands it out without a memset.
+                            std::memset(static_cast<void*>(cell), 0, sizeof(BigCell));
 
                             cell->internalSetNextRaw(batchHead);
                             if (!batchTail) batchTail = cell;
@@ -639,6 +1093,7 @@ namespace proto {
                             batchCount++;
                         } else {
                             cell->unmark();
+                            if (!graced.empty() && graced.count(cell)) dyingReferents.insert(cell);
 #ifdef PROTOCORE_GC_REINCLUDE_SURVIVORS
                             // Prepend to the survivor chain.  Use setNext
                             // (not internalSetNextRaw) so the cached
@@ -747,6 +1202,11 @@ namespace proto {
                     GC_LOCK_TRACE("gcLoop REL(chunk-tail)");
                 }
 
+                if (!dyingReferents.empty()) clearDeadWeakReferents(space, dyingReferents);
+                traceEnd(space, tracePhase, "gc.sweep", "reclaimed", static_cast<long>(reclaimedThisCycle));
+                PROTO_PROBE1(gc_sweep_done, reclaimedThisCycle);
+                tracePhase = traceBegin(space);
+
 #ifdef PROTOCORE_GC_INSTRUMENT
                 auto t_phase6_start = std::chrono::steady_clock::now();
                 dbg_total_phase5_us.fetch_add(
@@ -782,8 +1242,10 @@ namespace proto {
                 // a single atomic fetch_and, safe regardless of
                 // contention with mutator threads.
                 for (const Cell* m : markedList) {
+                    slicer.step();
                     if (m && (reinterpret_cast<uintptr_t>(m) & 0x3F) == 0) {
                         const_cast<Cell*>(m)->unmark();
+                        if (census) censusLive[static_cast<size_t>(m->getType())]++;
                     }
                 }
 
@@ -802,6 +1264,8 @@ namespace proto {
                 for (int s = 0; s < ProtoSpace::MUTABLE_ROOT_SHARDS; ++s) {
                     space->gcMutableSnapshot[s] = nullptr;
                 }
+                if (profile) profile->onCycleEnd(space->gcCycleCount.load(std::memory_order_relaxed));
+                traceEnd(space, tracePhase, "gc.unmark");
 #ifdef PROTOCORE_GC_INSTRUMENT
                 auto t_phase6_end = std::chrono::steady_clock::now();
                 dbg_total_phase6_us.fetch_add(
@@ -830,7 +1294,8 @@ namespace proto {
 
                 GC_LOCK_TRACE("gcLoop ACQ(after-sweep)");
                 lock.lock(); // Re-acquire for next wait
-                space->gcStarted = false;
+                // A snapshot requested after this cycle's stop runs the next.
+                space->gcStarted = space->heapSnapshotRequest != nullptr;
                 // Publish the cycle's accounting for the heap-limit path:
                 //  * reclaimedLastCycle — cells the sweep returned to the
                 //    freelist; the authoritative out-of-memory signal
@@ -843,6 +1308,14 @@ namespace proto {
                                                 std::memory_order_relaxed);
                 space->liveCellsLastCycle.store(markedList.size(),
                                                 std::memory_order_relaxed);
+                space->markStackOverflowsLastCycle.store(workList.overflows,
+                                                         std::memory_order_relaxed);
+                if (census) publishHeapCensus(space, censusLive, censusReclaimed);
+                traceEnd(space, traceCycle, "gc.cycle", "cycle",
+                         static_cast<long>(space->gcCycleCount.load(std::memory_order_relaxed)));
+                traceCounter(space, "gc.liveCells", static_cast<long>(markedList.size()));
+                PROTO_PROBE3(gc_done, space->gcCycleCount.load(std::memory_order_relaxed),
+                             markedList.size(), reclaimedThisCycle);
                 space->memoryReclaimedCV.notify_all();
                 space->gcCV.notify_all();
             }
@@ -867,9 +1340,6 @@ namespace proto {
         nonMethodCallback(nullptr),
         parameterTwiceAssignedCallback(nullptr),
         parameterNotFoundCallback(nullptr),
-        runningThreads(1), // Main thread starts running
-        stwFlag(false),
-        parkedThreads(0),
         blocksPerAllocation(8192),  // Larger default batch to reduce getFreeCells calls during script load (was 1024; 1151 calls observed for multithread benchmark)
         heapSize(0),
         maxHeapSize(0),
@@ -878,18 +1348,50 @@ namespace proto {
         gcSleepMilliseconds(10),
         tupleRoot(nullptr),
         stringInternMap(nullptr),
+        freeCells(nullptr),
+        freeCellsTail(nullptr),
+        freeChunks(nullptr),
+        freeChunkPool(nullptr),
         dirtySegments(nullptr),
         dirtySegmentFreePool(nullptr),
         survivorPen(nullptr),
         survivorStagger(SURVIVOR_STAGGER_DEFAULT),
+        markStackCapacity(MARK_STACK_CAPACITY_DEFAULT),
+        markStackOverflowsLastCycle(0),
         gcCycleCount(0),
+        ancestryEpoch(0),
+        serial(nextSpaceSerial.fetch_add(1, std::memory_order_relaxed)),
         liveCellsLastCycle(0),
         reclaimedLastCycle(0),
-        freeCells(nullptr),
-        freeCellsTail(nullptr),
-        freeChunks(nullptr),
-        freeChunkPool(nullptr),
+        timeToSafepointLastCycle(0),
+        safepointWatchdogMicros(0),
+        safepointLaggardCallback(nullptr),
+        safepointLaggardUserData(nullptr),
+        captureLaggardStacks(false),
+        heapSnapshotRequest(nullptr),
+        heapCensusEnabled(false),
+        heapCensusLastCycle{0, {}},
+        allocationProfiler(nullptr),
+        allocationSampling(false),
+        traceRecorder(nullptr),
+        tracing(false),
+        pauseLastCycle(0),
+        pauseBudgetMetLastCycle(true),
+        pauseBudgetMissedCycles(0),
+        pauseBudgetMicros(0),
+        noGCMaxMicros(NO_GC_MAX_MICROS_DEFAULT),
+        noGCOverrunCallback(nullptr),
+        noGCOverrunUserData(nullptr),
+        noGCRegions(0),
+        noGCStopPending(false),
+        noGCDeferredCycles(0),
+        noGCPostponedCycles(0),
+        noGCOverruns(0),
+        noGCLongestMicros(0),
+        noGCReserveExhausted(0),
         gcStarted(false),
+        runningThreads(1), // Main thread starts running
+        stwFlag(0),
         mainContext(nullptr),
         nextMutableRef(1),
         resolutionChain_(nullptr),
@@ -901,6 +1403,30 @@ namespace proto {
         // bootstrap context), enabling per-thread attribute and mutable-value
         // caches without requiring each runtime to pass rootContext explicitly.
         this->mainThreadId = std::this_thread::get_id();
+#if defined(__linux__) || defined(__APPLE__)
+        this->mainThreadHandle = pthread_self();
+#else
+        this->mainThreadHandle = {};
+#endif
+        for (auto& page : shapeEpochPages) page.store(nullptr, std::memory_order_relaxed);
+
+        // Safepoint watchdog from the environment: report threads that keep
+        // a stop-the-world waiting longer than this many milliseconds to
+        // stderr, with their stacks.
+        if (const char* envWatchdog = std::getenv("PROTOCORE_SAFEPOINT_WATCHDOG_MS")) {
+            char* endPtr = nullptr;
+            unsigned long parsed = std::strtoul(envWatchdog, &endPtr, 10);
+            if (endPtr && *endPtr == '\0' && parsed > 0)
+                this->setSafepointWatchdog(parsed * 1000, nullptr, nullptr, true);
+        }
+
+        // Pause budget from the environment, in microseconds.
+        if (const char* envBudget = std::getenv("PROTOCORE_GC_PAUSE_BUDGET_US")) {
+            char* endPtr = nullptr;
+            unsigned long parsed = std::strtoul(envBudget, &endPtr, 10);
+            if (endPtr && *endPtr == '\0' && parsed > 0)
+                this->setPauseBudget(parsed);
+        }
 
         // Per-context GC threshold: env var override, fall back to default.
         // Only consumed when PROTOCORE_GC_REINCLUDE_SURVIVORS is enabled, but
@@ -928,6 +1454,40 @@ namespace proto {
             }
         }
 
+        // No-GC region limit from the environment, in microseconds.
+        if (const char* envNoGC = std::getenv("PROTOCORE_NOGC_MAX_US")) {
+            char* endPtr = nullptr;
+            unsigned long parsed = std::strtoul(envNoGC, &endPtr, 10);
+            if (endPtr && *endPtr == '\0' && parsed > 0)
+                this->setNoGCLimit(parsed);
+        }
+
+        // Heap census from the environment: any positive value enables it.
+        if (const char* envCensus = std::getenv("PROTOCORE_GC_HEAP_CENSUS")) {
+            char* endPtr = nullptr;
+            unsigned long parsed = std::strtoul(envCensus, &endPtr, 10);
+            if (endPtr && *endPtr == '\0' && parsed > 0) {
+                this->heapCensusEnabled = true;
+            }
+        }
+
+        // Event trace from the environment, written when the space ends.
+        if (const char* envTrace = std::getenv("PROTOCORE_TRACE_FILE")) {
+            if (*envTrace) {
+                this->traceFile = envTrace;
+                this->startTrace();
+            }
+        }
+
+        // Mark stack capacity, in entries.
+        if (const char* envMarkStack = std::getenv("PROTOCORE_GC_MARK_STACK_ENTRIES")) {
+            char* endPtr = nullptr;
+            unsigned long parsed = std::strtoul(envMarkStack, &endPtr, 10);
+            if (endPtr && *endPtr == '\0' && parsed > 0) {
+                this->markStackCapacity = parsed;
+            }
+        }
+
         // Pre-allocate a pool of DirtySegments so submitYoungGeneration's
         // hot path (per-context threshold submission, every context-
         // destruction) can claim one without falling back to a system
@@ -973,7 +1533,7 @@ namespace proto {
         this->setPrototype = const_cast<ProtoObject*>(this->rootContext->newObject(false));
         this->multisetPrototype = const_cast<ProtoObject*>(this->rootContext->newObject(false));
         this->rangeIteratorPrototype = const_cast<ProtoObject*>(this->rootContext->newObject(false));
-        this->threads = reinterpret_cast<ProtoSparseList*>(const_cast<ProtoObject*>(this->rootContext->newSparseList()->asObject(this->rootContext)));
+        this->threads = new ThreadRegistry();
 
         // Initialize all other prototypes to a basic object for now
         // This prevents null dereferences if getPrototype is called on an uninitialized type
@@ -1037,11 +1597,32 @@ namespace proto {
     }
 
     ProtoSpace::~ProtoSpace() {
+        // Task pools own managed worker threads; stop them while the
+        // collector is still running so their exit path can allocate.
+        {
+            std::vector<ProtoTaskPool*> pools;
+            {
+                std::lock_guard<std::mutex> lock(taskPoolsMutex_);
+                pools.swap(taskPools_);
+            }
+            for (ProtoTaskPool* pool : pools) {
+                pool->shutdown(rootContext);
+                delete pool;
+            }
+        }
+        {
+            std::vector<ProtoEventLoop*> loops;
+            {
+                std::lock_guard<std::mutex> lock(eventLoopsMutex_);
+                loops.swap(eventLoops_);
+            }
+            for (ProtoEventLoop* loop : loops) delete loop;
+        }
+        releaseFibers(this);
         {
             std::lock_guard<std::recursive_mutex> lock(globalMutex);
             this->state = SPACE_STATE_ENDING;
             this->gcCV.notify_all();
-            this->stopTheWorldCV.notify_all();
         }
         if (gcThread && gcThread->joinable()) {
             gcThread->join();
@@ -1054,10 +1635,24 @@ namespace proto {
             for (auto* rs : rootSets_) delete rs;
             rootSets_.clear();
         }
+        reclaimRetiredLinkCaches();
+        for (auto& page : shapeEpochPages) delete[] page.load(std::memory_order_relaxed);
         delete this->rootContext;
+        // Weak maps, futures and channels still alive at teardown are
+        // never finalized; free their side tables here.
+        releaseWeakMapTables(this);
+        releaseFutureTables(this);
+        releaseChannelRings(this);
         freeStringInternMap(this);
         delete symbolTable;
         symbolTable = nullptr;
+        delete allocationProfiler;
+        allocationProfiler = nullptr;
+        this->tracing.store(false);
+        if (traceRecorder && !traceFile.empty() && !traceRecorder->writeChromeTrace(traceFile.c_str()))
+            std::fprintf(stderr, "protoCore: could not write the event trace to %s\n", traceFile.c_str());
+        delete traceRecorder;
+        traceRecorder = nullptr;
 
         // Drain DirtySegment lists (live, free pool, and survivor pen)
         // and free the underlying heap nodes.  GC thread is already
@@ -1075,6 +1670,10 @@ namespace proto {
         this->dirtySegments.store(nullptr, std::memory_order_relaxed);
         this->dirtySegmentFreePool.store(nullptr, std::memory_order_relaxed);
         this->survivorPen.store(nullptr, std::memory_order_relaxed);
+
+        delete this->threads;
+        this->threads = nullptr;
+        releaseThreadCachePool(this);
     }
 
     const ProtoObject* ProtoSpace::getResolutionChain() const {
@@ -1120,32 +1719,30 @@ namespace proto {
         const ProtoList* args,
         const ProtoSparseList* kwargs
     ) {
-        auto* c = new ProtoContext(this, nullptr, nullptr, nullptr, args, kwargs);
-        auto* newThreadImpl = new(c) ProtoThreadImplementation(c, name, this, mainFunction, args, kwargs);
-        // runningThreads is incremented in ProtoThreadImplementation constructor
-        return newThreadImpl->asThread(c);
+        auto* newThreadImpl = new(context) ProtoThreadImplementation(context, name, this, mainFunction, args, kwargs);
+        // runningThreads is incremented in thread_main
+        return newThreadImpl->asThread(context);
     }
 
     // Wait for the GC to complete a collection cycle, GC-safely.  The caller
-    // holds `lock` (globalMutex).  The waiting thread leaves the stop-the-world
-    // running set — so the GC quorum (parkedThreads >= runningThreads) is
-    // computed without it and it cannot stall a collection — sleeps until a
-    // cycle finishes (or a 50 ms watchdog fires, so a missed notify costs
-    // latency, not a hang), rejoins the running set, and parks at a safepoint
-    // if a stop-the-world began while it slept.  See
+    // holds `lock` (globalMutex).  The waiting thread goes unmanaged — so the
+    // collector's stop-the-world does not wait for it and it cannot stall a
+    // collection — sleeps until a cycle finishes (or a 50 ms watchdog fires,
+    // so a missed notify costs latency, not a hang), and on return parks if
+    // a stop-the-world began while it slept.  See
     // docs/superpowers/specs/2026-05-22-allocation-limit-oom-design.md.
     static void reclaimWaitLocked(ProtoSpace* space,
                                   std::unique_lock<std::recursive_mutex>& lock,
-                                  ProtoContext* ctx) {
+                                  ProtoContext* ctx, const char* traceName) {
+        const uint64_t traceWait = traceBegin(space);
         const uint64_t startCycle =
             space->gcCycleCount.load(std::memory_order_relaxed);
         // Make sure a collection will actually run.
         if (!space->gcStarted) space->gcStarted = true;
         space->gcCV.notify_all();
-        // Leave the running set.  A GC already parked on the Phase-1 quorum
-        // must re-evaluate it against the lowered bound, hence the notify.
-        space->runningThreads.fetch_sub(1, std::memory_order_acq_rel);
-        space->gcCV.notify_all();
+        // Step out of managed code; this wakes a collector already waiting
+        // for this thread in Phase 1.
+        ctx->goUnmanaged();
         space->memoryReclaimedCV.wait_for(
             lock, std::chrono::milliseconds(50),
             [space, startCycle] {
@@ -1153,13 +1750,12 @@ namespace proto {
                            != startCycle
                     || space->state == SPACE_STATE_ENDING;
             });
-        space->runningThreads.fetch_add(1, std::memory_order_acq_rel);
-        // safepoint() re-locks globalMutex and may park on the STW cv.  Running
-        // it while we still hold globalMutex would leave the lock owned across
-        // that park (recursive_mutex drops only one level) and wedge the GC —
-        // release globalMutex around the safepoint.
+        // returnFromUnmanaged() may park until the world restarts.  Doing so
+        // while holding globalMutex would wedge the GC, which re-locks it
+        // after Phase 1 — release globalMutex around the return.
         lock.unlock();
-        if (ctx) ctx->safepoint();
+        ctx->returnFromUnmanaged();
+        traceEnd(space, traceWait, traceName);
         lock.lock();
     }
 
@@ -1183,9 +1779,9 @@ namespace proto {
             if (this->heapSize < this->maxHeapSize) return;
             if (this->freeChunks || this->freeCells) return;
             // At the ceiling with an empty freelist: let the GC reclaim, then
-            // re-check.  reclaimWaitLocked leaves the running set for the wait
-            // so this thread never stalls the stop-the-world quorum.
-            reclaimWaitLocked(this, lock, ctx);
+            // re-check.  reclaimWaitLocked goes unmanaged for the wait so
+            // this thread never stalls a stop-the-world.
+            reclaimWaitLocked(this, lock, ctx, "heap.headroomWait");
             if (this->freeChunks || this->freeCells) return;
 
             // The freelist is still empty.  Distinguish "no cycle has
@@ -1271,6 +1867,7 @@ namespace proto {
                 this->freeChunks = chunk->next;
                 Cell* batchHead = chunk->head;
                 this->freeCellsCount -= static_cast<int>(chunk->count);
+                PROTO_PROBE1(heap_refill, chunk->count);
                 recycleFreeChunk(this, chunk);
                 GC_LOCK_TRACE("getFreeCells REL(chunk)");
                 return batchHead;
@@ -1283,6 +1880,7 @@ namespace proto {
                     Cell* batchHead = this->freeCells;
                     this->freeCells = nullptr;
                     this->freeCellsTail = nullptr;
+                    PROTO_PROBE1(heap_refill, this->freeCellsCount);
                     this->freeCellsCount = 0;
                     GC_LOCK_TRACE("getFreeCells REL(flat-all)");
                     return batchHead;
@@ -1300,13 +1898,14 @@ namespace proto {
                 current->setNext(nullptr);
                 this->freeCellsCount -= count;
                 if (!this->freeCells) this->freeCellsTail = nullptr;
+                PROTO_PROBE1(heap_refill, count);
                 GC_LOCK_TRACE("getFreeCells REL(flat-partial)");
                 return batchHead;
             }
 
             // No free cells. Policy (2026-05-23 night): the clean
             // reaction is to refill from the OS — that is what
-            // posix_memalign exists for. We do NOT trigger a GC
+            // the heap-block mmap exists for. We do NOT trigger a GC
             // cycle here. Triggering on every freelist exhaustion,
             // independent of how full the heap is, was the historical
             // default but produced a perverse interaction with the
@@ -1377,7 +1976,7 @@ namespace proto {
                         // SOFT zone: prefer reclamation over growth.  Wait one
                         // cycle, then re-check; grow only if that did not help.
                         softWaited = true;
-                        reclaimWaitLocked(this, lock, ctx);
+                        reclaimWaitLocked(this, lock, ctx, "heap.softLimitWait");
                         continue;
                     }
                     // Clamp the OS request so heapSize never crosses
@@ -1393,15 +1992,18 @@ namespace proto {
             }
 
             // --- OS allocation ----------------------------------------------
-            // Do the expensive posix_memalign + chaining outside the lock so
-            // other threads can make progress.
+            // Do the expensive mmap + chaining outside the lock so other
+            // threads can make progress.  Anonymous pages arrive zeroed from
+            // the kernel (and page-aligned, so cell-aligned), which keeps
+            // the invariant that free cells are zero but for their link.
             lock.unlock();
             GC_LOCK_TRACE("getFreeCells REL(OS alloc)");
 
-            Cell* newMemory = nullptr;
-            int result = posix_memalign(reinterpret_cast<void**>(&newMemory),
-                                        64,
-                                        blocksToAllocate * sizeof(BigCell));
+            const uint64_t traceGrow = traceBegin(this);
+            void* mapped = mmap(nullptr, blocksToAllocate * sizeof(BigCell),
+                                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            const int result = mapped == MAP_FAILED ? errno : 0;
+            Cell* newMemory = mapped == MAP_FAILED ? nullptr : static_cast<Cell*>(mapped);
             if (result != 0) {
                 // The OS itself is exhausted — beneath any protoCore ceiling.
                 if (this->outOfMemoryCallback)
@@ -1430,6 +2032,9 @@ namespace proto {
             lock.lock();
             GC_LOCK_TRACE("getFreeCells ACQ(OS done)");
             this->heapSize += blocksToAllocate;
+            traceEnd(this, traceGrow, "heap.grow", "cells", blocksToAllocate);
+            PROTO_PROBE2(heap_grow, blocksToAllocate, this->heapSize);
+            traceCounter(this, "heap.cells", this->heapSize);
 
             // Partition the remainder into CELL_CHUNK_SIZE chunks so the next
             // getFreeCells lands in the O(1) chunked fast path.
@@ -1463,6 +2068,64 @@ namespace proto {
         this->maxHeapSize   = hardCells;
     }
 
+    void ProtoSpace::setSafepointWatchdog(unsigned long thresholdMicros,
+                                          ProtoSafepointLaggardCallback callback,
+                                          void* userData,
+                                          bool captureStacks) {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        this->safepointWatchdogMicros = thresholdMicros;
+        this->safepointLaggardCallback = callback;
+        this->safepointLaggardUserData = userData;
+        this->captureLaggardStacks = captureStacks;
+    }
+
+    bool ProtoSpace::writeHeapSnapshot(ProtoContext* context, const char* path) {
+        HeapSnapshotRequest request{path, false, false};
+        std::unique_lock<std::recursive_mutex> lock(globalMutex);
+        auto wait = [&](auto ready) {
+            // Unmanaged, so the stop that takes the snapshot does not wait
+            // for this thread; returnFromUnmanaged may park until the world
+            // restarts, which must not happen holding globalMutex.
+            context->goUnmanaged();
+            this->gcCV.wait(lock, ready);
+            lock.unlock();
+            context->returnFromUnmanaged();
+            lock.lock();
+        };
+        if (this->heapSnapshotRequest) {
+            wait([this] { return !this->heapSnapshotRequest || this->state == SPACE_STATE_ENDING; });
+        }
+        if (this->state == SPACE_STATE_ENDING) return false;
+        this->heapSnapshotRequest = &request;
+        this->gcStarted = true;
+        this->gcCV.notify_all();
+        wait([this, &request] { return request.done || this->state == SPACE_STATE_ENDING; });
+        if (!request.done && this->heapSnapshotRequest == &request) this->heapSnapshotRequest = nullptr;
+        return request.written;
+    }
+
+    void ProtoSpace::setPauseBudget(unsigned long micros) {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        this->pauseBudgetMicros = micros;
+    }
+
+    void ProtoSpace::setNoGCLimit(unsigned long maxMicros, ProtoNoGCOverrunCallback callback, void* userData) {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        this->noGCMaxMicros.store(maxMicros, std::memory_order_relaxed);
+        this->noGCOverrunCallback = callback;
+        this->noGCOverrunUserData = userData;
+    }
+
+    void ProtoSpace::setHeapCensus(bool enabled) {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        this->heapCensusEnabled = enabled;
+    }
+
+    ProtoHeapCensus ProtoSpace::heapCensus() {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        return this->heapCensusLastCycle;
+    }
+
     void ProtoSpace::submitYoungGeneration(const Cell* cell) {
         if (!cell) return;
 
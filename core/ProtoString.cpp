@@ -807,6 +807,10 @@ namespace proto {
 
     const ProtoStringImplementation* ProtoStringImplementation::fromUTF8Bytes(
             ProtoContext* ctx, const uint8_t* bytes, size_t len) {
+        // One batch for the leaves, the internal nodes joining them and
+        // the string cell; the estimate need not be exact.
+        const unsigned long leaves = (len + StringLeafNode::MAX_PAYLOAD - 1) / StringLeafNode::MAX_PAYLOAD;
+        ProtoContext::CellBatch batch(leaves > 1 ? ctx : nullptr, 2 * leaves);
         return new(ctx) ProtoStringImplementation(ctx, buildAVL(ctx, bytes, len));
     }
 
@@ -1250,6 +1254,30 @@ namespace proto {
         return ProtoString::createSymbol(ctx, s.c_str());
     }
 
+    const ProtoString* ProtoSymbolLiteral::bind(ProtoContext* context) const {
+        // First use of this literal in context->space, or the slot is bound
+        // to another space.  The compile-time hash lets an already interned
+        // name be found without building a candidate string.
+        const ProtoObject* sym = context->space->symbolTable->lookupLiteral(
+            context, utf8, size, contentHash);
+        const ProtoString* symbol = sym ? reinterpret_cast<const ProtoString*>(sym)
+                                        : ProtoString::createSymbol(context, std::string(utf8, size));
+
+        // Publish, but only over an older space's binding: spaces are
+        // numbered in creation order, so a slot used alternately from two
+        // live spaces settles on the newer one and the older one keeps
+        // taking this path, without allocating.  Replaced bindings are
+        // never freed (see protoCore.h), so concurrent readers of the old
+        // one stay safe; a slot replaces at most one per space created.
+        const uint64_t serial = context->space->serial;
+        const ProtoSymbolBinding* seen = binding.load(std::memory_order_acquire);
+        if (seen && seen->spaceSerial >= serial) return symbol;
+        auto* fresh = new ProtoSymbolBinding{serial, symbol};
+        if (!binding.compare_exchange_strong(seen, fresh, std::memory_order_acq_rel))
+            delete fresh;
+        return symbol;
+    }
+
     unsigned long ProtoString::getHash(ProtoContext* context) const { return getProtoStringHash(context, reinterpret_cast<const ProtoObject*>(this)); }
     const Cell* ProtoString::asCell(ProtoContext* context) const { return isInlineString(reinterpret_cast<const ProtoObject*>(this)) ? nullptr : getImpl(reinterpret_cast<const ProtoObject*>(this)); }
     const ProtoString* ProtoString::appendLast(ProtoContext* context, const ProtoString* other) const {
@@ -0,0 +1,351 @@
+/*
+ * ProtoTaskPool.cpp
+ *
+ * Work-stealing task pool over a fixed set of protoCore threads.  See
+ * ProtoTaskPool in protoCore.h for the public contract.
+ *
+ * Implementation outline:
+ *
+ *   - Each worker owns a deque guarded by its own mutex.  The owner
+ *     pushes and pops at the back; thieves take from the front, so a
+ *     steal grabs the oldest (typically largest) piece of work.  Tasks
+ *     spawned by threads outside the pool go to a shared injection
+ *     queue.  Contention on a worker's mutex only happens while it is
+ *     being robbed, which is the rare case for a busy pool.
+ *
+ *   - `queued` counts tasks sitting in any queue.  An idle worker waits
+ *     on `idleCV` for it to become non-zero, inside an unmanaged region:
+ *     it touches no ProtoObject while parked, so the collector does not
+ *     wait for it.
+ *
+ *   - A task's receiver, arguments and result are pinned in the pool's
+ *     root set: between spawn and run they are only referenced from the
+ *     C++ task record, and between completion and join the result's
+ *     task context is gone.  join anchors the result in the joiner's
+ *     context (ReturnReference, as ~ProtoContext does) before unpinning.
+ */
+
+#include "../headers/proto_internal.h"
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <string>
+
+namespace proto {
+
+class ProtoTask {
+public:
+    ProtoMethod method = nullptr;
+    const ProtoObject* self = nullptr;
+    const ProtoList* args = nullptr;
+    const ProtoSparseList* kwargs = nullptr;
+    ProtoRootSet::Handle pins[3] = {};
+    ProtoRootSet::Handle result = ProtoRootSet::kNullHandle;
+    std::exception_ptr error;
+    std::atomic<bool> done{false};
+    bool detached = false;
+};
+
+struct ProtoTaskPool::Impl {
+    struct Worker {
+        std::mutex mutex;
+        std::deque<ProtoTask*> tasks;
+    };
+
+    ProtoSpace* space = nullptr;
+    ProtoRootSet* roots = nullptr;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<ProtoThread*> threads;
+
+    std::mutex injectedMutex;
+    std::deque<ProtoTask*> injected;
+
+    std::atomic<long> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex idleMutex;
+    std::condition_variable idleCV;
+
+    std::mutex doneMutex;
+    std::condition_variable doneCV;
+
+    ProtoTask* newTask(ProtoContext* context, ProtoMethod method, const ProtoObject* self,
+                       const ProtoList* args, const ProtoSparseList* kwargs);
+    void push(ProtoTask* task);
+    ProtoTask* take(unsigned int index);
+    void run(ProtoContext* parent, ProtoTask* task);
+};
+
+namespace {
+
+    constexpr unsigned int kNotAWorker = ~0u;
+
+    // The pool (if any) the calling OS thread is a worker of.
+    struct CurrentWorker {
+        ProtoTaskPool::Impl* pool = nullptr;
+        unsigned int index = kNotAWorker;
+    };
+    thread_local CurrentWorker currentWorker;
+
+    const ProtoObject* workerMain(
+        ProtoContext* context,
+        const ProtoObject* /*self*/,
+        const ParentLink* /*parentLink*/,
+        const ProtoList* args,
+        const ProtoSparseList* /*kwargs*/
+    ) {
+        auto* pool = static_cast<ProtoTaskPool::Impl*>(
+            args->getAt(context, 0)->asExternalPointer(context)->getPointer(context));
+        const auto index = static_cast<unsigned int>(args->getAt(context, 1)->asLong(context));
+        currentWorker = {pool, index};
+
+        while (true) {
+            if (ProtoTask* task = pool->take(index)) {
+                pool->run(context, task);
+                context->safepoint();
+                continue;
+            }
+            ProtoContext::UnmanagedScope unmanaged(context);
+            std::unique_lock<std::mutex> lock(pool->idleMutex);
+            pool->idleCV.wait(lock, [pool] {
+                return pool->queued.load(std::memory_order_acquire) > 0 || pool->stopping.load();
+            });
+            if (pool->stopping.load() && pool->queued.load(std::memory_order_acquire) == 0) break;
+        }
+
+        currentWorker = {};
+        return PROTO_NONE;
+    }
+
+    unsigned int defaultWorkerCount() {
+        if (const char* env = std::getenv("PROTOCORE_TASK_WORKERS")) {
+            const long n = std::strtol(env, nullptr, 10);
+            if (n > 0) return static_cast<unsigned int>(n);
+        }
+        const unsigned int hw = std::thread::hardware_concurrency();
+        return hw ? hw : 1;
+    }
+
+}
+
+void ProtoTaskPool::Impl::push(ProtoTask* task) {
+    if (currentWorker.pool == this) {
+        Worker& own = *workers[currentWorker.index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_back(task);
+    } else {
+        std::lock_guard<std::mutex> lock(injectedMutex);
+        injected.push_back(task);
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        // Pairs with the predicate check in workerMain: a worker that saw
+        // queued == 0 is either not yet waiting (and will re-check) or
+        // already waiting (and gets this notify).
+        std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    idleCV.notify_one();
+}
+
+ProtoTask* ProtoTaskPool::Impl::take(unsigned int index) {
+    ProtoTask* task = nullptr;
+    const auto n = static_cast<unsigned int>(workers.size());
+
+    if (index != kNotAWorker) {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+        }
+    }
+    if (!task) {
+        std::lock_guard<std::mutex> lock(injectedMutex);
+        if (!injected.empty()) {
+            task = injected.front();
+            injected.pop_front();
+        }
+    }
+    for (unsigned int k = 1; !task && k <= n; ++k) {
+        const unsigned int victim = (index == kNotAWorker ? k - 1 : index + k) % n;
+        if (victim == index) continue;
+        Worker& other = *workers[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+        }
+    }
+
+    if (task) queued.fetch_sub(1, std::memory_order_acq_rel);
+    return task;
+}
+
+void ProtoTaskPool::Impl::run(ProtoContext* parent, ProtoTask* task) {
+    {
+        ProtoContext taskContext(space, parent, nullptr, nullptr, nullptr, nullptr);
+        const ProtoObject* result = PROTO_NONE;
+        try {
+            result = task->method(&taskContext, task->self, nullptr, task->args, task->kwargs);
+            if (!result) result = PROTO_NONE;
+        } catch (...) {
+            task->error = std::current_exception();
+        }
+        // Pin before taskContext hands its young generation to the GC.
+        task->result = roots->add(result);
+    }
+    for (ProtoRootSet::Handle& pin : task->pins) {
+        roots->remove(pin);
+        pin = ProtoRootSet::kNullHandle;
+    }
+    if (task->detached) {
+        // Nobody will join: drop the result (and any exception) now.
+        roots->remove(task->result);
+        delete task;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        task->done.store(true, std::memory_order_release);
+    }
+    doneCV.notify_all();
+}
+
+ProtoTaskPool::ProtoTaskPool(ProtoContext* context, unsigned int workers)
+    : impl_(new Impl{}) {
+    impl_->space = context->space;
+    impl_->roots = context->space->createRootSet("task-pool");
+    if (workers == 0) workers = defaultWorkerCount();
+
+    // Every deque must exist before the first worker can try to steal.
+    for (unsigned int i = 0; i < workers; ++i)
+        impl_->workers.push_back(std::make_unique<Impl::Worker>());
+
+    const ProtoObject* poolPointer = context->fromExternalPointer(impl_);
+    for (unsigned int i = 0; i < workers; ++i) {
+        const ProtoList* args = context->newList()
+            ->appendLast(context, poolPointer)
+            ->appendLast(context, context->fromInteger(i));
+        const std::string name = "task-worker-" + std::to_string(i);
+        auto* thread = new(context) ProtoThreadImplementation(
+            context, context->fromUTF8String(name.c_str())->asString(context),
+            context->space, workerMain, args, nullptr);
+        ProtoThread* handle = const_cast<ProtoThread*>(thread->asThread(context));
+        // Keeps the thread cell (and its extension, which owns the
+        // std::thread) alive until shutdown joins it.
+        impl_->roots->add(thread->implAsObject(context));
+        impl_->threads.push_back(handle);
+    }
+}
+
+ProtoTaskPool::~ProtoTaskPool() {
+    delete impl_;
+}
+
+void ProtoTaskPool::shutdown(ProtoContext* context) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->idleMutex);
+        impl_->stopping.store(true);
+    }
+    impl_->idleCV.notify_all();
+    {
+        // Exiting workers allocate while unregistering; do not hold up
+        // the collector while waiting for them.
+        ProtoContext::UnmanagedScope unmanaged(context);
+        for (ProtoThread* thread : impl_->threads) thread->join(context);
+    }
+    impl_->space->destroyRootSet(impl_->roots);
+    impl_->roots = nullptr;
+}
+
+ProtoTask* ProtoTaskPool::Impl::newTask(ProtoContext* context, ProtoMethod method,
+                                        const ProtoObject* self,
+                                        const ProtoList* args,
+                                        const ProtoSparseList* kwargs) {
+    auto* task = new ProtoTask();
+    task->method = method;
+    task->self = self;
+    task->args = args;
+    task->kwargs = kwargs;
+    task->pins[0] = roots->add(self);
+    if (args) task->pins[1] = roots->add(args->asObject(context));
+    if (kwargs) task->pins[2] = roots->add(kwargs->asObject(context));
+    return task;
+}
+
+ProtoTask* ProtoTaskPool::spawn(ProtoContext* context, ProtoMethod method,
+                                const ProtoObject* self,
+                                const ProtoList* args,
+                                const ProtoSparseList* kwargs) {
+    ProtoTask* task = impl_->newTask(context, method, self, args, kwargs);
+    impl_->push(task);
+    return task;
+}
+
+void ProtoTaskPool::post(ProtoContext* context, ProtoMethod method,
+                         const ProtoObject* self,
+                         const ProtoList* args,
+                         const ProtoSparseList* kwargs) {
+    ProtoTask* task = impl_->newTask(context, method, self, args, kwargs);
+    task->detached = true;
+    impl_->push(task);
+}
+
+const ProtoObject* ProtoTaskPool::join(ProtoContext* context, ProtoTask* task) {
+    if (!task) return PROTO_NONE;
+
+    if (currentWorker.pool == impl_) {
+        // Help instead of blocking: a worker waiting on a task that sits
+        // in a deque nobody else is draining would otherwise deadlock.
+        while (!task->done.load(std::memory_order_acquire)) {
+            if (ProtoTask* other = impl_->take(currentWorker.index)) {
+                impl_->run(context, other);
+                continue;
+            }
+            ProtoContext::UnmanagedScope unmanaged(context);
+            std::unique_lock<std::mutex> lock(impl_->doneMutex);
+            impl_->doneCV.wait_for(lock, std::chrono::milliseconds(1), [task] {
+                return task->done.load(std::memory_order_acquire);
+            });
+        }
+    } else {
+        ProtoContext::UnmanagedScope unmanaged(context);
+        std::unique_lock<std::mutex> lock(impl_->doneMutex);
+        impl_->doneCV.wait(lock, [task] { return task->done.load(std::memory_order_acquire); });
+    }
+
+    const ProtoObject* result = impl_->roots->resolve(task->result);
+    if (result && ProtoObject::isCellPointer(result))
+        (void) new(context) ReturnReference(context, const_cast<Cell*>(ProtoObject::asCellPointer(result)));
+    impl_->roots->remove(task->result);
+
+    std::exception_ptr error = task->error;
+    delete task;
+    if (error) std::rethrow_exception(error);
+    return result ? result : PROTO_NONE;
+}
+
+unsigned int ProtoTaskPool::getWorkerCount() const {
+    return static_cast<unsigned int>(impl_->workers.size());
+}
+
+// ---- ProtoSpace integration -------------------------------------------
+
+ProtoTaskPool* ProtoSpace::createTaskPool(ProtoContext* context, unsigned int workers) {
+    auto* pool = new ProtoTaskPool(context, workers);
+    std::lock_guard<std::mutex> lock(taskPoolsMutex_);
+    taskPools_.push_back(pool);
+    return pool;
+}
+
+void ProtoSpace::destroyTaskPool(ProtoContext* context, ProtoTaskPool* pool) {
+    if (!pool) return;
+    {
+        std::lock_guard<std::mutex> lock(taskPoolsMutex_);
+        auto it = std::find(taskPools_.begin(), taskPools_.end(), pool);
+        if (it != taskPools_.end()) taskPools_.erase(it);
+    }
+    pool->shutdown(context);
+    delete pool;
+}
+
+} // namespace proto
@@ -0,0 +1,265 @@
+/*
+ * ProtoWeak.cpp
+ *
+ * Weak references and ephemeron maps.  Neither cell reports its referents
+ * to the marker; instead every live weak cell is registered with the space
+ * and the collector consults the registry directly (see gcThreadLoop):
+ *
+ *   Phase 2 (STW)   collectWeakReferents snapshots the referents and a
+ *                   copy of every weak map entry.
+ *   Phase 4         after the strong mark, entries whose key is marked get
+ *                   their value marked, to a fixpoint.  Referents still
+ *                   unmarked are then marked anyway ("grace"), together
+ *                   with the values they key, so that nothing a mutator
+ *                   may have read through a weak cell since the STW is
+ *                   freed this cycle.
+ *   Phase 5         a graced referent that sweep finds among its
+ *                   candidates is dying; clearDeadWeakReferents then
+ *                   clears the weak refs and map entries pointing at it.
+ *
+ * A cleared referent is therefore reclaimed one cycle later, once nothing
+ * weak points at it any more.
+ */
+
+#include "../headers/proto_internal.h"
+
+namespace proto {
+
+    namespace {
+
+        void registerWeakCell(ProtoContext* context, const Cell* cell) {
+            if (!context || !context->space) return;
+            std::lock_guard<std::mutex> lock(context->space->weakCellsMutex_);
+            context->space->weakCells_.insert(cell);
+        }
+
+        void unregisterWeakCell(ProtoContext* context, const Cell* cell) {
+            if (!context || !context->space) return;
+            std::lock_guard<std::mutex> lock(context->space->weakCellsMutex_);
+            context->space->weakCells_.erase(cell);
+        }
+
+        bool isWeakReferent(const ProtoObject* obj) {
+            return obj && ProtoObject::isCellPointer(obj);
+        }
+
+    }
+
+    // ------------------------------------------------------------------
+    // ProtoWeakRefImplementation
+    // ------------------------------------------------------------------
+
+    ProtoWeakRefImplementation::ProtoWeakRefImplementation(
+        ProtoContext* context,
+        const ProtoObject* target,
+        ProtoWeakClearCallback onClear,
+        void* userData
+    ) : Cell(context), target(target), onClear(onClear), userData(userData)
+    {
+        registerWeakCell(context, this);
+    }
+
+    const ProtoObject* ProtoWeakRefImplementation::implAsObject(ProtoContext* context) const {
+        ProtoObjectPointer p{};
+        p.weakRefImplementation = this;
+        p.op.pointer_tag = POINTER_TAG_WEAK_REF;
+        return p.oid;
+    }
+
+    const ProtoObject* ProtoWeakRefImplementation::implGet(ProtoContext* /*context*/) const {
+        return target.load(std::memory_order_acquire);
+    }
+
+    void ProtoWeakRefImplementation::processReferences(
+        ProtoContext* /*context*/,
+        void* /*self*/,
+        void (*/*method*/)(ProtoContext*, void*, const Cell*)
+    ) const {
+        /* The target is deliberately not reported. */
+    }
+
+    void ProtoWeakRefImplementation::finalize(ProtoContext* context) const {
+        unregisterWeakCell(context, this);
+    }
+
+    unsigned long ProtoWeakRefImplementation::getHash(ProtoContext* /*context*/) const {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    // ------------------------------------------------------------------
+    // ProtoWeakMapImplementation
+    // ------------------------------------------------------------------
+
+    ProtoWeakMapImplementation::ProtoWeakMapImplementation(
+        ProtoContext* context,
+        ProtoWeakClearCallback onClear,
+        void* userData
+    ) : Cell(context), table(new Table()), onClear(onClear), userData(userData)
+    {
+        registerWeakCell(context, this);
+    }
+
+    const ProtoObject* ProtoWeakMapImplementation::implAsObject(ProtoContext* context) const {
+        ProtoObjectPointer p{};
+        p.weakMapImplementation = this;
+        p.op.pointer_tag = POINTER_TAG_WEAK_MAP;
+        return p.oid;
+    }
+
+    const ProtoObject* ProtoWeakMapImplementation::implGet(ProtoContext* /*context*/, const ProtoObject* key) const {
+        std::lock_guard<std::mutex> lock(table->mutex);
+        auto it = table->entries.find(key);
+        return it == table->entries.end() ? nullptr : it->second;
+    }
+
+    void ProtoWeakMapImplementation::implSet(ProtoContext* /*context*/, const ProtoObject* key, const ProtoObject* value) const {
+        if (!key) return;
+        std::lock_guard<std::mutex> lock(table->mutex);
+        table->entries[key] = value;
+    }
+
+    bool ProtoWeakMapImplementation::implRemove(ProtoContext* /*context*/, const ProtoObject* key) const {
+        std::lock_guard<std::mutex> lock(table->mutex);
+        return table->entries.erase(key) != 0;
+    }
+
+    unsigned long ProtoWeakMapImplementation::implGetSize(ProtoContext* /*context*/) const {
+        std::lock_guard<std::mutex> lock(table->mutex);
+        return table->entries.size();
+    }
+
+    void ProtoWeakMapImplementation::processReferences(
+        ProtoContext* /*context*/,
+        void* /*self*/,
+        void (*/*method*/)(ProtoContext*, void*, const Cell*)
+    ) const {
+        /* Keys and values are traced by the collector's ephemeron pass. */
+    }
+
+    void ProtoWeakMapImplementation::finalize(ProtoContext* context) const {
+        unregisterWeakCell(context, this);
+        delete table;
+        table = nullptr;
+    }
+
+    unsigned long ProtoWeakMapImplementation::getHash(ProtoContext* /*context*/) const {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    // ------------------------------------------------------------------
+    // Collector support
+    // ------------------------------------------------------------------
+
+    void collectWeakReferents(ProtoSpace* space, WeakSnapshot& out) {
+        std::lock_guard<std::mutex> lock(space->weakCellsMutex_);
+        for (const Cell* cell : space->weakCells_) {
+            if (cell->getType() == CellType::WeakRef) {
+                const auto* ref = static_cast<const ProtoWeakRefImplementation*>(cell);
+                const ProtoObject* target = ref->target.load(std::memory_order_acquire);
+                if (isWeakReferent(target))
+                    out.referents.insert(ProtoObject::asCellPointer(target));
+            } else {
+                const auto* map = static_cast<const ProtoWeakMapImplementation*>(cell);
+                std::lock_guard<std::mutex> tableLock(map->table->mutex);
+                for (const auto& entry : map->table->entries) {
+                    if (isWeakReferent(entry.first))
+                        out.referents.insert(ProtoObject::asCellPointer(entry.first));
+                    out.entries.emplace_back(entry.first, entry.second);
+                }
+            }
+        }
+    }
+
+    void clearDeadWeakReferents(ProtoSpace* space, const std::unordered_set<const Cell*>& dying) {
+        struct Notification {
+            ProtoWeakClearCallback callback;
+            void* userData;
+            const ProtoObject* referent;
+        };
+        std::vector<Notification> notifications;
+
+        {
+            std::lock_guard<std::mutex> lock(space->weakCellsMutex_);
+            for (const Cell* cell : space->weakCells_) {
+                if (cell->getType() == CellType::WeakRef) {
+                    const auto* ref = static_cast<const ProtoWeakRefImplementation*>(cell);
+                    const ProtoObject* target = ref->target.load(std::memory_order_acquire);
+                    if (!isWeakReferent(target) || !dying.count(ProtoObject::asCellPointer(target)))
+                        continue;
+                    // A mutator may have retargeted the ref meanwhile; leave it alone then.
+                    if (ref->target.compare_exchange_strong(target, nullptr, std::memory_order_acq_rel) && ref->onClear)
+                        notifications.push_back({ref->onClear, ref->userData, target});
+                } else {
+                    const auto* map = static_cast<const ProtoWeakMapImplementation*>(cell);
+                    std::lock_guard<std::mutex> tableLock(map->table->mutex);
+                    auto& entries = map->table->entries;
+                    for (auto it = entries.begin(); it != entries.end();) {
+                        if (isWeakReferent(it->first) && dying.count(ProtoObject::asCellPointer(it->first))) {
+                            if (map->onClear)
+                                notifications.push_back({map->onClear, map->userData, it->first});
+                            it = entries.erase(it);
+                        } else {
+                            ++it;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (const Notification& n : notifications)
+            n.callback(n.userData, n.referent);
+    }
+
+    void releaseWeakMapTables(ProtoSpace* space) {
+        std::lock_guard<std::mutex> lock(space->weakCellsMutex_);
+        for (const Cell* cell : space->weakCells_) {
+            if (cell->getType() == CellType::WeakMap) {
+                const auto* map = static_cast<const ProtoWeakMapImplementation*>(cell);
+                delete map->table;
+                map->table = nullptr;
+            }
+        }
+        space->weakCells_.clear();
+    }
+
+}
+
+namespace proto {
+
+    const ProtoObject* ProtoWeakRef::get(ProtoContext* context) const {
+        return toImpl<const ProtoWeakRefImplementation>(this)->implGet(context);
+    }
+
+    const ProtoObject* ProtoWeakRef::asObject(ProtoContext* context) const {
+        return toImpl<const ProtoWeakRefImplementation>(this)->implAsObject(context);
+    }
+
+    unsigned long ProtoWeakRef::getHash(ProtoContext* context) const {
+        return toImpl<const ProtoWeakRefImplementation>(this)->getHash(context);
+    }
+
+    const ProtoObject* ProtoWeakMap::get(ProtoContext* context, const ProtoObject* key) const {
+        return toImpl<const ProtoWeakMapImplementation>(this)->implGet(context, key);
+    }
+
+    void ProtoWeakMap::set(ProtoContext* context, const ProtoObject* key, const ProtoObject* value) const {
+        toImpl<const ProtoWeakMapImplementation>(this)->implSet(context, key, value);
+    }
+
+    bool ProtoWeakMap::remove(ProtoContext* context, const ProtoObject* key) const {
+        return toImpl<const ProtoWeakMapImplementation>(this)->implRemove(context, key);
+    }
+
+    unsigned long ProtoWeakMap::getSize(ProtoContext* context) const {
+        return toImpl<const ProtoWeakMapImplementation>(this)->implGetSize(context);
+    }
+
+    const ProtoObject* ProtoWeakMap::asObject(ProtoContext* context) const {
+        return toImpl<const ProtoWeakMapImplementation>(this)->implAsObject(context);
+    }
+
+    unsigned long ProtoWeakMap::getHash(ProtoContext* context) const {
+        return toImpl<const ProtoWeakMapImplementation>(this)->getHash(context);
+    }
+
+}
@@ -141,6 +141,7 @@ const ProtoObject* SymbolTable::intern(ProtoContext* ctx,
         // Not found — insert the pre-built candidate.
         Bucket* bucket = new Bucket{ hash, symbol_candidate, shard.head };
         shard.head = bucket;
+        PROTO_PROBE2(symbol_insert, symbol_candidate, hash);
         return symbol_candidate;
     }
 }
@@ -177,4 +178,25 @@ const ProtoObject* SymbolTable::lookupByContent(ProtoContext* ctx,
     return nullptr;
 }
 
+// ---------------------------------------------------------------------------
+// lookupLiteral — lookupByContent for a PROTO_SYMBOL literal.
+//
+// The caller supplies the content hash (symbolLiteralHash, evaluated at
+// compile time), so no candidate string is built and nothing is hashed at
+// run time; only the bucket chain of one shard is compared byte-wise.
+// ---------------------------------------------------------------------------
+const ProtoObject* SymbolTable::lookupLiteral(ProtoContext* ctx, const char* utf8,
+                                              unsigned long len, uint64_t hash) const {
+    const Shard& shard = shards[shardIndex(hash)];
+    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(shard.mutex));
+    for (const Bucket* b = shard.head; b; b = b->next) {
+        if (b->content_hash != hash) continue;
+        std::string content;
+        reinterpret_cast<const ProtoString*>(b->symbol)->toUTF8String(ctx, content);
+        if (content.size() == len && std::memcmp(content.data(), utf8, len) == 0)
+            return b->symbol;
+    }
+    return nullptr;
+}
+
 } // namespace proto
@@ -6,30 +6,91 @@
  */
 
 #include "../headers/proto_internal.h"
+#include <chrono>
 #include <iostream>
+#include <vector>
+#ifdef __linux__
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <execinfo.h>
+#include <pthread.h>
+#define PROTO_HAS_STACK_CAPTURE 1
+#endif
 
 namespace proto {
 
     namespace {
+        // No-GC regions open on this OS thread, one entry per space: the
+        // nesting depth and the registry slot the collector watches.  A
+        // thread seldom works in more than one space, so a linear scan
+        // will do.
+        struct NoGCRegionState {
+            const ProtoSpace* space;
+            unsigned int depth;
+            ThreadRegistry::NoGCSlot* slot;
+        };
+        thread_local std::vector<NoGCRegionState> noGCRegionStates;
+
+        NoGCRegionState* findNoGCRegion(const ProtoSpace* space) {
+            for (NoGCRegionState& state : noGCRegionStates)
+                if (state.space == space) return &state;
+            return nullptr;
+        }
+
+        // Both caches share one block: the attribute cache first, 64-byte
+        // aligned so that the 32-byte AttributeCacheEntry pair always lands
+        // within one line (no split-line loads on lookups), then the
+        // mutable-value cache.  std::aligned_alloc requires the size to be
+        // a multiple of the alignment, which the asserts below check.
+        constexpr size_t kAttributeCacheBytes = THREAD_CACHE_DEPTH * sizeof(AttributeCacheEntry);
+        constexpr size_t kThreadCacheBytes =
+            kAttributeCacheBytes + MUTABLE_VALUE_CACHE_DEPTH * sizeof(MutableValueCacheEntry);
+        static_assert(kAttributeCacheBytes % 64 == 0, "attribute cache must fill whole cache lines");
+        static_assert(kThreadCacheBytes % 64 == 0, "thread cache block must fill whole cache lines");
+
+        // Blocks kept for reuse; beyond this, exiting threads free theirs.
+        constexpr size_t kThreadCachePoolLimit = 64;
+
+        // Upper bound on one park wait.  Wakes are explicit; this only
+        // bounds the cost of a missed one.
+        constexpr long kParkTimeoutMicros = 10000;
+
+        MutableValueCacheEntry* mutableValueCacheOf(void* block) {
+            return reinterpret_cast<MutableValueCacheEntry*>(static_cast<char*>(block) + kAttributeCacheBytes);
+        }
+
+        void clearThreadCaches(void* block) {
+            auto* attributeCache = static_cast<AttributeCacheEntry*>(block);
+            for (int i = 0; i < THREAD_CACHE_DEPTH; ++i) {
+                attributeCache[i] = {nullptr, nullptr, nullptr, nullptr};
+            }
+            MutableValueCacheEntry* mutableValueCache = mutableValueCacheOf(block);
+            for (int i = 0; i < MUTABLE_VALUE_CACHE_DEPTH; ++i) {
+                mutableValueCache[i] = {0, nullptr, nullptr};
+            }
+        }
+
         void thread_main(
             ProtoContext* context,
             ProtoMethod method,
             const ProtoList* args,
             const ProtoSparseList* kwargs
         ) {
-            // Mark the thread "running" only once the OS thread actually starts
-            // executing.  The constructor previously incremented runningThreads
-            // *before* std::thread was spawned, opening a window where the GC
-            // could observe a phantom running thread (counted in
-            // runningThreads but not yet able to park on stwFlag), and would
-            // wait forever for parkedThreads to catch up.
+            // Count the thread once the OS thread actually runs.
+            // runningThreads only sizes allocation batches; stop-the-world
+            // reads unmanagedDepth instead.
             context->space->runningThreads++;
-            // If a stop-the-world is already in progress when this OS thread
-            // starts, park immediately so the GC's wait-for-N-parked
-            // condition counts us correctly.  Without this, the new thread
-            // would sail past STW and run unsynchronised, sometimes leaving
-            // the GC waiting indefinitely.
-            context->safepoint();
+            auto* self = toImpl<ProtoThreadImplementation>(context->thread);
+            // The thread was created unmanaged (see the constructor), so a
+            // collection never waits for an OS thread that has not started.
+            // Entering managed code parks first if the world is stopped.
+            self->implReturnFromUnmanaged();
             try {
                 method(context, reinterpret_cast<const ProtoObject*>(context->thread), nullptr, args, kwargs);
             } catch (const std::exception& e) {
@@ -37,54 +98,261 @@ namespace proto {
                     std::cerr << "Uncaught exception in thread: " << e.what() << std::endl;
                 }
             }
-            context->space->runningThreads--;
-            // Rebuild the immutable threads list OUTSIDE the global
-            // mutex, then swap inside — see ProtoThreadImplementation
-            // constructor for the recursive_mutex / park deadlock this
-            // pattern avoids.
-            unsigned long threadId = reinterpret_cast<uintptr_t>(context->thread);
-            while (true) {
-                const ProtoSparseList* oldThreads = context->space->threads;
-                const ProtoSparseList* newThreads =
-                    oldThreads->removeAt(context, threadId);
-                std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-                if (context->space->threads == oldThreads) {
-                    context->space->threads = const_cast<ProtoSparseList*>(newThreads);
-                    break;
-                }
+            // Hand the caches straight to the next thread rather than
+            // waiting for the extension to be collected.  This runs while
+            // the thread is still managed and registered: no collection
+            // can be tracing the old pointers, and the registry keeps the
+            // extension alive, so its finalize cannot pool the same block.
+            ProtoThreadExtension* ext = self->extension;
+            AttributeCacheEntry* caches = ext->attributeCache;
+            ext->attributeCache = nullptr;
+            ext->mutableValueCache = nullptr;
+            if (!poolThreadCaches(context->space, caches)) {
+                ext->attributeCache = caches;
+                ext->mutableValueCache = mutableValueCacheOf(caches);
+            }
+            const unsigned int registrySlot = ext->registrySlot;
+            ProtoSpace* space = context->space;
+            // Leave managed code for good: from here on the collector
+            // never waits for this thread.
+            self->implGoUnmanaged();
+            space->runningThreads--;
+            // Leaving the registry is a single store: the exit path
+            // allocates nothing, so it never parks or takes globalMutex.
+            // Once out of it nothing roots this thread's cells, so none
+            // is touched after this point.
+            space->threads->remove(registrySlot, self);
+        }
+    }
+
+    //=========================================================================
+    // Stop-the-world parking
+    //=========================================================================
+
+    static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free,
+                  "futexWait needs std::atomic<int> to be a plain 32-bit word");
+
+    void futexWait(std::atomic<int>& word, int expected, long timeoutMicros) {
+#ifdef __linux__
+        struct timespec timeout;
+        timeout.tv_sec = timeoutMicros / 1000000;
+        timeout.tv_nsec = (timeoutMicros % 1000000) * 1000;
+        syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, &timeout, nullptr, 0);
+#else
+        if (word.load() == expected)
+            std::this_thread::sleep_for(std::chrono::microseconds(timeoutMicros < 50 ? timeoutMicros : 50));
+#endif
+    }
+
+    void futexWake(std::atomic<int>& word) {
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)word;
+#endif
+    }
+
+    void waitForWorldRestart(ProtoSpace* space) {
+        while (space->stwFlag.load() && space->state != SPACE_STATE_ENDING)
+            futexWait(space->stwFlag, 1, kParkTimeoutMicros);
+    }
+
+#ifdef PROTO_HAS_STACK_CAPTURE
+    namespace {
+        // One capture at a time per process.  The requester publishes the
+        // target and moves `state` to Requested; the handler, on the target
+        // thread only, claims it (Running), walks its own stack and
+        // publishes Done.  A requester that gives up takes Requested back
+        // to Idle; if the handler already claimed it, the requester waits
+        // for Done so the buffer is never reused under the handler.
+        enum CaptureState { CaptureIdle, CaptureRequested, CaptureRunning, CaptureDone };
+        constexpr int kMaxCapturedFrames = 64;
+
+        struct StackCapture {
+            std::mutex mutex;
+            std::atomic<int> state{CaptureIdle};
+            pthread_t target;
+            void* frames[kMaxCapturedFrames];
+            int depth = 0;
+        };
+
+        StackCapture stackCapture;
+        std::once_flag stackCaptureHandlerInstalled;
+        // The SIGURG disposition found at install time.  SIGURG also
+        // carries socket out-of-band notices and, in hosts that embed a Go
+        // runtime, goroutine preemption, so every signal that is not a
+        // capture request goes on to it.
+        struct sigaction previousUrgAction;
+
+        void forwardUrgSignal(int signo, siginfo_t* info, void* ucontext) {
+            if (previousUrgAction.sa_flags & SA_SIGINFO) {
+                if (previousUrgAction.sa_sigaction) previousUrgAction.sa_sigaction(signo, info, ucontext);
+            } else if (previousUrgAction.sa_handler != SIG_DFL && previousUrgAction.sa_handler != SIG_IGN) {
+                previousUrgAction.sa_handler(signo);
+            }
+            // SIGURG's default action is to ignore it.
+        }
+
+        void onStackCaptureSignal(int signo, siginfo_t* info, void* ucontext) {
+            const int savedErrno = errno;
+            int expected = CaptureRequested;
+            if (stackCapture.state.load(std::memory_order_acquire) == CaptureRequested &&
+                pthread_equal(pthread_self(), stackCapture.target) &&
+                stackCapture.state.compare_exchange_strong(expected, CaptureRunning)) {
+                stackCapture.depth = backtrace(stackCapture.frames, kMaxCapturedFrames);
+                stackCapture.state.store(CaptureDone, std::memory_order_release);
+                errno = savedErrno;
+                return;
+            }
+            errno = savedErrno;
+            forwardUrgSignal(signo, info, ucontext);
+        }
+
+        void installStackCaptureHandler() {
+            // backtrace() loads its unwinder on first use, which allocates;
+            // do that here rather than inside the handler.
+            void* warmup[1];
+            backtrace(warmup, 1);
+            struct sigaction action {};
+            action.sa_sigaction = onStackCaptureSignal;
+            sigemptyset(&action.sa_mask);
+            // Taken before installing, so the handler never sees it unset.
+            sigaction(SIGURG, nullptr, &previousUrgAction);
+            // Keep the previous handler's alternate stack, which a Go
+            // runtime's handler relies on.
+            action.sa_flags = SA_RESTART | SA_SIGINFO | (previousUrgAction.sa_flags & SA_ONSTACK);
+            sigaction(SIGURG, &action, &previousUrgAction);
+        }
+    }
+
+    int captureThreadStack(std::thread::native_handle_type thread, void** frames, int maxFrames,
+                           long timeoutMicros) {
+        std::call_once(stackCaptureHandlerInstalled, installStackCaptureHandler);
+        std::lock_guard<std::mutex> lock(stackCapture.mutex);
+        stackCapture.target = thread;
+        stackCapture.depth = 0;
+        stackCapture.state.store(CaptureRequested, std::memory_order_release);
+        if (pthread_kill(thread, SIGURG) != 0) {
+            stackCapture.state.store(CaptureIdle);
+            return 0;
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutMicros);
+        while (stackCapture.state.load(std::memory_order_acquire) != CaptureDone) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                int expected = CaptureRequested;
+                if (stackCapture.state.compare_exchange_strong(expected, CaptureIdle)) return 0;
+            }
+            std::this_thread::yield();
+        }
+        const int depth = std::min(stackCapture.depth, maxFrames);
+        std::copy(stackCapture.frames, stackCapture.frames + depth, frames);
+        stackCapture.state.store(CaptureIdle);
+        return depth;
+    }
+#else
+    int captureThreadStack(std::thread::native_handle_type, void**, int, long) {
+        return 0;
+    }
+#endif
+
+    //=========================================================================
+    // ThreadRegistry
+    //=========================================================================
+
+    ThreadRegistry::~ThreadRegistry() {
+        Chunk* c = first.next.load();
+        while (c) {
+            Chunk* next = c->next.load();
+            delete c;
+            c = next;
+        }
+    }
+
+    unsigned int ThreadRegistry::add(ProtoThreadImplementation* thread) {
+        unsigned int base = 0;
+        for (Chunk* c = &first; ; base += CHUNK) {
+            for (unsigned int i = 0; i < CHUNK; ++i) {
+                ProtoThreadImplementation* expected = nullptr;
+                if (!c->slots[i].load(std::memory_order_relaxed) &&
+                    c->slots[i].compare_exchange_strong(expected, thread, std::memory_order_acq_rel))
+                    return base + i;
+            }
+            Chunk* next = c->next.load(std::memory_order_acquire);
+            if (!next) {
+                auto* fresh = new Chunk();
+                if (c->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel))
+                    next = fresh;
+                else
+                    delete fresh;   // another thread grew the chain first
             }
-            context->space->gcCV.notify_all(); // Notify GC that a thread finished
+            c = next;
         }
     }
 
+    void ThreadRegistry::remove(unsigned int index, ProtoThreadImplementation* thread) {
+        Chunk* c = &first;
+        for (; index >= CHUNK; index -= CHUNK) c = c->next.load(std::memory_order_acquire);
+        // The slot may already have been cleared and reused by another thread.
+        ProtoThreadImplementation* expected = thread;
+        c->slots[index].compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+
+    ThreadRegistry::NoGCSlot& ThreadRegistry::noGCSlot(unsigned int index) {
+        Chunk* c = &first;
+        for (; index >= CHUNK; index -= CHUNK) c = c->next.load(std::memory_order_acquire);
+        return c->noGC[index];
+    }
+
+    //=========================================================================
+    // Thread cache pool
+    //=========================================================================
+
+    void acquireThreadCaches(ProtoSpace* space, AttributeCacheEntry*& attributeCache,
+                             MutableValueCacheEntry*& mutableValueCache) {
+        void* block = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(space->threadCachePoolMutex_);
+            if (!space->threadCachePool_.empty()) {
+                block = space->threadCachePool_.back();
+                space->threadCachePool_.pop_back();
+            }
+        }
+        if (!block) {
+            block = std::aligned_alloc(64, kThreadCacheBytes);
+            clearThreadCaches(block);
+        }
+        attributeCache = static_cast<AttributeCacheEntry*>(block);
+        mutableValueCache = mutableValueCacheOf(block);
+    }
+
+    bool poolThreadCaches(ProtoSpace* space, AttributeCacheEntry* attributeCache) {
+        if (!attributeCache) return false;
+        // Cleared by the releasing side so acquiring stays cheap.
+        clearThreadCaches(attributeCache);
+        std::lock_guard<std::mutex> lock(space->threadCachePoolMutex_);
+        if (space->threadCachePool_.size() >= kThreadCachePoolLimit) return false;
+        space->threadCachePool_.push_back(attributeCache);
+        return true;
+    }
+
+    void releaseThreadCachePool(ProtoSpace* space) {
+        std::lock_guard<std::mutex> lock(space->threadCachePoolMutex_);
+        for (void* block : space->threadCachePool_) std::free(block);
+        space->threadCachePool_.clear();
+    }
+
     //=========================================================================
     // ProtoThreadExtension
     //=========================================================================
 
     ProtoThreadExtension::ProtoThreadExtension(ProtoContext* context)
-        : Cell(context), osThread(nullptr), freeCells(nullptr) {
-        // Allocate the attribute cache aligned to a 64-byte cache line so
-        // that the 32-byte AttributeCacheEntry pair always lands within
-        // one line — no split-line loads on lookups.  malloc only
-        // guarantees 16-byte alignment; std::aligned_alloc requires the
-        // request size to be a multiple of the alignment (a C11
-        // requirement it inherits), which holds here because
-        // THREAD_CACHE_DEPTH * 32 is a multiple of 64 for any depth >= 2.
-        this->attributeCache = static_cast<AttributeCacheEntry*>(
-            std::aligned_alloc(64, THREAD_CACHE_DEPTH * sizeof(AttributeCacheEntry)));
-        for (int i = 0; i < THREAD_CACHE_DEPTH; ++i) {
-            this->attributeCache[i] = {nullptr, nullptr, nullptr, nullptr};
-        }
-        this->mutableValueCache = static_cast<MutableValueCacheEntry*>(
-            std::malloc(MUTABLE_VALUE_CACHE_DEPTH * sizeof(MutableValueCacheEntry)));
-        for (int i = 0; i < MUTABLE_VALUE_CACHE_DEPTH; ++i) {
-            this->mutableValueCache[i] = {0, nullptr, nullptr};
-        }
+        : Cell(context), osThread(nullptr), freeCells(nullptr), registrySlot(~0u), handles(nullptr) {
+        acquireThreadCaches(context->space, this->attributeCache, this->mutableValueCache);
     }
 
     ProtoThreadExtension::~ProtoThreadExtension() {
-        std::free(this->attributeCache);
-        std::free(this->mutableValueCache);
+        std::free(this->attributeCache);   // also holds mutableValueCache
+        delete this->handles;
         if (osThread && osThread->joinable()) {
             osThread->join();
         }
@@ -92,7 +360,20 @@ namespace proto {
     }
 
     void ProtoThreadExtension::finalize(ProtoContext* context) const {
-        // Nothing to do here
+        // The thread has left the registry and nobody holds its
+        // ProtoThread.  Its caches normally went back to the pool on
+        // exit; this catches the ones that did not fit.  A never-joined
+        // std::thread is detached so that deleting it does not
+        // terminate the process.
+        auto* self = const_cast<ProtoThreadExtension*>(this);
+        if (!poolThreadCaches(context->space, self->attributeCache)) std::free(self->attributeCache);
+        self->attributeCache = nullptr;
+        self->mutableValueCache = nullptr;
+        if (self->osThread) {
+            if (self->osThread->joinable()) self->osThread->detach();
+            delete self->osThread;
+            self->osThread = nullptr;
+        }
     }
 
     void ProtoThreadExtension::processReferences(
@@ -104,28 +385,35 @@ namespace proto {
             const Cell* cell
             )
     ) const {
-        for (int i = 0; i < THREAD_CACHE_DEPTH; ++i) {
-            if (ProtoObject::isCellPointer(this->attributeCache[i].object)) {
-                method(context, self, ProtoObject::asCellPointer(this->attributeCache[i].object));
+        // Load each cache pointer and entry once: an exiting thread hands
+        // its caches to the pool (clearing them) while marking may be
+        // running, and a live thread keeps writing its own entries.
+        const AttributeCacheEntry* attributes = this->attributeCache;
+        for (int i = 0; attributes && i < THREAD_CACHE_DEPTH; ++i) {
+            const AttributeCacheEntry entry = attributes[i];
+            if (ProtoObject::isCellPointer(entry.object)) {
+                method(context, self, ProtoObject::asCellPointer(entry.object));
             }
-            if (ProtoObject::isCellPointer(this->attributeCache[i].result)) {
-                method(context, self, ProtoObject::asCellPointer(this->attributeCache[i].result));
+            if (ProtoObject::isCellPointer(entry.result)) {
+                method(context, self, ProtoObject::asCellPointer(entry.result));
             }
-            if (ProtoObject::isCellPointer(reinterpret_cast<const ProtoObject*>(this->attributeCache[i].name))) {
-                method(context, self, ProtoObject::asCellPointer(reinterpret_cast<const ProtoObject*>(this->attributeCache[i].name)));
+            if (ProtoObject::isCellPointer(reinterpret_cast<const ProtoObject*>(entry.name))) {
+                method(context, self, ProtoObject::asCellPointer(reinterpret_cast<const ProtoObject*>(entry.name)));
             }
         }
         // Trace MutableValueCache entries as GC roots: the cached shard_root and current_value
         // must not be reclaimed while still referenced by a live cache entry.
-        if (this->mutableValueCache) {
+        const MutableValueCacheEntry* mutableValues = this->mutableValueCache;
+        if (mutableValues) {
             for (int i = 0; i < MUTABLE_VALUE_CACHE_DEPTH; ++i) {
-                if (this->mutableValueCache[i].mutable_ref == 0) continue;
-                const ProtoObject* sr = reinterpret_cast<const ProtoObject*>(this->mutableValueCache[i].shard_root);
+                const MutableValueCacheEntry entry = mutableValues[i];
+                if (entry.mutable_ref == 0) continue;
+                const ProtoObject* sr = reinterpret_cast<const ProtoObject*>(entry.shard_root);
                 if (ProtoObject::isCellPointer(sr)) {
                     method(context, self, ProtoObject::asCellPointer(sr));
                 }
-                if (ProtoObject::isCellPointer(this->mutableValueCache[i].current_value)) {
-                    method(context, self, ProtoObject::asCellPointer(this->mutableValueCache[i].current_value));
+                if (ProtoObject::isCellPointer(entry.current_value)) {
+                    method(context, self, ProtoObject::asCellPointer(entry.current_value));
                 }
             }
         }
@@ -156,55 +444,30 @@ namespace proto {
         const ProtoSparseList* kwargs
     ) : Cell(context), name(name), space(space), args(args), kwargs(kwargs) {
         this->extension = new (context) ProtoThreadExtension(context);
+        ProtoContext* const creatorMainContext = space->mainContext;
         this->context = new ProtoContext(space, nullptr, nullptr, nullptr, args, kwargs);
+        // A parentless context registers itself as its thread's current
+        // context -- the main thread's, when built on the main OS thread --
+        // or else as space->mainContext.  Either slot belongs to the
+        // creator, not to the thread being spawned; hand it back.
+        if (this->context->thread)
+            toImpl<ProtoThreadImplementation>(this->context->thread)->implSetCurrentContext(context);
+        else
+            space->mainContext = creatorMainContext;
         this->context->thread = (ProtoThread*)this->asThread(context);
         // Stash the per-thread mutable-value cache pointer in the
         // freshly-created context so resolveMutableState's hot path
         // can reach it with one load (see ProtoObject.cpp).
         this->context->mutableValueCache_ = this->extension->mutableValueCache;
-        // Build the new `space->threads` list OUTSIDE the global mutex.
-        //
-        // Why: `implSetAt` walks the SparseList and allocates new node
-        // Cells along the path.  Cell allocation may need to park on
-        // STW (stwFlag).  Parking re-acquires `globalMutex` via
-        // `unique_lock`, and `condition_variable::wait(lock)` only
-        // unlocks ONCE on a recursive_mutex — so if we already held
-        // globalMutex from an outer `lock_guard`, the wait leaves the
-        // mutex still owned by us at depth 1.  GC then cannot acquire
-        // it and waits forever for parkedThreads, while we wait
-        // forever for stwFlag to clear.  Doing the allocation here,
-        // before the lock, lets the alloc park cleanly.
-        //
-        // The CAS retry loop handles the rare case where another
-        // thread inserts into space->threads between our read and our
-        // swap — we recompute newThreads off the current oldThreads.
-        unsigned long threadId = reinterpret_cast<uintptr_t>(this->asThread(context));
-        const ProtoObject* threadAsObj = (const ProtoObject*)this->asThread(context);
-        // GC critical section: implSetAt allocates a chain of new
-        // SparseList nodes that are reachable only via `newThreads`
-        // (a C++ local) until the publish-store to space->threads
-        // happens under globalMutex.  A concurrent STW root scan would
-        // miss the chain and a sweep would free it before the publish.
-        // Same discipline as ProtoObject::setAttribute (mutable path).
-        ProtoContext::CriticalSection cs(context);
-        while (true) {
-            const ProtoSparseList* oldThreads = space->threads;
-            const ProtoSparseList* newThreads =
-                oldThreads->setAt(context, threadId, threadAsObj);
-            std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-            if (space->threads == oldThreads) {
-                space->threads = const_cast<ProtoSparseList*>(newThreads);
-                break;
-            }
-            // Else: another newThread won the race; loop and rebuild
-            // off the now-current oldThreads.
-        }
-        // NOTE: runningThreads is intentionally NOT incremented here.
-        // It is incremented inside thread_main, the moment the OS
-        // thread actually starts executing.  This closes the deadlock
-        // window between this point and `new std::thread(...)` below,
-        // during which GC would otherwise see a phantom running thread
-        // that could never park on stwFlag.
+        // Publish in the registry before the OS thread exists, so the
+        // collector scans the new context from its first instruction.
+        // The thread starts out unmanaged; thread_main enters managed
+        // code once it runs.
+        this->extension->unmanagedDepth.store(1);
+        this->extension->registrySlot = space->threads->add(this);
+        // NOTE: runningThreads is incremented inside thread_main, the
+        // moment the OS thread actually starts executing.  It only sizes
+        // allocation batches; stop-the-world reads unmanagedDepth.
         this->extension->osThread = new std::thread(thread_main, this->context, mainFunction, args, kwargs);
     }
 
@@ -230,48 +493,14 @@ namespace proto {
         // adopted main context so resolveMutableState's hot path can
         // reach it with one load (see ProtoObject.cpp).
         this->context->mutableValueCache_ = this->extension->mutableValueCache;
-        // Register in space->threads using the same lock-out-of-the-CAS
-        // pattern as the spawning constructor.
-        unsigned long threadId = reinterpret_cast<uintptr_t>(this->asThread(mainContext));
-        const ProtoObject* threadAsObj = (const ProtoObject*)this->asThread(mainContext);
-        // GC critical section: same rationale as the spawning
-        // constructor above — newThreads is held in a C++ local across
-        // the implSetAt allocations and only published to
-        // space->threads at the bottom of the loop.
-        ProtoContext::CriticalSection cs(mainContext);
-        while (true) {
-            const ProtoSparseList* oldThreads = space->threads;
-            const ProtoSparseList* newThreads =
-                oldThreads->setAt(mainContext, threadId, threadAsObj);
-            std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-            if (space->threads == oldThreads) {
-                space->threads = const_cast<ProtoSparseList*>(newThreads);
-                break;
-            }
-        }
-        // No osThread spawn — we are the OS thread.
-        // No runningThreads bump — the main thread is implicit and
-        // doesn't participate in stop-the-world parking the same way
-        // child threads do (it owns the main loop that drives GC).
+        this->extension->registrySlot = space->threads->add(this);
+        // No osThread spawn — we are the OS thread, already running
+        // managed code (unmanagedDepth 0).  No runningThreads bump — the
+        // space counts the main thread from construction.
     }
 
     ProtoThreadImplementation::~ProtoThreadImplementation() {
-        // Same pattern as the constructor: do the immutable-list rebuild
-        // OUTSIDE the global mutex, then swap inside.  implRemoveAt
-        // allocates new node Cells and may park; parking under
-        // recursive_mutex would leave the lock held at depth 1 (see
-        // constructor comment for the full deadlock chain).
-        unsigned long threadId = reinterpret_cast<uintptr_t>(this->asThread(this->context));
-        while (true) {
-            const ProtoSparseList* oldThreads = space->threads;
-            const ProtoSparseList* newThreads =
-                oldThreads->removeAt(this->context, threadId);
-            std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-            if (space->threads == oldThreads) {
-                space->threads = const_cast<ProtoSparseList*>(newThreads);
-                break;
-            }
-        }
+        space->threads->remove(this->extension->registrySlot, this);
         delete this->context;
     }
 
@@ -304,6 +533,8 @@ namespace proto {
     Cell* ProtoThreadImplementation::implAllocCell(ProtoContext* context) {
         if (!this->extension->freeCells) {
             this->implSynchToGC();
+            if (inNoGCRegion(this->space))
+                this->space->noGCReserveExhausted.fetch_add(1, std::memory_order_relaxed);
             // getFreeCells takes the context so it can enforce the heap
             // allocation limit (and identify critical-section / GC-thread
             // callers that bypass it).  No per-context spinlock is held on
@@ -322,8 +553,42 @@ namespace proto {
         return newCell;
     }
 
+    Cell* ProtoThreadImplementation::implAllocCells(ProtoContext* context, unsigned long count,
+                                                     unsigned long& taken) {
+        Cell* head = nullptr;
+        Cell* tail = nullptr;
+        taken = 0;
+        while (taken < count) {
+            if (!this->extension->freeCells) {
+                this->implSynchToGC();
+                if (inNoGCRegion(this->space))
+                    this->space->noGCReserveExhausted.fetch_add(1, std::memory_order_relaxed);
+                this->extension->freeCells = this->space->getFreeCells(context);
+                if (!this->extension->freeCells) break;
+            }
+            // Cut the longest prefix the request still needs in one walk.
+            Cell* first = this->extension->freeCells;
+            Cell* last = first;
+            ++taken;
+            for (Cell* next; taken < count && (next = last->getNext()); last = next)
+                ++taken;
+            this->extension->freeCells = last->getNext();
+            if (tail) tail->internalSetNextRaw(first);
+            else head = first;
+            tail = last;
+        }
+        if (tail) tail->internalSetNextRaw(nullptr);
+        return head;
+    }
+
     void ProtoThreadImplementation::implSynchToGC() {
-        if (this->space->stwFlag.load()) {
+        if (this->space->stwFlag.load(std::memory_order_relaxed)) {
+            // Only while the collector backs off from a stop that raced a
+            // region's entry (see gcThreadLoop): the region keeps running.
+            // An expired region parks like any other code.
+            const NoGCRegionState* region = findNoGCRegion(this->space);
+            if (region && region->slot->state.load(std::memory_order_relaxed) == ThreadRegistry::NoGCSlot::OPEN)
+                return;
 #ifdef PROTOCORE_GC_REINCLUDE_SURVIVORS
             // Same critical-section discipline as ProtoContext::allocCell()
             // and ProtoContext::safepoint(): never park while the current
@@ -335,13 +600,14 @@ namespace proto {
             // unreachable from any root and freed.
             if (this->context && this->context->criticalSectionDepth > 0) return;
 #endif
-            this->space->parkedThreads++;
-            {
-                std::unique_lock<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-                this->space->gcCV.notify_all(); // Notify GC that a thread parked
-                this->space->stopTheWorldCV.wait(lock, [this] { return !this->space->stwFlag.load(); });
-            }
-            this->space->parkedThreads--;
+            // A safepoint park is an unmanaged region that only ends once
+            // the world restarts.
+            const uint64_t tracePark = traceBegin(this->space);
+            PROTO_PROBE1(safepoint_park, this);
+            this->implGoUnmanaged();
+            this->implReturnFromUnmanaged();
+            PROTO_PROBE1(safepoint_unpark, this);
+            traceEnd(this->space, tracePark, "safepoint.park");
         }
     }
 
@@ -349,16 +615,14 @@ namespace proto {
     //
     // The thread is about to leave protoCore-managed code (typically for a
     // blocking OS call: read / write / sleep / poll / network I/O). Bump the
-    // depth counter; if this is the FIRST entry (0 → 1) the thread also
-    // pre-registers as parked in the GC quorum (parkedThreads++), so the
-    // collector can complete a stop-the-world phase without waiting for this
-    // thread to reach a real safepoint. Notify the GC after the counter bump
-    // — it may already have set stwFlag and be waiting on the quorum that
-    // this thread was the missing piece of.
+    // depth counter, which is also the thread's stop-the-world state: any
+    // non-zero value tells the collector it need not wait for this thread.
     //
-    // Nested calls (depth > 1 after increment) do not change parkedThreads —
-    // a single thread can only contribute one slot to the quorum regardless
-    // of how many transitive unmanaged regions it has open.
+    // The common case is one uncontended atomic add plus a load.  Only when
+    // a stop-the-world is in progress does the outermost entry wake the
+    // collector, which may be futex-waiting on exactly this word.  The add
+    // and the load are both seq_cst, pairing with the collector's store of
+    // stwFlag and its load of the depth: at least one side sees the other.
     void ProtoThreadImplementation::implGoUnmanaged() {
         if (!this->extension) {
             // Early-bootstrap path: the per-thread extension is not yet
@@ -368,46 +632,124 @@ namespace proto {
             // until the extension is in place.
             return;
         }
-        int prev = this->extension->unmanagedDepth.fetch_add(1, std::memory_order_acq_rel);
-        if (prev == 0) {
-            // First entry: announce this thread as "out".
-            this->space->parkedThreads.fetch_add(1, std::memory_order_acq_rel);
-            // The GC may have been waiting for us — kick the quorum check.
-            std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-            this->space->gcCV.notify_all();
-        }
+        std::atomic<int>& depth = this->extension->unmanagedDepth;
+        if (depth.fetch_add(1) == 0 && this->space->stwFlag.load())
+            futexWake(depth);
     }
 
-    // Mirror of implGoUnmanaged. Decrement the counter; if this was the
-    // outermost pair (depth went 1 → 0) the thread re-enters the GC quorum.
-    // If a stop-the-world phase is in progress at that moment, the thread
-    // BLOCKS exactly like a normal safepoint park — it must not touch any
-    // ProtoObject* until the GC's scan finishes.
+    // Mirror of implGoUnmanaged. Nested returns just decrement.  The
+    // outermost one swaps the depth back to 0 and then checks stwFlag; if a
+    // stop-the-world began meanwhile the thread steps back out (waking the
+    // collector, which may have seen the 0), waits for the world to
+    // restart, and tries again.  It must not touch any ProtoObject* until
+    // the GC's scan finishes.
     //
-    // Order matters: we decrement parkedThreads first (we are no longer
-    // "out"), THEN if STW is set we re-park properly. The brief window where
-    // parkedThreads dipped is harmless: if the GC was past its quorum check
-    // (i.e. stwFlag set), it is already running and the dip does not affect
-    // it; if the GC was NOT yet past quorum, our re-park immediately
-    // restores the count.
+    // An unmatched return (depth already 0) is ignored: letting the depth go
+    // negative would report a managed thread as safe.
     void ProtoThreadImplementation::implReturnFromUnmanaged() {
         if (!this->extension) return;  // mirror implGoUnmanaged's early-bootstrap guard
-        int prev = this->extension->unmanagedDepth.fetch_sub(1, std::memory_order_acq_rel);
-        if (prev == 1) {
-            // Last release: un-park.
-            this->space->parkedThreads.fetch_sub(1, std::memory_order_acq_rel);
-            // If STW is happening, block as a normal safepoint would.
-            if (this->space->stwFlag.load(std::memory_order_acquire)) {
-                this->space->parkedThreads.fetch_add(1, std::memory_order_acq_rel);
-                {
-                    std::unique_lock<std::recursive_mutex> lock(ProtoSpace::globalMutex);
-                    this->space->gcCV.notify_all();
-                    this->space->stopTheWorldCV.wait(lock,
-                        [this] { return !this->space->stwFlag.load(); });
-                }
-                this->space->parkedThreads.fetch_sub(1, std::memory_order_acq_rel);
+        std::atomic<int>& depth = this->extension->unmanagedDepth;
+        const int current = depth.load(std::memory_order_relaxed);
+        if (current <= 0) return;
+        if (current > 1) {
+            depth.store(current - 1, std::memory_order_relaxed);
+            return;
+        }
+        for (;;) {
+            depth.exchange(0);
+            if (!this->space->stwFlag.load()) return;
+            depth.store(1);
+            futexWake(depth);
+            waitForWorldRestart(this->space);
+        }
+    }
+
+    // No-GC regions.  Entry counts the region in space->noGCRegions and
+    // then re-checks stwFlag; the collector raises stwFlag and then
+    // re-checks noGCRegions.  All four are seq_cst, so either the region
+    // sees the stop and lets it finish first, or the collector sees the
+    // region and backs off.  That handshake is the only place a region and
+    // a stop can meet: past noGCMaxMicros the collector expires the
+    // region (ThreadRegistry::NoGCSlot) instead of stopping the world
+    // under it, and the thread parks at its next safepoint.
+    void ProtoThreadImplementation::implEnterNoGC(ProtoContext* context, unsigned long reserveCells) {
+        if (!this->extension) return;
+        if (NoGCRegionState* open = findNoGCRegion(this->space)) {
+            ++open->depth;
+            return;
+        }
+
+        // Top the free cells up to the reservation while parking and
+        // taking the global lock are still allowed.
+        unsigned long reserved = 0;
+        for (Cell* cell = this->extension->freeCells; cell && reserved < reserveCells; cell = cell->getNext())
+            ++reserved;
+        while (reserved < reserveCells) {
+            Cell* batch = this->space->getFreeCells(context);
+            if (!batch) break;
+            Cell* last = batch;
+            ++reserved;
+            while (last->getNext()) {
+                last = last->getNext();
+                ++reserved;
             }
+            last->internalSetNextRaw(this->extension->freeCells);
+            this->extension->freeCells = batch;
         }
+
+        for (;;) {
+            this->space->noGCRegions.fetch_add(1);
+            if (!this->space->stwFlag.load()) break;
+            // A stop is already under way: let it finish first.
+            if (this->space->noGCRegions.fetch_sub(1) == 1 && this->space->noGCStopPending.load())
+                futexWake(this->space->noGCRegions);
+            this->implGoUnmanaged();
+            this->implReturnFromUnmanaged();
+        }
+        ThreadRegistry::NoGCSlot& slot = this->space->threads->noGCSlot(this->extension->registrySlot);
+        slot.entered.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        slot.state.store(ThreadRegistry::NoGCSlot::OPEN, std::memory_order_release);
+        noGCRegionStates.push_back({this->space, 1, &slot});
+    }
+
+    void ProtoThreadImplementation::implExitNoGC() {
+        if (!this->extension) return;
+        NoGCRegionState* open = findNoGCRegion(this->space);
+        if (!open || --open->depth > 0) return;
+        ThreadRegistry::NoGCSlot* slot = open->slot;
+        const std::chrono::steady_clock::time_point entered{
+            std::chrono::steady_clock::duration(slot->entered.load(std::memory_order_relaxed))};
+        const unsigned long micros = static_cast<unsigned long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - entered).count());
+        noGCRegionStates.erase(noGCRegionStates.begin() + (open - noGCRegionStates.data()));
+        // An expired region was already uncounted and reported by the
+        // collector.
+        const bool expired = slot->state.exchange(ThreadRegistry::NoGCSlot::CLOSED) == ThreadRegistry::NoGCSlot::EXPIRED;
+        if (!expired && this->space->noGCRegions.fetch_sub(1) == 1 && this->space->noGCStopPending.load())
+            futexWake(this->space->noGCRegions);
+        // The safepoint the region skipped: a postponed cycle may be
+        // about to stop the world.
+        this->implSynchToGC();
+
+        unsigned long longest = this->space->noGCLongestMicros.load(std::memory_order_relaxed);
+        while (micros > longest &&
+               !this->space->noGCLongestMicros.compare_exchange_weak(longest, micros, std::memory_order_relaxed)) {
+        }
+        if (expired || micros <= this->space->noGCMaxMicros.load(std::memory_order_relaxed)) return;
+        this->space->noGCOverruns.fetch_add(1, std::memory_order_relaxed);
+        ProtoNoGCOverrunCallback callback;
+        void* userData;
+        {
+            std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
+            callback = this->space->noGCOverrunCallback;
+            userData = this->space->noGCOverrunUserData;
+        }
+        if (callback) callback(userData, this->asThread(context), micros);
+    }
+
+    bool ProtoThreadImplementation::inNoGCRegion(const ProtoSpace* space) {
+        return !noGCRegionStates.empty() && findNoGCRegion(space) != nullptr;
     }
 
     void ProtoThreadImplementation::implSetCurrentContext(ProtoContext* context) {
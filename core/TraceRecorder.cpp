@@ -0,0 +1,246 @@
+/*
+ * TraceRecorder.cpp
+ *
+ * The event trace behind ProtoSpace::startTrace.
+ *
+ * Recording.  Events go into a power-of-two ring of 64-byte slots.  A
+ * writer claims the next index with one atomic add and fills the slot in
+ * place; the slot's sequence word is 0 while it is written and index + 1
+ * once it is complete, so readers copy a slot and keep it only if the
+ * sequence was the expected one before and after the copy.  Once the ring
+ * wraps, the oldest events are overwritten.  Two writers can only share a
+ * slot if one is a whole ring behind the other, which the minimum
+ * capacity makes a non-issue for spans recorded as they end.
+ *
+ * Restarting with the same capacity keeps the ring and moves the trace's
+ * first index past the events already recorded; another capacity swaps in
+ * a new ring and retires the old one, which stays allocated in case a
+ * writer that loaded it is still filling a slot.
+ *
+ * Output.  writeChromeTrace writes the JSON object format of the Chrome
+ * trace-event spec: spans as complete ("X") events, counters as "C"
+ * events, and thread names as metadata.  Timestamps are microseconds
+ * since the recorder was created.  The category of an event is its name
+ * up to the first '.'.
+ */
+
+#include "../headers/proto_internal.h"
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+namespace proto {
+
+    namespace {
+
+        constexpr unsigned long kMinCapacity = 1024;
+
+        // Small process-wide thread numbers, assigned at a thread's first
+        // event.
+        std::atomic<unsigned int> nextTraceThread{1};
+        thread_local unsigned int traceThread = 0;
+
+        unsigned int currentTraceThread() {
+            if (!traceThread) traceThread = nextTraceThread.fetch_add(1, std::memory_order_relaxed);
+            return traceThread;
+        }
+
+        unsigned long roundUpToPowerOfTwo(unsigned long n) {
+            unsigned long capacity = kMinCapacity;
+            while (capacity < n) capacity <<= 1;
+            return capacity;
+        }
+
+        void writeJSONString(FILE* out, const char* text) {
+            std::fputc('"', out);
+            for (const char* c = text; *c; ++c) {
+                const unsigned char ch = static_cast<unsigned char>(*c);
+                if (ch == '"' || ch == '\\') std::fprintf(out, "\\%c", ch);
+                else if (ch < 0x20) std::fprintf(out, "\\u%04x", ch);
+                else std::fputc(ch, out);
+            }
+            std::fputc('"', out);
+        }
+
+        void writeCategory(FILE* out, const char* name) {
+            std::fputc('"', out);
+            for (const char* c = name; *c && *c != '.'; ++c) std::fputc(*c, out);
+            std::fputc('"', out);
+        }
+
+    } // namespace
+
+    TraceRecorder::Ring::Ring(unsigned long capacity)
+        : mask(capacity - 1), slots(new Event[capacity]()), next(0), begin(0) {}
+
+    TraceRecorder::Ring::~Ring() {
+        delete[] slots;
+    }
+
+    TraceRecorder::TraceRecorder() : origin(now()), ring(nullptr) {}
+
+    TraceRecorder::~TraceRecorder() {
+        delete ring.load(std::memory_order_relaxed);
+        for (Ring* old : retired) delete old;
+    }
+
+    uint64_t TraceRecorder::now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void TraceRecorder::start(unsigned long capacity) {
+        capacity = roundUpToPowerOfTwo(capacity);
+        std::lock_guard<std::mutex> lock(mutex);
+        Ring* current = ring.load(std::memory_order_relaxed);
+        if (current && current->mask + 1 == capacity) {
+            current->begin = current->next.load();
+            return;
+        }
+        if (current) retired.push_back(current);
+        ring.store(new Ring(capacity), std::memory_order_release);
+    }
+
+    void TraceRecorder::record(char kind, const char* name, uint64_t start, uint64_t duration,
+                               const char* argName, long value, const char* detail) {
+        Ring* current = ring.load(std::memory_order_acquire);
+        const uint64_t index = current->next.fetch_add(1, std::memory_order_relaxed);
+        Event& event = current->slots[index & current->mask];
+        event.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        event.start = start;
+        event.duration = duration;
+        event.name = name;
+        event.argName = argName;
+        event.detail = detail;
+        event.value = value;
+        event.thread = currentTraceThread();
+        event.kind = kind;
+        event.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    void TraceRecorder::complete(const char* name, uint64_t start, uint64_t end,
+                                 const char* argName, long value, const char* detail) {
+        record('X', name, start, end > start ? end - start : 0, argName, value, detail);
+    }
+
+    void TraceRecorder::counter(const char* name, long value) {
+        record('C', name, now(), 0, nullptr, value, nullptr);
+    }
+
+    const char* TraceRecorder::intern(const std::string& text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return strings.insert(text).first->c_str();
+    }
+
+    void TraceRecorder::nameThread(const char* name) {
+        const unsigned int thread = currentTraceThread();
+        std::lock_guard<std::mutex> lock(mutex);
+        threadNames[thread] = name;
+    }
+
+    std::vector<ProtoTraceEvent> TraceRecorder::events() {
+        std::vector<ProtoTraceEvent> out;
+        std::lock_guard<std::mutex> lock(mutex);
+        Ring* current = ring.load(std::memory_order_acquire);
+        if (!current) return out;
+        const uint64_t end = current->next.load(std::memory_order_acquire);
+        const uint64_t capacity = current->mask + 1;
+        const uint64_t first = std::max(current->begin, end > capacity ? end - capacity : 0);
+        out.reserve(end - first);
+        for (uint64_t index = first; index < end; ++index) {
+            const Event& event = current->slots[index & current->mask];
+            const uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+            if (sequence != index + 1) continue;  // still being written, or overwritten
+            ProtoTraceEvent copy{event.name, event.kind, event.thread,
+                                 event.start >= origin ? event.start - origin : 0,
+                                 event.duration, event.argName, event.value, event.detail};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (event.sequence.load(std::memory_order_relaxed) != sequence) continue;
+            out.push_back(copy);
+        }
+        return out;
+    }
+
+    bool TraceRecorder::writeChromeTrace(const char* path) {
+        const std::vector<ProtoTraceEvent> list = events();
+        std::map<unsigned int, std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            names = threadNames;
+        }
+        FILE* out = std::fopen(path, "w");
+        if (!out) return false;
+        const int pid = static_cast<int>(getpid());
+
+        std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+                          "\"args\":{\"name\":\"protoCore\"}}", pid);
+        for (const auto& entry : names) {
+            std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",
+                         pid, entry.first);
+            writeJSONString(out, entry.second.c_str());
+            std::fprintf(out, "}}");
+        }
+        for (const ProtoTraceEvent& event : list) {
+            std::fprintf(out, ",\n{\"name\":");
+            writeJSONString(out, event.name);
+            std::fprintf(out, ",\"cat\":");
+            writeCategory(out, event.name);
+            std::fprintf(out, ",\"ph\":\"%c\",\"ts\":%.3f,", event.kind, event.startNanos / 1000.0);
+            if (event.kind == 'X') std::fprintf(out, "\"dur\":%.3f,", event.durationNanos / 1000.0);
+            std::fprintf(out, "\"pid\":%d,\"tid\":%u,\"args\":{", pid, event.thread);
+            if (event.kind == 'C') {
+                writeJSONString(out, event.name);
+                std::fprintf(out, ":%ld", event.value);
+            } else {
+                bool first = true;
+                if (event.argName) {
+                    writeJSONString(out, event.argName);
+                    std::fprintf(out, ":%ld", event.value);
+                    first = false;
+                }
+                if (event.detail) {
+                    std::fprintf(out, "%s\"detail\":", first ? "" : ",");
+                    writeJSONString(out, event.detail);
+                }
+            }
+            std::fprintf(out, "}}");
+        }
+        std::fprintf(out, "\n]}\n");
+        const bool written = !std::ferror(out);
+        return std::fclose(out) == 0 && written;
+    }
+
+    void ProtoSpace::startTrace(unsigned long capacity) {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        if (!this->traceRecorder) this->traceRecorder = new TraceRecorder();
+        this->traceRecorder->start(capacity ? capacity : TRACE_EVENTS_DEFAULT);
+        this->tracing.store(true, std::memory_order_release);
+    }
+
+    void ProtoSpace::stopTrace() {
+        std::lock_guard<std::recursive_mutex> lock(globalMutex);
+        this->tracing.store(false, std::memory_order_relaxed);
+    }
+
+    std::vector<ProtoTraceEvent> ProtoSpace::traceEvents() {
+        TraceRecorder* recorder;
+        {
+            std::lock_guard<std::recursive_mutex> lock(globalMutex);
+            recorder = this->traceRecorder;
+        }
+        return recorder ? recorder->events() : std::vector<ProtoTraceEvent>();
+    }
+
+    bool ProtoSpace::writeTrace(const char* path) {
+        TraceRecorder* recorder;
+        {
+            std::lock_guard<std::recursive_mutex> lock(globalMutex);
+            recorder = this->traceRecorder;
+        }
+        return recorder && recorder->writeChromeTrace(path);
+    }
+
+} // namespace proto
@@ -14,6 +14,7 @@
 #include <string>
 #include <mutex>
 #include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace proto
@@ -29,6 +30,10 @@ namespace proto
     class ProtoContext;
     class ProtoSpace;
     class ProtoRootSet;
+    class ProtoTaskPool;
+    class ProtoTask;
+    class ProtoFiber;
+    class ProtoEventLoop;
     class DirtySegment;
     class ProtoObject;
     class TupleDictionary;
@@ -36,6 +41,11 @@ namespace proto
     class ProtoString;
     class ProtoExternalPointer;
     class ProtoExternalBuffer;
+    class ProtoWeakRef;
+    class ProtoWeakMap;
+    class ProtoFuture;
+    class ProtoPromise;
+    class ProtoChannel;
     class ParentLink;
     class ProtoList;
     class ProtoListIterator;
@@ -52,6 +62,14 @@ namespace proto
     class ProtoSpaceImplementation;
     class ModuleProvider;
     class ProviderRegistry;
+    struct AncestorTable;
+    struct ChainSummary;
+    struct HandleArea;
+    struct HandleBlock;
+    struct ThreadRegistry;
+    struct HeapSnapshotRequest;
+    class AllocationProfiler;
+    class TraceRecorder;
 
     //! Useful constants.
     //! @warning They should be kept in sync with proto_internal.h!
@@ -67,6 +85,169 @@ namespace proto
         const ProtoSparseList* keywordParameters
     );
 
+    /**
+     * @brief Vectorcall-style native method signature.
+     *
+     * Arguments arrive as a contiguous caller-owned array instead of a
+     * ProtoList / ProtoSparseList pair, so a call through
+     * `ProtoObject::callv` allocates nothing before the callee runs:
+     *
+     *   - `args[0 .. nargs)` are the positional arguments;
+     *   - `args[nargs + i]` is the value of keyword `kwnames[i]`, for each
+     *     entry of `kwnames` (a tuple of ProtoString names);
+     *   - `kwnames` is nullptr when the call carries no keywords.
+     *
+     * The array is only valid for the duration of the call.  A callee that
+     * needs to keep an argument must store it in a GC-visible structure
+     * (attribute, list, root set) before returning.
+     */
+    typedef const ProtoObject*(*ProtoFastMethod)(
+        ProtoContext* context,
+        const ProtoObject* self,
+        const ParentLink* parentLink,
+        const ProtoObject* const* args,
+        unsigned long nargs,
+        const ProtoTuple* kwnames
+    );
+
+    /**
+     * @brief Notification that a weak reference or weak map entry lost its
+     * referent.  Runs on the collector thread after sweep, with no context:
+     * it must not allocate or call into the space.  `referent` is the dead
+     * object (a weak ref's target or a weak map key); it is still allocated
+     * during the call but must not be stored anywhere.
+     */
+    typedef void (*ProtoWeakClearCallback)(void* userData, const ProtoObject* referent);
+
+    /**
+     * @brief A thread that has kept a stop-the-world waiting longer than the
+     * safepoint watchdog threshold (see ProtoSpace::setSafepointWatchdog).
+     */
+    struct ProtoSafepointLaggard {
+        const ProtoThread* thread;
+        /** The thread's name; empty when it has none. */
+        std::string name;
+        /** How long the current stop-the-world has been waiting. */
+        unsigned long waitedMicros;
+        /** Whether the collector has ever seen this thread parked or
+         *  unmanaged.  False for a thread started since the last stop. */
+        bool seenAtSafepoint;
+        /** Time from the thread's last observed safepoint to the start of
+         *  this stop; 0 when `seenAtSafepoint` is false. */
+        unsigned long sinceSafepointMicros;
+        /** Return addresses sampled from the thread, innermost first.
+         *  Empty unless stack capture is enabled. */
+        std::vector<void*> stack;
+    };
+
+    /**
+     * @brief Safepoint watchdog report.  Runs on the collector thread while
+     * the world is stopping, with no context: it must not allocate or call
+     * into the space.
+     */
+    typedef void (*ProtoSafepointLaggardCallback)(void* userData, const ProtoSafepointLaggard& laggard);
+
+    /**
+     * @brief No-GC region overrun report (see ProtoSpace::setNoGCLimit).
+     * Runs on the collector thread as soon as a region outlasts the limit
+     * and holds off a cycle; `thread` owns the region and `micros` is how
+     * long it had been open.  Otherwise it runs on the region's own
+     * thread, after the region has closed.
+     */
+    typedef void (*ProtoNoGCOverrunCallback)(void* userData, const ProtoThread* thread, unsigned long micros);
+
+    /**
+     * @brief Allocations recorded by the sampling allocation profiler (see
+     * ProtoSpace::startAllocationProfiler).  A live sample is one cell;
+     * dead samples with the same type, site, stack and survival count are
+     * merged.
+     */
+    struct ProtoAllocationSample {
+        /** The cell type ("Object", "List", ...), or "unresolved" while the
+         *  cell was still being constructed when last looked at. */
+        std::string type;
+        /** The ProtoAllocationSite tag in force when the cell was
+         *  allocated; nullptr outside any site. */
+        const char* site;
+        /** Return addresses at the allocation, innermost first.  Empty
+         *  unless stack capture is enabled. */
+        std::vector<void*> stack;
+        /** Samples merged into this one. */
+        unsigned long count;
+        /** Allocations these samples stand for, given the sampling rate. */
+        double weight;
+        /** GC cycles the cells lived through: so far if live, in all if dead. */
+        unsigned long survivedCycles;
+        /** Whether the cells are still allocated. */
+        bool live;
+    };
+
+    /**
+     * @brief Cells of one type in a heap census (see ProtoSpace::setHeapCensus).
+     */
+    struct ProtoHeapCensusEntry {
+        /** The cell type ("List", "StringLeafNode", "Double", ...). */
+        const char* type;
+        /** Cells of this type the cycle's mark found reachable. */
+        unsigned long live;
+        /** Cells of this type the cycle's sweep reclaimed. */
+        unsigned long reclaimed;
+    };
+
+    struct ProtoHeapCensus {
+        /** gcCycleCount of the cycle counted; 0 if no cycle ran with the census on. */
+        uint64_t cycle;
+        /** Every type with live or reclaimed cells, most live first. */
+        std::vector<ProtoHeapCensusEntry> entries;
+    };
+
+    /**
+     * @brief A runtime event recorded by the event trace (see
+     * ProtoSpace::startTrace).
+     */
+    struct ProtoTraceEvent {
+        /** What happened ("gc.mark", "safepoint.park", "heap.grow", ...). */
+        const char* name;
+        /** 'X' for a span, 'C' for a counter sample. */
+        char kind;
+        /** Small per-process number of the recording thread. */
+        unsigned int thread;
+        /** Nanoseconds since the space's first startTrace. */
+        uint64_t startNanos;
+        /** Length of a span; 0 for a counter. */
+        uint64_t durationNanos;
+        /** Name of the event's one argument, or nullptr if it has none. */
+        const char* argName;
+        /** The argument's value, or the counter's. */
+        long value;
+        /** Free-form detail such as a module path, or nullptr. */
+        const char* detail;
+    };
+
+    /**
+     * @brief Tags the allocations the current thread makes while the
+     * object is alive, for the allocation profiler.
+     *
+     *   ProtoAllocationSite site("parser.tokens");
+     *   ... allocations here are attributed to "parser.tokens" ...
+     *
+     * Sites nest; the innermost wins.  `tag` is not copied and must stay
+     * valid as long as the space's profile does (a string literal, in
+     * practice).  Costs two thread-local stores, profiler on or off.
+     */
+    class ProtoAllocationSite
+    {
+    public:
+        explicit ProtoAllocationSite(const char* tag);
+        ~ProtoAllocationSite();
+
+        ProtoAllocationSite(const ProtoAllocationSite&) = delete;
+        ProtoAllocationSite& operator=(const ProtoAllocationSite&) = delete;
+
+    private:
+        const char* previous_;
+    };
+
     class ProtoObject
     {
     public:
@@ -193,7 +374,25 @@ namespace proto
                                 const ProtoObject* self,
                                 const ProtoList* positionalParameters,
                                 const ProtoSparseList* keywordParametersDict = nullptr) const;
-        
+        /**
+         * @brief Allocation-free call: vectorcall counterpart of `call`.
+         *
+         * Resolves `method` exactly like `call`, but takes the arguments as
+         * a native array (see ProtoFastMethod for the `args` / `nargs` /
+         * `kwnames` layout).  When the target was created with
+         * `ProtoContext::fromFastMethod` the array is handed straight to
+         * the callee and no list is built.  Legacy ProtoMethod targets and
+         * `nonMethodCallback` still receive a ProtoList + keyword dict,
+         * packed on demand with `newList(n, items)` (one cell for n ≤ 5).
+         */
+        const ProtoObject* callv(ProtoContext* context,
+                                 const ParentLink* nextParent,
+                                 const ProtoString* method,
+                                 const ProtoObject* self,
+                                 const ProtoObject* const* args,
+                                 unsigned long nargs,
+                                 const ProtoTuple* kwnames = nullptr) const;
+
         const ProtoObject* divmod(ProtoContext* context, const ProtoObject* other) const;
 
         //- Internals & Type Checking
@@ -292,6 +491,10 @@ namespace proto
         const ProtoThread* asThread(ProtoContext* context) const;
         const ProtoExternalPointer* asExternalPointer(ProtoContext* context) const;
         const ProtoExternalBuffer* asExternalBuffer(ProtoContext* context) const;
+        const ProtoWeakRef* asWeakRef(ProtoContext* context) const;
+        const ProtoWeakMap* asWeakMap(ProtoContext* context) const;
+        const ProtoFuture* asFuture(ProtoContext* context) const;
+        const ProtoChannel* asChannel(ProtoContext* context) const;
         const ProtoByteBuffer* asByteBuffer(ProtoContext* context) const;
         const ProtoObject* nextInNativeRange(ProtoContext* context) const;
         /**
@@ -302,7 +505,10 @@ namespace proto
         char* getDataIfByteBuffer(ProtoContext* context) const;
         /** If this object is a ProtoExternalBuffer, returns the raw segment pointer; otherwise nullptr. Stable until the object is collected (no compaction). */
         void* getRawPointerIfExternalBuffer(ProtoContext* context) const;
+        // Returns nullptr for a method created with fromFastMethod and no
+        // legacy entry point; dispatch such methods with call / callv.
         ProtoMethod asMethod(ProtoContext* context) const;
+        ProtoFastMethod asFastMethod(ProtoContext* context) const;
         const ProtoObject* asMethodSelf(ProtoContext* context) const;
 
         //- Comparison
@@ -591,6 +797,132 @@ namespace proto
         unsigned long getHash(ProtoContext* context) const;
     };
 
+    /**
+     * Reference that does not keep its target alive.  get() returns the
+     * target until a collection finds it unreachable, then nullptr.
+     * Non-cell targets (small integers, booleans, ...) are never cleared.
+     */
+    class ProtoWeakRef
+    {
+    public:
+        const ProtoObject* get(ProtoContext* context) const;
+        const ProtoObject* asObject(ProtoContext* context) const;
+        unsigned long getHash(ProtoContext* context) const;
+    };
+
+    /**
+     * Ephemeron map keyed by object identity.  A value stays alive only
+     * while its key is reachable from outside the map (a value that refers
+     * back to its own key does not count); entries whose key dies are
+     * dropped by the collector.  Updated in place and safe to share
+     * between threads.
+     */
+    class ProtoWeakMap
+    {
+    public:
+        /** Returns the value stored under \a key, or nullptr if absent. */
+        const ProtoObject* get(ProtoContext* context, const ProtoObject* key) const;
+        void set(ProtoContext* context, const ProtoObject* key, const ProtoObject* value) const;
+        /** Returns true if an entry was removed. */
+        bool remove(ProtoContext* context, const ProtoObject* key) const;
+        unsigned long getSize(ProtoContext* context) const;
+        const ProtoObject* asObject(ProtoContext* context) const;
+        unsigned long getHash(ProtoContext* context) const;
+    };
+
+    /**
+     * Read side of a single-assignment result slot, typically filled by
+     * another thread.  The value is traced by the collector like any other
+     * reference, so it needs no extra rooting while in flight.  Waiting
+     * goes unmanaged, so a blocked reader never holds up a collection.
+     */
+    class ProtoFuture
+    {
+    public:
+        /**
+         * Waits until the future is settled.  Returns the value, or
+         * nullptr if it was rejected (see getError).
+         */
+        const ProtoObject* get(ProtoContext* context) const;
+        /** Waits at most \a milliseconds; returns whether the future is settled. */
+        bool waitFor(ProtoContext* context, unsigned long milliseconds) const;
+        bool isReady(ProtoContext* context) const;
+        bool isRejected(ProtoContext* context) const;
+        /** The rejection reason, or nullptr unless rejected. */
+        const ProtoObject* getError(ProtoContext* context) const;
+        /**
+         * Future of `method(ctx, self, nullptr, [value], nullptr)`, called
+         * once this future is fulfilled: on \a pool when given, otherwise
+         * on the thread that settles it (or right away, on the caller, if
+         * already settled).  A rejection, or an exception thrown by
+         * \a method, rejects the returned future instead.
+         */
+        const ProtoFuture* then(ProtoContext* context, ProtoMethod method,
+                                const ProtoObject* self = nullptr,
+                                ProtoTaskPool* pool = nullptr) const;
+        const ProtoObject* asObject(ProtoContext* context) const;
+        unsigned long getHash(ProtoContext* context) const;
+    };
+
+    /**
+     * Write side of a ProtoFuture; both are views of the same cell.  The
+     * first resolve or reject wins and wakes every waiter.
+     */
+    class ProtoPromise
+    {
+    public:
+        /** Returns false if the promise was already settled. */
+        bool resolve(ProtoContext* context, const ProtoObject* value) const;
+        /** Returns false if the promise was already settled. */
+        bool reject(ProtoContext* context, const ProtoObject* error) const;
+        const ProtoFuture* getFuture(ProtoContext* context) const;
+        const ProtoObject* asObject(ProtoContext* context) const;
+        unsigned long getHash(ProtoContext* context) const;
+    };
+
+    /**
+     * Bounded multi-producer / multi-consumer queue of objects, for handing
+     * work between threads.  Queued values are collector roots.  Sends and
+     * receives that find room or a value are lock-free; blocking ones wait
+     * unmanaged, so a blocked thread never holds up a collection.
+     *
+     * The capacity is rounded up to a power of two.  A closed channel
+     * refuses sends; receivers drain what is left, then get nullptr.
+     */
+    class ProtoChannel
+    {
+    public:
+        /** Waits while full.  Returns false if the channel is closed. */
+        bool send(ProtoContext* context, const ProtoObject* value) const;
+        /** Returns false if the channel is full or closed. */
+        bool trySend(ProtoContext* context, const ProtoObject* value) const;
+        /** Waits while empty.  Returns nullptr once closed and drained. */
+        const ProtoObject* receive(ProtoContext* context) const;
+        /** Returns nullptr if the channel is empty. */
+        const ProtoObject* tryReceive(ProtoContext* context) const;
+        /** Wakes every blocked sender and receiver. */
+        void close(ProtoContext* context) const;
+        bool isClosed(ProtoContext* context) const;
+        unsigned long getCapacity(ProtoContext* context) const;
+        /** Approximate under concurrent use. */
+        unsigned long getSize(ProtoContext* context) const;
+
+        /**
+         * Receives from whichever of \a channels has a value first, storing
+         * its position in \a index.  Waits up to \a milliseconds (forever if
+         * negative).  Returns nullptr on timeout or once every channel is
+         * closed and drained.
+         */
+        static const ProtoObject* select(ProtoContext* context,
+                                         const ProtoChannel* const* channels,
+                                         unsigned long count,
+                                         unsigned long* index,
+                                         long milliseconds = -1);
+
+        const ProtoObject* asObject(ProtoContext* context) const;
+        unsigned long getHash(ProtoContext* context) const;
+    };
+
     /** Abstract base for module providers. Resolution chain entries "provider:alias" or "provider:GUID" delegate to a registered provider. */
     class ModuleProvider
     {
@@ -780,7 +1112,7 @@ namespace proto
          *        `sleep`, `poll`, network I/O, etc.).
          *
          * While the unmanaged counter is > 0, this thread does NOT
-         * participate in the stop-the-world quorum — the GC may run a
+         * hold up stop-the-world — the GC may run a
          * collection without waiting for the thread to reach a
          * safepoint. The thread is treated as "permanently parked" for
          * the duration of the unmanaged region.
@@ -796,9 +1128,10 @@ namespace proto
          *     only the outermost pair changes the thread's GC
          *     participation.
          *
-         * After incrementing the counter, this also notifies the GC —
-         * if it was waiting for this very thread to reach the quorum,
-         * the wait can complete immediately.
+         * The counter is the thread's stop-the-world state, so the
+         * common case costs one uncontended atomic add.  Only while a
+         * collection is stopping the world does the outermost call also
+         * wake the collector, which may be waiting on this very thread.
          *
          * Pair with `returnFromUnmanaged()`; in C++ prefer
          * `ProtoContext::UnmanagedScope` (RAII).
@@ -810,7 +1143,9 @@ namespace proto
          *        code. Matches an earlier `goUnmanaged()`.
          *
          * Decrements the unmanaged counter; on the outermost pair
-         * (counter back to 0) the thread re-joins the GC quorum. If
+         * (counter back to 0, a single atomic exchange) the thread is
+         * managed again and the GC waits for it at the next
+         * stop-the-world. If
          * the GC is currently in a stop-the-world phase, this call
          * BLOCKS until the STW phase clears — exactly like a normal
          * safepoint park — so the returning thread cannot resume
@@ -943,6 +1278,10 @@ namespace proto
         const ProtoObject* fromUnicodeChar(unsigned int unicodeChar);
         const ProtoObject* fromUTF8String(const char* zeroTerminatedUtf8String);
         const ProtoObject* fromMethod(ProtoObject* self, ProtoMethod method);
+        // Method with a vectorcall entry point.  `legacy` is optional: when
+        // present it serves `call` (ProtoList form); otherwise `call`
+        // unpacks the list into a native array and invokes `method`.
+        const ProtoObject* fromFastMethod(ProtoObject* self, ProtoFastMethod method, ProtoMethod legacy = nullptr);
         const ProtoObject* fromExternalPointer(void* pointer, void (*finalizer)(void*) = nullptr);
         const ProtoObject* fromBuffer(unsigned long length, char* buffer, bool freeOnExit = false);
         const ProtoObject* newBuffer(unsigned long length);
@@ -982,6 +1321,20 @@ namespace proto
         const ProtoObject* newObject(bool mutableObject = false);
         /** Allocates a contiguous buffer (aligned_alloc). GC finalize frees it when descriptor is collected (Shadow GC). */
         const ProtoObject* newExternalBuffer(unsigned long size);
+        /**
+         * Weak reference to \a target.  \a onClear, if given, is called with
+         * \a userData and the target when the collector clears it.
+         */
+        const ProtoWeakRef* newWeakRef(const ProtoObject* target,
+                                       ProtoWeakClearCallback onClear = nullptr,
+                                       void* userData = nullptr);
+        /** Empty ephemeron map; \a onClear runs once per entry dropped by the collector. */
+        const ProtoWeakMap* newWeakMap(ProtoWeakClearCallback onClear = nullptr,
+                                       void* userData = nullptr);
+        /** Unsettled promise; hand `getFuture()` to the consumer. */
+        const ProtoPromise* newPromise();
+        /** Empty channel holding at least \a capacity values (minimum 1). */
+        const ProtoChannel* newChannel(unsigned long capacity);
         /**
          * Create a fresh, GC-owned ProtoByteBuffer holding `len` raw octets.
          * The bytes are copied from `data` (data may be null only if len == 0).
@@ -1009,7 +1362,8 @@ namespace proto
          * stall every other thread waiting for STW to begin.
          *
          * Cheap on the fast path: a single relaxed atomic load of
-         * `stwFlag`.  Only takes the global mutex if the flag is set.
+         * `stwFlag`.  If the flag is set the thread parks on a futex
+         * without taking the global mutex.
          */
         void safepoint();
 
@@ -1022,8 +1376,7 @@ namespace proto
          * arbitrary time) and pair with `returnFromUnmanaged()` after
          * the call returns. While unmanaged, the GC may run a
          * stop-the-world phase WITHOUT waiting for this thread — the
-         * thread is treated as "permanently parked" for quorum
-         * purposes.
+         * thread is treated as parked for the whole region.
          *
          * Invariants while unmanaged:
          *   * NO `ProtoObject*` access (the GC may move / reclaim cells).
@@ -1041,15 +1394,14 @@ namespace proto
          * @brief Leave the unmanaged region. Mirror of `goUnmanaged()`.
          *
          * Decrements the thread's unmanaged counter; on the outermost
-         * pair (counter back to 0) the thread re-enters the GC
-         * quorum. If a stop-the-world phase is in progress at that
-         * moment, this BLOCKS until it clears — the returning thread
-         * is treated as a normal safepoint park while the GC finishes.
+         * pair (counter back to 0) the thread is managed again. If a
+         * stop-the-world phase is in progress at that moment, this
+         * BLOCKS until it clears — the returning thread is treated as
+         * a normal safepoint park while the GC finishes.
          *
-         * Failing to call this after a matching `goUnmanaged()` keeps
-         * the thread out of the GC quorum permanently, but does not
-         * corrupt anything; the worst case is that the GC's quorum
-         * count drifts off the real running-thread count.
+         * Failing to call this after a matching `goUnmanaged()` leaves
+         * the thread unmanaged permanently: collections never wait for
+         * it.  A return without a matching `goUnmanaged()` is ignored.
          *
          * No-op when this context has no thread.
          */
@@ -1097,7 +1449,7 @@ namespace proto
          * the out-of-memory handling.  It is a no-op when no limit is set.
          *
          * It MUST run at criticalSectionDepth == 0: the thread holds no
-         * half-built tree there, so it can leave the running set and let the
+         * half-built tree there, so it can go unmanaged and let the
          * GC run.  Blocking inside a critical section would instead let a
          * stop-the-world cycle reclaim a helper's in-flight, not-yet-anchored
          * cells.  See ProtoSpace::waitForHeapHeadroom.
@@ -1174,6 +1526,111 @@ namespace proto
             ProtoContext* ctx_;
         };
         
+        /**
+         * @brief Open a no-GC region on this context's thread.
+         *
+         * Until the matching exitNoGC the thread does not park for the
+         * collector: safepoints and allocations run straight through.  A
+         * cycle that wants to stop the world while a region is open waits
+         * for it to close, at most ProtoSpace::noGCMaxMicros; past that the
+         * region expires, and the thread parks at its next safepoint as if
+         * it had closed.  A live region never overlaps a stop.  Regions
+         * that outlast the limit are counted and reported
+         * (ProtoSpace::setNoGCLimit).
+         *
+         * Entry tops up the thread's free cells to at least `reserveCells`,
+         * so the region's allocations need neither the global lock nor the
+         * OS; it may park for a stop already in progress, before the region
+         * begins.  Allocating past the reservation still works, but may
+         * block (counted in ProtoSpace::noGCReserveExhausted).  Inside a
+         * region, do not go unmanaged or wait on anything the collector
+         * may be holding.  Calls nest; only the outermost pair counts.
+         * No-op when this context has no thread.
+         */
+        static constexpr unsigned long NO_GC_RESERVE_CELLS_DEFAULT = 4096;
+        void enterNoGC(unsigned long reserveCells = NO_GC_RESERVE_CELLS_DEFAULT);
+        /** @brief Close the region opened by enterNoGC; parks if a stop began meanwhile. */
+        void exitNoGC();
+
+        /**
+         * @brief RAII helper for a no-GC region (enterNoGC / exitNoGC).
+         *
+         * @code
+         *   {
+         *       ProtoContext::NoGCScope noGC(ctx, 2048);
+         *       fillOrder(ctx, book);   // never stopped by the collector
+         *   }
+         * @endcode
+         */
+        class NoGCScope {
+        public:
+            explicit NoGCScope(ProtoContext* ctx, unsigned long reserveCells = NO_GC_RESERVE_CELLS_DEFAULT)
+                : ctx_(ctx) {
+                if (ctx_) ctx_->enterNoGC(reserveCells);
+            }
+            ~NoGCScope() {
+                if (ctx_) ctx_->exitNoGC();
+            }
+            NoGCScope(const NoGCScope&) = delete;
+            NoGCScope& operator=(const NoGCScope&) = delete;
+        private:
+            ProtoContext* ctx_;
+        };
+
+        /**
+         * @brief Reserve cells for a multi-cell structure built next.
+         *
+         * Takes `count` free cells in one step, after a single
+         * stop-the-world poll, and hands them to the following allocations
+         * from this context with no poll and no freelist access.  The cells
+         * constructed until the matching releaseCells are linked into the
+         * young chain in one splice when it runs — or earlier, before
+         * anything that may park: an allocation past the reservation or a
+         * safepoint.  Do not go unmanaged while a batch is open.
+         *
+         * Reserving too few is safe (later allocations take the normal
+         * path); unused cells go back to the free cells on release.
+         * Calls nest, topping the reservation up to `count` if needed.
+         * No-op for a context with no space.
+         */
+        void allocCells(unsigned long count);
+        /** @brief Close the batch opened by allocCells and return the cells it did not use. */
+        void releaseCells();
+        /** @brief Link the cells constructed so far in the open batch into the young chain. */
+        void spliceCellBatch();
+
+        /**
+         * @brief RAII helper for a cell batch (allocCells / releaseCells).
+         *
+         * @code
+         *   {
+         *       ProtoContext::CellBatch batch(ctx, n);
+         *       const ProtoList* list = ctx->newList(n, items);   // n cells, one splice
+         *   }
+         * @endcode
+         */
+        class CellBatch {
+        public:
+            CellBatch(ProtoContext* ctx, unsigned long count) : ctx_(ctx) {
+                if (ctx_) ctx_->allocCells(count);
+            }
+            ~CellBatch() {
+                if (ctx_) ctx_->releaseCells();
+            }
+            CellBatch(const CellBatch&) = delete;
+            CellBatch& operator=(const CellBatch&) = delete;
+        private:
+            ProtoContext* ctx_;
+        };
+
+        // Open cell batch: depth, the reserved cells not yet handed out,
+        // and the constructed cells waiting for their young-chain splice.
+        unsigned int cellBatchDepth = 0;
+        Cell* reservedCells = nullptr;
+        unsigned long reservedCount = 0;
+        Cell* batchYoungHead = nullptr;
+        Cell* batchYoungTail = nullptr;
+
         ProtoContext(const ProtoContext&) = delete;
         ProtoContext& operator=(const ProtoContext&) = delete;
     };
@@ -1205,10 +1662,13 @@ namespace proto
      * root set during STW and treats their contents as additional
      * roots — see `ProtoSpace::forEachRootSet`.
      *
-     * Thread-safe: `add` / `remove` / `resolve` are safe to call from
-     * any thread.  `forEach` is intended to be called only from the GC
-     * thread during STW; mutators are parked at that point so no
-     * concurrent `add`/`remove` can race with iteration.
+     * Thread-safe and lock-free: `add` / `remove` / `resolve` are safe
+     * to call from any thread.  `forEach` is intended to be called only
+     * from the GC thread during STW; mutators are parked at that point
+     * so no concurrent `add`/`remove` can race with iteration.
+     *
+     * For pins that do not outlive a native call, ProtoHandleScope is
+     * cheaper still.
      */
     class ProtoRootSet
     {
@@ -1220,6 +1680,9 @@ namespace proto
          * @brief Pin `obj` as a GC root.  Returns an opaque handle that
          *        the caller must later pass to `remove()`.  Pinning a
          *        null pointer is a no-op and returns `kNullHandle`.
+         *        The set grows on demand; only once all 2^32 - 1 slot
+         *        indices are live does `add` fail, returning
+         *        `kNullHandle`.
          */
         Handle add(const ProtoObject* obj);
 
@@ -1246,10 +1709,9 @@ namespace proto
 
         /**
          * @brief Iterate every currently-pinned root.  The visitor is
-         *        invoked once per live slot.  Holds the internal mutex
-         *        for the duration so it is safe to call concurrently
-         *        with `add` / `remove`, but the GC normally calls this
-         *        during STW where the lock is uncontended.
+         *        invoked once per live slot.  Safe to call concurrently
+         *        with `add` / `remove` (a slot changing meanwhile may or
+         *        may not be visited); the GC calls it during STW.
          */
         void forEachRoot(void (*visit)(void* user, const ProtoObject* obj),
                           void* user) const;
@@ -1263,6 +1725,255 @@ namespace proto
         Impl* impl_;
     };
 
+    /**
+     * @brief Scoped GC roots local to one thread, in the spirit of V8's
+     *        HandleScope.
+     *
+     *   {
+     *       ProtoHandleScope scope(context);
+     *       scope.pin(callback);
+     *       scope.pin(receiver);
+     *       cLibraryCall(...);      // may allocate and collect
+     *   }                           // both unpinned here
+     *
+     * `pin` bump-allocates a slot in the calling thread's handle area —
+     * no lock, no atomics — and the scope releases every slot pinned
+     * since it was opened when it is destroyed.  The collector scans each
+     * thread's handle area during STW root collection.
+     *
+     * Scopes must be stack-allocated on the thread that owns `context`
+     * and nest strictly (LIFO).  Pins always land in the innermost open
+     * scope, whichever scope object `pin` is called on.  Do not pin from
+     * inside an unmanaged region: the collector may be scanning.
+     */
+    class ProtoHandleScope
+    {
+    public:
+        explicit ProtoHandleScope(ProtoContext* context);
+        ~ProtoHandleScope();
+
+        /** @brief Pin `obj` until the innermost open scope closes; returns `obj`. */
+        const ProtoObject* pin(const ProtoObject* obj);
+
+        ProtoHandleScope(const ProtoHandleScope&) = delete;
+        ProtoHandleScope& operator=(const ProtoHandleScope&) = delete;
+
+    private:
+        HandleArea* area_;
+        HandleBlock* savedBlock_;
+        unsigned int savedUsed_;
+    };
+
+    /**
+     * @brief Work-stealing pool of protoCore worker threads.
+     *
+     * Each worker is an ordinary ProtoThread (registered with the space,
+     * with its own caches and freelist) created once with the pool, so
+     * fine-grained parallel work does not pay for a thread per task:
+     *
+     *   ProtoTaskPool* pool = space->createTaskPool(context);
+     *   ProtoTask* a = pool->spawn(context, leftHalf, self, args);
+     *   ProtoTask* b = pool->spawn(context, rightHalf, self, args);
+     *   const ProtoObject* r = pool->join(context, a);
+     *   ...
+     *
+     * Every task runs in a fresh ProtoContext on some worker.  Tasks
+     * spawned from a worker go to that worker's own deque (LIFO for the
+     * owner); idle workers steal from the other end of their peers'
+     * deques, and take tasks spawned from outside the pool from a shared
+     * queue.  A worker with nothing to do parks inside an unmanaged region,
+     * so idle workers never hold up a stop-the-world.
+     *
+     * The receiver, arguments and result of a task are pinned in a root
+     * set owned by the pool until the task is joined.
+     */
+    class ProtoTaskPool
+    {
+    public:
+        /**
+         * @brief Queue `method(taskContext, self, nullptr, args, kwargs)`.
+         *        The returned task must be passed to `join` exactly once.
+         */
+        ProtoTask* spawn(ProtoContext* context, ProtoMethod method,
+                         const ProtoObject* self = nullptr,
+                         const ProtoList* args = nullptr,
+                         const ProtoSparseList* kwargs = nullptr);
+
+        /**
+         * @brief Wait for `task` and return its result, anchored in
+         *        `context`.  An exception thrown by the task is rethrown
+         *        here.  Called from a worker, join runs other queued tasks
+         *        while it waits; otherwise the caller waits unmanaged.
+         */
+        const ProtoObject* join(ProtoContext* context, ProtoTask* task);
+
+        /**
+         * @brief Like spawn, for a task nobody joins: its result is
+         *        dropped and an exception it throws is swallowed.
+         */
+        void post(ProtoContext* context, ProtoMethod method,
+                  const ProtoObject* self = nullptr,
+                  const ProtoList* args = nullptr,
+                  const ProtoSparseList* kwargs = nullptr);
+
+        /** @brief Number of worker threads. */
+        unsigned int getWorkerCount() const;
+
+        /** Opaque; defined in ProtoTaskPool.cpp. */
+        struct Impl;
+
+    private:
+        friend class ProtoSpace;
+        ProtoTaskPool(ProtoContext* context, unsigned int workers);
+        ~ProtoTaskPool();
+        void shutdown(ProtoContext* context);
+
+        Impl* impl_;
+    };
+
+    /**
+     * @brief Stackful coroutine on the protoCore thread that created it.
+     *
+     * A fiber runs `method(fiberContext, self, nullptr, args, kwargs)` on
+     * its own machine stack with its own ProtoContext chain.  `resume`
+     * switches into it until it calls `ProtoFiber::yield` or returns; the
+     * value handed across either way arrives anchored in the receiving
+     * context:
+     *
+     *   ProtoFiber* gen = space->createFiber(context, produce);
+     *   while (!gen->isFinished()) use(gen->resume(context));
+     *   space->destroyFiber(context, gen);
+     *
+     * A switch saves callee-saved registers only (hand-written on x86-64,
+     * ucontext elsewhere) and takes no lock.  While a fiber runs, its
+     * context chain sits on top of the resumer's, so the collector sees
+     * both through the thread; while it is suspended the collector scans
+     * its chain from the space's fiber registry.
+     *
+     * A fiber may only be resumed on its creating thread.  No
+     * ProtoHandleScope or CriticalSection may be held across a yield; a
+     * yield with a handle scope still open aborts.
+     */
+    class ProtoFiber
+    {
+    public:
+        /**
+         * @brief Run the fiber until it yields or returns.  Returns the
+         *        yielded value or the method's result; an exception thrown
+         *        by the method is rethrown here.  `value` becomes the
+         *        result of the pending `yield` (ignored on first resume).
+         *        Resuming a finished fiber returns PROTO_NONE.
+         */
+        const ProtoObject* resume(ProtoContext* context, const ProtoObject* value = PROTO_NONE);
+
+        /**
+         * @brief Suspend the running fiber, handing `value` to its resumer.
+         *        Returns the value passed to the next `resume`.  Aborts if
+         *        called outside a fiber.
+         */
+        static const ProtoObject* yield(ProtoContext* context, const ProtoObject* value = PROTO_NONE);
+
+        bool isFinished() const;
+
+        /** Opaque; defined in ProtoFiber.cpp. */
+        struct Impl;
+
+    protected:
+        ProtoFiber() = default;
+        ~ProtoFiber() = default;
+        ProtoFiber(const ProtoFiber&) = delete;
+        ProtoFiber& operator=(const ProtoFiber&) = delete;
+    };
+
+    /**
+     * @brief Single-threaded I/O event loop whose waits never hold up a
+     *        collection.
+     *
+     * Blocking I/O on a managed thread stalls every stop-the-world until
+     * it returns.  The loop instead waits for readiness (epoll on Linux,
+     * poll(2) elsewhere) inside an unmanaged region and runs callbacks
+     * back in managed state, each in a fresh ProtoContext:
+     *
+     *   ProtoEventLoop* loop = space->createEventLoop(context);
+     *   loop->read(context, fd, buffer, onRead, self);
+     *   loop->run(context);
+     *   space->destroyEventLoop(context, loop);
+     *
+     * Callbacks are called as `callback(cbContext, self, nullptr, args,
+     * nullptr)`:
+     *
+     *   - watch:       args = (fd, events), on every wakeup until unwatch;
+     *   - read/write:  args = (fd, result), once; result is the byte
+     *                  count (0 on end of file for read) or -errno;
+     *   - setTimeout:  args = (), once.
+     *
+     * Descriptors must be non-blocking.  `read` transfers at most once
+     * into the buffer; `write` keeps going until the whole range is
+     * written or fails.  Receivers and buffers are pinned in a root set
+     * owned by the loop until their callback has run.  An exception
+     * thrown by a callback propagates out of runOnce / run.
+     *
+     * Every method except `stop` must be called on the thread that runs
+     * the loop.
+     */
+    class ProtoEventLoop
+    {
+    public:
+        enum Events : unsigned int {
+            Readable = 1,
+            Writable = 2,
+            Closed = 4     // hang-up or error; always reported to watchers
+        };
+
+        /** @brief Call `callback` whenever `fd` is ready for `events`.
+         *         Replaces any previous watch on `fd`.  False, leaving
+         *         any previous watch alone, if `events` has neither
+         *         Readable nor Writable. */
+        bool watch(ProtoContext* context, int fd, unsigned int events,
+                   ProtoMethod callback, const ProtoObject* self = nullptr);
+        bool unwatch(ProtoContext* context, int fd);
+
+        /** @brief Read into `buffer[offset, offset + length)` once `fd` is
+         *         readable.  `length == 0` means up to the end of the
+         *         buffer.  One pending read per descriptor. */
+        bool read(ProtoContext* context, int fd, const ProtoByteBuffer* buffer,
+                  ProtoMethod callback, const ProtoObject* self = nullptr,
+                  unsigned long offset = 0, unsigned long length = 0);
+
+        /** @brief Write `buffer[offset, offset + length)` to `fd`.
+         *         One pending write per descriptor. */
+        bool write(ProtoContext* context, int fd, const ProtoByteBuffer* buffer,
+                   ProtoMethod callback, const ProtoObject* self = nullptr,
+                   unsigned long offset = 0, unsigned long length = 0);
+
+        void setTimeout(ProtoContext* context, unsigned long milliseconds,
+                        ProtoMethod callback, const ProtoObject* self = nullptr);
+
+        /**
+         * @brief Wait up to `milliseconds` (forever if negative, bounded by
+         *        the next timer) and run whatever became ready.  Returns
+         *        the number of callbacks run.
+         */
+        unsigned long runOnce(ProtoContext* context, long milliseconds = -1);
+
+        /** @brief Run until `stop` is called or nothing is left to wait for. */
+        void run(ProtoContext* context);
+
+        /** @brief Make `run` return after the current iteration.  Safe
+         *         from any thread, including non-protoCore ones. */
+        void stop();
+
+        /** Opaque; defined in ProtoEventLoop.cpp. */
+        struct Impl;
+
+    private:
+        friend class ProtoSpace;
+        explicit ProtoEventLoop(ProtoContext* context);
+        ~ProtoEventLoop();
+
+        Impl* impl_;
+    };
+
     class ProtoSpace
     {
     public:
@@ -1383,13 +2094,73 @@ namespace proto
          */
         void setHeapLimits(int softCells, int hardCells);
 
+        /**
+         * @brief Report threads that keep a stop-the-world waiting.
+         *
+         * The collector measures how long it waits for each thread to park
+         * or go unmanaged.  A thread still running managed code after
+         * `thresholdMicros` is reported through `callback`, again after
+         * twice that, and so on while the wait lasts.  A null callback
+         * prints the report to std::cerr.  `0` disables the watchdog (the
+         * default; `PROTOCORE_SAFEPOINT_WATCHDOG_MS` enables it with the
+         * stderr report and stack capture).
+         *
+         * With `captureStacks`, the collector interrupts the late thread
+         * with SIGURG and samples its stack from the signal handler.  The
+         * thread is not parked there: it may hold unanchored cells in
+         * registers, so it resumes and must still reach a safepoint.  The
+         * handler is installed the first time stack capture is enabled,
+         * and hands any other SIGURG (socket out-of-band data, a Go
+         * runtime's preemption) to the handler that was there before.
+         */
+        void setSafepointWatchdog(unsigned long thresholdMicros,
+                                  ProtoSafepointLaggardCallback callback = nullptr,
+                                  void* userData = nullptr,
+                                  bool captureStacks = false);
+
+        /**
+         * @brief Set a target for the collector's stop-the-world pauses.
+         *
+         * The stop covers only the work that needs the mutators parked:
+         * thread roots and the mutable-shard and weak snapshots.  Young
+         * generation chains are traced after the restart.  With a budget,
+         * mark, sweep and bulk unmark also run in slices no longer than
+         * the budget, yielding the CPU between them, and every cycle
+         * records its pause against the budget (pauseLastCycle,
+         * pauseBudgetMetLastCycle, pauseBudgetMissedCycles).  `0` (the
+         * default) sets no target; `PROTOCORE_GC_PAUSE_BUDGET_US` sets one
+         * from the environment.
+         */
+        void setPauseBudget(unsigned long micros);
+
+        /**
+         * @brief Bound how long a cycle waits for open no-GC regions
+         *        (ProtoContext::NoGCScope), and report regions that last
+         *        longer.
+         *
+         * Past `maxMicros` the collector expires the regions still open
+         * that long: it stops the world without them, and their threads
+         * park at their next safepoint.  Younger regions postpone the cycle
+         * (counted in noGCPostponedCycles) until they close or expire in
+         * turn.  Every region that stays open longer than `maxMicros`
+         * counts in noGCOverruns and, when `callback` is set, is reported
+         * to it: from the collector when it expires, otherwise from its own
+         * thread after it closes.  The default limit is
+         * NO_GC_MAX_MICROS_DEFAULT; `PROTOCORE_NOGC_MAX_US` sets it from
+         * the environment.
+         */
+        static constexpr unsigned long NO_GC_MAX_MICROS_DEFAULT = 10000;
+        void setNoGCLimit(unsigned long maxMicros,
+                          ProtoNoGCOverrunCallback callback = nullptr,
+                          void* userData = nullptr);
+
         /**
          * @brief Block until the heap has room to satisfy an allocation, or
          *        escalate to out-of-memory handling.
          *
          * Called from ProtoContext::heapLimitCheckpoint (a critical-section
          * boundary) and from the depth-0 path of getFreeCells.  When the heap
-         * is at its ceiling with no free cells, it leaves the running set,
+         * is at its ceiling with no free cells, it goes unmanaged,
          * waits for the GC to reclaim, and re-checks.  If two consecutive GC
          * cycles confirm the live set itself meets the ceiling, it invokes
          * `outOfMemoryCallback` once and then performs a controlled abort.
@@ -1414,6 +2185,115 @@ namespace proto
         ProtoRootSet* createRootSet(const char* name);
         void destroyRootSet(ProtoRootSet* rs);
 
+        //- Task Pools
+        //
+        // `workers == 0` picks std::thread::hardware_concurrency(), or
+        // PROTOCORE_TASK_WORKERS when set.  destroyTaskPool lets queued
+        // tasks finish, then stops and joins the workers; the destructor
+        // destroys any pool still registered.
+        ProtoTaskPool* createTaskPool(ProtoContext* context, unsigned int workers = 0);
+        void destroyTaskPool(ProtoContext* context, ProtoTaskPool* pool);
+
+        //- Fibers
+        //
+        // `stackSize == 0` uses the default (128 KiB, committed lazily).
+        // Destroying a fiber that has not finished abandons its frames
+        // without unwinding them; cells it allocated go to the collector.
+        // The destructor releases any fiber still registered.
+        ProtoFiber* createFiber(ProtoContext* context, ProtoMethod method,
+                                const ProtoObject* self = nullptr,
+                                const ProtoList* args = nullptr,
+                                const ProtoSparseList* kwargs = nullptr,
+                                size_t stackSize = 0);
+        void destroyFiber(ProtoContext* context, ProtoFiber* fiber);
+
+        //- Event Loops
+        //
+        // The destructor destroys any loop still registered; pending
+        // callbacks are dropped without running.
+        ProtoEventLoop* createEventLoop(ProtoContext* context);
+        void destroyEventLoop(ProtoContext* context, ProtoEventLoop* loop);
+
+        /**
+         * @brief Write every reachable cell to `path` for offline analysis.
+         *
+         * The collector takes the snapshot in the stop-the-world of its next
+         * cycle, so the world stays stopped while the file is written.
+         * Each cell is recorded with its type, size and outgoing strong
+         * references, and each root with its category (thread contexts,
+         * global prototypes, modules, interned tuples, mutable shards, root
+         * sets, fibers, channels, young generations, survivor pen).  Weak
+         * references are not edges.  `tools/heap_snapshot_analyzer`
+         * reads the file and reports dominators and retained sizes; the
+         * format is described in core/HeapSnapshot.cpp.
+         *
+         * The calling thread waits unmanaged.  Returns false if the file
+         * could not be written or the space ended first.
+         */
+        bool writeHeapSnapshot(ProtoContext* context, const char* path);
+
+        /**
+         * @brief Count live and reclaimed cells per cell type in every cycle.
+         *
+         * Live cells are the ones the mark reached (those counted by
+         * liveCellsLastCycle), counted as the bulk unmark walks them;
+         * reclaimed cells are counted as the sweep frees them (those
+         * counted by reclaimedLastCycle).  heapCensus returns the counts of
+         * the most recent cycle that ran with the census on.  Off by
+         * default, when the collector pays one predictable branch per cell
+         * swept or unmarked; `PROTOCORE_GC_HEAP_CENSUS=1` turns it on from
+         * the environment.  Read at the start of every cycle.
+         */
+        void setHeapCensus(bool enabled);
+        ProtoHeapCensus heapCensus();
+
+        //- Allocation Profiler
+        //
+        // Samples allocations at a mean of one every `meanBytes` bytes
+        // allocated (a Poisson process over the allocated bytes, so a
+        // sample stands for meanBytes/64 cells on average) and records the
+        // cell type, the ProtoAllocationSite tag in force and, when
+        // `captureStacks` is set, the native stack.  Sampled cells are
+        // followed through the collector: how many cycles each survives,
+        // and when it dies.  Starting again discards the previous profile;
+        // stopping ends sampling but keeps following the cells already
+        // sampled.  While stopped, allocation pays one atomic load.
+        //
+        // writeAllocationProfile writes the profile in pprof format
+        // (uncompressed profile.proto) with alloc_objects, alloc_space,
+        // inuse_objects and inuse_space values; the cell type and site are
+        // the innermost frames, and are also labels, with the survived
+        // cycles, of each sample.  Returns false if no profile was started
+        // or the file could not be written.
+        static constexpr unsigned long ALLOCATION_SAMPLE_BYTES_DEFAULT = 512 * 1024;
+        void startAllocationProfiler(unsigned long meanBytes = ALLOCATION_SAMPLE_BYTES_DEFAULT,
+                                     bool captureStacks = true);
+        void stopAllocationProfiler();
+        std::vector<ProtoAllocationSample> allocationSamples();
+        bool writeAllocationProfile(const char* path);
+
+        //- Event Trace
+        //
+        // Records runtime events in a ring of `capacity` events (rounded up
+        // to a power of two; the oldest are overwritten): each collector
+        // cycle with its no-GC wait, stop, root scan, mark, sweep and
+        // unmark phases, every thread's safepoint parks, heap growth in
+        // getFreeCells, waits for the collector to reclaim under a heap
+        // limit, and module loads.  Recording an event is a clock read, an
+        // atomic add and one cache-line store; while stopped, each trace
+        // point pays one atomic load.  Starting again begins a new trace.
+        //
+        // writeTrace writes the events as Chrome trace-event JSON, for
+        // chrome://tracing or Perfetto.  Returns false if no trace was
+        // started or the file could not be written.
+        // `PROTOCORE_TRACE_FILE=<path>` starts a trace with the space and
+        // writes it there when the space ends.
+        static constexpr unsigned long TRACE_EVENTS_DEFAULT = 1 << 16;
+        void startTrace(unsigned long capacity = TRACE_EVENTS_DEFAULT);
+        void stopTrace();
+        std::vector<ProtoTraceEvent> traceEvents();
+        bool writeTrace(const char* path);
+
         /**
          * @brief Invokes `visit(user, rs)` for every currently-registered
          *        root set.  Called from the GC thread during STW; embedders
@@ -1492,7 +2372,7 @@ namespace proto
 
         // --- Maquinaria Interna (Público por ahora) ---
 
-        ProtoSparseList* threads;
+        ThreadRegistry* threads;   // live threads, for the collector (see Thread.cpp)
         Cell* freeCells;
         // Tail pointer for the global freeCells linked list.  Maintained
         // alongside `freeCells` so getFreeCells can take the entire list in
@@ -1571,6 +2451,23 @@ namespace proto
         static constexpr unsigned int SURVIVOR_STAGGER_DEFAULT = 1;
         unsigned int survivorStagger;
 
+        /**
+         * @brief Entries in the collector's mark stack.
+         *
+         * The stack is allocated once at this size.  When it fills, the
+         * collector marks further cells without queueing them and later
+         * rescans the cells it marked from the first of those, so a very
+         * wide or deep heap costs rescans rather than memory.  Read at the
+         * start of every cycle.
+         *
+         * Default: MARK_STACK_CAPACITY_DEFAULT (262144 entries, 2 MB).
+         * Override at startup via env var PROTOCORE_GC_MARK_STACK_ENTRIES.
+         */
+        static constexpr unsigned long MARK_STACK_CAPACITY_DEFAULT = 1UL << 18;
+        unsigned long markStackCapacity;
+        /** @brief Cells the most recent cycle marked on a full mark stack. */
+        std::atomic<unsigned long> markStackOverflowsLastCycle;
+
         /**
          * @brief Monotonic GC cycle counter.
          *
@@ -1591,6 +2488,58 @@ namespace proto
          */
         std::atomic<uint64_t> gcCycleCount;
 
+        /**
+         * @brief Per-prototype shape epochs for the negative-lookup chain
+         * summaries.
+         *
+         * getAttribute caches, on each ParentLink, a bloom of every name
+         * reachable through that chain so that most misses are rejected
+         * without walking it.  A summary that reaches mutable prototypes
+         * records each one's epoch and stays valid while none of them
+         * moves.  A mutable object's epoch moves when, already being some
+         * other object's parent, it gains a new attribute name or a new
+         * parent chain; value overwrites, removals and writes to objects
+         * that are nobody's parent leave it untouched.
+         *
+         * Indexed by mutable_ref, in pages allocated on first use; refs
+         * past the table wrap around, which only costs spurious expiries.
+         * Bit 0 of an entry marks an object some ParentLink points at, the
+         * epoch counts in steps of 2 above it.
+         */
+        static constexpr unsigned long SHAPE_EPOCH_PAGE_SIZE = 4096;
+        static constexpr unsigned long SHAPE_EPOCH_PAGES = 1024;
+        std::atomic<std::atomic<uint64_t>*> shapeEpochPages[SHAPE_EPOCH_PAGES];
+        /**
+         * @brief The shape epoch entry of mutable object `mutableRef`.
+         * Returns nullptr when its page was never allocated and `create`
+         * is false (an absent entry reads as 0).
+         */
+        std::atomic<uint64_t>* shapeEpoch(unsigned long mutableRef, bool create);
+
+        /**
+         * @brief Invalidation token for the cached ancestor sets used by
+         * isInstanceOf.  Bumped when a mutable object that is some other
+         * object's parent gets a new parent chain (addParent / setParents).
+         */
+        std::atomic<uint64_t> ancestryEpoch;
+
+        /**
+         * @brief Process-unique identity of this space.  Unlike the address
+         * it is never reused, so PROTO_SYMBOL bindings can be keyed by it.
+         */
+        const uint64_t serial;
+
+        /**
+         * @brief Hand a replaced ancestor table to the space.  It is freed
+         * at the next stop-the-world, once no mutator can still be reading
+         * it.  Internal; called by ParentLinkImplementation.
+         */
+        void retireAncestorTable(AncestorTable* table);
+        /** @brief Same as retireAncestorTable, for a replaced chain summary. */
+        void retireChainSummary(ChainSummary* summary);
+        /** @brief Free every retired ancestor table and chain summary.  Requires the world to be stopped. */
+        void reclaimRetiredLinkCaches();
+
         /**
          * @brief Cells found reachable by the most recently completed GC
          * cycle's mark phase.  Published by the GC thread at end of cycle;
@@ -1614,6 +2563,72 @@ namespace proto
          */
         std::atomic<unsigned long> reclaimedLastCycle;
 
+        /**
+         * @brief Time the most recent stop-the-world waited for the last
+         * thread to park or go unmanaged, in microseconds.
+         */
+        std::atomic<unsigned long> timeToSafepointLastCycle;
+
+        // Safepoint watchdog settings (setSafepointWatchdog), read by the
+        // collector under globalMutex at the start of each stop.
+        unsigned long safepointWatchdogMicros;
+        ProtoSafepointLaggardCallback safepointLaggardCallback;
+        void* safepointLaggardUserData;
+        bool captureLaggardStacks;
+        // Pending writeHeapSnapshot, taken by the collector at its next
+        // stop.  Guarded by globalMutex.
+        HeapSnapshotRequest* heapSnapshotRequest;
+        // Heap census switch (setHeapCensus) and the last census taken,
+        // both guarded by globalMutex.
+        bool heapCensusEnabled;
+        ProtoHeapCensus heapCensusLastCycle;
+        // Allocation profiler, created by the first startAllocationProfiler
+        // (under globalMutex) and kept until the space ends.
+        AllocationProfiler* allocationProfiler;
+        // Whether allocCell samples; read without the lock.
+        std::atomic<bool> allocationSampling;
+        // Event trace, created by the first startTrace (under globalMutex)
+        // and kept until the space ends.
+        TraceRecorder* traceRecorder;
+        // Whether trace points record; read without the lock.
+        std::atomic<bool> tracing;
+        // PROTOCORE_TRACE_FILE, written by the destructor.
+        std::string traceFile;
+
+        /**
+         * @brief Length of the most recent stop-the-world, from the stop
+         * request to the restart, in microseconds.
+         */
+        std::atomic<unsigned long> pauseLastCycle;
+        /** @brief Whether that pause fit the pause budget; always true with no budget. */
+        std::atomic<bool> pauseBudgetMetLastCycle;
+        /** @brief Cycles whose pause exceeded the budget in force when they began. */
+        std::atomic<uint64_t> pauseBudgetMissedCycles;
+        // Pause budget (setPauseBudget), read by the collector under
+        // globalMutex at the start of each stop.
+        unsigned long pauseBudgetMicros;
+        // No-GC region limit (setNoGCLimit).  The limit is read without
+        // the lock by closing regions; the callback only under it.
+        std::atomic<unsigned long> noGCMaxMicros;
+        ProtoNoGCOverrunCallback noGCOverrunCallback;
+        void* noGCOverrunUserData;
+        // Open no-GC regions, and whether the collector is waiting for
+        // them to close (so the last one to close wakes it).
+        std::atomic<int> noGCRegions;
+        std::atomic<bool> noGCStopPending;
+        /** @brief Cycles whose stop waited for no-GC regions to close. */
+        std::atomic<uint64_t> noGCDeferredCycles;
+        /** @brief Cycles postponed for no-GC regions still younger than noGCMaxMicros. */
+        std::atomic<uint64_t> noGCPostponedCycles;
+        /** @brief No-GC regions that stayed open longer than noGCMaxMicros. */
+        std::atomic<uint64_t> noGCOverruns;
+        /** @brief The longest no-GC region so far, in microseconds. */
+        std::atomic<unsigned long> noGCLongestMicros;
+        /** @brief Allocations in a no-GC region that found its reservation used up. */
+        std::atomic<uint64_t> noGCReserveExhausted;
+        /** Native handle of the thread that created the space (the adopted main thread). */
+        std::thread::native_handle_type mainThreadHandle;
+
         /**
          * @brief Notified by the GC thread at the end of every cycle, once the
          * sweep has published reclaimed Cells to the freelist.  A thread
@@ -1675,13 +2690,12 @@ namespace proto
         std::atomic<bool> gcLock;
         std::thread::id mainThreadId;
         std::unique_ptr<std::thread> gcThread; // Usando unique_ptr
-        std::condition_variable_any stopTheWorldCV;
-        std::condition_variable_any restartTheWorldCV;
         std::condition_variable_any gcCV;
         std::atomic<bool> gcStarted;
         std::atomic<int> runningThreads;
-        std::atomic<bool> stwFlag;
-        std::atomic<int> parkedThreads;
+        // Set while the collector stops the world; parked threads
+        // futex-wait on it (see Thread.cpp, waitForWorldRestart).
+        std::atomic<int> stwFlag;
         ProtoContext* mainContext;
 
         const ProtoList* resolutionChain_;
@@ -1691,10 +2705,142 @@ namespace proto
         /** @brief Global reentrant mutex for protecting space-wide metadata (interning, thread registry, GC state). */
         static std::recursive_mutex globalMutex;
 
+        // --- Task pools (see `createTaskPool`) ---
+        std::vector<ProtoTaskPool*> taskPools_;
+        std::mutex taskPoolsMutex_;
+
+        // --- Recycled per-thread cache blocks (see acquireThreadCaches) ---
+        std::vector<void*> threadCachePool_;
+        std::mutex threadCachePoolMutex_;
+
+        // --- Event loops (see `createEventLoop`) ---
+        std::vector<ProtoEventLoop*> eventLoops_;
+        std::mutex eventLoopsMutex_;
+
+        // --- Fibers (see `createFiber`); intrusive list through Impl ---
+        ProtoFiber::Impl* fibers_{nullptr};
+        std::mutex fibersMutex_;
+
         // --- Embedder root sets (see `createRootSet`) ---
         std::vector<ProtoRootSet*> rootSets_;
         mutable std::mutex rootSetsMutex_;
+
+        // --- Link caches awaiting reclamation (see `retireAncestorTable`) ---
+        std::vector<AncestorTable*> retiredAncestorTables_;
+        std::vector<ChainSummary*> retiredChainSummaries_;
+        std::mutex retiredLinkCachesMutex_;
+
+        // --- Live weak refs and weak maps, for the collector (see ProtoWeak.cpp) ---
+        std::unordered_set<const Cell*> weakCells_;
+        std::mutex weakCellsMutex_;
+
+        // --- Futures that allocated a waiter table (see ProtoFuture.cpp) ---
+        std::unordered_set<const Cell*> futureCells_;
+        std::mutex futureCellsMutex_;
+
+        // --- Live channels, whose contents are roots (see ProtoChannel.cpp) ---
+        std::unordered_set<const Cell*> channelCells_;
+        std::mutex channelCellsMutex_;
+    };
+
+    // ------------------------------------------------------------------
+    // Compile-time symbol literals
+    // ------------------------------------------------------------------
+    //
+    //   const ProtoString* name = PROTO_SYMBOL(context, "__init__");
+    //
+    // yields the same pointer as ProtoString::createSymbol(context,
+    // "__init__"), without the per-call SymbolTable lookup.  Each macro
+    // expansion owns a constinit ProtoSymbolLiteral slot:
+    //
+    //   * ASCII literals of up to 6 bytes are inline strings — the whole
+    //     symbol is a constant bit pattern (proto_internal.h checks it
+    //     against its `inlineString` layout) and no slot state is touched.
+    //   * Longer literals carry their SymbolTable content hash, computed
+    //     at compile time.  The first use in a space interns the literal
+    //     and publishes a {space serial, symbol} binding with one CAS;
+    //     every later use in that space is a load and a compare.
+    //
+    // Symbols are per space, hence the serial check.  A slot only rebinds
+    // to a space created after the one it is bound to; used from an older
+    // space it falls back to the hashed SymbolTable lookup.  Bindings are
+    // perennial like the symbols they point at, so a reader can never see
+    // one freed under it: at most one per literal and space created, and
+    // a program with a single space allocates one per literal.
+
+    /** SymbolTable content hash of `n` UTF-8 bytes, as built by createSymbol:
+     *  FNV-1a per 32-byte leaf, leaves combined along the balanced split
+     *  ProtoStringImplementation::fromUTF8Bytes uses. */
+    static constexpr uint64_t symbolLiteralHash(const char* s, unsigned long n) {
+        if (n == 0) return 0;
+        if (n <= 32) {
+            uint64_t h = 14695981039346656037ULL;
+            for (unsigned long i = 0; i < n; ++i)
+                h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ULL;
+            return h;
+        }
+        unsigned long mid = n / 2;
+        while (mid > 0 && (static_cast<unsigned char>(s[mid]) & 0xC0u) == 0x80u) --mid;
+        const uint64_t a = symbolLiteralHash(s, mid);
+        const uint64_t b = symbolLiteralHash(s + mid, n - mid);
+        return a ^ (b + 0x9e3779b97f4a7c15ULL + (a << 6) + (a >> 2));
+    }
+
+    /** Inline-string bit pattern for a literal of up to 6 ASCII bytes, else 0.
+     *  pointer_tag 1 (EMBEDDED_VALUE), embedded_type 4 (INLINE_STRING),
+     *  byte count in bits 10-12, bytes from bit 13 (first byte lowest). */
+    static constexpr unsigned long symbolLiteralInlineWord(const char* s, unsigned long n) {
+        if (n > 6) return 0;
+        unsigned long bytes = 0;
+        for (unsigned long i = 0; i < n; ++i) {
+            const unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x80u) return 0;
+            bytes |= static_cast<unsigned long>(c) << (8 * i);
+        }
+        return 0x1UL | (0x4UL << 6) | (n << 10) | (bytes << 13);
+    }
+
+    struct ProtoSymbolBinding {
+        uint64_t spaceSerial;
+        const ProtoString* symbol;
+    };
+
+    /** Per-literal slot behind PROTO_SYMBOL.  Not meant to be used directly. */
+    class ProtoSymbolLiteral {
+    public:
+        template <unsigned long N>
+        constexpr ProtoSymbolLiteral(const char (&text)[N])
+            : utf8(text), size(N - 1),
+              contentHash(symbolLiteralHash(text, N - 1)),
+              inlineWord(symbolLiteralInlineWord(text, N - 1)),
+              binding(nullptr) {}
+
+        const ProtoString* get(ProtoContext* context) const {
+            if (inlineWord) return reinterpret_cast<const ProtoString*>(inlineWord);
+            const ProtoSymbolBinding* b = binding.load(std::memory_order_acquire);
+            if (b && b->spaceSerial == context->space->serial) return b->symbol;
+            return bind(context);
+        }
+
+        const char* const utf8;
+        const unsigned long size;
+        const uint64_t contentHash;
+        const unsigned long inlineWord;
+
+    private:
+        // Slow path: intern and publish a binding for context->space.
+        const ProtoString* bind(ProtoContext* context) const;
+
+        mutable std::atomic<const ProtoSymbolBinding*> binding;
     };
 }
 
+/** Canonical symbol for string literal `literal` in `context`'s space;
+ *  see "Compile-time symbol literals" above. */
+#define PROTO_SYMBOL(context, literal)                                              \
+    ([](proto::ProtoContext* protoSymbolContext_) -> const proto::ProtoString* {   \
+        static constinit proto::ProtoSymbolLiteral protoSymbolSlot_(literal);      \
+        return protoSymbolSlot_.get(protoSymbolContext_);                          \
+    }(context))
+
 #endif /* PROTO_H_ */
@@ -10,14 +10,17 @@
 
 #include "protoCore.h"
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <memory>
 #include <string>
 #include <algorithm>
+#include <bit>
 #include <climits>
 #include <iostream> // For std::cerr and std::abort
 #include <vector>
 #include <functional>
+#include <map>
 
 #ifdef PROTO_GC_LOCK_TRACE
 #include <chrono>
@@ -30,6 +33,24 @@
 #define GC_LOCK_TRACE(msg) do {} while(0)
 #endif
 
+// USDT probes, provider "protocore" (see the PROTOCORE_USDT CMake option).
+// An enabled probe site is one nop plus an ELF note naming it and its
+// arguments; tools such as bpftrace patch the nop only while attached.
+// Arguments must be cheap and side-effect free: without <sys/sdt.h> the
+// macros expand to nothing and the arguments are not evaluated.
+#ifdef PROTOCORE_USDT
+#include <sys/sdt.h>
+#define PROTO_PROBE0(name) DTRACE_PROBE(protocore, name)
+#define PROTO_PROBE1(name, a) DTRACE_PROBE1(protocore, name, a)
+#define PROTO_PROBE2(name, a, b) DTRACE_PROBE2(protocore, name, a, b)
+#define PROTO_PROBE3(name, a, b, c) DTRACE_PROBE3(protocore, name, a, b, c)
+#else
+#define PROTO_PROBE0(name) do {} while(0)
+#define PROTO_PROBE1(name, a) do {} while(0)
+#define PROTO_PROBE2(name, a, b) do {} while(0)
+#define PROTO_PROBE3(name, a, b, c) do {} while(0)
+#endif
+
 #define THREAD_CACHE_DEPTH 1024
 #define MUTABLE_VALUE_CACHE_DEPTH 1024
 #define TUPLE_SIZE 4
@@ -64,6 +85,10 @@ namespace proto {
     class ProtoByteBufferImplementation;
     class ProtoExternalPointerImplementation;
     class ProtoExternalBufferImplementation;
+    class ProtoWeakRefImplementation;
+    class ProtoWeakMapImplementation;
+    class ProtoFutureImplementation;
+    class ProtoChannelImplementation;
     class ProtoMethodCell;
     class ProtoThreadImplementation;
     class ProtoThreadExtension;
@@ -92,6 +117,11 @@ namespace proto {
         const ProtoByteBuffer *byteBuffer;
         const ProtoExternalPointer *externalPointer;
         const ProtoExternalBuffer *externalBuffer;
+        const ProtoWeakRef *weakRef;
+        const ProtoWeakMap *weakMap;
+        const ProtoFuture *future;
+        const ProtoPromise *promise;
+        const ProtoChannel *channel;
         const ProtoThread *thread;
         const ProtoSet *set;
         const ProtoSetIterator *setIterator;
@@ -118,6 +148,10 @@ namespace proto {
         const ProtoByteBufferImplementation *byteBufferImplementation;
         const ProtoExternalPointerImplementation *externalPointerImplementation;
         const ProtoExternalBufferImplementation *externalBufferImplementation;
+        const ProtoWeakRefImplementation *weakRefImplementation;
+        const ProtoWeakMapImplementation *weakMapImplementation;
+        const ProtoFutureImplementation *futureImplementation;
+        const ProtoChannelImplementation *channelImplementation;
         const ProtoThreadImplementation *threadImplementation;
         const ProtoSetImplementation *setImplementation;
         const ProtoSetIteratorImplementation *setIteratorImplementation;
@@ -246,6 +280,10 @@ namespace proto {
 #define POINTER_TAG_STRING_INTERNAL_NODE 24 // StringInternalNode (internal AVL node)
 #define POINTER_TAG_LIST_SMALL          25 // ProtoListSmallImplementation — inline-slot list (size ≤ 5)
 #define POINTER_TAG_SPARSE_LIST_SMALL   26 // ProtoSparseListSmallImplementation — inline (key,value) sparse list (size ≤ 3)
+#define POINTER_TAG_WEAK_REF            27 // ProtoWeakRefImplementation — referent is not traced
+#define POINTER_TAG_WEAK_MAP            28 // ProtoWeakMapImplementation — ephemeron table
+#define POINTER_TAG_FUTURE              29 // ProtoFutureImplementation — also viewed as ProtoPromise
+#define POINTER_TAG_CHANNEL             30 // ProtoChannelImplementation — bounded MPMC ring
 
 #define EMBEDDED_TYPE_SMALLINT 0
 #define EMBEDDED_TYPE_UNICODE_CHAR 2
@@ -256,6 +294,18 @@ namespace proto {
 #define INLINE_STRING_MAX_BYTES 6       // max UTF-8 bytes in embedded pointer
 #define INLINE_STRING_BYTE_COUNT_BITS 3
 
+    // PROTO_SYMBOL (protoCore.h) builds inline-string literals without
+    // seeing the layout above; keep its encoder in step with it.
+    static_assert([] {
+        using InlineString = decltype(ProtoObjectPointer::inlineString);
+        const auto word = std::bit_cast<InlineString>(symbolLiteralInlineWord("abcdef", 6));
+        return word.pointer_tag == POINTER_TAG_EMBEDDED_VALUE &&
+               word.embedded_type == EMBEDDED_TYPE_INLINE_STRING &&
+               word.inline_byte_count == INLINE_STRING_MAX_BYTES &&
+               word.inline_utf8_bytes == 0x666564636261UL && word.reserved == 0 &&
+               symbolLiteralInlineWord("abcdefg", INLINE_STRING_MAX_BYTES + 1) == 0;
+    }(), "symbolLiteralInlineWord disagrees with the inlineString layout");
+
     /** Returns byte count of an inline string pointer (0..6). */
     inline unsigned long inlineStringByteCount(const ProtoObject* o) {
         ProtoObjectPointer pa{}; pa.oid = o;
@@ -373,6 +423,14 @@ namespace proto {
     template<> struct ExpectedTag<ProtoExternalPointerImplementation> { static constexpr unsigned long value = POINTER_TAG_EXTERNAL_POINTER; };
     template<> struct ExpectedTag<const ProtoExternalBufferImplementation> { static constexpr unsigned long value = POINTER_TAG_EXTERNAL_BUFFER; };
     template<> struct ExpectedTag<ProtoExternalBufferImplementation> { static constexpr unsigned long value = POINTER_TAG_EXTERNAL_BUFFER; };
+    template<> struct ExpectedTag<const ProtoWeakRefImplementation> { static constexpr unsigned long value = POINTER_TAG_WEAK_REF; };
+    template<> struct ExpectedTag<ProtoWeakRefImplementation> { static constexpr unsigned long value = POINTER_TAG_WEAK_REF; };
+    template<> struct ExpectedTag<const ProtoWeakMapImplementation> { static constexpr unsigned long value = POINTER_TAG_WEAK_MAP; };
+    template<> struct ExpectedTag<ProtoWeakMapImplementation> { static constexpr unsigned long value = POINTER_TAG_WEAK_MAP; };
+    template<> struct ExpectedTag<const ProtoFutureImplementation> { static constexpr unsigned long value = POINTER_TAG_FUTURE; };
+    template<> struct ExpectedTag<ProtoFutureImplementation> { static constexpr unsigned long value = POINTER_TAG_FUTURE; };
+    template<> struct ExpectedTag<const ProtoChannelImplementation> { static constexpr unsigned long value = POINTER_TAG_CHANNEL; };
+    template<> struct ExpectedTag<ProtoChannelImplementation> { static constexpr unsigned long value = POINTER_TAG_CHANNEL; };
 
     template<> struct ExpectedTag<const ProtoListIteratorImplementation> { static constexpr unsigned long value = POINTER_TAG_LIST_ITERATOR; };
     template<> struct ExpectedTag<ProtoListIteratorImplementation> { static constexpr unsigned long value = POINTER_TAG_LIST_ITERATOR; };
@@ -560,9 +618,15 @@ namespace proto {
         StringLeafNode,
         StringInternalNode,
         ListSmall,
-        SparseListSmall
+        SparseListSmall,
+        WeakRef,
+        WeakMap,
+        Future,
+        Channel
     };
 
+    constexpr size_t CELL_TYPE_COUNT = static_cast<size_t>(CellType::Channel) + 1;
+
     class Cell {
     public:
         // Layout:
@@ -712,10 +776,67 @@ namespace proto {
         }
     };
 
+    /**
+     * Hashed set of every object reachable through a ParentLink chain
+     * (transitively, through each member's own chain).  Open addressing,
+     * power-of-two capacity, keyed by object identity; one malloc block
+     * with `slots` trailing the header.  Lives outside the GC heap: owned
+     * by the ParentLink it is cached on, freed by that link's finalize, or
+     * — when replaced by a fresher table — retired to the space and freed
+     * at the next stop-the-world (see ProtoSpace::retireAncestorTable).
+     */
+    struct AncestorTable {
+        // Either "stable" (no mutable member in the closure) or epoch + 1
+        // of ProtoSpace::ancestryEpoch at build time.
+        uint64_t tag;
+        unsigned long mask;
+        const ProtoObject *slots[1];
+
+        static AncestorTable *build(ProtoContext *context, const ParentLinkImplementation *head);
+
+        bool contains(const ProtoObject *candidate) const {
+            unsigned long i = slotFor(candidate, mask);
+            while (slots[i]) {
+                if (slots[i] == candidate) return true;
+                i = (i + 1) & mask;
+            }
+            return false;
+        }
+
+        static unsigned long slotFor(const ProtoObject *o, unsigned long mask) {
+            return static_cast<unsigned long>(
+                ((reinterpret_cast<uintptr_t>(o) >> 6) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+        }
+    };
+
+    /**
+     * Negative-lookup summary of a ParentLink chain: a 64-bit bloom of
+     * every attribute name reachable through it (two bits per name), and
+     * the mutable prototypes it was read from with their shape epochs at
+     * the time (ProtoSpace::shapeEpoch).  One malloc block with `deps`
+     * trailing the header, owned and reclaimed like AncestorTable.  See
+     * the "Chain summaries" section of core/ProtoObject.cpp.
+     */
+    struct ChainSummary {
+        struct Dependency {
+            unsigned long mutableRef;
+            uint64_t epoch;
+        };
+        uint64_t bloom;
+        unsigned long count;
+        Dependency deps[1];
+    };
+
     class ParentLinkImplementation : public Cell {
     public:
         const ParentLinkImplementation *parent;
         const ProtoObject *object;
+        // Lazily built ancestor set for the chain starting at this link;
+        // see implHasAncestor.
+        mutable std::atomic<AncestorTable *> ancestors;
+        // Lazily built name summary for the same chain; see the "Chain
+        // summaries" section of core/ProtoObject.cpp.
+        mutable std::atomic<ChainSummary *> summary;
 
         CellType getType() const override { return CellType::ParentLink; }
 
@@ -723,6 +844,12 @@ namespace proto {
 
         ~ParentLinkImplementation() override = default;
 
+        void finalize(ProtoContext *context) const override;
+
+        // O(1) (amortised) membership test: is `candidate` one of the
+        // objects reachable through this chain?  No depth limit.
+        bool implHasAncestor(ProtoContext *context, const ProtoObject *candidate) const;
+
         void processReferences(ProtoContext *context, void *self,
                                void (*method)(ProtoContext *, void *, const Cell *)) const override;
 
@@ -733,28 +860,101 @@ namespace proto {
         const ParentLinkImplementation *getParent(ProtoContext *context) const;
     };
 
+    /** Own-attribute storage of a ProtoObjectCell.
+     *
+     *  Most objects carry one to three attributes, so instead of an AVL
+     *  tree (one cell per attribute, a dependent load per level) they
+     *  keep their (symbol, value) pairs in the object cell itself: up to
+     *  IN_CELL_MAX pairs fill the 32 bytes after `parent` and
+     *  `mutable_ref`, and a lookup never leaves the object's cache line.
+     *  One more pair moves them to a ProtoSparseListSmallImplementation
+     *  block (object cell plus one block cell, a 3-slot scan), and the
+     *  first write past MAX_INLINE pairs (or any store of key 0, the
+     *  empty-slot sentinel of both forms) spills to the AVL tree.  An
+     *  object keeps the out-of-line form it reached; removals never fold
+     *  back, so a record that hovers around a limit does not flip-flop.
+     *
+     *  keys[0] != 0 means the pairs are held here, used slots first and
+     *  key-ascending.  keys[0] == 0 means they are not, and keys[1] holds
+     *  the out-of-line word instead: cells are 64-byte aligned, so bit 0
+     *  marks the block and no getType() dispatch is needed, and a null
+     *  word is an object without own attributes — newObject and newChild
+     *  do not allocate an empty tree up front.
+     *
+     *  Values are immutable like every other attribute table: setAt /
+     *  removeAt return a new store and leave this one untouched.  Both
+     *  may allocate, so callers hold a CriticalSection exactly as they
+     *  did around implSetAt / implRemoveAt.  Defined in ProtoObject.cpp. */
+    class AttributeStore {
+    public:
+        static constexpr unsigned IN_CELL_MAX = 2;
+
+        constexpr AttributeStore() : keys{0, 0}, values{nullptr, nullptr} {}
+        AttributeStore(const ProtoSparseListImplementation *tree)
+            : keys{0, reinterpret_cast<uintptr_t>(tree)}, values{nullptr, nullptr} {}
+        AttributeStore(const ProtoSparseListSmallImplementation *block)
+            : keys{0, block ? reinterpret_cast<uintptr_t>(block) | INLINE_BIT : 0}, values{nullptr, nullptr} {}
+        // In-cell pairs; n <= IN_CELL_MAX, keys non-zero and ascending.
+        AttributeStore(unsigned n, const unsigned long *ks, const ProtoObject *const *vs);
+
+        bool isEmpty() const { return keys[0] == 0 && keys[1] == 0; }
+        bool isInCell() const { return keys[0] != 0; }
+        // Key of in-cell slot `i`; 0 for an unused slot or out-of-line pairs.
+        unsigned long inCellKey(unsigned i) const { return isInCell() ? keys[i] : 0; }
+        const ProtoObject *inCellValue(unsigned i) const { return isInCell() ? values[i] : nullptr; }
+        const ProtoSparseListSmallImplementation *inlineBlock() const {
+            return !isInCell() && (keys[1] & INLINE_BIT)
+                       ? reinterpret_cast<const ProtoSparseListSmallImplementation *>(keys[1] & ~INLINE_BIT)
+                       : nullptr;
+        }
+        const ProtoSparseListImplementation *tree() const {
+            return !isInCell() && !(keys[1] & INLINE_BIT)
+                       ? reinterpret_cast<const ProtoSparseListImplementation *>(keys[1])
+                       : nullptr;
+        }
+        // The backing cell, for GC tracing; nullptr when the pairs are
+        // held in-cell or there are none.
+        const Cell *cell() const;
+
+        // nullptr when `key` is absent; PROTO_NONE is a present value.
+        const ProtoObject *getAt(ProtoContext *context, unsigned long key) const {
+            if (isInCell()) {
+                if (keys[0] == key) return values[0];
+                return (keys[1] == key && key != 0) ? values[1] : nullptr;
+            }
+            return getOutOfLine(context, key);
+        }
+        bool has(ProtoContext *context, unsigned long key) const { return getAt(context, key) != nullptr; }
+        unsigned long count() const;
+
+        AttributeStore setAt(ProtoContext *context, unsigned long key, const ProtoObject *value) const;
+        AttributeStore removeAt(ProtoContext *context, unsigned long key) const;
+
+        // AVL view for merge loops (allocates unless already a tree) and
+        // the public-API handle for the trampolines (allocates a block
+        // for in-cell pairs).
+        const ProtoSparseListImplementation *asTree(ProtoContext *context) const;
+        const ProtoSparseList *asSparseList(ProtoContext *context) const;
+
+    private:
+        static constexpr uintptr_t INLINE_BIT = 1;
+        const ProtoObject *getOutOfLine(ProtoContext *context, unsigned long key) const;
+        unsigned long keys[IN_CELL_MAX];
+        const ProtoObject *values[IN_CELL_MAX];
+    };
+
     class ProtoObjectCell : public Cell {
     public:
         const ParentLinkImplementation *parent;
-        // Raw IMPL pointer to the AVL-form sparse list. Internal struct
-        // fields in protoCore implementation classes are always raw
-        // C++ pointers to other implementation classes — never tagged
-        // public-API handles. This lets every internal access go through
-        // the IMPL methods directly (`implGetAt`, `implSetAt`,
-        // `implRemoveAt`, `implHas`) with zero tag dispatch and no
-        // toImpl conversions.
-        //
-        // The Small variant of sparse list does not appear here: the
-        // AVL-vs-Small dispatch was a public-API optimisation that
-        // leaked into a private slot and produced inconsistent type
-        // discipline. Object attribute storage is always AVL form.
-        const ProtoSparseListImplementation *attributes;
+        // Own attributes: held right here for small objects, in a block
+        // or an AVL tree once they outgrow it.  See AttributeStore above.
+        AttributeStore attributes;
         const unsigned long mutable_ref;
 
         CellType getType() const override { return CellType::Object; }
 
         ProtoObjectCell(ProtoContext *context, const ParentLinkImplementation *parent,
-                        const ProtoSparseListImplementation *attributes, unsigned long mutable_ref);
+                        AttributeStore attributes, unsigned long mutable_ref);
 
         ~ProtoObjectCell() override = default;
 
@@ -783,14 +983,39 @@ namespace proto {
     public:
         const ProtoObject *self;
         ProtoMethod method;
+        // Vectorcall entry point; nullptr for legacy-only methods.  At
+        // least one of `method` / `fastMethod` is always set.
+        ProtoFastMethod fastMethod;
 
         CellType getType() const override { return CellType::MethodCell; }
 
         ProtoMethodCell(ProtoContext *context, const ProtoObject *selfObject, ProtoMethod methodTarget);
 
+        ProtoMethodCell(ProtoContext *context, const ProtoObject *selfObject, ProtoFastMethod fastTarget,
+                        ProtoMethod legacyTarget);
+
         const ProtoObject *
         implInvoke(ProtoContext *context, const ProtoList *args, const ProtoSparseList *kwargs) const;
 
+        // Dispatch with the legacy (list / keyword dict) argument form,
+        // unpacking into a native array when only `fastMethod` is set.
+        const ProtoObject *implCall(ProtoContext *context, const ProtoObject *callSelf,
+                                    const ParentLink *parentLink, const ProtoList *args,
+                                    const ProtoSparseList *kwargs) const;
+
+        // Dispatch with the vectorcall argument form, packing a list only
+        // when the target has no `fastMethod`.
+        const ProtoObject *implCallVector(ProtoContext *context, const ProtoObject *callSelf,
+                                          const ParentLink *parentLink, const ProtoObject *const *args,
+                                          unsigned long nargs, const ProtoTuple *kwnames) const;
+
+        // Pack a native argument array into the legacy (ProtoList, keyword
+        // dict) pair.  Keyword dict keys are the name hashes, matching the
+        // binding done by ProtoContext's constructor.
+        static void packArguments(ProtoContext *context, const ProtoObject *const *args, unsigned long nargs,
+                                  const ProtoTuple *kwnames, const ProtoList **outArgs,
+                                  const ProtoSparseList **outKwargs);
+
         const ProtoObject *implAsObject(ProtoContext *context) const override;
 
         unsigned long getHash(ProtoContext *context) const override;
@@ -803,6 +1028,8 @@ namespace proto {
         const ProtoObject *implGetSelf(ProtoContext *context) const;
 
         ProtoMethod implGetMethod(ProtoContext *context) const;
+
+        ProtoFastMethod implGetFastMethod(ProtoContext *context) const;
     };
 
     class DoubleImplementation : public Cell {
@@ -956,6 +1183,12 @@ namespace proto {
         const ProtoObject* lookupByContent(ProtoContext* ctx,
                                             const ProtoObject* strObj) const;
 
+        // Read-only lookup of raw UTF-8 bytes whose content hash the caller
+        // already has (PROTO_SYMBOL computes it at compile time).  Returns
+        // nullptr if not interned; never allocates.
+        const ProtoObject* lookupLiteral(ProtoContext* ctx, const char* utf8,
+                                          unsigned long len, uint64_t hash) const;
+
         static bool isSymbol(const ProtoObject* obj);
 
     private:
@@ -1184,6 +1417,138 @@ namespace proto {
         const ProtoObject*  current_value;   // resolved snapshot
     };
 
+    /**
+     * @brief Backing store of a thread's ProtoHandleScopes.
+     *
+     * A chain of fixed-size blocks used as a stack: pin() bumps `used`,
+     * closing a scope restores the (block, used) pair saved when it was
+     * opened.  Blocks past `current` are kept as spares.  Only the owning
+     * thread mutates the area; the collector reads it during STW, while
+     * that thread is parked.
+     */
+    struct HandleBlock {
+        static constexpr unsigned int CAPACITY = 254;
+        HandleBlock* previous;
+        HandleBlock* next;
+        const ProtoObject* slots[CAPACITY];
+    };
+
+    struct HandleArea {
+        HandleBlock* first;
+        HandleBlock* current;
+        unsigned int used;
+
+        HandleArea();
+        ~HandleArea();
+        HandleArea(const HandleArea&) = delete;
+        HandleArea& operator=(const HandleArea&) = delete;
+
+        void push(const ProtoObject* obj);
+        /** Calls \a visit for every pinned object, oldest first. */
+        template<typename Visitor>
+        void forEach(Visitor&& visit) const {
+            for (const HandleBlock* b = first; b; b = b->next) {
+                const unsigned int n = b == current ? used : HandleBlock::CAPACITY;
+                for (unsigned int i = 0; i < n; ++i) visit(b->slots[i]);
+                if (b == current) break;
+            }
+        }
+    };
+
+    /**
+     * Lock-free registry of live threads, scanned by the collector.
+     *
+     * Slots live in fixed chunks chained off an inline first chunk and are
+     * only freed with the space, so readers need no reclamation.  A thread
+     * claims the first null slot with a CAS and clears it on exit; the
+     * chain only grows when every slot is taken.
+     */
+    struct ThreadRegistry {
+        static constexpr unsigned int CHUNK = 64;
+
+        /**
+         * The no-GC region of the thread in the matching slot, where the
+         * collector can see it (ProtoThreadImplementation::implEnterNoGC).
+         * Only the owner opens or closes it; the collector moves an OPEN
+         * region that outlasted ProtoSpace::noGCMaxMicros to EXPIRED, and
+         * whichever side leaves OPEN uncounts it from noGCRegions.
+         */
+        struct NoGCSlot {
+            enum : int { CLOSED = 0, OPEN = 1, EXPIRED = 2 };
+            std::atomic<int> state{CLOSED};
+            // steady_clock ticks at the outermost enterNoGC.
+            std::atomic<int64_t> entered{0};
+        };
+
+        struct Chunk {
+            std::atomic<ProtoThreadImplementation*> slots[CHUNK]{};
+            NoGCSlot noGC[CHUNK];
+            std::atomic<Chunk*> next{nullptr};
+        };
+
+        Chunk first;
+
+        ThreadRegistry() = default;
+        ~ThreadRegistry();
+        ThreadRegistry(const ThreadRegistry&) = delete;
+        ThreadRegistry& operator=(const ThreadRegistry&) = delete;
+
+        /** Claims a slot for \a thread and returns its index. */
+        unsigned int add(ProtoThreadImplementation* thread);
+        /** Clears slot \a index if it still holds \a thread. */
+        void remove(unsigned int index, ProtoThreadImplementation* thread);
+        /** The no-GC state of slot \a index. */
+        NoGCSlot& noGCSlot(unsigned int index);
+
+        template<typename Visitor>
+        void forEach(Visitor&& visit) const {
+            for (const Chunk* c = &first; c; c = c->next.load(std::memory_order_acquire))
+                for (const auto& slot : c->slots)
+                    if (ProtoThreadImplementation* t = slot.load(std::memory_order_acquire)) visit(t);
+        }
+    };
+
+    /**
+     * Hands out a cleared attribute cache and mutable-value cache, carved
+     * from one block recycled from an exited thread when the pool has one.
+     */
+    void acquireThreadCaches(ProtoSpace* space, AttributeCacheEntry*& attributeCache,
+                             MutableValueCacheEntry*& mutableValueCache);
+
+    /**
+     * Clears the block starting at \a attributeCache and returns it to the
+     * pool.  Returns false, leaving the block with the caller, if the pool
+     * is full.
+     */
+    bool poolThreadCaches(ProtoSpace* space, AttributeCacheEntry* attributeCache);
+
+    /** Frees the pooled blocks.  Called from ~ProtoSpace. */
+    void releaseThreadCachePool(ProtoSpace* space);
+
+    /**
+     * Blocks while \a word still holds \a expected, for at most
+     * \a timeoutMicros.  A futex wait on Linux, a short sleep elsewhere;
+     * callers re-check their condition, since it may return early.
+     */
+    void futexWait(std::atomic<int>& word, int expected, long timeoutMicros);
+
+    /** Wakes every thread blocked in futexWait on \a word. */
+    void futexWake(std::atomic<int>& word);
+
+    /** Blocks the calling thread until the collector restarts the world. */
+    void waitForWorldRestart(ProtoSpace* space);
+
+    /**
+     * Samples the stack of \a thread by interrupting it with SIGURG.
+     * Stores up to \a maxFrames return addresses and returns how many; 0
+     * when the thread did not answer within \a timeoutMicros or the
+     * platform cannot do it.  Installs the handler on first use; it
+     * passes every SIGURG that is not a capture request on to the
+     * handler it replaced.
+     */
+    int captureThreadStack(std::thread::native_handle_type thread, void** frames, int maxFrames,
+                           long timeoutMicros);
+
     class ProtoThreadExtension : public Cell {
     public:
         std::thread* osThread;
@@ -1195,7 +1560,18 @@ namespace proto {
         // a 64-byte Cell with no remaining slot. See
         // ProtoThread::goUnmanaged / returnFromUnmanaged for the
         // contract.
+        //
+        // It is also the thread's stop-the-world state, which the
+        // collector polls (and futex-waits on): 0 while the thread runs
+        // managed code, non-zero while it is parked at a safepoint,
+        // inside an unmanaged region, not yet started or finished.  Only
+        // the owning thread writes it once the thread is running.
         std::atomic<int> unmanagedDepth{0};
+        // Index of this thread's slot in space->threads.
+        unsigned int registrySlot;
+        // ProtoHandleScope storage; created by the first scope opened on
+        // this thread.
+        HandleArea* handles;
 
         CellType getType() const override { return CellType::ThreadExtension; }
 
@@ -1239,6 +1615,9 @@ namespace proto {
         ~ProtoThreadImplementation() override;
 
         Cell *implAllocCell(ProtoContext *context);
+        // Detaches up to `count` free cells as one null-terminated chain
+        // (ProtoContext::allocCells); `taken` receives how many.
+        Cell *implAllocCells(ProtoContext *context, unsigned long count, unsigned long &taken);
         const ProtoObject *implAsObject(ProtoContext *context) const override;
         const ProtoThread* asThread(ProtoContext* context) const;
         void implSynchToGC();
@@ -1247,6 +1626,12 @@ namespace proto {
         // and the field-level comment on `unmanagedDepth` above.
         void implGoUnmanaged();
         void implReturnFromUnmanaged();
+        // No-GC regions (ProtoContext::NoGCScope).  The depth is kept per
+        // OS thread and space: a region never leaves the thread that
+        // opened it, and only holds off that space's collector.
+        void implEnterNoGC(ProtoContext* context, unsigned long reserveCells);
+        void implExitNoGC();
+        static bool inNoGCRegion(const ProtoSpace* space);
         void finalize(ProtoContext* context) const;
         void processReferences(ProtoContext* context, void* self, void (*method)(ProtoContext*, void*, const Cell*)) const override;
         unsigned long getHash(ProtoContext* context) const override;
@@ -1285,6 +1670,11 @@ namespace proto {
                                          const ProtoListImplementation *prev = nullptr,
                                          const ProtoListImplementation *next = nullptr);
 
+        // Balanced AVL list over items[0..n), built bottom-up in one cell
+        // batch of n cells.  n == 0 yields the empty list cell.
+        static const ProtoListImplementation *fromArray(ProtoContext *context,
+                                                        const ProtoObject *const *items, unsigned n);
+
         const ProtoObject *implGetAt(ProtoContext *context, int index) const;
 
         bool implHas(ProtoContext *context, const ProtoObject *targetValue) const;
@@ -1672,6 +2062,408 @@ namespace proto {
         unsigned long getHash(ProtoContext* context) const override;
     };
 
+    /**
+     * Weak reference: holds its target without keeping it alive.  The
+     * referent is not reported by processReferences; the collector clears
+     * `target` (and calls onClear) in the cycle that finds the referent
+     * unreachable.  Registered with the space for the collector's Phase 2.
+     */
+    class ProtoWeakRefImplementation : public Cell {
+    public:
+        mutable std::atomic<const ProtoObject*> target;
+        ProtoWeakClearCallback onClear;
+        void* userData;
+
+        CellType getType() const override { return CellType::WeakRef; }
+
+        ProtoWeakRefImplementation(ProtoContext* context, const ProtoObject* target,
+                                   ProtoWeakClearCallback onClear, void* userData);
+        const ProtoObject* implAsObject(ProtoContext* context) const override;
+        const ProtoObject* implGet(ProtoContext* context) const;
+        void processReferences(ProtoContext* context, void* self, void (*method)(ProtoContext*, void*, const Cell*)) const override;
+        void finalize(ProtoContext* context) const override;
+        unsigned long getHash(ProtoContext* context) const override;
+    };
+
+    /**
+     * Ephemeron table keyed by object identity.  An entry's value is kept
+     * alive only while its key is reachable from outside the table; once
+     * the key dies the collector drops the entry.  Unlike every other
+     * collection in the runtime it is updated in place, so the entries live
+     * in a malloc'd table guarded by its own mutex; finalize frees it.
+     */
+    class ProtoWeakMapImplementation : public Cell {
+    public:
+        struct Table {
+            std::mutex mutex;
+            std::unordered_map<const ProtoObject*, const ProtoObject*> entries;
+        };
+
+        mutable Table* table;
+        ProtoWeakClearCallback onClear;
+        void* userData;
+
+        CellType getType() const override { return CellType::WeakMap; }
+
+        ProtoWeakMapImplementation(ProtoContext* context, ProtoWeakClearCallback onClear, void* userData);
+        const ProtoObject* implAsObject(ProtoContext* context) const override;
+        const ProtoObject* implGet(ProtoContext* context, const ProtoObject* key) const;
+        void implSet(ProtoContext* context, const ProtoObject* key, const ProtoObject* value) const;
+        bool implRemove(ProtoContext* context, const ProtoObject* key) const;
+        unsigned long implGetSize(ProtoContext* context) const;
+        void processReferences(ProtoContext* context, void* self, void (*method)(ProtoContext*, void*, const Cell*)) const override;
+        void finalize(ProtoContext* context) const override;
+        unsigned long getHash(ProtoContext* context) const override;
+    };
+
+    /** Where a heap snapshot root was found; recorded in the snapshot by name. */
+    enum class HeapRootKind : uint8_t {
+        Thread,
+        Global,
+        Module,
+        TupleInterner,
+        MutableShard,
+        RootSet,
+        Fiber,
+        Channel,
+        Young,
+        SurvivorPen
+    };
+
+    struct HeapSnapshotRoot {
+        const Cell* cell;
+        HeapRootKind kind;
+    };
+
+    /** A writeHeapSnapshot call waiting for the collector's next stop. */
+    struct HeapSnapshotRequest {
+        const char* path;
+        bool done;
+        bool written;
+    };
+
+    /**
+     * Writes every cell reachable from \a roots to \a path in the heap
+     * snapshot format (see HeapSnapshot.cpp).  Returns false if the file
+     * could not be written.  Requires the world to be stopped.
+     */
+    bool writeHeapSnapshotFile(ProtoSpace* space, const char* path,
+                               const std::vector<HeapSnapshotRoot>& roots);
+
+    /** Name of a cell type as used in heap snapshots and profiles ("Object", "List", ...). */
+    const char* cellTypeName(CellType type);
+
+    /**
+     * The sampling allocation profiler behind
+     * ProtoSpace::startAllocationProfiler (see AllocationProfiler.cpp).
+     *
+     * Mutators call onAllocation from allocCell while sampling is on; the
+     * collector resolves the types of sampled cells during its stop
+     * (resolveTypes), reports sampled cells as it sweeps them (onFreed,
+     * behind the mayBeSampled filter) and counts survivors at the end of
+     * every cycle (onCycleEnd).
+     */
+    class AllocationProfiler {
+    public:
+        explicit AllocationProfiler(ProtoSpace* space);
+
+        /** Drop every sample and start a new sampling session. */
+        void start(unsigned long meanBytes, bool captureStacks);
+        void onAllocation(Cell* cell);
+
+        bool mayBeSampled(const Cell* cell) const {
+            const size_t bit = filterBit(cell);
+            return (filter[bit / 64].load(std::memory_order_relaxed) >> (bit % 64)) & 1;
+        }
+        void onFreed(const Cell* cell);
+        /** Requires the world to be stopped. */
+        void resolveTypes();
+        void onCycleEnd(uint64_t cycle);
+
+        std::vector<ProtoAllocationSample> samples();
+        bool writePprof(const char* path);
+
+    private:
+        struct LiveSample {
+            uint64_t id;
+            CellType type;
+            bool resolved;
+            const char* site;
+            std::vector<void*> stack;
+            double weight;
+            uint64_t cycle;
+            unsigned long survivedCycles;
+        };
+        struct FreedKey {
+            CellType type;
+            const char* site;
+            std::vector<void*> stack;
+            unsigned long survivedCycles;
+            bool operator<(const FreedKey& other) const;
+        };
+        struct FreedTotals {
+            unsigned long count;
+            double weight;
+        };
+
+        static constexpr size_t FILTER_BITS = 1 << 16;
+
+        static size_t filterBit(const Cell* cell) {
+            return static_cast<size_t>(
+                ((reinterpret_cast<uintptr_t>(cell) >> 6) * 0x9E3779B97F4A7C15ULL) >> 48);
+        }
+        static bool resolveType(const Cell* cell, LiveSample& sample);
+        void resolvePending();
+
+        ProtoSpace* space;
+        std::atomic<uint64_t> session;
+        std::atomic<unsigned long> meanBytes;
+        std::atomic<bool> captureStacks;
+        std::mutex mutex;
+        uint64_t nextSampleId;
+        std::unordered_map<const Cell*, LiveSample> live;
+        std::map<FreedKey, FreedTotals> freed;
+        std::atomic<uint64_t> filter[FILTER_BITS / 64];
+    };
+
+    /**
+     * The event ring behind ProtoSpace::startTrace (see TraceRecorder.cpp).
+     *
+     * Any thread records without locking: complete() for a span that has
+     * just ended, counter() for a sampled value.  Names and argument names
+     * must be string literals; anything else goes through intern().  Trace
+     * points go through traceBegin / traceEnd, which skip the clock read
+     * while tracing is off.
+     */
+    class TraceRecorder {
+    public:
+        TraceRecorder();
+        ~TraceRecorder();
+
+        /** Forget the recorded events and record into a ring of at least \a capacity. */
+        void start(unsigned long capacity);
+
+        /** Nanoseconds on the trace clock. */
+        static uint64_t now();
+
+        void complete(const char* name, uint64_t start, uint64_t end,
+                      const char* argName = nullptr, long value = 0, const char* detail = nullptr);
+        void counter(const char* name, long value);
+        /** A copy of \a text that lives as long as the recorder. */
+        const char* intern(const std::string& text);
+        /** Name the calling thread in the trace. */
+        void nameThread(const char* name);
+
+        std::vector<ProtoTraceEvent> events();
+        bool writeChromeTrace(const char* path);
+
+    private:
+        // One cache line per event.  `sequence` is the event's index + 1
+        // once it is written and 0 while it is being written; readers copy
+        // the fields and re-check it, seqlock-style.
+        struct alignas(64) Event {
+            std::atomic<uint64_t> sequence;
+            uint64_t start;
+            uint64_t duration;
+            const char* name;
+            const char* argName;
+            const char* detail;
+            long value;
+            unsigned int thread;
+            char kind;
+        };
+        struct Ring {
+            explicit Ring(unsigned long capacity);
+            ~Ring();
+            const uint64_t mask;
+            Event* const slots;
+            std::atomic<uint64_t> next;
+            // Index of the first event of the current trace.
+            uint64_t begin;
+        };
+
+        void record(char kind, const char* name, uint64_t start, uint64_t duration,
+                    const char* argName, long value, const char* detail);
+
+        const uint64_t origin;
+        std::atomic<Ring*> ring;
+        // Guards the fields below, and `begin` of the current ring.
+        std::mutex mutex;
+        // Rings replaced by a start with another capacity: a thread may
+        // still be writing into one, so they live as long as the recorder.
+        std::vector<Ring*> retired;
+        std::unordered_set<std::string> strings;
+        std::map<unsigned int, std::string> threadNames;
+    };
+
+    /** Trace clock reading for a span about to begin, or 0 while \a space is not tracing. */
+    inline uint64_t traceBegin(ProtoSpace* space) {
+        return space->tracing.load(std::memory_order_acquire) ? TraceRecorder::now() : 0;
+    }
+
+    /** Records the span begun at \a start (from traceBegin) if it was traced. */
+    inline void traceEnd(ProtoSpace* space, uint64_t start, const char* name,
+                         const char* argName = nullptr, long value = 0, const char* detail = nullptr) {
+        if (start && space->tracing.load(std::memory_order_acquire))
+            space->traceRecorder->complete(name, start, TraceRecorder::now(), argName, value, detail);
+    }
+
+    /** Records a sample of the counter \a name while \a space is tracing. */
+    inline void traceCounter(ProtoSpace* space, const char* name, long value) {
+        if (space->tracing.load(std::memory_order_acquire))
+            space->traceRecorder->counter(name, value);
+    }
+
+    /**
+     * What the collector needs from the weak cells of a space, captured
+     * during the stop-the-world root collection: every cell some weak ref
+     * points at or some weak map uses as a key (`referents`), and a copy of
+     * every weak map entry (`entries`) for the ephemeron fixpoint.
+     */
+    struct WeakSnapshot {
+        std::unordered_set<const Cell*> referents;
+        std::vector<std::pair<const ProtoObject*, const ProtoObject*>> entries;
+    };
+
+    /** Fills \a out from the weak cells registered with \a space.  Requires the world to be stopped. */
+    void collectWeakReferents(ProtoSpace* space, WeakSnapshot& out);
+
+    /**
+     * Clears every weak ref whose target is in \a dying and drops every
+     * weak map entry keyed by one, then runs the onClear callbacks.  Called
+     * by the collector after sweep; the dying cells are still allocated.
+     */
+    void clearDeadWeakReferents(ProtoSpace* space, const std::unordered_set<const Cell*>& dying);
+
+    /** Frees the tables of weak maps that were never collected.  Called from ~ProtoSpace. */
+    void releaseWeakMapTables(ProtoSpace* space);
+
+    /**
+     * Single-assignment result slot behind ProtoFuture and ProtoPromise.
+     * `value` holds the result or the rejection reason once `state` leaves
+     * Pending.  Waiters and `then` continuations need a mutex and condition
+     * variable; those live in a malloc'd table created on first use (most
+     * futures are settled before anyone waits), freed by finalize.
+     *
+     * Continuations stay in the table after they have been dispatched, so
+     * everything the cell referenced when a collection's root scan ran is
+     * still reported when the concurrent mark reaches it.
+     */
+    class ProtoFutureImplementation : public Cell {
+    public:
+        enum State : int { Pending = 0, Settling = 1, Fulfilled = 2, Rejected = 3 };
+
+        struct Continuation {
+            ProtoMethod method;
+            const ProtoObject* self;
+            const ProtoFutureImplementation* derived;
+            ProtoTaskPool* pool;
+            bool dispatched;
+        };
+
+        struct Waiters {
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::vector<Continuation> continuations;
+        };
+
+        mutable std::atomic<const ProtoObject*> value;
+        mutable std::atomic<int> state;
+        mutable std::atomic<Waiters*> waiters;
+
+        CellType getType() const override { return CellType::Future; }
+
+        explicit ProtoFutureImplementation(ProtoContext* context);
+        const ProtoObject* implAsObject(ProtoContext* context) const override;
+        bool implSettle(ProtoContext* context, const ProtoObject* result, bool rejected) const;
+        bool implWaitFor(ProtoContext* context, long milliseconds) const;
+        const ProtoFutureImplementation* implThen(ProtoContext* context, ProtoMethod method,
+                                                  const ProtoObject* self, ProtoTaskPool* pool) const;
+        bool implIsSettled() const;
+        void processReferences(ProtoContext* context, void* self, void (*method)(ProtoContext*, void*, const Cell*)) const override;
+        void finalize(ProtoContext* context) const override;
+        unsigned long getHash(ProtoContext* context) const override;
+
+    private:
+        Waiters* ensureWaiters(ProtoContext* context) const;
+    };
+
+    /** Frees the waiter tables of futures that were never collected.  Called from ~ProtoSpace. */
+    void releaseFutureTables(ProtoSpace* space);
+
+    /**
+     * Bounded MPMC ring behind ProtoChannel.  The ring lives in a malloc'd
+     * block (freed by finalize): a Vyukov-style array of sequence-numbered
+     * slots, head and tail on their own cache lines, and the mutex and
+     * condition variables blocked senders and receivers sleep on.  The
+     * fast paths touch only the atomics; a sender or receiver takes the
+     * mutex only to sleep or to wake a sleeper.
+     *
+     * Queued values are not reported by processReferences.  The collector
+     * takes them as roots during the stop-the-world root scan
+     * (collectChannelContents), since a value received after that scan
+     * would otherwise be gone from the ring by the time the concurrent
+     * mark visits it.
+     */
+    class ProtoChannelImplementation : public Cell {
+    public:
+        struct SelectWaiter {
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool signaled = false;
+        };
+
+        struct Slot {
+            std::atomic<unsigned long> sequence;
+            const ProtoObject* value;
+        };
+
+        struct Ring {
+            alignas(64) std::atomic<unsigned long> head{0};
+            alignas(64) std::atomic<unsigned long> tail{0};
+            alignas(64) std::atomic<int> sleepingSenders{0};
+            std::atomic<int> sleepingReceivers{0};
+            std::atomic<bool> closed{false};
+            unsigned long mask = 0;
+            std::unique_ptr<Slot[]> slots;
+            std::mutex mutex;
+            std::condition_variable notFull;
+            std::condition_variable notEmpty;
+            std::vector<SelectWaiter*> selectors;
+        };
+
+        mutable Ring* ring;
+
+        CellType getType() const override { return CellType::Channel; }
+
+        ProtoChannelImplementation(ProtoContext* context, unsigned long capacity);
+        const ProtoObject* implAsObject(ProtoContext* context) const override;
+        bool implTrySend(const ProtoObject* value) const;
+        const ProtoObject* implTryReceive() const;
+        bool implSend(ProtoContext* context, const ProtoObject* value) const;
+        const ProtoObject* implReceive(ProtoContext* context) const;
+        void implClose() const;
+        void processReferences(ProtoContext* context, void* self, void (*method)(ProtoContext*, void*, const Cell*)) const override;
+        void finalize(ProtoContext* context) const override;
+        unsigned long getHash(ProtoContext* context) const override;
+    };
+
+    /** Appends every value queued in a channel of \a space to \a out.  Requires the world to be stopped. */
+    void collectChannelContents(ProtoSpace* space, std::vector<const Cell*>& out);
+
+    /** Frees the rings of channels that were never collected.  Called from ~ProtoSpace. */
+    void releaseChannelRings(ProtoSpace* space);
+
+    /**
+     * Appends the innermost context of every suspended fiber of \a space
+     * to \a out.  Running fibers are reached through their thread's
+     * context chain instead.  Requires the world to be stopped.
+     */
+    void collectSuspendedFiberContexts(ProtoSpace* space, std::vector<ProtoContext*>& out);
+
+    /** Releases every fiber still registered with \a space.  Called from ~ProtoSpace. */
+    void releaseFibers(ProtoSpace* space);
+
     class TupleDictionary : public Cell {
     public:
         CellType getType() const override { return CellType::TupleDictionary; }
@@ -1704,6 +2496,10 @@ namespace proto {
             ProtoMethodCell methodCell;
             ProtoExternalPointerImplementation externalPointerCell;
             ProtoExternalBufferImplementation externalBufferCell;
+            ProtoWeakRefImplementation weakRefCell;
+            ProtoWeakMapImplementation weakMapCell;
+            ProtoFutureImplementation futureCell;
+            ProtoChannelImplementation channelCell;
             ProtoThreadImplementation threadCell;
             ProtoThreadExtension threadExtensionCell;
             LargeIntegerImplementation largeIntegerCell;
@@ -1716,6 +2512,7 @@ namespace proto {
 
     static_assert(sizeof(BigCell) <= 64, "BigCell exceeds 64 bytes!!!!");
     static_assert(sizeof(ProtoObjectCell) <= 64, "ProtoObjectCell exceeds 64 bytes!");
+    static_assert(sizeof(AttributeStore) == 4 * sizeof(void*), "AttributeStore must fill the object cell's spare words");
     static_assert(sizeof(ProtoListIteratorImplementation) <= 64, "ProtoListIteratorImplementation exceeds 64 bytes!");
     static_assert(sizeof(ProtoListImplementation) <= 64, "ProtoListImplementation exceeds 64 bytes!");
     static_assert(sizeof(ProtoListSmallImplementation) <= 64, "ProtoListSmallImplementation exceeds 64 bytes!");
@@ -1730,6 +2527,10 @@ namespace proto {
     static_assert(sizeof(ProtoMethodCell) <= 64, "ProtoMethodCell exceeds 64 bytes!");
     static_assert(sizeof(ProtoExternalPointerImplementation) <= 64, "ProtoExternalPointerImplementation exceeds 64 bytes!");
     static_assert(sizeof(ProtoExternalBufferImplementation) <= 64, "ProtoExternalBufferImplementation exceeds 64 bytes!");
+    static_assert(sizeof(ProtoWeakRefImplementation) <= 64, "ProtoWeakRefImplementation exceeds 64 bytes!");
+    static_assert(sizeof(ProtoWeakMapImplementation) <= 64, "ProtoWeakMapImplementation exceeds 64 bytes!");
+    static_assert(sizeof(ProtoFutureImplementation) <= 64, "ProtoFutureImplementation exceeds 64 bytes!");
+    static_assert(sizeof(ProtoChannelImplementation) <= 64, "ProtoChannelImplementation exceeds 64 bytes!");
     static_assert(sizeof(ProtoThreadImplementation) <= 64, "ProtoThreadImplementation exceeds 64 bytes!");
     static_assert(sizeof(ProtoThreadExtension) <= 64, "ProtoThreadExtension exceeds 64 bytes!");
     static_assert(sizeof(LargeIntegerImplementation) <= 64, "LargeIntegerImplementation exceeds 64 bytes!");
@@ -0,0 +1,173 @@
+/*
+ * AllocationProfilerTests.cpp
+ *
+ * Covers the sampling allocation profiler: samples carry the cell type
+ * and the site tag in force, their weights estimate the allocations they
+ * stand for, the collector reports which sampled cells survive and which
+ * die, and the profile is written as pprof protobuf.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace proto;
+
+namespace {
+
+bool atSite(const ProtoAllocationSample& sample, const char* site) {
+    return sample.site && std::strcmp(sample.site, site) == 0;
+}
+
+uint64_t readVarint(const std::string& data, size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; pos < data.size(); shift += 7) {
+        const unsigned char byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+} // namespace
+
+TEST(AllocationProfilerTest, SamplesCarryTypeSiteAndWeight) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    EXPECT_TRUE(space.allocationSamples().empty());
+
+    // A 64-byte mean samples most cells, so the estimate is tight.
+    space.startAllocationProfiler(64, false);
+    constexpr int kObjects = 2000;
+    {
+        ProtoAllocationSite site("test.objects");
+        for (int i = 0; i < kObjects; ++i) ctx->newObject(false);
+    }
+    ctx->newList();
+
+    double objectWeight = 0;
+    unsigned long objectSamples = 0;
+    for (const ProtoAllocationSample& sample : space.allocationSamples()) {
+        EXPECT_TRUE(sample.live);
+        EXPECT_TRUE(sample.stack.empty());
+        if (atSite(sample, "test.objects") && sample.type == "Object") {
+            objectWeight += sample.weight;
+            objectSamples++;
+        }
+        if (!sample.site) EXPECT_NE(sample.type, "Object");
+    }
+    EXPECT_GT(objectSamples, 0u);
+    EXPECT_GT(objectWeight, kObjects * 0.8);
+    EXPECT_LT(objectWeight, kObjects * 1.2);
+}
+
+TEST(AllocationProfilerTest, FollowsSurvivorsAndDeaths) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    space.startAllocationProfiler(64, true);
+
+    ProtoRootSet* rs = space.createRootSet("profiler-test");
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        {
+            ProtoAllocationSite site("kept");
+            for (int i = 0; i < 100; ++i) rs->add(sub.newObject(false));
+        }
+        ProtoAllocationSite site("garbage");
+        for (int i = 0; i < 100; ++i) sub.newObject(false);
+    }
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(forceCollection(ctx));
+
+    unsigned long kept = 0;
+    unsigned long dead = 0;
+    for (const ProtoAllocationSample& sample : space.allocationSamples()) {
+        EXPECT_FALSE(sample.stack.empty());
+        if (atSite(sample, "kept") && sample.type == "Object") {
+            kept++;
+            EXPECT_TRUE(sample.live);
+            EXPECT_GE(sample.survivedCycles, 2u);
+        }
+        if (atSite(sample, "garbage")) {
+            EXPECT_FALSE(sample.live) << sample.type;
+            if (sample.type == "Object") dead += sample.count;
+        }
+    }
+    EXPECT_GT(kept, 0u);
+    EXPECT_GT(dead, 0u);
+    space.destroyRootSet(rs);
+}
+
+TEST(AllocationProfilerTest, StopEndsSampling) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    space.startAllocationProfiler(64, false);
+    for (int i = 0; i < 100; ++i) ctx->newObject(false);
+    space.stopAllocationProfiler();
+    const size_t sampled = space.allocationSamples().size();
+    EXPECT_GT(sampled, 0u);
+    for (int i = 0; i < 1000; ++i) ctx->newObject(false);
+    EXPECT_EQ(space.allocationSamples().size(), sampled);
+
+    // Starting again begins a new profile.
+    space.startAllocationProfiler(1UL << 30, false);
+    EXPECT_TRUE(space.allocationSamples().empty());
+}
+
+TEST(AllocationProfilerTest, WritesPprofProfile) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const std::string path = "alloc_profile_test_" + std::to_string(getpid()) + ".pb";
+    EXPECT_FALSE(space.writeAllocationProfile(path.c_str()));
+
+    space.startAllocationProfiler(64, true);
+    {
+        ProtoAllocationSite site("test.pprof");
+        for (int i = 0; i < 200; ++i) ctx->newObject(false);
+    }
+    EXPECT_FALSE(space.writeAllocationProfile("/nonexistent-dir/profile.pb"));
+    ASSERT_TRUE(space.writeAllocationProfile(path.c_str()));
+
+    std::ifstream in(path, std::ios::binary);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+
+    // Walk the top-level Profile fields: samples (2), locations (4),
+    // functions (5) and the string table (6).
+    unsigned long samples = 0, locations = 0, functions = 0;
+    std::set<std::string> strings;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        const uint64_t key = readVarint(data, pos);
+        const int field = static_cast<int>(key >> 3);
+        if ((key & 7) == 0) {
+            readVarint(data, pos);
+            continue;
+        }
+        ASSERT_EQ(key & 7, 2u);
+        const uint64_t length = readVarint(data, pos);
+        ASSERT_LE(pos + length, data.size());
+        if (field == 2) samples++;
+        if (field == 4) locations++;
+        if (field == 5) functions++;
+        if (field == 6) strings.insert(data.substr(pos, length));
+        pos += length;
+    }
+    EXPECT_EQ(pos, data.size());
+    EXPECT_GT(samples, 0u);
+    EXPECT_GT(locations, 2u);
+    EXPECT_GT(functions, 2u);
+    for (const char* expected : {"alloc_objects", "alloc_space", "inuse_objects", "inuse_space",
+                                 "[cell Object]", "[site test.pprof]", "cell_type", "survived_cycles"})
+        EXPECT_TRUE(strings.count(expected)) << expected;
+}
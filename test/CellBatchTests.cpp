@@ -0,0 +1,120 @@
+/*
+ * CellBatchTests.cpp
+ *
+ * Covers ProtoContext::allocCells: the reservation serves the allocations
+ * that follow, their cells join the young chain in one splice, unused
+ * cells go back to the free cells, and the bulk builders (lists, large
+ * integers, strings) that use it build the same values, across a
+ * collection taken mid-batch.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace proto;
+
+namespace {
+
+unsigned long threadFreeCells(ProtoContext* context) {
+    unsigned long count = 0;
+    ProtoThreadExtension* extension = toImpl<ProtoThreadImplementation>(context->thread)->extension;
+    for (Cell* cell = extension->freeCells; cell; cell = cell->getNext()) ++count;
+    return count;
+}
+
+unsigned long chainLength(const Cell* cell) {
+    unsigned long count = 0;
+    for (; cell; cell = cell->getNext()) ++count;
+    return count;
+}
+
+} // namespace
+
+TEST(CellBatchTest, ReservationServesAllocationsWithOneSplice) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const unsigned long youngBefore = chainLength(ctx->lastAllocatedCell);
+
+    ctx->allocCells(16);
+    EXPECT_EQ(ctx->reservedCount, 16u);
+    const unsigned long freeReserved = threadFreeCells(ctx);
+    for (int i = 0; i < 10; ++i) ctx->newObject(false);
+    // Constructed, but not in the young chain until the batch closes.
+    const unsigned long used = 16u - ctx->reservedCount;
+    EXPECT_GT(used, 0u);
+    EXPECT_EQ(chainLength(ctx->lastAllocatedCell), youngBefore);
+    EXPECT_EQ(chainLength(ctx->batchYoungHead), used);
+    EXPECT_EQ(threadFreeCells(ctx), freeReserved);
+    ctx->releaseCells();
+
+    EXPECT_EQ(chainLength(ctx->lastAllocatedCell), youngBefore + used);
+    EXPECT_EQ(threadFreeCells(ctx), freeReserved + 16u - used);
+    EXPECT_EQ(ctx->cellBatchDepth, 0u);
+    EXPECT_EQ(ctx->reservedCells, nullptr);
+    EXPECT_EQ(ctx->batchYoungHead, nullptr);
+}
+
+TEST(CellBatchTest, ShortReservationAndNestingFallBackCleanly) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const unsigned long youngBefore = chainLength(ctx->lastAllocatedCell);
+    {
+        ProtoContext::CellBatch outer(ctx, 2);
+        {
+            // Nesting tops the reservation up rather than stacking it.
+            ProtoContext::CellBatch inner(ctx, 8);
+            EXPECT_EQ(ctx->reservedCount, 8u);
+            EXPECT_EQ(ctx->cellBatchDepth, 2u);
+        }
+        EXPECT_EQ(ctx->cellBatchDepth, 1u);
+        // Past the reservation, allocation takes the normal path.
+        for (int i = 0; i < 40; ++i) ctx->fromUTF8String("a string well past the inline limit");
+        EXPECT_EQ(ctx->reservedCount, 0u);
+    }
+    EXPECT_GE(chainLength(ctx->lastAllocatedCell), youngBefore + 40);
+    EXPECT_EQ(ctx->batchYoungHead, nullptr);
+}
+
+TEST(CellBatchTest, BulkBuildersSurviveACollectionMidBatch) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    auto* rs = space.createRootSet("cell-batch-test");
+
+    std::vector<const ProtoObject*> items;
+    for (int i = 0; i < 200; ++i) items.push_back(ctx->fromInteger(i));
+    const std::string text(1000, 'x');
+    const ProtoList* list;
+    const ProtoObject* big;
+    const ProtoObject* str;
+    {
+        ProtoContext::CellBatch batch(ctx, 64);
+        list = ctx->newList(static_cast<unsigned>(items.size()), items.data());
+        rs->add(list->asObject(ctx));
+        // The safepoint inside splices the batch before parking.
+        ASSERT_TRUE(forceCollection(ctx));
+        big = Integer::fromString(ctx, "123456789012345678901234567890123456789012345678901234567890", 10);
+        rs->add(big);
+        str = ctx->fromUTF8String(text.c_str());
+        rs->add(str);
+    }
+    ASSERT_TRUE(forceCollection(ctx));
+    for (int i = 0; i < 200000; ++i) ctx->newObject(false);
+    ASSERT_TRUE(forceCollection(ctx));
+
+    ASSERT_EQ(list->getSize(ctx), 200u);
+    for (int i = 0; i < 200; ++i) EXPECT_EQ(list->getAt(ctx, i)->asLong(ctx), i);
+    std::string digits;
+    Integer::toString(ctx, big, 10)->toUTF8String(ctx, digits);
+    EXPECT_EQ(digits, "123456789012345678901234567890123456789012345678901234567890");
+    std::string back;
+    str->asString(ctx)->toUTF8String(ctx, back);
+    EXPECT_EQ(back, text);
+    space.destroyRootSet(rs);
+}
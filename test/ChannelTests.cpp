@@ -0,0 +1,216 @@
+/*
+ * ChannelTests.cpp
+ *
+ * Covers ProtoChannel: non-blocking and blocking transfer, close
+ * semantics, many producers and consumers on a task pool, collections
+ * while threads are blocked on a channel, rooting of queued and received
+ * values, and select.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+constexpr long kPerProducer = 2000;
+
+// self: the channel.  Sends 1..kPerProducer.
+const ProtoObject* producer(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                            const ProtoList*, const ProtoSparseList*) {
+    const ProtoChannel* channel = self->asChannel(context);
+    for (long i = 1; i <= kPerProducer; ++i)
+        if (!channel->send(context, context->fromInteger(i))) return PROTO_FALSE;
+    return PROTO_TRUE;
+}
+
+// self: the channel.  Returns the sum of everything received before close.
+const ProtoObject* consumer(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                            const ProtoList*, const ProtoSparseList*) {
+    const ProtoChannel* channel = self->asChannel(context);
+    long sum = 0;
+    while (const ProtoObject* value = channel->receive(context)) sum += value->asLong(context);
+    return context->fromInteger(sum);
+}
+
+// self: the channel.  Sends a single fresh object.
+const ProtoObject* sendOne(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                           const ProtoList*, const ProtoSparseList*) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return context->fromBoolean(self->asChannel(context)->send(context, context->newObject(false)));
+}
+
+} // namespace
+
+TEST(ChannelTest, TrySendAndReceive) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoChannel* channel = ctx->newChannel(3);
+
+    EXPECT_EQ(channel->getCapacity(ctx), 4u);
+    EXPECT_EQ(channel->tryReceive(ctx), nullptr);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(channel->trySend(ctx, ctx->fromInteger(i)));
+    EXPECT_FALSE(channel->trySend(ctx, ctx->fromInteger(4)));
+    EXPECT_EQ(channel->getSize(ctx), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(channel->tryReceive(ctx)->asLong(ctx), i);
+    EXPECT_EQ(channel->tryReceive(ctx), nullptr);
+
+    EXPECT_TRUE(channel->trySend(ctx, nullptr));
+    EXPECT_EQ(channel->receive(ctx), PROTO_NONE);
+    EXPECT_EQ(channel->asObject(ctx)->asChannel(ctx), channel);
+}
+
+TEST(ChannelTest, CloseDrainsThenEnds) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoChannel* channel = ctx->newChannel(2);
+
+    EXPECT_TRUE(channel->send(ctx, ctx->fromInteger(1)));
+    channel->close(ctx);
+    EXPECT_TRUE(channel->isClosed(ctx));
+    EXPECT_FALSE(channel->send(ctx, ctx->fromInteger(2)));
+    EXPECT_FALSE(channel->trySend(ctx, ctx->fromInteger(2)));
+    EXPECT_EQ(channel->receive(ctx)->asLong(ctx), 1);
+    EXPECT_EQ(channel->receive(ctx), nullptr);
+}
+
+TEST(ChannelTest, ManyProducersAndConsumers) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 4);
+    const ProtoChannel* channel = ctx->newChannel(8);
+
+    ProtoTask* consumers[2];
+    ProtoTask* producers[2];
+    for (auto& task : consumers) task = pool->spawn(ctx, consumer, channel->asObject(ctx));
+    for (auto& task : producers) task = pool->spawn(ctx, producer, channel->asObject(ctx));
+    for (auto* task : producers) EXPECT_EQ(pool->join(ctx, task), PROTO_TRUE);
+    channel->close(ctx);
+
+    long total = 0;
+    for (auto* task : consumers) total += pool->join(ctx, task)->asLong(ctx);
+    EXPECT_EQ(total, 2 * kPerProducer * (kPerProducer + 1) / 2);
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(ChannelTest, BlockedThreadsDoNotStallCollection) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 2);
+    const ProtoChannel* empty = ctx->newChannel(2);
+    const ProtoChannel* full = ctx->newChannel(2);
+    full->send(ctx, ctx->fromInteger(1));
+    full->send(ctx, ctx->fromInteger(2));
+
+    ProtoTask* receiving = pool->spawn(ctx, consumer, empty->asObject(ctx));
+    ProtoTask* sending = pool->spawn(ctx, producer, full->asObject(ctx));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(forceCollection(ctx));
+
+    empty->send(ctx, ctx->fromInteger(5));
+    empty->close(ctx);
+    EXPECT_EQ(pool->join(ctx, receiving)->asLong(ctx), 5);
+    long received = 0;
+    for (long i = 0; i < kPerProducer + 2; ++i) received += full->receive(ctx) != nullptr;
+    EXPECT_EQ(received, kPerProducer + 2);
+    EXPECT_EQ(pool->join(ctx, sending), PROTO_TRUE);
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(ChannelTest, QueuedValuesAreRoots) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoChannel* channel = ctx->newChannel(4);
+
+    const ProtoWeakRef* probe = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        const ProtoObject* value = sub.newObject(false);
+        probe = ctx->newWeakRef(value);
+        channel->send(&sub, value);
+    }
+
+    waitForGcCycles(space, 3);
+
+    ASSERT_NE(probe->get(ctx), nullptr);
+    EXPECT_EQ(channel->tryReceive(ctx), probe->get(ctx));
+}
+
+TEST(ChannelTest, ReceivedValueStaysRootedWhileAnchored) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoChannel* channel = ctx->newChannel(4);
+
+    const ProtoWeakRef* probe = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        const ProtoObject* value = sub.newObject(false);
+        probe = ctx->newWeakRef(value);
+        channel->send(&sub, value);
+    }
+    waitForGcCycles(space, 2);
+    ASSERT_NE(probe->get(ctx), nullptr);
+
+    // Keep a stop pending, so that the anchor allocation of a receive (the
+    // first allocation of a fresh context) parks for it.  The value, no
+    // longer in the ring, must still be a root while the world is stopped.
+    std::atomic<bool> done{false};
+    std::thread requester([&space, &done] {
+        while (!done.load()) {
+            requestCollection(&space);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+    const uint64_t before = space.gcCycleCount.load();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    bool intact = true;
+    for (int round = 0; intact && space.gcCycleCount.load() < before + 20 &&
+                        std::chrono::steady_clock::now() < deadline; ++round) {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        const ProtoObject* value = nullptr;
+        switch (round % 3) {
+            case 0: value = channel->receive(&sub); break;
+            case 1: value = channel->tryReceive(&sub); break;
+            default: value = ProtoChannel::select(&sub, &channel, 1, nullptr); break;
+        }
+        intact = value != nullptr && value == probe->get(&sub);
+        channel->send(&sub, value);
+    }
+    done = true;
+    requester.join();
+    EXPECT_TRUE(intact);
+    EXPECT_GE(space.gcCycleCount.load(), before + 20);
+    EXPECT_EQ(channel->tryReceive(ctx), probe->get(ctx));
+}
+
+TEST(ChannelTest, SelectPicksReadyChannel) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 1);
+    const ProtoChannel* channels[2] = {ctx->newChannel(2), ctx->newChannel(2)};
+    unsigned long index = 99;
+
+    EXPECT_EQ(ProtoChannel::select(ctx, channels, 2, &index, 10), nullptr);
+
+    channels[1]->send(ctx, ctx->fromInteger(7));
+    EXPECT_EQ(ProtoChannel::select(ctx, channels, 2, &index)->asLong(ctx), 7);
+    EXPECT_EQ(index, 1u);
+
+    // Blocks until a worker sends on the first channel.
+    ProtoTask* task = pool->spawn(ctx, sendOne, channels[0]->asObject(ctx));
+    EXPECT_NE(ProtoChannel::select(ctx, channels, 2, &index), nullptr);
+    EXPECT_EQ(index, 0u);
+    EXPECT_EQ(pool->join(ctx, task), PROTO_TRUE);
+
+    channels[0]->close(ctx);
+    channels[1]->close(ctx);
+    EXPECT_EQ(ProtoChannel::select(ctx, channels, 2, &index), nullptr);
+    space.destroyTaskPool(ctx, pool);
+}
@@ -0,0 +1,201 @@
+/*
+ * EventLoopTests.cpp
+ *
+ * Covers ProtoEventLoop over local pipes and sockets: one-shot reads and
+ * writes into ProtoByteBuffers, persistent watches, timers, stop from
+ * another thread, and collections while the loop is waiting.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace proto;
+
+namespace {
+
+struct Record {
+    std::vector<long> results;
+    std::vector<long> order;
+    std::vector<char> received;
+};
+
+Record* recordOf(ProtoContext* context, const ProtoObject* self) {
+    return static_cast<Record*>(self->asExternalPointer(context)->getPointer(context));
+}
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Records the (fd, result) pair's result.
+const ProtoObject* onTransfer(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                              const ProtoList* args, const ProtoSparseList*) {
+    recordOf(context, self)->results.push_back(args->getAt(context, 1)->asLong(context));
+    return PROTO_NONE;
+}
+
+// Drains whatever is readable; unwatches itself at end of file.
+const ProtoObject* onReadable(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                              const ProtoList* args, const ProtoSparseList*) {
+    Record* record = recordOf(context, self);
+    const int fd = static_cast<int>(args->getAt(context, 0)->asLong(context));
+    char chunk[4096];
+    long n;
+    while ((n = ::read(fd, chunk, sizeof chunk)) > 0) record->received.insert(record->received.end(), chunk, chunk + n);
+    if (n == 0) record->results.push_back(0);
+    return PROTO_NONE;
+}
+
+template <long N>
+const ProtoObject* onTimer(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                           const ProtoList*, const ProtoSparseList*) {
+    recordOf(context, self)->order.push_back(N);
+    return PROTO_NONE;
+}
+
+} // namespace
+
+TEST(EventLoopTest, ReadsPipeIntoBuffer) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoEventLoop* loop = space.createEventLoop(ctx);
+    Record record;
+    const ProtoObject* self = ctx->fromExternalPointer(&record);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    setNonBlocking(fds[0]);
+    const ProtoByteBuffer* buffer = ctx->newBuffer(16)->asByteBuffer(ctx);
+
+    ASSERT_TRUE(loop->read(ctx, fds[0], buffer, onTransfer, self, 2));
+    EXPECT_FALSE(loop->read(ctx, fds[0], buffer, onTransfer, self));
+    ASSERT_EQ(::write(fds[1], "hello", 5), 5);
+    loop->run(ctx);
+    ASSERT_EQ(record.results.size(), 1u);
+    EXPECT_EQ(record.results[0], 5);
+    EXPECT_EQ(std::memcmp(buffer->getBuffer(ctx) + 2, "hello", 5), 0);
+
+    ::close(fds[1]);
+    ASSERT_TRUE(loop->read(ctx, fds[0], buffer, onTransfer, self));
+    loop->run(ctx);
+    ASSERT_EQ(record.results.size(), 2u);
+    EXPECT_EQ(record.results[1], 0);
+
+    ::close(fds[0]);
+    space.destroyEventLoop(ctx, loop);
+}
+
+TEST(EventLoopTest, WritesWholeBufferThroughSocket) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoEventLoop* loop = space.createEventLoop(ctx);
+    Record record;
+    const ProtoObject* self = ctx->fromExternalPointer(&record);
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    setNonBlocking(fds[0]);
+    setNonBlocking(fds[1]);
+
+    // Larger than the socket buffers, so the write completes in pieces
+    // while the watch on the other end drains it.
+    const unsigned long size = 4 << 20;
+    const ProtoByteBuffer* buffer = ctx->newBuffer(size)->asByteBuffer(ctx);
+    for (unsigned long i = 0; i < size; ++i) buffer->getBuffer(ctx)[i] = static_cast<char>(i * 7);
+
+    ASSERT_TRUE(loop->write(ctx, fds[0], buffer, onTransfer, self));
+    ASSERT_TRUE(loop->watch(ctx, fds[1], ProtoEventLoop::Readable, onReadable, self));
+    while (record.received.size() < size) loop->runOnce(ctx, 1000);
+
+    ASSERT_EQ(record.results.size(), 1u);
+    EXPECT_EQ(record.results[0], static_cast<long>(size));
+    EXPECT_EQ(std::memcmp(record.received.data(), buffer->getBuffer(ctx), size), 0);
+
+    EXPECT_TRUE(loop->unwatch(ctx, fds[1]));
+    EXPECT_FALSE(loop->unwatch(ctx, fds[1]));
+    // A watch with nothing to wait for is refused.
+    EXPECT_FALSE(loop->watch(ctx, fds[1], 0, onReadable, self));
+    EXPECT_FALSE(loop->watch(ctx, fds[1], ProtoEventLoop::Closed, onReadable, self));
+    EXPECT_FALSE(loop->unwatch(ctx, fds[1]));
+    ::close(fds[0]);
+    ::close(fds[1]);
+    space.destroyEventLoop(ctx, loop);
+}
+
+TEST(EventLoopTest, TimersFireInOrderAndStopWakesLoop) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoEventLoop* loop = space.createEventLoop(ctx);
+    Record record;
+    const ProtoObject* self = ctx->fromExternalPointer(&record);
+
+    loop->setTimeout(ctx, 30, onTimer<3>, self);
+    loop->setTimeout(ctx, 10, onTimer<1>, self);
+    loop->setTimeout(ctx, 10, onTimer<2>, self);
+    loop->run(ctx);
+    EXPECT_EQ(record.order, (std::vector<long>{1, 2, 3}));
+
+    // A watch on a pipe nobody writes keeps run() waiting until stop().
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_TRUE(loop->watch(ctx, fds[0], ProtoEventLoop::Readable, onReadable, self));
+    std::thread stopper([loop] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        loop->stop();
+    });
+    loop->run(ctx);
+    stopper.join();
+    EXPECT_TRUE(record.received.empty());
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    space.destroyEventLoop(ctx, loop);
+}
+
+TEST(EventLoopTest, WaitingLoopDoesNotStallCollection) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoEventLoop* loop = space.createEventLoop(ctx);
+    Record record;
+    const ProtoObject* self = ctx->fromExternalPointer(&record);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    setNonBlocking(fds[0]);
+    const ProtoByteBuffer* buffer = ctx->newBuffer(8)->asByteBuffer(ctx);
+    ASSERT_TRUE(loop->read(ctx, fds[0], buffer, onTransfer, self));
+
+    // Requests a collection while the loop waits, and only then wakes it.
+    bool collected = false;
+    std::thread trigger([&space, &collected, fds] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const uint64_t before = space.gcCycleCount.load();
+        requestCollection(&space);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (space.gcCycleCount.load() == before && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        collected = space.gcCycleCount.load() != before;
+        ASSERT_EQ(::write(fds[1], "x", 1), 1);
+    });
+    loop->run(ctx);
+    trigger.join();
+
+    EXPECT_TRUE(collected);
+    ASSERT_EQ(record.results.size(), 1u);
+    EXPECT_EQ(record.results[0], 1);
+    EXPECT_EQ(buffer->getBuffer(ctx)[0], 'x');
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    space.destroyEventLoop(ctx, loop);
+}
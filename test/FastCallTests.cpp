@@ -0,0 +1,118 @@
+/*
+ * FastCallTests.cpp
+ *
+ * Covers the vectorcall-style entry point (ProtoObject::callv /
+ * ProtoContext::fromFastMethod) and its interoperation with legacy
+ * ProtoMethod targets and the list-based ProtoObject::call.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+
+using namespace proto;
+
+namespace {
+
+const ProtoObject* fastSum(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                           const ProtoObject* const* args, unsigned long nargs, const ProtoTuple* kwnames) {
+    long long total = 0;
+    for (unsigned long i = 0; i < nargs; ++i) total += args[i]->asLong(context);
+    // Keyword values follow the positionals; weight them by 100 so the
+    // test can tell them apart.
+    const unsigned long nkw = kwnames ? kwnames->getSize(context) : 0;
+    for (unsigned long i = 0; i < nkw; ++i) total += 100 * args[nargs + i]->asLong(context);
+    return context->fromInteger(total);
+}
+
+const ProtoObject* legacySum(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                             const ProtoList* positional, const ProtoSparseList* keywords) {
+    long long total = 0;
+    const unsigned long n = positional ? positional->getSize(context) : 0;
+    for (unsigned long i = 0; i < n; ++i) total += positional->getAt(context, static_cast<int>(i))->asLong(context);
+    if (keywords) {
+        const ProtoString* scale = context->fromUTF8String("scale")->asString(context);
+        const ProtoObject* v = keywords->getAt(context, scale->getHash(context));
+        if (v && v != PROTO_NONE) total *= v->asLong(context);
+    }
+    return context->fromInteger(total);
+}
+
+} // namespace
+
+class FastCallTest : public ::testing::Test {
+protected:
+    ProtoSpace* space;
+    ProtoContext* context;
+
+    void SetUp() override {
+        space = new ProtoSpace();
+        context = space->rootContext;
+    }
+
+    void TearDown() override {
+        delete space;
+    }
+
+    const ProtoObject* objectWith(const char* name, const ProtoObject* method) {
+        const ProtoObject* obj = context->newObject(true);
+        obj->setAttribute(context, context->fromUTF8String(name)->asString(context), method);
+        return obj;
+    }
+};
+
+TEST_F(FastCallTest, FastTargetReceivesArrayWithoutAllocating) {
+    const ProtoObject* obj = objectWith("sum", context->fromFastMethod(nullptr, fastSum));
+    const ProtoString* name = context->fromUTF8String("sum")->asString(context);
+    const ProtoObject* args[] = {context->fromInteger(1), context->fromInteger(2), context->fromInteger(3)};
+
+    // Warm the attribute cache, then measure a steady-state call.
+    obj->callv(context, nullptr, name, obj, args, 3);
+    const unsigned long before = context->allocatedCellsCount;
+    const ProtoObject* result = obj->callv(context, nullptr, name, obj, args, 3);
+    EXPECT_EQ(context->allocatedCellsCount, before);
+    EXPECT_EQ(result->asLong(context), 6);
+}
+
+TEST_F(FastCallTest, FastTargetReceivesKeywordsAfterPositionals) {
+    const ProtoObject* obj = objectWith("sum", context->fromFastMethod(nullptr, fastSum));
+    const ProtoString* name = context->fromUTF8String("sum")->asString(context);
+    const ProtoTuple* kwnames = context->newTuple({context->fromUTF8String("bonus")});
+    const ProtoObject* args[] = {context->fromInteger(5), context->fromInteger(2)};
+
+    const ProtoObject* result = obj->callv(context, nullptr, name, obj, args, 1, kwnames);
+    EXPECT_EQ(result->asLong(context), 205);
+}
+
+TEST_F(FastCallTest, LegacyTargetGetsPackedListAndKeywords) {
+    const ProtoObject* obj = objectWith("sum", context->fromMethod(nullptr, legacySum));
+    const ProtoString* name = context->fromUTF8String("sum")->asString(context);
+    const ProtoTuple* kwnames = context->newTuple({context->fromUTF8String("scale")});
+    const ProtoObject* args[] = {context->fromInteger(4), context->fromInteger(6), context->fromInteger(10)};
+
+    EXPECT_EQ(obj->callv(context, nullptr, name, obj, args, 2)->asLong(context), 10);
+    EXPECT_EQ(obj->callv(context, nullptr, name, obj, args, 2, kwnames)->asLong(context), 100);
+}
+
+TEST_F(FastCallTest, ListCallReachesFastOnlyTarget) {
+    const ProtoObject* method = context->fromFastMethod(nullptr, fastSum);
+    EXPECT_EQ(method->asMethod(context), nullptr);
+    EXPECT_EQ(method->asFastMethod(context), &fastSum);
+
+    const ProtoObject* obj = objectWith("sum", method);
+    const ProtoString* name = context->fromUTF8String("sum")->asString(context);
+    const ProtoList* list = context->newList();
+    for (int i = 1; i <= 12; ++i) list = list->appendLast(context, context->fromInteger(i));
+
+    // 12 arguments exercises the spill past the inline stack buffer.
+    EXPECT_EQ(obj->call(context, nullptr, name, obj, list)->asLong(context), 78);
+}
+
+TEST_F(FastCallTest, LegacyEntryPreferredForListCalls) {
+    const ProtoObject* obj = objectWith("sum", context->fromFastMethod(nullptr, fastSum, legacySum));
+    const ProtoString* name = context->fromUTF8String("sum")->asString(context);
+    const ProtoObject* items[] = {context->fromInteger(2), context->fromInteger(3)};
+    const ProtoList* list = context->newList(2, items);
+
+    EXPECT_EQ(obj->call(context, nullptr, name, obj, list)->asLong(context), 5);
+    EXPECT_EQ(obj->callv(context, nullptr, name, obj, items, 2)->asLong(context), 5);
+}
@@ -0,0 +1,180 @@
+/*
+ * FiberTests.cpp
+ *
+ * Covers ProtoFiber: values flow both ways across yield/resume, results and
+ * exceptions come back from resume, fibers nest, suspended fibers keep what
+ * they allocated across collections, many fibers can coexist, and a yield
+ * inside a handle scope aborts.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+// Yields 0 .. args[0]-1, then returns the sum of the values resumed with.
+const ProtoObject* counter(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                           const ProtoList* args, const ProtoSparseList*) {
+    const long long n = args->getAt(context, 0)->asLong(context);
+    long long sum = 0;
+    for (long long i = 0; i < n; ++i)
+        sum += ProtoFiber::yield(context, context->fromInteger(i))->asLong(context);
+    return context->fromInteger(sum);
+}
+
+const ProtoObject* failing(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                           const ProtoList*, const ProtoSparseList*) {
+    ProtoFiber::yield(context);
+    throw std::runtime_error("fiber failed");
+}
+
+// Drives the fiber passed as self (an external pointer) and yields each of
+// its values doubled.
+const ProtoObject* doubler(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                           const ProtoList*, const ProtoSparseList*) {
+    auto* inner = static_cast<ProtoFiber*>(self->asExternalPointer(context)->getPointer(context));
+    while (true) {
+        const ProtoObject* v = inner->resume(context, context->fromInteger(0));
+        if (inner->isFinished()) break;
+        ProtoFiber::yield(context, context->fromInteger(v->asLong(context) * 2));
+    }
+    return PROTO_NONE;
+}
+
+// Gets an object back from a finished callee (so it is already handed to
+// the collector and only the fiber's chain refers to it), yields across a
+// collection, then returns it.
+struct Probe {
+    ProtoContext* root;
+    const ProtoWeakRef* ref;
+};
+
+const ProtoObject* holder(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                          const ProtoList*, const ProtoSparseList*) {
+    auto* probe = static_cast<Probe*>(self->asExternalPointer(context)->getPointer(context));
+    ProtoContext inner(context->space, context, nullptr, nullptr, nullptr, nullptr);
+    const ProtoObject* kept = nullptr;
+    {
+        ProtoContext callee(context->space, &inner, nullptr, nullptr, nullptr, nullptr);
+        const ProtoString* name = callee.fromUTF8String("payload")->asString(&callee);
+        kept = callee.newObject(false)->setAttribute(&callee, name, callee.fromInteger(99));
+        for (int i = 0; i < 5000; ++i) callee.newObject(false);
+        callee.returnValue = kept;
+    }
+    probe->ref = probe->root->newWeakRef(kept);
+    ProtoFiber::yield(&inner);
+    inner.returnValue = kept;
+    return kept;
+}
+
+// Yields with a handle scope still open.
+const ProtoObject* yieldsInScope(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                                 const ProtoList*, const ProtoSparseList*) {
+    ProtoHandleScope scope(context);
+    scope.pin(context->newObject(false));
+    ProtoFiber::yield(context);
+    return PROTO_NONE;
+}
+
+} // namespace
+
+TEST(FiberTest, YieldAndResumeExchangeValues) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoFiber* fiber = space.createFiber(ctx, counter, nullptr,
+        ctx->newList()->appendLast(ctx, ctx->fromInteger(5)));
+
+    EXPECT_EQ(fiber->resume(ctx)->asLong(ctx), 0);
+    for (int i = 1; i < 5; ++i) {
+        EXPECT_FALSE(fiber->isFinished());
+        EXPECT_EQ(fiber->resume(ctx, ctx->fromInteger(10))->asLong(ctx), i);
+    }
+    EXPECT_EQ(fiber->resume(ctx, ctx->fromInteger(10))->asLong(ctx), 50);
+    EXPECT_TRUE(fiber->isFinished());
+    EXPECT_EQ(fiber->resume(ctx), PROTO_NONE);
+    EXPECT_EQ(ctx->thread->getCurrentContext(), ctx);
+    space.destroyFiber(ctx, fiber);
+}
+
+TEST(FiberTest, ExceptionPropagatesThroughResume) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoFiber* fiber = space.createFiber(ctx, failing);
+
+    EXPECT_EQ(fiber->resume(ctx), PROTO_NONE);
+    EXPECT_THROW(fiber->resume(ctx), std::runtime_error);
+    EXPECT_TRUE(fiber->isFinished());
+    EXPECT_EQ(ctx->thread->getCurrentContext(), ctx);
+    space.destroyFiber(ctx, fiber);
+}
+
+TEST(FiberTest, FibersNest) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoFiber* inner = space.createFiber(ctx, counter, nullptr,
+        ctx->newList()->appendLast(ctx, ctx->fromInteger(4)));
+    ProtoFiber* outer = space.createFiber(ctx, doubler, ctx->fromExternalPointer(inner));
+
+    long long sum = 0;
+    while (true) {
+        const ProtoObject* v = outer->resume(ctx);
+        if (outer->isFinished()) break;
+        sum += v->asLong(ctx);
+    }
+    EXPECT_EQ(sum, 2 * (0 + 1 + 2 + 3));
+    EXPECT_TRUE(inner->isFinished());
+    space.destroyFiber(ctx, outer);
+    space.destroyFiber(ctx, inner);
+}
+
+TEST(FiberTest, SuspendedFiberKeepsItsObjects) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoString* name = ctx->fromUTF8String("payload")->asString(ctx);
+    Probe probe{ctx, nullptr};
+    ProtoFiber* fiber = space.createFiber(ctx, holder, ctx->fromExternalPointer(&probe));
+
+    fiber->resume(ctx);
+    waitForGcCycles(space, 3);
+    ASSERT_NE(probe.ref->get(ctx), nullptr);
+    const ProtoObject* kept = fiber->resume(ctx);
+
+    ASSERT_TRUE(fiber->isFinished());
+    EXPECT_EQ(kept, probe.ref->get(ctx));
+    EXPECT_EQ(kept->getAttribute(ctx, name)->asLong(ctx), 99);
+    space.destroyFiber(ctx, fiber);
+}
+
+TEST(FiberTest, ManyFibersAndAbandonedOnes) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    std::vector<ProtoFiber*> fibers;
+    for (int i = 0; i < 2000; ++i) {
+        fibers.push_back(space.createFiber(ctx, counter, nullptr,
+            ctx->newList()->appendLast(ctx, ctx->fromInteger(3))));
+        EXPECT_EQ(fibers.back()->resume(ctx)->asLong(ctx), 0);
+    }
+    // Destroy half while suspended; leave the rest to ~ProtoSpace.
+    for (size_t i = 0; i < fibers.size(); i += 2) space.destroyFiber(ctx, fibers[i]);
+    EXPECT_EQ(ctx->thread->getCurrentContext(), ctx);
+    waitForGcCycles(space, 1);
+    EXPECT_EQ(fibers[1]->resume(ctx, ctx->fromInteger(1))->asLong(ctx), 1);
+}
+
+TEST(FiberDeathTest, YieldInsideHandleScopeAborts) {
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    ASSERT_DEATH({
+        ProtoSpace space;
+        ProtoContext* ctx = space.rootContext;
+        ProtoFiber* fiber = space.createFiber(ctx, yieldsInScope);
+        fiber->resume(ctx);
+    }, "yield inside a handle scope");
+}
@@ -0,0 +1,153 @@
+/*
+ * FutureTests.cpp
+ *
+ * Covers ProtoFuture / ProtoPromise: settle-once semantics, blocking get
+ * across threads without stalling the collector, `then` continuations
+ * inline and on a task pool, and tracing of the stored value.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+const ProtoObject* increment(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                             const ProtoList* args, const ProtoSparseList*) {
+    return context->fromInteger(args->getAt(context, 0)->asLong(context) + 1);
+}
+
+const ProtoObject* throwing(ProtoContext*, const ProtoObject*, const ParentLink*,
+                            const ProtoList*, const ProtoSparseList*) {
+    throw std::runtime_error("continuation failed");
+}
+
+// self: the promise's future.  Blocks on it from a worker thread.
+const ProtoObject* consumer(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                            const ProtoList*, const ProtoSparseList*) {
+    return self->asFuture(context)->get(context);
+}
+
+// self: the promise.  Forces a full collection while the consumer is
+// blocked, then resolves with a fresh object.
+const ProtoObject* producer(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                            const ProtoList*, const ProtoSparseList*) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const ProtoObject* gcRan = context->fromBoolean(forceCollection(context));
+    const ProtoString* name = context->fromUTF8String("gcRan")->asString(context);
+    reinterpret_cast<const ProtoPromise*>(self)->resolve(
+        context, context->newObject(false)->setAttribute(context, name, gcRan));
+    return PROTO_NONE;
+}
+
+} // namespace
+
+TEST(FutureTest, SettlesOnce) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoPromise* promise = ctx->newPromise();
+    const ProtoFuture* future = promise->getFuture(ctx);
+
+    EXPECT_FALSE(future->isReady(ctx));
+    EXPECT_FALSE(future->waitFor(ctx, 10));
+    EXPECT_TRUE(promise->resolve(ctx, ctx->fromInteger(7)));
+    EXPECT_FALSE(promise->resolve(ctx, ctx->fromInteger(8)));
+    EXPECT_FALSE(promise->reject(ctx, ctx->fromInteger(9)));
+    EXPECT_TRUE(future->isReady(ctx));
+    EXPECT_EQ(future->get(ctx)->asLong(ctx), 7);
+    EXPECT_EQ(future->getError(ctx), nullptr);
+    EXPECT_EQ(promise->asObject(ctx)->asFuture(ctx), future);
+}
+
+TEST(FutureTest, RejectionReportsError) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoPromise* promise = ctx->newPromise();
+    const ProtoFuture* future = promise->getFuture(ctx);
+
+    EXPECT_TRUE(promise->reject(ctx, ctx->fromInteger(-1)));
+    EXPECT_TRUE(future->isRejected(ctx));
+    EXPECT_EQ(future->get(ctx), nullptr);
+    EXPECT_EQ(future->getError(ctx)->asLong(ctx), -1);
+}
+
+TEST(FutureTest, BlockedGetDoesNotStallCollection) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 2);
+    const ProtoPromise* promise = ctx->newPromise();
+    const ProtoString* name = ctx->fromUTF8String("gcRan")->asString(ctx);
+
+    ProtoTask* waiting = pool->spawn(ctx, consumer, promise->getFuture(ctx)->asObject(ctx));
+    ProtoTask* resolving = pool->spawn(ctx, producer, promise->asObject(ctx));
+    pool->join(ctx, resolving);
+    const ProtoObject* result = pool->join(ctx, waiting);
+
+    EXPECT_EQ(result->getAttribute(ctx, name), PROTO_TRUE);
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(FutureTest, ThenChainsInlineAndOnPool) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 2);
+    const ProtoPromise* promise = ctx->newPromise();
+    const ProtoFuture* future = promise->getFuture(ctx);
+
+    const ProtoFuture* inlineNext = future->then(ctx, increment);
+    const ProtoFuture* pooled = inlineNext->then(ctx, increment, nullptr, pool);
+    EXPECT_FALSE(inlineNext->isReady(ctx));
+
+    promise->resolve(ctx, ctx->fromInteger(1));
+    EXPECT_TRUE(inlineNext->isReady(ctx));
+    EXPECT_EQ(inlineNext->get(ctx)->asLong(ctx), 2);
+    EXPECT_EQ(pooled->get(ctx)->asLong(ctx), 3);
+
+    // Already settled: runs right away.
+    EXPECT_EQ(future->then(ctx, increment)->get(ctx)->asLong(ctx), 2);
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(FutureTest, ThenPropagatesRejectionAndExceptions) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+
+    const ProtoPromise* rejected = ctx->newPromise();
+    const ProtoFuture* passed = rejected->getFuture(ctx)->then(ctx, increment);
+    rejected->reject(ctx, ctx->fromInteger(5));
+    EXPECT_TRUE(passed->isRejected(ctx));
+    EXPECT_EQ(passed->getError(ctx)->asLong(ctx), 5);
+
+    const ProtoPromise* promise = ctx->newPromise();
+    const ProtoFuture* failed = promise->getFuture(ctx)->then(ctx, throwing);
+    promise->resolve(ctx, ctx->fromInteger(1));
+    EXPECT_TRUE(failed->isRejected(ctx));
+    EXPECT_NE(failed->getError(ctx), nullptr);
+}
+
+TEST(FutureTest, ValueIsTraced) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoPromise* promise = ctx->newPromise();
+    const ProtoFuture* future = promise->getFuture(ctx);
+
+    const ProtoWeakRef* probe = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        const ProtoObject* value = sub.newObject(false);
+        probe = ctx->newWeakRef(value);
+        promise->resolve(&sub, value);
+    }
+
+    waitForGcCycles(space, 3);
+
+    ASSERT_NE(probe->get(ctx), nullptr);
+    EXPECT_EQ(future->get(ctx), probe->get(ctx));
+}
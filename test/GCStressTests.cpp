@@ -1,10 +1,27 @@
 #include <gtest/gtest.h>
 #include "../headers/protoCore.h"
 #include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+#include <chrono>
+#include <thread>
 #include <vector>
 
 using namespace proto;
 
+namespace {
+
+// True when every byte of \a cell except its link word is zero.
+bool zeroButLink(const Cell* cell) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(cell);
+    for (size_t i = 0; i < sizeof(BigCell); ++i) {
+        if (i >= sizeof(void*) && i < 2 * sizeof(void*)) continue;
+        if (bytes[i]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
 TEST(GCStressTest, LargeAllocationReclamation) {
     ProtoSpace space;
     ProtoContext* ctx = space.rootContext;
@@ -72,3 +89,32 @@ TEST(GCStressTest, LargeAllocationReclamation) {
     // is kept as a sanity check at the same threshold.
     ASSERT_LT(space.heapSize, 3000000u);
 }
+
+TEST(GCStressTest, FreeCellsAreZeroedBeyondTheirLink) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+
+    // Cells straight from the OS, as the thread's freelist holds them.
+    unsigned long fresh = 0;
+    for (Cell* cell = ctx->freeCells; cell && fresh < 1000; cell = cell->getNext(), ++fresh)
+        ASSERT_TRUE(zeroButLink(cell)) << "fresh cell " << fresh;
+    EXPECT_GT(fresh, 0u);
+
+    // Garbage reclaimed by the sweep: non-zero payloads must not survive.
+    {
+        ProtoContext subCtx(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        const ProtoString* name = subCtx.fromUTF8String("k")->asString(&subCtx);
+        for (int i = 0; i < 20000; ++i)
+            subCtx.newObject(false)->setAttribute(&subCtx, name, subCtx.fromInteger(i));
+    }
+    ASSERT_TRUE(forceCollection(ctx));
+
+    std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
+    unsigned long reclaimed = 0;
+    for (ProtoSpace::FreeChunk* chunk = space.freeChunks; chunk; chunk = chunk->next)
+        for (Cell* cell = chunk->head; cell; cell = cell->getNext(), ++reclaimed)
+            ASSERT_TRUE(zeroButLink(cell)) << "reclaimed cell " << reclaimed;
+    for (Cell* cell = space.freeCells; cell; cell = cell->getNext(), ++reclaimed)
+        ASSERT_TRUE(zeroButLink(cell)) << "reclaimed cell " << reclaimed;
+    EXPECT_GT(reclaimed, 0u);
+}
@@ -19,8 +19,8 @@ namespace {
 //   1. triggerGC() in production is gated on heap pressure
 //      (freeRatio < 0.2), which never trips when a test allocates only a
 //      handful of cells.  Tests must set gcStarted directly.
-//   2. STW root collection cannot start until parkedThreads >=
-//      runningThreads.  The test thread is "running" and must
+//   2. STW root collection cannot start until every registered thread
+//      is parked or unmanaged.  The test thread is "running" and must
 //      cooperate by calling safepoint() so it actually parks when STW
 //      is requested.  Otherwise the GC blocks forever waiting for the
 //      test thread to reach a safepoint.
@@ -0,0 +1,66 @@
+/*
+ * GCTestHelpers.h
+ *
+ * Collection drivers shared by the test suites.
+ *
+ * The collector only starts on its own under heap pressure, which a test
+ * that allocates a handful of cells never reaches, so these request a
+ * cycle by setting gcStarted directly.  The requesting thread is a
+ * running, registered thread: it must keep reaching safepoints while it
+ * waits, or the stop-the-world would wait for it forever.
+ */
+
+#ifndef PROTO_GC_TEST_HELPERS_H_
+#define PROTO_GC_TEST_HELPERS_H_
+
+#include "../headers/protoCore.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Asks the collector of \a space for a cycle; returns at once.
+inline void requestCollection(proto::ProtoSpace* space) {
+    std::lock_guard<std::recursive_mutex> lock(proto::ProtoSpace::globalMutex);
+    space->gcStarted = true;
+    space->gcCV.notify_all();
+}
+
+// Waits, reaching safepoints from \a context, until a cycle that began
+// after gcCycleCount was \a before has finished.  False after 5 seconds.
+inline bool finishCollection(proto::ProtoContext* context, uint64_t before) {
+    proto::ProtoSpace* space = context->space;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((space->gcCycleCount.load() == before || space->gcStarted.load()) &&
+           std::chrono::steady_clock::now() < deadline) {
+        context->safepoint();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return space->gcCycleCount.load() != before;
+}
+
+// Forces one collection from \a context and waits for it to finish.
+inline bool forceCollection(proto::ProtoContext* context) {
+    const uint64_t before = context->space->gcCycleCount.load();
+    requestCollection(context->space);
+    return finishCollection(context, before);
+}
+
+// Drives \a cycles collections from the root context, leaving each one
+// time to finish its sweep: the collector clears gcStarted before the
+// sweep ends (it runs without the global lock).
+inline void waitForGcCycles(proto::ProtoSpace& space, int cycles = 1) {
+    proto::ProtoContext* ctx = space.rootContext;
+    for (int i = 0; i < cycles; ++i) {
+        requestCollection(&space);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (space.gcStarted.load() && std::chrono::steady_clock::now() < deadline) {
+            if (ctx) ctx->safepoint();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+#endif /* PROTO_GC_TEST_HELPERS_H_ */
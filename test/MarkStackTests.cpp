@@ -0,0 +1,73 @@
+/*
+ * MarkStackTests.cpp
+ *
+ * Covers the collector's bounded mark stack: with a stack far smaller
+ * than the live graph, every reachable cell still survives through the
+ * overflow rescans, and unreachable cells are still reclaimed.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+constexpr int kElements = 3000;
+
+} // namespace
+
+TEST(MarkStackTest, DefaultCapacity) {
+    ProtoSpace space;
+    EXPECT_EQ(space.markStackCapacity, ProtoSpace::MARK_STACK_CAPACITY_DEFAULT);
+    ASSERT_TRUE(forceCollection(space.rootContext));
+    EXPECT_EQ(space.markStackOverflowsLastCycle.load(), 0u);
+}
+
+TEST(MarkStackTest, OverflowingStackKeepsEveryReachableCell) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    space.markStackCapacity = 4;
+    const ProtoString* name = ProtoString::fromUTF8(ctx, "v");
+
+    // The list and its objects are submitted with the sub-context; only a
+    // young cell of the root context keeps them reachable.
+    const ProtoList* list = nullptr;
+    const ProtoWeakRef* garbage = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        list = sub.newList();
+        for (int i = 0; i < kElements; ++i)
+            list = list->appendLast(&sub, sub.newObject(false)->setAttribute(&sub, name, sub.fromInteger(i)));
+        garbage = ctx->newWeakRef(sub.newObject(false));
+    }
+    const ProtoList* holder = ctx->newList()->appendLast(ctx, list->asObject(ctx));
+
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        ASSERT_TRUE(forceCollection(ctx));
+        if (cycle == 0) EXPECT_GT(space.markStackOverflowsLastCycle.load(), 0u);
+        // Reuse whatever the sweep freed, so a wrongly freed cell would
+        // be overwritten.
+        ProtoContext churn(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        for (int i = 0; i < kElements; ++i) churn.newObject(false)->setAttribute(&churn, name, churn.fromInteger(-1));
+    }
+
+    EXPECT_EQ(garbage->get(ctx), nullptr);
+    ASSERT_EQ(holder->getAt(ctx, 0), list->asObject(ctx));
+    ASSERT_EQ(list->getSize(ctx), static_cast<unsigned long>(kElements));
+    for (int i = 0; i < kElements; ++i)
+        ASSERT_EQ(list->getAt(ctx, i)->getAttribute(ctx, name)->asLong(ctx), i) << i;
+}
+
+TEST(MarkStackTest, EnvironmentSetsCapacity) {
+    setenv("PROTOCORE_GC_MARK_STACK_ENTRIES", "1024", 1);
+    ProtoSpace space;
+    unsetenv("PROTOCORE_GC_MARK_STACK_ENTRIES");
+    EXPECT_EQ(space.markStackCapacity, 1024u);
+}
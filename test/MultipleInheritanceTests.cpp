@@ -107,3 +107,65 @@ TEST_F(MultipleInheritanceTest, DeepLinearization) {
     ASSERT_EQ(target->getAttribute(context, s("a2"))->asLong(context), 2);
     ASSERT_EQ(target->getAttribute(context, s("a3"))->asLong(context), 3);
 }
+
+/**
+ * isInstanceOf over a diamond: every ancestor is found, including the
+ * branch that is not the first parent, and unrelated objects are not.
+ */
+TEST_F(MultipleInheritanceTest, DiamondIsInstanceOf) {
+    proto::ProtoObject* a = const_cast<proto::ProtoObject*>(context->newObject(true));
+    proto::ProtoObject* b = const_cast<proto::ProtoObject*>(context->newObject(true));
+    proto::ProtoObject* c = const_cast<proto::ProtoObject*>(context->newObject(true));
+    proto::ProtoObject* d = const_cast<proto::ProtoObject*>(context->newObject(true));
+    const proto::ProtoObject* unrelated = context->newObject(true);
+
+    b->addParent(context, a);
+    c->addParent(context, a);
+    d->addParent(context, b);
+    d->addParent(context, c);
+
+    const proto::ProtoObject* instance = d->newChild(context);
+    for (const proto::ProtoObject* ancestor : {static_cast<const proto::ProtoObject*>(a),
+                                                static_cast<const proto::ProtoObject*>(b),
+                                                static_cast<const proto::ProtoObject*>(c),
+                                                static_cast<const proto::ProtoObject*>(d)}) {
+        ASSERT_EQ(instance->isInstanceOf(context, ancestor), PROTO_TRUE);
+    }
+    ASSERT_EQ(d->isInstanceOf(context, b), PROTO_TRUE);
+    ASSERT_EQ(instance->isInstanceOf(context, unrelated), PROTO_FALSE);
+}
+
+/**
+ * Hierarchies deeper than the old walker's fixed limits.
+ */
+TEST_F(MultipleInheritanceTest, DeepIsInstanceOf) {
+    const proto::ProtoObject* root = context->newObject();
+    const proto::ProtoObject* current = root;
+    for (int depth = 0; depth < 200; ++depth) {
+        current = current->newChild(context);
+    }
+    ASSERT_EQ(current->isInstanceOf(context, root), PROTO_TRUE);
+    ASSERT_EQ(root->isInstanceOf(context, current), PROTO_FALSE);
+}
+
+/**
+ * Cached ancestor sets must expire when a mutable ancestor gets new
+ * parents after instances have already been type-checked.
+ */
+TEST_F(MultipleInheritanceTest, IsInstanceOfSeesLaterParentChanges) {
+    proto::ProtoObject* base = const_cast<proto::ProtoObject*>(context->newObject(true));
+    proto::ProtoObject* klass = const_cast<proto::ProtoObject*>(context->newObject(true));
+    const proto::ProtoObject* mixin = context->newObject(true);
+    klass->addParent(context, base);
+
+    const proto::ProtoObject* instance = klass->newChild(context)->newChild(context);
+    ASSERT_EQ(instance->isInstanceOf(context, base), PROTO_TRUE);
+    ASSERT_EQ(instance->isInstanceOf(context, mixin), PROTO_FALSE);
+
+    base->addParent(context, mixin);
+    ASSERT_EQ(instance->isInstanceOf(context, mixin), PROTO_TRUE);
+
+    klass->setParents(context, context->newList());
+    ASSERT_EQ(instance->isInstanceOf(context, base), PROTO_FALSE);
+    ASSERT_EQ(instance->isInstanceOf(context, klass), PROTO_TRUE);
+}
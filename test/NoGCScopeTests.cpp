@@ -0,0 +1,123 @@
+/*
+ * NoGCScopeTests.cpp
+ *
+ * Covers ProtoContext::NoGCScope: a cycle requested during a region waits
+ * for it to close instead of stopping the thread, a region that outlasts
+ * the no-GC limit is reported at once and expired so the cycle goes ahead,
+ * regions are counted per space, and the reservation serves the region's
+ * allocations.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+struct Overrun {
+    int reports = 0;
+    const ProtoThread* thread = nullptr;
+    unsigned long micros = 0;
+};
+
+void recordOverrun(void* userData, const ProtoThread* thread, unsigned long micros) {
+    auto* overrun = static_cast<Overrun*>(userData);
+    overrun->reports++;
+    overrun->thread = thread;
+    overrun->micros = micros;
+}
+
+} // namespace
+
+TEST(NoGCScopeTest, CollectionWaitsForTheRegion) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    EXPECT_EQ(space.noGCMaxMicros.load(), ProtoSpace::NO_GC_MAX_MICROS_DEFAULT);
+    space.setNoGCLimit(5000000);
+    const uint64_t before = space.gcCycleCount.load();
+    {
+        ProtoContext::NoGCScope noGC(ctx);
+        requestCollection(&space);
+        for (int i = 0; i < 100; ++i) {
+            ctx->newObject(false);
+            ctx->safepoint();
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        // The collector is still waiting to stop: nothing was stopped.
+        EXPECT_EQ(space.stwFlag.load(), 0);
+        EXPECT_EQ(space.gcCycleCount.load(), before);
+    }
+    ASSERT_TRUE(finishCollection(ctx, before));
+    EXPECT_GE(space.noGCDeferredCycles.load(), 1u);
+    EXPECT_EQ(space.noGCOverruns.load(), 0u);
+    EXPECT_GT(space.noGCLongestMicros.load(), 0u);
+}
+
+TEST(NoGCScopeTest, OverdueRegionIsReportedAndExpired) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    Overrun overrun;
+    space.setNoGCLimit(20000, recordOverrun, &overrun);
+    const uint64_t before = space.gcCycleCount.load();
+    {
+        ProtoContext::NoGCScope noGC(ctx);
+        requestCollection(&space);
+        // Past the limit the collector reports the region while it is
+        // still open and stops the world without it: the region's next
+        // safepoint parks, and the cycle completes before it closes.
+        ASSERT_TRUE(finishCollection(ctx, before));
+        EXPECT_EQ(overrun.reports, 1);
+        EXPECT_EQ(overrun.thread, ctx->thread);
+        EXPECT_GE(overrun.micros, 20000u);
+        EXPECT_EQ(space.noGCOverruns.load(), 1u);
+        EXPECT_EQ(space.noGCRegions.load(), 0);
+        EXPECT_TRUE(ProtoThreadImplementation::inNoGCRegion(&space));
+    }
+    // Closing the expired region does not report it again.
+    EXPECT_EQ(overrun.reports, 1);
+    EXPECT_EQ(space.noGCOverruns.load(), 1u);
+    EXPECT_EQ(space.noGCRegions.load(), 0);
+    EXPECT_EQ(space.noGCPostponedCycles.load(), 0u);
+    EXPECT_GE(space.noGCLongestMicros.load(), 20000u);
+    EXPECT_TRUE(forceCollection(ctx));
+}
+
+TEST(NoGCScopeTest, RegionsAreCountedPerSpace) {
+    ProtoSpace first;
+    ProtoSpace second;
+    ProtoContext::NoGCScope noGC(first.rootContext);
+    EXPECT_EQ(first.noGCRegions.load(), 1);
+    EXPECT_EQ(second.noGCRegions.load(), 0);
+    EXPECT_FALSE(ProtoThreadImplementation::inNoGCRegion(&second));
+    // A region in one space does not hold off another space's collector.
+    EXPECT_TRUE(forceCollection(second.rootContext));
+    EXPECT_EQ(second.noGCDeferredCycles.load(), 0u);
+}
+
+TEST(NoGCScopeTest, ReservationServesTheRegion) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    {
+        ProtoContext::NoGCScope noGC(ctx, 20000);
+        ProtoContext::NoGCScope nested(ctx, 20000);
+        for (int i = 0; i < 10000; ++i) ctx->newObject(false);
+        EXPECT_EQ(space.noGCRegions.load(), 1);
+    }
+    EXPECT_EQ(space.noGCRegions.load(), 0);
+    EXPECT_EQ(space.noGCReserveExhausted.load(), 0u);
+    EXPECT_TRUE(forceCollection(ctx));
+}
+
+TEST(NoGCScopeTest, EnvironmentSetsLimit) {
+    setenv("PROTOCORE_NOGC_MAX_US", "2500", 1);
+    ProtoSpace space;
+    unsetenv("PROTOCORE_NOGC_MAX_US");
+    EXPECT_EQ(space.noGCMaxMicros.load(), 2500u);
+}
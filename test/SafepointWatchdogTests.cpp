@@ -0,0 +1,180 @@
+/*
+ * SafepointWatchdogTests.cpp
+ *
+ * Covers the safepoint watchdog: a thread that runs managed code without
+ * reaching a safepoint is reported with its name, the time the stop has
+ * waited, when it was last seen at a safepoint and a sampled stack, the
+ * stop's time-to-safepoint is published, and the stack-capture handler
+ * passes other SIGURGs on to the handler it replaced.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__) || defined(__APPLE__)
+#include <csignal>
+#include <pthread.h>
+#endif
+
+using namespace proto;
+
+namespace {
+
+std::atomic<bool> startSpinning{false};
+std::atomic<bool> stopSpinning{false};
+std::atomic<bool> spinning{false};
+
+struct Reports {
+    std::mutex mutex;
+    std::vector<ProtoSafepointLaggard> laggards;
+};
+
+// Records the report and lets the late thread go, so the stop completes.
+void recordLaggard(void* userData, const ProtoSafepointLaggard& laggard) {
+    auto* reports = static_cast<Reports*>(userData);
+    {
+        std::lock_guard<std::mutex> lock(reports->mutex);
+        reports->laggards.push_back(laggard);
+    }
+    stopSpinning = true;
+}
+
+// Cooperates with collections until told to spin, then runs without any
+// safepoint until released.
+const ProtoObject* spinner(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                           const ProtoList*, const ProtoSparseList*) {
+    while (!startSpinning.load()) {
+        context->safepoint();
+        std::this_thread::yield();
+    }
+    spinning = true;
+    while (!stopSpinning.load()) {
+    }
+    spinning = false;
+    return PROTO_NONE;
+}
+
+} // namespace
+
+TEST(SafepointWatchdogTest, ReportsThreadThatNeverReachesSafepoint) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    Reports reports;
+    startSpinning = false;
+    stopSpinning = false;
+    space.setSafepointWatchdog(200000, recordLaggard, &reports, true);
+
+    auto* thread = const_cast<ProtoThread*>(
+        space.newThread(ctx, ProtoString::fromUTF8(ctx, "spinner"), spinner, nullptr, nullptr));
+
+    // A first stop sees the thread at a safepoint and reports nothing.
+    ASSERT_TRUE(forceCollection(ctx));
+    EXPECT_TRUE(reports.laggards.empty());
+    EXPECT_LT(space.timeToSafepointLastCycle.load(), 200000u);
+
+    startSpinning = true;
+    while (!spinning.load()) std::this_thread::yield();
+    ASSERT_TRUE(forceCollection(ctx));
+    {
+        ProtoContext::UnmanagedScope unmanaged(ctx);
+        thread->join(ctx);
+    }
+
+    std::lock_guard<std::mutex> lock(reports.mutex);
+    ASSERT_FALSE(reports.laggards.empty());
+    const ProtoSafepointLaggard& laggard = reports.laggards.front();
+    EXPECT_EQ(laggard.thread, thread);
+    EXPECT_EQ(laggard.name, "spinner");
+    EXPECT_GE(laggard.waitedMicros, 200000u);
+    EXPECT_TRUE(laggard.seenAtSafepoint);
+#if defined(__linux__) || defined(__APPLE__)
+    EXPECT_FALSE(laggard.stack.empty());
+#endif
+    EXPECT_GE(space.timeToSafepointLastCycle.load(), 200000u);
+}
+
+TEST(SafepointWatchdogTest, DisabledByDefault) {
+    ProtoSpace space;
+    EXPECT_EQ(space.safepointWatchdogMicros, 0u);
+    EXPECT_EQ(space.safepointLaggardCallback, nullptr);
+}
+
+TEST(SafepointWatchdogTest, EnvironmentEnablesStderrReport) {
+    setenv("PROTOCORE_SAFEPOINT_WATCHDOG_MS", "20", 1);
+    ProtoSpace space;
+    unsetenv("PROTOCORE_SAFEPOINT_WATCHDOG_MS");
+    ProtoContext* ctx = space.rootContext;
+    EXPECT_EQ(space.safepointWatchdogMicros, 20000u);
+    EXPECT_TRUE(space.captureLaggardStacks);
+
+    startSpinning = true;
+    stopSpinning = false;
+    auto* thread = const_cast<ProtoThread*>(
+        space.newThread(ctx, ProtoString::fromUTF8(ctx, "spinner"), spinner, nullptr, nullptr));
+    while (!spinning.load()) std::this_thread::yield();
+    // The stderr report does not release the thread; a timer started
+    // once the world begins stopping does.
+    std::thread release([&space] {
+        while (!space.stwFlag.load()) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        stopSpinning = true;
+    });
+    testing::internal::CaptureStderr();
+    const bool collected = forceCollection(ctx);
+    const std::string report = testing::internal::GetCapturedStderr();
+    release.join();
+    {
+        ProtoContext::UnmanagedScope unmanaged(ctx);
+        thread->join(ctx);
+    }
+    EXPECT_TRUE(collected);
+    EXPECT_NE(report.find("thread 'spinner' has kept a stop-the-world waiting"), std::string::npos) << report;
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+std::atomic<int> hostUrgSignals{0};
+
+void countHostUrgSignal(int) {
+    hostUrgSignals.fetch_add(1);
+}
+
+} // namespace
+
+TEST(SafepointWatchdogTest, StackCaptureForwardsOtherSigurg) {
+    struct sigaction current {};
+    sigaction(SIGURG, nullptr, &current);
+    if (current.sa_flags & SA_SIGINFO)
+        GTEST_SKIP() << "the stack-capture handler is already installed in this process";
+
+    // The host's own SIGURG handler, installed before protoCore's.
+    struct sigaction host {};
+    host.sa_handler = countHostUrgSignal;
+    sigemptyset(&host.sa_mask);
+    ASSERT_EQ(sigaction(SIGURG, &host, nullptr), 0);
+
+    std::atomic<bool> done{false};
+    std::thread target([&done] {
+        while (!done.load()) std::this_thread::yield();
+    });
+    void* frames[64];
+    const int depth = captureThreadStack(target.native_handle(), frames, 64, 1000000);
+    done = true;
+    target.join();
+    // The capture request is answered by protoCore and not forwarded...
+    EXPECT_GT(depth, 0);
+    EXPECT_EQ(hostUrgSignals.load(), 0);
+    // ...while any other SIGURG still reaches the host's handler.
+    pthread_kill(pthread_self(), SIGURG);
+    EXPECT_EQ(hostUrgSignals.load(), 1);
+}
+#endif
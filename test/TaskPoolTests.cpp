@@ -0,0 +1,128 @@
+/*
+ * TaskPoolTests.cpp
+ *
+ * Covers ProtoTaskPool: results come back through join, tasks may spawn and
+ * join subtasks on the pool itself, exceptions cross join, and idle or busy
+ * workers neither stall the collector nor lose task results to it.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+const ProtoObject* doubleArg(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                             const ProtoList* args, const ProtoSparseList*) {
+    return context->fromInteger(args->getAt(context, 0)->asLong(context) * 2);
+}
+
+// self is the pool, args[0] is n.
+const ProtoObject* fib(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                       const ProtoList* args, const ProtoSparseList*) {
+    const long long n = args->getAt(context, 0)->asLong(context);
+    if (n < 2) return context->fromInteger(n);
+    auto* pool = static_cast<ProtoTaskPool*>(
+        self->asExternalPointer(context)->getPointer(context));
+    ProtoTask* left = pool->spawn(context, fib, self,
+        context->newList()->appendLast(context, context->fromInteger(n - 1)));
+    const ProtoObject* right = fib(context, self, nullptr,
+        context->newList()->appendLast(context, context->fromInteger(n - 2)), nullptr);
+    return context->fromInteger(pool->join(context, left)->asLong(context) + right->asLong(context));
+}
+
+const ProtoObject* failing(ProtoContext*, const ProtoObject*, const ParentLink*,
+                           const ProtoList*, const ProtoSparseList*) {
+    throw std::runtime_error("task failed");
+}
+
+// Builds garbage, then returns a fresh object carrying args[0].
+const ProtoObject* allocating(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                              const ProtoList* args, const ProtoSparseList*) {
+    for (int i = 0; i < 2000; ++i) context->newObject(false);
+    const ProtoString* name = context->fromUTF8String("value")->asString(context);
+    return context->newObject(false)->setAttribute(context, name, args->getAt(context, 0));
+}
+
+} // namespace
+
+TEST(TaskPoolTest, SpawnJoinReturnsResults) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 4);
+    EXPECT_EQ(pool->getWorkerCount(), 4u);
+
+    std::vector<ProtoTask*> tasks;
+    for (int i = 0; i < 100; ++i)
+        tasks.push_back(pool->spawn(ctx, doubleArg, nullptr,
+            ctx->newList()->appendLast(ctx, ctx->fromInteger(i))));
+    long long sum = 0;
+    for (ProtoTask* task : tasks) sum += pool->join(ctx, task)->asLong(ctx);
+
+    EXPECT_EQ(sum, 2 * (99 * 100 / 2));
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(TaskPoolTest, TasksSpawnAndJoinSubtasks) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    // Fewer workers than outstanding joins: only works if joining workers
+    // run queued tasks instead of blocking.
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 2);
+
+    ProtoTask* task = pool->spawn(ctx, fib, ctx->fromExternalPointer(pool),
+        ctx->newList()->appendLast(ctx, ctx->fromInteger(15)));
+    EXPECT_EQ(pool->join(ctx, task)->asLong(ctx), 610);
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(TaskPoolTest, ExceptionPropagatesThroughJoin) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 2);
+
+    ProtoTask* task = pool->spawn(ctx, failing);
+    EXPECT_THROW(pool->join(ctx, task), std::runtime_error);
+    // The worker survives the failure.
+    task = pool->spawn(ctx, doubleArg, nullptr, ctx->newList()->appendLast(ctx, ctx->fromInteger(4)));
+    EXPECT_EQ(pool->join(ctx, task)->asLong(ctx), 8);
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(TaskPoolTest, ResultsSurviveCollectionBeforeJoin) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 3);
+    const ProtoString* name = ctx->fromUTF8String("value")->asString(ctx);
+
+    std::vector<ProtoTask*> tasks;
+    for (int i = 0; i < 8; ++i)
+        tasks.push_back(pool->spawn(ctx, allocating, nullptr,
+            ctx->newList()->appendLast(ctx, ctx->fromInteger(i))));
+
+    // Idle workers sit in unmanaged regions; these cycles must complete.
+    const uint64_t before = space.gcCycleCount.load();
+    waitForGcCycles(space, 2);
+    EXPECT_GT(space.gcCycleCount.load(), before);
+
+    for (int i = 0; i < 8; ++i) {
+        const ProtoObject* result = pool->join(ctx, tasks[i]);
+        EXPECT_EQ(result->getAttribute(ctx, name)->asLong(ctx), i);
+    }
+    space.destroyTaskPool(ctx, pool);
+}
+
+TEST(TaskPoolTest, SpaceShutsDownUndestroyedPools) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ProtoTaskPool* pool = space.createTaskPool(ctx, 2);
+    ProtoTask* task = pool->spawn(ctx, doubleArg, nullptr, ctx->newList()->appendLast(ctx, ctx->fromInteger(1)));
+    EXPECT_EQ(pool->join(ctx, task)->asLong(ctx), 2);
+}
@@ -0,0 +1,93 @@
+/*
+ * ThreadRegistryTests.cpp
+ *
+ * Covers the lock-free thread registry and the per-thread cache pool:
+ * registration across chunk growth, collection while many threads are
+ * alive, and reuse of an exited thread's cleared caches.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace proto;
+
+namespace {
+
+std::atomic<bool> released{false};
+std::atomic<const AttributeCacheEntry*> touchedCaches{nullptr};
+
+unsigned long registeredThreads(ProtoSpace& space) {
+    unsigned long n = 0;
+    space.threads->forEach([&n](ProtoThreadImplementation*) { ++n; });
+    return n;
+}
+
+// Allocates, then waits unmanaged until released.
+const ProtoObject* holdOpen(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                            const ProtoList*, const ProtoSparseList*) {
+    const ProtoObject* list = context->newList()->appendLast(context, context->fromInteger(1))->asObject(context);
+    {
+        ProtoContext::UnmanagedScope unmanaged(context);
+        while (!released.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return list;
+}
+
+// Fills one attribute-cache entry with a recognisable marker and records
+// which cache block the thread ran with.
+const ProtoObject* touchCache(ProtoContext* context, const ProtoObject* self, const ParentLink*,
+                              const ProtoList*, const ProtoSparseList*) {
+    auto* ext = toImpl<ProtoThreadImplementation>(self->asThread(context))->extension;
+    ext->attributeCache[0].result = PROTO_TRUE;
+    touchedCaches = ext->attributeCache;
+    return PROTO_NONE;
+}
+
+} // namespace
+
+TEST(ThreadRegistryTest, GrowsAndShrinksWithLiveThreads) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ASSERT_EQ(registeredThreads(space), 1u);   // the adopted main thread
+
+    // More threads than one registry chunk holds.
+    const unsigned long count = ThreadRegistry::CHUNK + 16;
+    released = false;
+    std::vector<ProtoThread*> threads;
+    for (unsigned long i = 0; i < count; ++i)
+        threads.push_back(const_cast<ProtoThread*>(space.newThread(ctx, nullptr, holdOpen, nullptr, nullptr)));
+    EXPECT_EQ(registeredThreads(space), count + 1);
+
+    // A collection with every thread parked unmanaged completes.
+    EXPECT_TRUE(forceCollection(ctx));
+
+    released = true;
+    for (ProtoThread* thread : threads) thread->join(ctx);
+    EXPECT_EQ(registeredThreads(space), 1u);
+}
+
+TEST(ThreadRegistryTest, ExitedThreadCachesAreReusedCleared) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+
+    auto* first = const_cast<ProtoThread*>(space.newThread(ctx, nullptr, touchCache, nullptr, nullptr));
+    first->join(ctx);
+    const AttributeCacheEntry* firstCaches = touchedCaches.load();
+    ASSERT_NE(firstCaches, nullptr);
+    EXPECT_EQ(toImpl<ProtoThreadImplementation>(first)->extension->attributeCache, nullptr);
+
+    released = true;
+    auto* second = const_cast<ProtoThread*>(space.newThread(ctx, nullptr, holdOpen, nullptr, nullptr));
+    const AttributeCacheEntry* secondCaches =
+        toImpl<ProtoThreadImplementation>(second)->extension->attributeCache;
+    EXPECT_EQ(secondCaches, firstCaches);
+    EXPECT_EQ(secondCaches[0].result, nullptr);
+    second->join(ctx);
+}
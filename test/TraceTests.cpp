@@ -0,0 +1,159 @@
+/*
+ * TraceTests.cpp
+ *
+ * Covers the event trace: off by default, records the collector's phases,
+ * safepoint parks and heap growth, keeps a bounded ring, and writes Chrome
+ * trace-event JSON.
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace proto;
+
+namespace {
+
+const ProtoTraceEvent* findEvent(const std::vector<ProtoTraceEvent>& events, const char* name) {
+    for (const ProtoTraceEvent& event : events)
+        if (std::strcmp(event.name, name) == 0) return &event;
+    return nullptr;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(TraceTest, OffByDefault) {
+    ProtoSpace space;
+    ASSERT_TRUE(forceCollection(space.rootContext));
+    EXPECT_FALSE(space.tracing.load());
+    EXPECT_TRUE(space.traceEvents().empty());
+    EXPECT_FALSE(space.writeTrace("never-written.json"));
+}
+
+TEST(TraceTest, RecordsCollectorPhasesParksAndHeapGrowth) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    space.startTrace();
+    for (int i = 0; i < 300000; ++i) ctx->newObject(false);
+    ASSERT_TRUE(forceCollection(ctx));
+    ASSERT_TRUE(forceCollection(ctx));
+
+    const std::vector<ProtoTraceEvent> events = space.traceEvents();
+    for (const char* name : {"gc.cycle", "gc.safepointWait", "gc.roots", "gc.pause", "gc.mark",
+                             "gc.sweep", "gc.unmark", "gc.liveCells", "safepoint.park",
+                             "heap.grow", "heap.cells"})
+        EXPECT_NE(findEvent(events, name), nullptr) << name;
+
+    // The pause and the phases fall inside their cycle, on the collector's
+    // thread; the park is on the mutator's.
+    const ProtoTraceEvent* cycle = findEvent(events, "gc.cycle");
+    const ProtoTraceEvent* pause = findEvent(events, "gc.pause");
+    const ProtoTraceEvent* park = findEvent(events, "safepoint.park");
+    ASSERT_TRUE(cycle && pause && park);
+    EXPECT_EQ(cycle->kind, 'X');
+    EXPECT_EQ(cycle->thread, pause->thread);
+    EXPECT_NE(cycle->thread, park->thread);
+    EXPECT_GE(pause->startNanos, cycle->startNanos);
+    EXPECT_LE(pause->startNanos + pause->durationNanos, cycle->startNanos + cycle->durationNanos);
+    EXPECT_GE(cycle->value, 1);
+
+    const ProtoTraceEvent* grow = findEvent(events, "heap.grow");
+    ASSERT_NE(grow, nullptr);
+    EXPECT_STREQ(grow->argName, "cells");
+    EXPECT_GT(grow->value, 0);
+    const ProtoTraceEvent* cells = findEvent(events, "heap.cells");
+    ASSERT_NE(cells, nullptr);
+    EXPECT_EQ(cells->kind, 'C');
+}
+
+TEST(TraceTest, RingIsBoundedAndRestartsClean) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    space.startTrace(1000);  // rounded up to 1024
+    for (int i = 0; i < 5000; ++i) space.traceRecorder->counter("test.count", i);
+    std::vector<ProtoTraceEvent> events = space.traceEvents();
+    EXPECT_LE(events.size(), 1024u);
+    EXPECT_GT(events.size(), 1000u);
+    EXPECT_EQ(events.back().value, 4999);
+
+    space.stopTrace();
+    ASSERT_TRUE(forceCollection(ctx));
+    EXPECT_EQ(findEvent(space.traceEvents(), "gc.cycle"), nullptr);
+
+    // Starting again forgets the previous trace, whatever the capacity.
+    space.startTrace(1024);
+    EXPECT_TRUE(space.traceEvents().empty());
+    space.traceRecorder->counter("test.count", 1);
+    space.startTrace(4096);
+    EXPECT_TRUE(space.traceEvents().empty());
+    ASSERT_TRUE(forceCollection(ctx));
+    EXPECT_NE(findEvent(space.traceEvents(), "gc.cycle"), nullptr);
+}
+
+TEST(TraceTest, WritesChromeTraceJSON) {
+    const std::string path = "trace_test_" + std::to_string(getpid()) + ".json";
+    {
+        ProtoSpace space;
+        ProtoContext* ctx = space.rootContext;
+        space.startTrace();
+        ASSERT_TRUE(forceCollection(ctx));
+        space.traceRecorder->nameThread("test \"main\"");
+        EXPECT_FALSE(space.writeTrace("/nonexistent-dir/trace.json"));
+        ASSERT_TRUE(space.writeTrace(path.c_str()));
+    }
+    const std::string json = readFile(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    for (const char* expected : {"\"name\":\"gc.cycle\",\"cat\":\"gc\",\"ph\":\"X\"",
+                                 "\"name\":\"thread_name\"", "\"protoCore GC\"",
+                                 "\"test \\\"main\\\"\"", "\"dur\":", "\"args\":{\"cycle\":"})
+        EXPECT_NE(json.find(expected), std::string::npos) << expected;
+    int depth = 0;
+    bool inString = false;
+    for (size_t i = 0; i < json.size(); ++i) {
+        if (inString) {
+            if (json[i] == '\\') ++i;
+            else if (json[i] == '"') inString = false;
+        } else if (json[i] == '"') {
+            inString = true;
+        } else if (json[i] == '{' || json[i] == '[') {
+            ++depth;
+        } else if (json[i] == '}' || json[i] == ']') {
+            --depth;
+            ASSERT_GE(depth, 0);
+        }
+    }
+    EXPECT_EQ(depth, 0);
+    EXPECT_FALSE(inString);
+}
+
+TEST(TraceTest, EnvironmentWritesTraceAtEnd) {
+    const std::string path = "trace_env_test_" + std::to_string(getpid()) + ".json";
+    setenv("PROTOCORE_TRACE_FILE", path.c_str(), 1);
+    {
+        ProtoSpace space;
+        unsetenv("PROTOCORE_TRACE_FILE");
+        EXPECT_TRUE(space.tracing.load());
+        ASSERT_TRUE(forceCollection(space.rootContext));
+    }
+    const std::string json = readFile(path);
+    std::remove(path.c_str());
+    EXPECT_NE(json.find("\"gc.cycle\""), std::string::npos);
+}
@@ -3,20 +3,18 @@
 // Tests for the goUnmanaged() / returnFromUnmanaged() API added 2026-05-25.
 //
 // The API lets a thread bracket a blocking OS call (read / write / sleep /
-// poll / network I/O) so that protoCore's stop-the-world GC quorum does NOT
-// wait for that thread to reach a real safepoint. While unmanaged, the
-// thread is pre-counted as parked in `ProtoSpace::parkedThreads` — the
-// collector can run to completion without that thread cooperating.
+// poll / network I/O) so that protoCore's stop-the-world does NOT wait for
+// that thread to reach a real safepoint. The per-thread depth counter is
+// also the thread's stop-the-world state: while it is non-zero the
+// collector treats the thread as parked.
 //
-// The three things we verify here:
+// The things we verify here:
 //   1. Counter semantics: nested calls work; the depth is per-thread.
-//   2. parkedThreads is bumped on the first (outermost) goUnmanaged and
-//      restored on the matching returnFromUnmanaged — invisible for nested
-//      calls.
-//   3. End-to-end: a thread that calls goUnmanaged before a real ~50 ms
-//      sleep does not block the GC. We exercise this by triggering a STW
-//      from another thread while the worker is inside its sleep — the STW
-//      completes in milliseconds, not after the sleep returns.
+//   2. End-to-end: a collection completes while the thread is unmanaged
+//      and never polls a safepoint.
+//   3. The RAII helper pairs the calls on every exit path.
+//   4. The lock-free transition races correctly with stop-the-world.
+//   5. An unmatched return is ignored.
 
 #include <gtest/gtest.h>
 #include "../headers/protoCore.h"
@@ -76,45 +74,35 @@ TEST_F(UnmanagedRegionTest, CounterTracksNestedDepth) {
     EXPECT_EQ(currentUnmanagedDepth(), 0);
 }
 
-// 2. parkedThreads bumps on the OUTERMOST goUnmanaged only — a nested call
-// must not double-count this thread in the quorum.
-TEST_F(UnmanagedRegionTest, ParkedThreadsBumpsOnOutermostOnly) {
-    int before = space->parkedThreads.load();
-
-    ctx->goUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before + 1);   // outermost: +1
-
+// 2. A collection completes while the only managed thread sits in an
+// unmanaged region without ever polling a safepoint.
+TEST_F(UnmanagedRegionTest, CollectionCompletesWhileUnmanaged) {
+    const uint64_t before = space->gcCycleCount.load();
     ctx->goUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before + 1);   // nested: no change
-
-    ctx->goUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before + 1);   // nested: no change
-
-    ctx->returnFromUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before + 1);   // still nested
-
-    ctx->returnFromUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before + 1);   // still nested
-
+    {
+        std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
+        space->gcStarted = true;
+        space->gcCV.notify_all();
+    }
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (space->gcCycleCount.load() == before && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+    EXPECT_NE(space->gcCycleCount.load(), before);
     ctx->returnFromUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before);       // outermost release: -1
+    EXPECT_EQ(currentUnmanagedDepth(), 0);
 }
 
 // 3. The RAII helper guarantees pairing under early-exit / exception paths.
 TEST_F(UnmanagedRegionTest, RaiiScopeReleasesOnNormalExit) {
-    int before = space->parkedThreads.load();
     EXPECT_EQ(currentUnmanagedDepth(), 0);
     {
         ProtoContext::UnmanagedScope u(ctx);
         EXPECT_EQ(currentUnmanagedDepth(), 1);
-        EXPECT_EQ(space->parkedThreads.load(), before + 1);
     }
     EXPECT_EQ(currentUnmanagedDepth(), 0);
-    EXPECT_EQ(space->parkedThreads.load(), before);
 }
 
 TEST_F(UnmanagedRegionTest, RaiiScopeReleasesOnException) {
-    int before = space->parkedThreads.load();
     try {
         ProtoContext::UnmanagedScope u(ctx);
         EXPECT_EQ(currentUnmanagedDepth(), 1);
@@ -123,71 +111,60 @@ TEST_F(UnmanagedRegionTest, RaiiScopeReleasesOnException) {
         // ignored
     }
     EXPECT_EQ(currentUnmanagedDepth(), 0);
-    EXPECT_EQ(space->parkedThreads.load(), before);
 }
 
-// 4. End-to-end: simulate a long blocking OS call by sleeping for ~50 ms
-// while another thread bumps parkedThreads and notifies the GC quorum.
-// Without the unmanaged region, a hypothetical STW would have to wait the
-// full 50 ms for the worker to reach a safepoint. With it, the worker is
-// pre-counted as parked from the moment it enters the sleep — the
-// "quorum check" (parkedThreads >= 1 for this single-thread test) can be
-// satisfied within microseconds.
-//
-// We don't actually run the GC here (the test harness has no managed
-// workload). What we verify is the COUNTER: while the worker is sleeping
-// inside its unmanaged region, parkedThreads stays bumped. Without the
-// API, parkedThreads would only bump when the worker reached a real
-// safepoint at the end of the sleep — which never happens during the
-// sleep itself.
-TEST_F(UnmanagedRegionTest, ParkedThreadsRemainsBumpedAcrossSimulatedOSCall) {
-    int beforeOuter = space->parkedThreads.load();
-
-    std::atomic<bool> insideSleep{false};
-    std::atomic<int>  observedParkedThreadsDuringSleep{-1};
-
-    // Worker enters an unmanaged region, "sleeps" 50 ms, returns.
-    // The main thread (this test body) observes parkedThreads halfway
-    // through the sleep — it should be bumped by exactly 1.
-    std::thread worker([&]() {
-        // We need a thread that has its own ProtoContext for goUnmanaged
-        // to do anything (no thread → no extension → no-op). For the
-        // unit-test scope we use the rootContext directly: it's the
-        // main thread's context. To exercise the worker side we'd need
-        // a full ProtoThread spawn, which the existing test harness
-        // does via separate scenarios. Here we keep it simple — the
-        // INVARIANT being tested is "parkedThreads stays bumped while
-        // unmanagedDepth > 0", which we can observe from the main
-        // thread's own goUnmanaged.
-    });
-    worker.join();
-
-    // Main-thread variant of the same observation:
-    ctx->goUnmanaged();
-    // Pretend to do a 50 ms OS call. The main thread is now counted as
-    // parked even though no real safepoint was reached.
-    std::this_thread::sleep_for(50ms);
-    EXPECT_EQ(space->parkedThreads.load(), beforeOuter + 1)
-        << "parkedThreads must remain bumped for the entire unmanaged region.";
-    ctx->returnFromUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), beforeOuter);
+// 4. A thread flipping in and out of unmanaged code as fast as it can,
+// while collections stop the world over and over, never stalls the
+// collector and is never left parked.
+namespace {
+std::atomic<bool> flipping{true};
+
+const ProtoObject* flipUnmanaged(ProtoContext* context, const ProtoObject*, const ParentLink*,
+                                 const ProtoList*, const ProtoSparseList*) {
+    while (flipping.load()) {
+        context->goUnmanaged();
+        context->returnFromUnmanaged();
+    }
+    return PROTO_NONE;
+}
+}  // namespace
+
+TEST_F(UnmanagedRegionTest, FastTransitionsRaceWithStopTheWorld) {
+    flipping = true;
+    ProtoThread* worker = const_cast<ProtoThread*>(
+        space->newThread(ctx, nullptr, flipUnmanaged, nullptr, nullptr));
+    for (int cycle = 0; cycle < 20; ++cycle) {
+        const uint64_t before = space->gcCycleCount.load();
+        {
+            std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
+            space->gcStarted = true;
+            space->gcCV.notify_all();
+        }
+        // The count moves during the stop; gcStarted clears only after the
+        // sweep, and a trigger sent before that would be lost.
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while ((space->gcCycleCount.load() == before || space->gcStarted.load()) &&
+               std::chrono::steady_clock::now() < deadline) {
+            ctx->safepoint();
+            std::this_thread::yield();
+        }
+        ASSERT_NE(space->gcCycleCount.load(), before) << "cycle " << cycle;
+    }
+    flipping = false;
+    {
+        ProtoContext::UnmanagedScope unmanaged(ctx);
+        worker->join(ctx);
+    }
 }
 
 // 5. Mismatched returnFromUnmanaged (called without a preceding goUnmanaged)
-// is detected by the depth going negative on the underlying fetch_sub —
-// the parkedThreads counter is NOT decremented in that case (the "prev == 1"
-// check). Verifies the API does not corrupt the quorum on user error.
-TEST_F(UnmanagedRegionTest, OrphanReturnDoesNotCorruptQuorum) {
-    int before = space->parkedThreads.load();
-    // Direct stress: call returnFromUnmanaged once without goUnmanaged.
-    // The depth becomes -1; parkedThreads is unchanged (the "prev == 1"
-    // branch is skipped because prev was 0 before fetch_sub returned 0,
-    // not 1). Restore by an explicit goUnmanaged afterwards.
+// is ignored: letting the depth go negative would report a managed thread
+// as safe to the collector.
+TEST_F(UnmanagedRegionTest, OrphanReturnIsIgnored) {
     ctx->returnFromUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before)
-        << "Orphan return must not decrement parkedThreads (would corrupt quorum).";
-    // Restore depth to 0 so subsequent tests start clean.
+    EXPECT_EQ(currentUnmanagedDepth(), 0);
     ctx->goUnmanaged();
-    EXPECT_EQ(space->parkedThreads.load(), before)
-        << "Counter went -1→0, no fresh 0→1 transition, so no parkedThreads bump.";
+    EXPECT_EQ(currentUnmanagedDepth(), 1);
+    ctx->returnFromUnmanaged();
+    EXPECT_EQ(currentUnmanagedDepth(), 0);
 }
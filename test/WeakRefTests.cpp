@@ -0,0 +1,157 @@
+/*
+ * WeakRefTests.cpp
+ *
+ * Covers ProtoWeakRef and ProtoWeakMap: referents that become unreachable
+ * are cleared by the collector, rooted ones are kept, and weak map values
+ * follow ephemeron semantics (alive only while their key is).
+ */
+
+#include <gtest/gtest.h>
+#include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
+#include "GCTestHelpers.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace proto;
+
+namespace {
+
+struct ClearLog {
+    int calls = 0;
+    const ProtoObject* last = nullptr;
+};
+
+void recordClear(void* userData, const ProtoObject* referent) {
+    auto* log = static_cast<ClearLog*>(userData);
+    log->calls++;
+    log->last = referent;
+}
+
+} // namespace
+
+TEST(WeakRefTest, ClearedWhenTargetUnreachable) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ClearLog log;
+
+    const ProtoWeakRef* ref = nullptr;
+    const ProtoObject* target = nullptr;
+    {
+        // The target lives in a sub-context, so it becomes a collection
+        // candidate when the sub-context ends.
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        target = sub.newObject(false);
+        ref = ctx->newWeakRef(target, recordClear, &log);
+        EXPECT_EQ(ref->get(ctx), target);
+    }
+
+    waitForGcCycles(space, 2);
+
+    EXPECT_EQ(ref->get(ctx), nullptr);
+    EXPECT_EQ(log.calls, 1);
+    EXPECT_EQ(log.last, target);
+}
+
+TEST(WeakRefTest, RootedTargetIsKept) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    auto* rs = space.createRootSet("weak-ref-test");
+
+    const ProtoWeakRef* ref = nullptr;
+    const ProtoObject* target = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        target = sub.newObject(false);
+        rs->add(target);
+        ref = ctx->newWeakRef(target);
+    }
+
+    waitForGcCycles(space, 2);
+
+    EXPECT_EQ(ref->get(ctx), target);
+    EXPECT_EQ(ref->asObject(ctx)->asWeakRef(ctx), ref);
+    space.destroyRootSet(rs);
+}
+
+TEST(WeakRefTest, EmbeddedTargetIsNeverCleared) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoWeakRef* ref = ctx->newWeakRef(ctx->fromInteger(42));
+
+    waitForGcCycles(space, 2);
+
+    ASSERT_NE(ref->get(ctx), nullptr);
+    EXPECT_EQ(ref->get(ctx)->asLong(ctx), 42);
+}
+
+TEST(WeakMapTest, SetGetRemove) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    const ProtoWeakMap* map = ctx->newWeakMap();
+    const ProtoObject* key = ctx->newObject(false);
+
+    EXPECT_EQ(map->get(ctx, key), nullptr);
+    map->set(ctx, key, ctx->fromInteger(1));
+    map->set(ctx, key, ctx->fromInteger(2));
+    EXPECT_EQ(map->getSize(ctx), 1u);
+    EXPECT_EQ(map->get(ctx, key)->asLong(ctx), 2);
+    EXPECT_TRUE(map->remove(ctx, key));
+    EXPECT_FALSE(map->remove(ctx, key));
+    EXPECT_EQ(map->getSize(ctx), 0u);
+    EXPECT_EQ(map->asObject(ctx)->asWeakMap(ctx), map);
+}
+
+TEST(WeakMapTest, LiveKeyKeepsValueAlive) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    auto* rs = space.createRootSet("weak-map-test");
+    const ProtoWeakMap* map = ctx->newWeakMap();
+    const ProtoString* name = ctx->fromUTF8String("payload")->asString(ctx);
+
+    const ProtoObject* key = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        key = sub.newObject(false);
+        rs->add(key);
+        const ProtoObject* value = sub.newObject(false)->setAttribute(&sub, name, sub.fromInteger(7));
+        map->set(&sub, key, value);
+    }
+
+    waitForGcCycles(space, 3);
+
+    ASSERT_EQ(map->getSize(ctx), 1u);
+    const ProtoObject* value = map->get(ctx, key);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->getAttribute(ctx, name)->asLong(ctx), 7);
+    space.destroyRootSet(rs);
+}
+
+TEST(WeakMapTest, EntryDroppedWhenKeyDiesEvenIfValueRefersToKey) {
+    ProtoSpace space;
+    ProtoContext* ctx = space.rootContext;
+    ClearLog log;
+    const ProtoWeakMap* map = ctx->newWeakMap(recordClear, &log);
+    const ProtoString* name = ctx->fromUTF8String("owner")->asString(ctx);
+
+    const ProtoObject* key = nullptr;
+    {
+        ProtoContext sub(&space, ctx, nullptr, nullptr, nullptr, nullptr);
+        key = sub.newObject(false);
+        // The value points back at its key: a strong map would keep both
+        // alive forever, an ephemeron must not.
+        const ProtoObject* value = sub.newObject(false)->setAttribute(&sub, name, key);
+        map->set(&sub, key, value);
+        map->set(&sub, sub.fromInteger(5), sub.newObject(false));
+    }
+
+    waitForGcCycles(space, 2);
+
+    EXPECT_EQ(map->get(ctx, key), nullptr);
+    EXPECT_EQ(log.calls, 1);
+    EXPECT_EQ(log.last, key);
+    // The entry under a non-cell key is strong and survives.
+    EXPECT_EQ(map->getSize(ctx), 1u);
+    EXPECT_NE(map->get(ctx, ctx->fromInteger(5)), nullptr);
+}
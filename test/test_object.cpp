@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <vector>
 #include "../headers/protoCore.h"
+#include "../headers/proto_internal.h"
 
 using namespace proto;
 
@@ -163,3 +166,152 @@ TEST_F(ObjectTest, RemoveAttributePreservesNoneOverride) {
     ASSERT_FALSE(child->hasOwnAttribute(context, x)->asBoolean(context));
     ASSERT_EQ(child->getAttribute(context, x)->asLong(context), 42);
 }
+
+TEST_F(ObjectTest, NegativeLookupSeesNameAddedToMutablePrototype) {
+    // A miss builds the child's chain summary; a later name added to a
+    // mutable ancestor must expire it so the lookup finds the new value.
+    proto::ProtoObject* base = const_cast<proto::ProtoObject*>(context->newObject(true));
+    const proto::ProtoString* present = context->fromUTF8String("present")->asString(context);
+    const proto::ProtoString* optional = context->fromUTF8String("optionalHook")->asString(context);
+    base->setAttribute(context, present, context->fromInteger(1));
+
+    const proto::ProtoObject* middle = base->newChild(context, true);
+    const proto::ProtoObject* leaf = middle->newChild(context);
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(leaf->getAttribute(context, optional), PROTO_NONE);
+        ASSERT_FALSE(leaf->hasAttribute(context, optional)->asBoolean(context));
+    }
+    ASSERT_EQ(leaf->getAttribute(context, present)->asLong(context), 1);
+
+    base->setAttribute(context, optional, context->fromInteger(7));
+    ASSERT_TRUE(leaf->hasAttribute(context, optional)->asBoolean(context));
+    ASSERT_EQ(leaf->getAttribute(context, optional)->asLong(context), 7);
+}
+
+TEST_F(ObjectTest, NegativeLookupSeesParentAddedToMutablePrototype) {
+    proto::ProtoObject* base = const_cast<proto::ProtoObject*>(context->newObject(true));
+    const proto::ProtoObject* leaf = base->newChild(context);
+    const proto::ProtoString* mixed = context->fromUTF8String("mixedIn")->asString(context);
+
+    const proto::ProtoObject* mixin = context->newObject(true);
+    mixin->setAttribute(context, mixed, context->fromInteger(3));
+
+    ASSERT_FALSE(leaf->hasAttribute(context, mixed)->asBoolean(context));
+    ASSERT_FALSE(leaf->hasAttribute(context, mixed)->asBoolean(context));
+
+    // hasAttribute descends into the mutable base's own chain, so the
+    // mixin becomes visible through it once linked.
+    base->addParent(context, mixin);
+    ASSERT_TRUE(leaf->hasAttribute(context, mixed)->asBoolean(context));
+}
+
+TEST_F(ObjectTest, NegativeLookupSummaryIgnoresUnrelatedPrototypes) {
+    // Summaries depend only on the prototypes they were read from: a new
+    // name on some other mutable class must not expire them.
+    proto::ProtoObject* base = const_cast<proto::ProtoObject*>(context->newObject(true));
+    proto::ProtoObject* other = const_cast<proto::ProtoObject*>(context->newObject(true));
+    const proto::ProtoObject* leaf = base->newChild(context);
+    const proto::ProtoObject* otherLeaf = other->newChild(context);
+    const proto::ProtoString* missing = context->fromUTF8String("neverDefined")->asString(context);
+    // Intern the name, or the lookup rejects it before walking any chain.
+    context->newObject()->setAttribute(context, missing, context->fromInteger(0));
+
+    ASSERT_EQ(leaf->getAttribute(context, missing), PROTO_NONE);
+    const proto::ParentLinkImplementation* link = proto::toImpl<const proto::ProtoObjectCell>(leaf)->parent;
+    const proto::ChainSummary* summary = link->summary.load();
+    ASSERT_NE(summary, nullptr);
+
+    other->setAttribute(context, context->fromUTF8String("added")->asString(context), context->fromInteger(1));
+    ASSERT_EQ(leaf->getAttribute(context, missing), PROTO_NONE);
+    EXPECT_EQ(link->summary.load(), summary);
+    ASSERT_TRUE(otherLeaf->hasAttribute(context, context->fromUTF8String("added")->asString(context))->asBoolean(context));
+
+    base->setAttribute(context, context->fromUTF8String("added")->asString(context), context->fromInteger(2));
+    ASSERT_EQ(leaf->getAttribute(context, context->fromUTF8String("added")->asString(context))->asLong(context), 2);
+}
+
+TEST_F(ObjectTest, NegativeLookupDeepImmutableChain) {
+    // Deep, fully immutable chain: summaries are permanent and must still
+    // report every real attribute at every depth.
+    const proto::ProtoObject* current = context->newObject();
+    std::vector<const proto::ProtoString*> names;
+    for (int depth = 0; depth < 40; ++depth) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "level%d", depth);
+        const proto::ProtoString* name = context->fromUTF8String(buf)->asString(context);
+        names.push_back(name);
+        current = current->setAttribute(context, name, context->fromInteger(depth));
+        current = current->newChild(context);
+    }
+    const proto::ProtoString* missing = context->fromUTF8String("notThere")->asString(context);
+    ASSERT_EQ(current->getAttribute(context, missing), PROTO_NONE);
+    ASSERT_EQ(current->getAttribute(context, missing), PROTO_NONE);
+    for (int depth = 0; depth < 40; ++depth) {
+        ASSERT_EQ(current->getAttribute(context, names[depth])->asLong(context), depth);
+    }
+}
+
+TEST_F(ObjectTest, SmallObjectAttributesSpillPastInlineBlock) {
+    // Attributes start in the object cell, move to a block on the third
+    // name and to the tree on the fourth; every value must survive each
+    // transition, for both the copy-on-write and the mutable (snapshot)
+    // paths.
+    const char* names[] = {"a", "b", "c", "d", "e"};
+    for (bool isMutable : {false, true}) {
+        const proto::ProtoObject* obj = context->newObject(isMutable);
+        for (int i = 0; i < 5; ++i) {
+            obj = obj->setAttribute(context, context->fromUTF8String(names[i])->asString(context),
+                                    context->fromInteger(i + 1));
+            for (int j = 0; j <= i; ++j) {
+                const proto::ProtoString* name = context->fromUTF8String(names[j])->asString(context);
+                ASSERT_EQ(obj->getAttribute(context, name)->asLong(context), j + 1);
+                ASSERT_TRUE(obj->hasOwnAttribute(context, name)->asBoolean(context));
+            }
+            ASSERT_EQ(obj->getOwnAttributes(context)->getSize(context), static_cast<unsigned long>(i + 1));
+            if (!isMutable) {
+                const proto::AttributeStore& store = proto::toImpl<const proto::ProtoObjectCell>(obj)->attributes;
+                EXPECT_EQ(store.isInCell(), i < 2);
+                EXPECT_EQ(store.inlineBlock() != nullptr, i == 2);
+            }
+        }
+    }
+}
+
+TEST_F(ObjectTest, SmallObjectAttributeOverwriteAndRemove) {
+    const proto::ProtoString* x = context->fromUTF8String("x")->asString(context);
+    const proto::ProtoString* y = context->fromUTF8String("y")->asString(context);
+    const proto::ProtoObject* empty = context->newObject();
+    ASSERT_EQ(empty->getOwnAttributes(context)->getSize(context), 0UL);
+    ASSERT_FALSE(empty->hasOwnAttribute(context, x)->asBoolean(context));
+
+    const proto::ProtoObject* obj = empty->setAttribute(context, x, context->fromInteger(1));
+    obj = obj->setAttribute(context, y, PROTO_NONE);
+    obj = obj->setAttribute(context, x, context->fromInteger(2));
+    ASSERT_EQ(obj->getOwnAttributes(context)->getSize(context), 2UL);
+    ASSERT_EQ(obj->getAttribute(context, x)->asLong(context), 2);
+    // A None value is still present.
+    ASSERT_TRUE(obj->hasOwnAttribute(context, y)->asBoolean(context));
+
+    obj = obj->removeAttribute(context, x);
+    ASSERT_FALSE(obj->hasOwnAttribute(context, x)->asBoolean(context));
+    ASSERT_TRUE(obj->hasOwnAttribute(context, y)->asBoolean(context));
+    obj = obj->removeAttribute(context, y);
+    ASSERT_EQ(obj->getOwnAttributes(context)->getSize(context), 0UL);
+}
+
+TEST_F(ObjectTest, SmallObjectAttributesMergeWithInherited) {
+    const proto::ProtoString* own = context->fromUTF8String("own")->asString(context);
+    const proto::ProtoString* shared = context->fromUTF8String("shared")->asString(context);
+    const proto::ProtoObject* base = context->newObject()
+        ->setAttribute(context, shared, context->fromInteger(1))
+        ->setAttribute(context, own, context->fromInteger(10));
+    const proto::ProtoObject* child = base->newChild(context)->setAttribute(context, own, context->fromInteger(20));
+
+    const proto::ProtoSparseList* all = child->getAttributes(context);
+    ASSERT_EQ(all->getSize(context), 2UL);
+    ASSERT_EQ(all->getAt(context, reinterpret_cast<uintptr_t>(context->fromUTF8String("own")->asString(context)))
+                  ->asLong(context), 20);
+    ASSERT_EQ(child->getAttribute(context, shared)->asLong(context), 1);
+    ASSERT_EQ(child->getOwnAttributes(context)->getSize(context), 1UL);
+}
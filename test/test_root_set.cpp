@@ -6,15 +6,19 @@
 //     resurrect a freed slot's contents).
 //   - Slot recycling after remove keeps generations distinct.
 //   - Live size accounting matches add/remove balance.
+//   - A set grows past its first slot directory.
 //   - GC scan during STW counts pinned roots even when the JS-side
 //     reference graph would otherwise let them be reclaimed.
 //   - createRootSet / destroyRootSet round-trips, and ProtoSpace
 //     destructor frees orphan sets without leaking.
 //   - Concurrent add/remove from multiple threads is safe.
+//   - ProtoHandleScope pins survive a collection and are released,
+//     in LIFO order, when their scope closes.
 
 #include <gtest/gtest.h>
 #include "../headers/protoCore.h"
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <vector>
 
@@ -114,6 +118,28 @@ TEST_F(RootSetTest, ForEachIteratesLiveRoots) {
     EXPECT_EQ(counted, static_cast<int>(kept.size()));
 }
 
+TEST_F(RootSetTest, GrowsPastFirstDirectory) {
+    // One directory covers 1M slots; the next pins link in a second.
+    auto* rs = space->createRootSet("test");
+    constexpr int N = (1 << 20) + 16;
+    auto* o = context->newObject(true);
+    std::vector<ProtoRootSet::Handle> handles;
+    handles.reserve(N);
+    for (int i = 0; i < N; i++) handles.push_back(rs->add(o));
+    EXPECT_EQ(rs->size(), static_cast<unsigned long>(N));
+    EXPECT_EQ(rs->resolve(handles.back()), o);
+    int counted = 0;
+    rs->forEachRoot(
+        [](void* user, const ProtoObject* obj) {
+            (void)obj;
+            (*static_cast<int*>(user))++;
+        },
+        &counted);
+    EXPECT_EQ(counted, N);
+    for (auto h : handles) rs->remove(h);
+    EXPECT_EQ(rs->size(), 0u);
+}
+
 TEST_F(RootSetTest, RemoveOfStaleHandleIsNoop) {
     auto* rs = space->createRootSet("test");
     auto* o = context->newObject(true);
@@ -199,3 +225,100 @@ TEST_F(RootSetTest, GCMarksPinnedObjects) {
     ASSERT_NE(val, nullptr);
     EXPECT_EQ(val->asLong(context), 0xDEADBEEFLL);
 }
+
+TEST_F(RootSetTest, ConcurrentChurnRecyclesSlots) {
+    // Interleaved add/remove on every thread keeps the free-slot stack
+    // hot, which is where an ABA bug in the lock-free pop would show.
+    auto* rs = space->createRootSet("churn");
+    constexpr int kThreads = 4;
+    constexpr int kRounds = 5000;
+    const ProtoObject* obj = context->newObject(false);
+    std::atomic<int> errors{0};
+
+    auto worker = [&]() {
+        ProtoRootSet::Handle held[4] = {};
+        for (int i = 0; i < kRounds; i++) {
+            auto& h = held[i % 4];
+            rs->remove(h);
+            h = rs->add(obj);
+            if (rs->resolve(h) != obj) errors++;
+        }
+        for (auto h : held) rs->remove(h);
+    };
+
+    std::vector<std::thread> ts;
+    for (int t = 0; t < kThreads; t++) ts.emplace_back(worker);
+    for (auto& t : ts) t.join();
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(rs->size(), 0u);
+    int visited = 0;
+    rs->forEachRoot([](void* user, const ProtoObject*) { (*static_cast<int*>(user))++; }, &visited);
+    EXPECT_EQ(visited, 0);
+}
+
+namespace {
+void runGcCycle(ProtoSpace* space) {
+    {
+        std::lock_guard<std::recursive_mutex> lock(ProtoSpace::globalMutex);
+        space->gcStarted = true;
+        space->gcCV.notify_all();
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (space->gcStarted.load() && std::chrono::steady_clock::now() < deadline) {
+        space->rootContext->safepoint();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+} // namespace
+
+TEST_F(RootSetTest, HandleScopeKeepsPinnedObjectsAlive) {
+    const ProtoWeakRef* probe = nullptr;
+    {
+        ProtoHandleScope scope(context);
+        {
+            // Allocated in a sub-context, so only the scope keeps it.
+            ProtoContext sub(space, context, nullptr, nullptr, nullptr, nullptr);
+            const ProtoObject* obj = scope.pin(sub.newObject(false));
+            probe = context->newWeakRef(obj);
+        }
+        runGcCycle(space);
+        runGcCycle(space);
+        EXPECT_NE(probe->get(context), nullptr);
+    }
+    runGcCycle(space);
+    runGcCycle(space);
+    EXPECT_EQ(probe->get(context), nullptr);
+}
+
+TEST_F(RootSetTest, NestedHandleScopesReleaseInLifoOrder) {
+    // More pins than one handle block holds, so the inner scope spills
+    // into a second block and must rewind across it.
+    constexpr int kInner = 600;
+    const ProtoWeakRef* outerProbe = nullptr;
+    std::vector<const ProtoWeakRef*> innerProbes;
+    {
+        ProtoHandleScope outer(context);
+        {
+            ProtoContext sub(space, context, nullptr, nullptr, nullptr, nullptr);
+            outerProbe = context->newWeakRef(outer.pin(sub.newObject(false)));
+        }
+        {
+            ProtoHandleScope inner(context);
+            {
+                ProtoContext sub(space, context, nullptr, nullptr, nullptr, nullptr);
+                for (int i = 0; i < kInner; i++)
+                    innerProbes.push_back(context->newWeakRef(inner.pin(sub.newObject(false))));
+            }
+            runGcCycle(space);
+            for (auto* p : innerProbes) ASSERT_NE(p->get(context), nullptr);
+        }
+        runGcCycle(space);
+        runGcCycle(space);
+        EXPECT_NE(outerProbe->get(context), nullptr);
+        int cleared = 0;
+        for (auto* p : innerProbes) cleared += p->get(context) == nullptr;
+        EXPECT_EQ(cleared, kInner);
+    }
+}
@@ -783,3 +783,66 @@ TEST_F(SymbolTest, SymbolSurvivesGcStress) {
     again->toUTF8String(c, out);
     EXPECT_EQ(out, name);
 }
+
+// ---- PROTO_SYMBOL literals ---------------------------------------------------
+
+TEST_F(SymbolTest, LiteralHashMatchesRuntimeHash) {
+    // The compile-time hash must track ProtoStringImplementation's leaf
+    // split, including multi-leaf and multi-byte content.
+    const std::string samples[] = {
+        "x", "seventeen_bytes__", std::string(32, 'a'), std::string(33, 'b'),
+        std::string(100, 'c'), "\xc3\xa9t\xc3\xa9 d'\xc3\xa9t\xc3\xa9 sans fin, \xc3\xa9t\xc3\xa9 d'hiver bient\xc3\xb4t"};
+    for (const std::string& s : samples) {
+        auto* impl = ProtoStringImplementation::fromUTF8Bytes(
+            c, reinterpret_cast<const uint8_t*>(s.data()), s.size());
+        EXPECT_EQ(symbolLiteralHash(s.data(), s.size()), impl->implGetHash()) << s;
+    }
+}
+
+TEST_F(SymbolTest, LiteralMatchesCreateSymbol) {
+    EXPECT_EQ(PROTO_SYMBOL(c, "x"), ProtoString::createSymbol(c, "x"));
+    EXPECT_EQ(PROTO_SYMBOL(c, "abcdef"), ProtoString::createSymbol(c, "abcdef"));
+    EXPECT_EQ(PROTO_SYMBOL(c, ""), ProtoString::createSymbol(c, ""));
+
+    // Interned before first use: found through the compile-time hash.
+    const ProtoString* before = ProtoString::createSymbol(c, "alreadyInternedName");
+    EXPECT_EQ(PROTO_SYMBOL(c, "alreadyInternedName"), before);
+
+    // Not yet interned: the literal interns it.
+    const ProtoString* fresh = PROTO_SYMBOL(c, "internedByTheLiteral");
+    EXPECT_TRUE(fresh->isSymbol());
+    EXPECT_EQ(ProtoString::createSymbol(c, "internedByTheLiteral"), fresh);
+}
+
+TEST_F(SymbolTest, LiteralSlotIsStableAndPerSpace) {
+    auto lookup = [](ProtoContext* context) { return PROTO_SYMBOL(context, "perSpaceLiteralName"); };
+    const ProtoString* first = lookup(c);
+    EXPECT_EQ(lookup(c), first);
+
+    // A second space has its own symbol table: the slot must rebind
+    // rather than hand out the first space's symbol.
+    {
+        ProtoSpace other;
+        ProtoContext otherCtx{&other};
+        const ProtoString* there = lookup(&otherCtx);
+        EXPECT_EQ(there, ProtoString::createSymbol(&otherCtx, "perSpaceLiteralName"));
+        const ProtoObject* obj = otherCtx.newObject()->setAttribute(&otherCtx, there, otherCtx.fromInteger(1));
+        EXPECT_EQ(obj->getAttribute(&otherCtx, ProtoString::createSymbol(&otherCtx, "perSpaceLiteralName"))
+                      ->asLong(&otherCtx), 1);
+    }
+    EXPECT_EQ(lookup(c), first);
+}
+
+TEST_F(SymbolTest, LiteralSlotAlternatingBetweenLiveSpaces) {
+    // Alternating uses from two live spaces must keep returning each
+    // space's own symbol; the older space takes the lookup path.
+    auto lookup = [](ProtoContext* context) { return PROTO_SYMBOL(context, "alternatingLiteralName"); };
+    ProtoSpace other;
+    ProtoContext otherCtx{&other};
+    const ProtoString* here = ProtoString::createSymbol(c, "alternatingLiteralName");
+    const ProtoString* there = ProtoString::createSymbol(&otherCtx, "alternatingLiteralName");
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(lookup(c), here);
+        EXPECT_EQ(lookup(&otherCtx), there);
+    }
+}
@@ -0,0 +1,29 @@
+# Checks that every USDT probe of provider "protocore" is present in the
+# library's .note.stapsdt section.  Run by ctest as
+#   cmake -DREADELF=<readelf> -DLIBRARY=<libprotoCore.so> -P usdt_probes.cmake
+# when the library was built with PROTOCORE_USDT.
+
+set(PROBES
+    gc_start gc_stop_requested gc_world_stopped gc_world_restarted
+    gc_mark_done gc_sweep_done gc_done
+    heap_grow heap_refill
+    safepoint_park safepoint_unpark
+    symbol_insert
+    module_resolve_start module_resolve_done
+    attrcache_miss)
+
+execute_process(COMMAND ${READELF} -n ${LIBRARY}
+                OUTPUT_VARIABLE notes
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "readelf -n ${LIBRARY} failed (${result})")
+endif()
+
+foreach(probe IN LISTS PROBES)
+    string(REGEX MATCH "Provider: protocore[ \t\r\n]+Name: ${probe}[ \t\r\n]" found "${notes}")
+    if(NOT found)
+        message(FATAL_ERROR "USDT probe protocore:${probe} not found in ${LIBRARY}")
+    endif()
+endforeach()
+list(LENGTH PROBES count)
+message(STATUS "${count} protocore USDT probes present")
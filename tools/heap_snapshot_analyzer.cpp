@@ -0,0 +1,299 @@
+/*
+ * heap_snapshot_analyzer.cpp
+ *
+ * Reads a heap snapshot written by ProtoSpace::writeHeapSnapshot (format
+ * in core/HeapSnapshot.cpp) and reports what keeps the heap alive:
+ *
+ *   - totals, and cell counts and sizes per type;
+ *   - per root category, how many roots it has and how much of the heap
+ *     only it retains;
+ *   - the cells with the largest retained size (the size of everything
+ *     they dominate: cells unreachable from any root without passing
+ *     through them), each with its dominator chain back to a root.
+ *
+ * Dominators are computed with the iterative algorithm of Cooper, Harvey
+ * and Kennedy over a virtual root that points at every snapshot root.
+ *
+ * Usage: heap_snapshot_analyzer <snapshot> [--top N]
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Snapshot {
+    std::vector<std::string> typeNames;
+    std::vector<std::string> rootKindNames;
+    std::vector<uint64_t> address;
+    std::vector<uint8_t> type;
+    std::vector<uint64_t> size;
+    std::vector<uint64_t> edgeStart;     // node i's edges: edges[edgeStart[i] .. edgeStart[i + 1])
+    std::vector<uint32_t> edges;
+    std::vector<uint32_t> rootNode;
+    std::vector<uint8_t> rootKind;
+};
+
+class Reader {
+public:
+    explicit Reader(std::FILE* file) : file(file) {}
+
+    uint64_t le(int width) {
+        unsigned char in[8];
+        if (std::fread(in, 1, width, file) != static_cast<size_t>(width)) fail("truncated file");
+        uint64_t v = 0;
+        for (int i = 0; i < width; ++i) v |= static_cast<uint64_t>(in[i]) << (8 * i);
+        return v;
+    }
+
+    std::string string() {
+        std::string s(le(2), '\0');
+        if (!s.empty() && std::fread(&s[0], 1, s.size(), file) != s.size()) fail("truncated file");
+        return s;
+    }
+
+    [[noreturn]] static void fail(const char* what) {
+        std::fprintf(stderr, "heap_snapshot_analyzer: %s\n", what);
+        std::exit(1);
+    }
+
+private:
+    std::FILE* file;
+};
+
+Snapshot load(const char* path) {
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::perror(path);
+        std::exit(1);
+    }
+    Reader in(file);
+    char magic[4];
+    for (char& c : magic) c = static_cast<char>(in.le(1));
+    if (std::memcmp(magic, "PCHS", 4) != 0) Reader::fail("not a protoCore heap snapshot");
+    if (in.le(4) != 1) Reader::fail("unsupported snapshot version");
+
+    Snapshot s;
+    for (uint64_t n = in.le(4); n > 0; --n) s.typeNames.push_back(in.string());
+    for (uint64_t n = in.le(4); n > 0; --n) s.rootKindNames.push_back(in.string());
+
+    const uint64_t nodes = in.le(8);
+    s.address.reserve(nodes);
+    s.type.reserve(nodes);
+    s.size.reserve(nodes);
+    s.edgeStart.reserve(nodes + 1);
+    for (uint64_t i = 0; i < nodes; ++i) {
+        s.address.push_back(in.le(8));
+        s.type.push_back(static_cast<uint8_t>(in.le(1)));
+        s.size.push_back(in.le(8));
+        s.edgeStart.push_back(s.edges.size());
+        for (uint64_t n = in.le(4); n > 0; --n) {
+            const uint64_t target = in.le(4);
+            if (target >= nodes) Reader::fail("edge to an undefined node");
+            s.edges.push_back(static_cast<uint32_t>(target));
+        }
+    }
+    s.edgeStart.push_back(s.edges.size());
+
+    for (uint64_t n = in.le(8); n > 0; --n) {
+        const uint64_t node = in.le(4);
+        if (node >= nodes) Reader::fail("root names an undefined node");
+        s.rootNode.push_back(static_cast<uint32_t>(node));
+        s.rootKind.push_back(static_cast<uint8_t>(in.le(1)));
+    }
+    std::fclose(file);
+    return s;
+}
+
+const std::string& typeName(const Snapshot& s, uint32_t node) {
+    static const std::string unknown = "?";
+    return s.type[node] < s.typeNames.size() ? s.typeNames[s.type[node]] : unknown;
+}
+
+const std::string& rootKindName(const Snapshot& s, uint8_t kind) {
+    static const std::string unknown = "?";
+    return kind < s.rootKindNames.size() ? s.rootKindNames[kind] : unknown;
+}
+
+std::string human(uint64_t bytes) {
+    char out[32];
+    if (bytes >= (1ULL << 30)) std::snprintf(out, sizeof out, "%.1f GB", bytes / double(1ULL << 30));
+    else if (bytes >= (1ULL << 20)) std::snprintf(out, sizeof out, "%.1f MB", bytes / double(1ULL << 20));
+    else if (bytes >= (1ULL << 10)) std::snprintf(out, sizeof out, "%.1f KB", bytes / double(1ULL << 10));
+    else std::snprintf(out, sizeof out, "%llu B", static_cast<unsigned long long>(bytes));
+    return out;
+}
+
+// Immediate dominators over the nodes plus a virtual root (id = node
+// count) with an edge to every root.  Returns them with the reverse
+// postorder used to compute them; idom[virtual root] is itself.
+void dominators(const Snapshot& s, std::vector<uint32_t>& idom, std::vector<uint32_t>& rpo) {
+    const uint32_t n = static_cast<uint32_t>(s.address.size());
+    const uint32_t root = n;
+    auto degree = [&](uint32_t v) -> uint64_t {
+        return v == root ? s.rootNode.size() : s.edgeStart[v + 1] - s.edgeStart[v];
+    };
+    auto successor = [&](uint32_t v, uint64_t i) {
+        return v == root ? s.rootNode[i] : s.edges[s.edgeStart[v] + i];
+    };
+
+    // Postorder by an explicit DFS stack of (node, next successor index).
+    std::vector<uint32_t> order(n + 1, UINT32_MAX);
+    std::vector<uint32_t> post;
+    post.reserve(n + 1);
+    std::vector<bool> seen(n + 1, false);
+    std::vector<std::pair<uint32_t, uint64_t>> stack{{root, 0}};
+    seen[root] = true;
+    while (!stack.empty()) {
+        const uint32_t v = stack.back().first;
+        uint64_t& next = stack.back().second;
+        while (next < degree(v) && seen[successor(v, next)]) ++next;
+        if (next == degree(v)) {
+            order[v] = static_cast<uint32_t>(post.size());
+            post.push_back(v);
+            stack.pop_back();
+        } else {
+            const uint32_t child = successor(v, next++);
+            seen[child] = true;
+            stack.push_back({child, 0});
+        }
+    }
+    rpo.assign(post.rbegin(), post.rend());
+
+    std::vector<std::vector<uint32_t>> predecessors(n + 1);
+    for (uint32_t v : rpo)
+        for (uint64_t i = 0; i < degree(v); ++i) predecessors[successor(v, i)].push_back(v);
+
+    idom.assign(n + 1, UINT32_MAX);
+    idom[root] = root;
+    auto intersect = [&](uint32_t a, uint32_t b) {
+        while (a != b) {
+            while (order[a] < order[b]) a = idom[a];
+            while (order[b] < order[a]) b = idom[b];
+        }
+        return a;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (uint32_t v : rpo) {
+            if (v == root) continue;
+            uint32_t dom = UINT32_MAX;
+            for (uint32_t p : predecessors[v]) {
+                if (idom[p] == UINT32_MAX) continue;
+                dom = dom == UINT32_MAX ? p : intersect(p, dom);
+            }
+            if (dom != idom[v]) {
+                idom[v] = dom;
+                changed = true;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    unsigned long top = 20;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "usage: %s <snapshot> [--top N]\n", argv[0]);
+        return 2;
+    }
+
+    const Snapshot s = load(path);
+    const uint32_t n = static_cast<uint32_t>(s.address.size());
+    std::vector<uint32_t> idom, rpo;
+    dominators(s, idom, rpo);
+
+    std::vector<uint64_t> retained(n + 1, 0);
+    for (uint32_t v = 0; v < n; ++v) retained[v] = s.size[v];
+    for (auto it = rpo.rbegin(); it != rpo.rend(); ++it)
+        if (*it != n) retained[idom[*it]] += retained[*it];
+
+    std::printf("%u cells, %s reachable, %zu roots\n\n", n, human(retained[n]).c_str(), s.rootNode.size());
+
+    // Per type.
+    std::vector<uint64_t> typeCount(256, 0), typeSize(256, 0);
+    for (uint32_t v = 0; v < n; ++v) {
+        ++typeCount[s.type[v]];
+        typeSize[s.type[v]] += s.size[v];
+    }
+    std::vector<uint8_t> types;
+    for (int t = 0; t < 256; ++t) if (typeCount[t]) types.push_back(static_cast<uint8_t>(t));
+    std::sort(types.begin(), types.end(), [&](uint8_t a, uint8_t b) { return typeSize[a] > typeSize[b]; });
+    std::printf("%-22s %12s %12s\n", "type", "cells", "size");
+    for (uint8_t t : types) {
+        const std::string& name = t < s.typeNames.size() ? s.typeNames[t] : std::string("?");
+        std::printf("%-22s %12llu %12s\n", name.c_str(),
+                    static_cast<unsigned long long>(typeCount[t]), human(typeSize[t]).c_str());
+    }
+
+    // Per root category: what each retains alone.  A cell held by roots
+    // of several categories is dominated by the virtual root and counts
+    // for none of them.
+    std::printf("\n%-22s %12s %12s\n", "root category", "roots", "retains");
+    std::vector<uint64_t> kindRoots(256, 0), kindRetained(256, 0);
+    std::vector<int> onlyKind(n, -1);
+    for (size_t i = 0; i < s.rootNode.size(); ++i) {
+        const uint32_t v = s.rootNode[i];
+        ++kindRoots[s.rootKind[i]];
+        onlyKind[v] = onlyKind[v] == -1 || onlyKind[v] == s.rootKind[i] ? s.rootKind[i] : -2;
+    }
+    std::vector<bool> counted(n, false);
+    for (size_t i = 0; i < s.rootNode.size(); ++i) {
+        const uint32_t v = s.rootNode[i];
+        if (idom[v] != n || onlyKind[v] < 0 || counted[v]) continue;
+        counted[v] = true;
+        kindRetained[onlyKind[v]] += retained[v];
+    }
+    for (int k = 0; k < 256; ++k) {
+        if (!kindRoots[k]) continue;
+        std::printf("%-22s %12llu %12s\n", rootKindName(s, static_cast<uint8_t>(k)).c_str(),
+                    static_cast<unsigned long long>(kindRoots[k]), human(kindRetained[k]).c_str());
+    }
+
+    // Largest retainers, with their dominator chains.
+    std::vector<uint32_t> byRetained(n);
+    for (uint32_t v = 0; v < n; ++v) byRetained[v] = v;
+    const size_t shown = std::min<size_t>(top, n);
+    std::partial_sort(byRetained.begin(), byRetained.begin() + shown, byRetained.end(),
+                      [&](uint32_t a, uint32_t b) { return retained[a] > retained[b]; });
+    std::vector<int> firstRootKind(n, -1);
+    for (size_t i = 0; i < s.rootNode.size(); ++i)
+        if (firstRootKind[s.rootNode[i]] == -1) firstRootKind[s.rootNode[i]] = s.rootKind[i];
+
+    std::printf("\n%-18s %-20s %10s %10s  dominator chain\n", "cell", "type", "size", "retains");
+    for (size_t i = 0; i < shown; ++i) {
+        const uint32_t v = byRetained[i];
+        if (idom[v] == UINT32_MAX) continue;
+        std::string chain;
+        uint32_t up = v;
+        while (idom[up] != n) {
+            up = idom[up];
+            chain = typeName(s, up) + (chain.empty() ? "" : " > ") + chain;
+        }
+        const std::string origin = firstRootKind[up] >= 0
+            ? "[" + rootKindName(s, static_cast<uint8_t>(firstRootKind[up])) + "]"
+            : "[shared]";
+        std::printf("0x%016llx %-20s %10s %10s  %s%s%s\n",
+                    static_cast<unsigned long long>(s.address[v]), typeName(s, v).c_str(),
+                    human(s.size[v]).c_str(), human(retained[v]).c_str(),
+                    origin.c_str(), chain.empty() ? "" : " ", chain.c_str());
+    }
+    return 0;
+}